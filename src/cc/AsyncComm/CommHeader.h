@@ -48,19 +48,23 @@ namespace Hypertable {
     /** Enumeration constants for bits in #flags field
      */
     enum Flags {
-      FLAGS_BIT_REQUEST          = 0x0001, //!< Request message
-      FLAGS_BIT_IGNORE_RESPONSE  = 0x0002, //!< Response should be ignored
-      FLAGS_BIT_URGENT           = 0x0004, //!< Request is urgent
-      FLAGS_BIT_PROXY_MAP_UPDATE = 0x4000, //!< ProxyMap update message
-      FLAGS_BIT_PAYLOAD_CHECKSUM = 0x8000  //!< Payload checksumming is enabled
+      FLAGS_BIT_REQUEST             = 0x0001, //!< Request message
+      FLAGS_BIT_IGNORE_RESPONSE     = 0x0002, //!< Response should be ignored
+      FLAGS_BIT_URGENT              = 0x0004, //!< Request is urgent
+      FLAGS_BIT_ACCEPT_COMPRESSED   = 0x0008, //!< Peer inflates compressed payloads
+      FLAGS_BIT_PAYLOAD_COMPRESSED  = 0x0010, //!< Payload is compressed
+      FLAGS_BIT_PROXY_MAP_UPDATE    = 0x4000, //!< ProxyMap update message
+      FLAGS_BIT_PAYLOAD_CHECKSUM    = 0x8000  //!< Payload checksumming is enabled
     };
 
     enum FlagMask {
-      FLAGS_MASK_REQUEST          = 0xFFFE,
-      FLAGS_MASK_IGNORE_RESPONSE  = 0xFFFD,
-      FLAGS_MASK_URGENT           = 0xFFFB,
-      FLAGS_MASK_PROXY_MAP_UPDATE = 0xBFFF,
-      FLAGS_MASK_PAYLOAD_CHECKSUM = 0x7FFF
+      FLAGS_MASK_REQUEST            = 0xFFFE,
+      FLAGS_MASK_IGNORE_RESPONSE    = 0xFFFD,
+      FLAGS_MASK_URGENT             = 0xFFFB,
+      FLAGS_MASK_ACCEPT_COMPRESSED  = 0xFFF7,
+      FLAGS_MASK_PAYLOAD_COMPRESSED = 0xFFEF,
+      FLAGS_MASK_PROXY_MAP_UPDATE   = 0xBFFF,
+      FLAGS_MASK_PAYLOAD_CHECKSUM   = 0x7FFF
     };
 
     /** Default constructor.
@@ -87,8 +91,14 @@ namespace Hypertable {
 
     void set_total_length(uint32_t len) { total_len = len; }
 
+    /** Initializes response header from request header.  The payload
+     * compression bits describe the message they are set on and are not
+     * carried over to the response.
+     * @param req_header Request header
+     */
     void initialize_from_request_header(CommHeader &req_header) {
-      flags = req_header.flags;
+      flags = req_header.flags & FLAGS_MASK_ACCEPT_COMPRESSED &
+        FLAGS_MASK_PAYLOAD_COMPRESSED;
       id = req_header.id;
       gid = req_header.gid;
       command = req_header.command;
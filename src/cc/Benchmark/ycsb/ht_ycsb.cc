@@ -0,0 +1,597 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <boost/random.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Common/DiscreteRandomGeneratorUniform.h"
+#include "Common/DiscreteRandomGeneratorZipf.h"
+#include "Common/Error.h"
+#include "Common/Init.h"
+#include "Common/LatencyHistogram.h"
+#include "Common/Mutex.h"
+#include "Common/String.h"
+#include "Common/System.h"
+#include "Common/Time.h"
+
+#include "AsyncComm/Config.h"
+
+#include "Hypertable/Lib/Client.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/KeySpec.h"
+
+using namespace Hypertable;
+using namespace Hypertable::Config;
+using namespace std;
+
+
+namespace {
+
+  const char *usage =
+    "Usage: ht_ycsb [options] <workload>\n\n"
+    "Description:\n"
+    "  Runs one of the YCSB core workloads against a Hypertable table.  The\n"
+    "  <workload> argument is one of 'a' through 'f':\n\n"
+    "    a  50% read, 50% update, zipfian\n"
+    "    b  95% read, 5% update, zipfian\n"
+    "    c  100% read, zipfian\n"
+    "    d  95% read, 5% insert, latest\n"
+    "    e  95% short scan, 5% insert, zipfian\n"
+    "    f  50% read, 50% read-modify-write, zipfian\n\n"
+    "  The 'load' phase inserts --record-count records and must be run once\n"
+    "  against an empty table (see ycsb-create-table.hql) with the same\n"
+    "  --record-count used by later 'run' phases.  Results are written as\n"
+    "  JSON.  When --target is given, each thread issues operations on a\n"
+    "  fixed schedule and latency is measured from the time an operation was\n"
+    "  scheduled to start, which corrects for coordinated omission; the\n"
+    "  service time, measured from when it actually started, is reported\n"
+    "  alongside.\n\n"
+    "Options";
+
+  struct AppPolicy : Config::Policy {
+    static void init_options() {
+      cmdline_desc(usage).add_options()
+        ("table", str()->default_value("usertable"), "Table to benchmark")
+        ("phase", str()->default_value("run"),
+         "Phase to execute ('load' or 'run')")
+        ("record-count", i64()->default_value(100000),
+         "Number of records inserted by the load phase")
+        ("operation-count", i64()->default_value(100000),
+         "Number of operations executed by the run phase")
+        ("threads", i32()->default_value(1), "Number of client threads")
+        ("target", i32()->default_value(0), "Target throughput in "
+         "operations/s across all threads (0 runs unthrottled)")
+        ("field-count", i32()->default_value(10), "Number of fields per record")
+        ("field-length", i32()->default_value(100), "Size of each field value")
+        ("max-scan-length", i32()->default_value(100),
+         "Maximum number of records returned by a scan")
+        ("request-distribution", str(), "Override the key distribution of "
+         "the workload ('uniform', 'zipfian' or 'latest')")
+        ("zipfian-constant", f64()->default_value(0.99),
+         "Zipfian skew, must be in the range (0, 1)")
+        ("seed", i32()->default_value(1), "Random number generator seed")
+        ("output", str(), "File to write JSON results to (default stdout)")
+        ;
+      cmdline_hidden_desc().add_options()("workload", str(), "");
+      cmdline_positional_desc().add("workload", 1);
+    }
+  };
+
+  typedef Meta::list<AppPolicy, DefaultCommPolicy> Policies;
+
+  enum Distribution { UNIFORM, ZIPFIAN, LATEST };
+
+  enum Operation { READ, UPDATE, INSERT, SCAN, READ_MODIFY_WRITE,
+                   OPERATION_MAX };
+
+  const char *operation_names[OPERATION_MAX] = {
+    "READ", "UPDATE", "INSERT", "SCAN", "READ-MODIFY-WRITE"
+  };
+
+  const char *distribution_names[] = { "uniform", "zipfian", "latest" };
+
+  struct Workload {
+    const char *name;
+    double proportion[OPERATION_MAX];
+    Distribution distribution;
+  };
+
+  const Workload workloads[] = {
+    { "a", { 0.50, 0.50, 0.00, 0.00, 0.00 }, ZIPFIAN },
+    { "b", { 0.95, 0.05, 0.00, 0.00, 0.00 }, ZIPFIAN },
+    { "c", { 1.00, 0.00, 0.00, 0.00, 0.00 }, ZIPFIAN },
+    { "d", { 0.95, 0.00, 0.05, 0.00, 0.00 }, LATEST },
+    { "e", { 0.00, 0.00, 0.05, 0.95, 0.00 }, ZIPFIAN },
+    { "f", { 0.50, 0.00, 0.00, 0.00, 0.50 }, ZIPFIAN },
+    { 0, { 0, 0, 0, 0, 0 }, UNIFORM }
+  };
+
+  const char *COLUMN_FAMILY = "field";
+
+  /** Maps a record number to its row key.  Record numbers are hashed so
+   * that inserts are spread across the table, as with YCSB's default
+   * hashed insert order.
+   */
+  String record_key(uint64_t keynum) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i=0; i<8; i++) {
+      hash ^= keynum & 0xFF;
+      hash *= 1099511628211ULL;
+      keynum >>= 8;
+    }
+    return format("user%llu", (Llu)hash);
+  }
+
+  int64_t now_micros() {
+    return get_ts64() / 1000LL;
+  }
+
+  /** Zipfian generator over ranks, where rank 0 is the most popular.  Used
+   * by the 'latest' distribution to favor recently inserted records.
+   */
+  class DiscreteRandomGeneratorZipfRank : public DiscreteRandomGeneratorZipf {
+  public:
+    DiscreteRandomGeneratorZipfRank(double s)
+      : DiscreteRandomGeneratorZipf(s) { }
+
+  protected:
+    virtual void generate_cmf() {
+      DiscreteRandomGeneratorZipf::generate_cmf();
+      for (uint64_t i=0; i<m_value_count; i++)
+        m_numbers[i] = i;
+    }
+  };
+
+  /** Chooses the records operated on and hands out record numbers for
+   * inserts.  A single generator is shared by all threads so that they
+   * agree on which records are popular.  The 'latest' distribution is
+   * relative to the most recent insert that has been flushed.
+   */
+  class KeyChooser {
+  public:
+    KeyChooser(Distribution distribution, uint64_t record_count, double s,
+               unsigned seed)
+      : m_distribution(distribution), m_next_insert(record_count),
+        m_latest(record_count - 1) {
+      if (distribution == UNIFORM)
+        m_generator = new DiscreteRandomGeneratorUniform();
+      else if (distribution == ZIPFIAN)
+        m_generator = new DiscreteRandomGeneratorZipf(s);
+      else
+        m_generator = new DiscreteRandomGeneratorZipfRank(s);
+      m_generator->set_seed(seed);
+      m_generator->set_value_count(record_count);
+    }
+
+    uint64_t next_key() {
+      ScopedLock lock(m_mutex);
+      uint64_t sample = m_generator->get_sample();
+      if (m_distribution == LATEST)
+        return sample > m_latest ? 0 : m_latest - sample;
+      return sample;
+    }
+
+    uint64_t next_insert() {
+      ScopedLock lock(m_mutex);
+      return m_next_insert++;
+    }
+
+    void insert_complete(uint64_t keynum) {
+      ScopedLock lock(m_mutex);
+      if (keynum > m_latest)
+        m_latest = keynum;
+    }
+
+  private:
+    Mutex m_mutex;
+    Distribution m_distribution;
+    DiscreteRandomGeneratorPtr m_generator;
+    uint64_t m_next_insert;
+    uint64_t m_latest;
+  };
+
+  /** Settings and state shared by all benchmark threads */
+  struct BenchmarkContext {
+    TablePtr table;
+    const Workload *workload;
+    KeyChooser *chooser;
+    bool load;
+    uint64_t record_count;
+    int32_t threads;
+    int32_t target;
+    int32_t field_count;
+    int32_t field_length;
+    int32_t max_scan_length;
+    int32_t seed;
+  };
+
+  /** Per-thread results */
+  struct ThreadResults {
+    ThreadResults() : operations(0) {
+      memset(errors, 0, sizeof(errors));
+    }
+    LatencyHistogram latency[OPERATION_MAX];
+    LatencyHistogram service_time[OPERATION_MAX];
+    uint64_t errors[OPERATION_MAX];
+    uint64_t operations;
+  };
+
+  class BenchmarkThread {
+  public:
+    BenchmarkThread(BenchmarkContext &context, int32_t id, uint64_t count,
+                    ThreadResults &results)
+      : m_context(context), m_id(id), m_count(count), m_results(results) { }
+
+    void operator()() {
+      try {
+        m_rng.seed((uint32_t)(m_context.seed + m_id));
+        m_values.resize(64 * 1024 + m_context.field_length);
+        for (size_t i=0; i<m_values.size(); i++)
+          m_values[i] = 'a' + (m_rng() % 26);
+        m_mutator = m_context.table->create_mutator();
+        if (m_context.load)
+          load();
+        else
+          run();
+      }
+      catch (Exception &e) {
+        HT_ERROR_OUT << e << HT_END;
+        _exit(1);
+      }
+    }
+
+  private:
+
+    void load() {
+      for (uint64_t i=m_id; i<m_context.record_count;
+           i += m_context.threads) {
+        insert_record(i);
+        m_results.operations++;
+      }
+      m_mutator->flush();
+    }
+
+    void run() {
+      int64_t start = now_micros();
+      int64_t interval = 0;
+      int64_t intended, begin;
+      Operation operation;
+
+      if (m_context.target > 0)
+        interval = (1000000LL * m_context.threads) / m_context.target;
+
+      for (uint64_t i=0; i<m_count; i++) {
+        begin = now_micros();
+        if (interval) {
+          intended = start + (int64_t)i * interval;
+          if (begin < intended) {
+            boost::this_thread::sleep(
+                boost::posix_time::microseconds(intended - begin));
+            begin = now_micros();
+          }
+        }
+        else
+          intended = begin;
+
+        operation = choose_operation();
+        try {
+          execute(operation);
+        }
+        catch (Exception &e) {
+          HT_ERROR_OUT << operation_names[operation] << " - " << e << HT_END;
+          m_results.errors[operation]++;
+          // a failed flush leaves the mutator unusable
+          m_mutator = m_context.table->create_mutator();
+          continue;
+        }
+        int64_t end = now_micros();
+        m_results.latency[operation].record(end - intended);
+        m_results.service_time[operation].record(end - begin);
+        m_results.operations++;
+      }
+    }
+
+    Operation choose_operation() {
+      double r = (double)m_rng() / 4294967296.0;
+      for (int i=0; i<OPERATION_MAX-1; i++) {
+        if (r < m_context.workload->proportion[i])
+          return (Operation)i;
+        r -= m_context.workload->proportion[i];
+      }
+      return (Operation)(OPERATION_MAX-1);
+    }
+
+    void execute(Operation operation) {
+      uint64_t keynum;
+      String row;
+
+      switch (operation) {
+      case READ:
+        read_record(record_key(m_context.chooser->next_key()));
+        break;
+      case UPDATE:
+        update_record(record_key(m_context.chooser->next_key()));
+        break;
+      case INSERT:
+        keynum = m_context.chooser->next_insert();
+        insert_record(keynum);
+        m_mutator->flush();
+        m_context.chooser->insert_complete(keynum);
+        break;
+      case SCAN:
+        scan_records(record_key(m_context.chooser->next_key()),
+                     1 + (m_rng() % m_context.max_scan_length));
+        break;
+      default:
+        row = record_key(m_context.chooser->next_key());
+        read_record(row);
+        update_record(row);
+        break;
+      }
+    }
+
+    const char *random_value() {
+      return &m_values[m_rng() % (m_values.size() - m_context.field_length)];
+    }
+
+    void set_field(const String &row, int32_t field) {
+      String qualifier = format("field%d", (int)field);
+      KeySpec key(row.c_str(), COLUMN_FAMILY, qualifier.c_str());
+      m_mutator->set(key, random_value(), m_context.field_length);
+    }
+
+    void insert_record(uint64_t keynum) {
+      String row = record_key(keynum);
+      for (int32_t i=0; i<m_context.field_count; i++)
+        set_field(row, i);
+    }
+
+    void update_record(const String &row) {
+      set_field(row, m_rng() % m_context.field_count);
+      m_mutator->flush();
+    }
+
+    void read_record(const String &row) {
+      ScanSpecBuilder ssb;
+      Cell cell;
+      ssb.add_row(row.c_str());
+      ssb.set_max_versions(1);
+      TableScannerPtr scanner = m_context.table->create_scanner(ssb.get());
+      size_t cells = 0;
+      while (scanner->next(cell))
+        cells++;
+      if (cells == 0)
+        HT_THROWF(Error::FAILED_EXPECTATION, "Record %s not found", row.c_str());
+    }
+
+    void scan_records(const String &start_row, int32_t count) {
+      ScanSpecBuilder ssb;
+      Cell cell;
+      ssb.add_row_interval(start_row.c_str(), true, Key::END_ROW_MARKER, true);
+      ssb.set_row_limit(count);
+      ssb.set_max_versions(1);
+      TableScannerPtr scanner = m_context.table->create_scanner(ssb.get());
+      while (scanner->next(cell))
+        ;
+    }
+
+    BenchmarkContext &m_context;
+    int32_t m_id;
+    uint64_t m_count;
+    ThreadResults &m_results;
+    boost::mt19937 m_rng;
+    std::vector<char> m_values;
+    TableMutatorPtr m_mutator;
+  };
+
+  void write_latency(ostream &out, const char *name,
+                     const LatencyHistogram &histogram) {
+    out << format("      \"%s\": { \"min\": %llu, \"mean\": %.1f, "
+                  "\"p50\": %llu, \"p90\": %llu, \"p95\": %llu, "
+                  "\"p99\": %llu, \"p99.9\": %llu, \"max\": %llu }",
+                  name, (Llu)histogram.percentile(0), histogram.mean(),
+                  (Llu)histogram.percentile(50), (Llu)histogram.percentile(90),
+                  (Llu)histogram.percentile(95), (Llu)histogram.percentile(99),
+                  (Llu)histogram.percentile(99.9), (Llu)histogram.max());
+  }
+
+  void write_results(ostream &out, BenchmarkContext &context,
+                     const String &table, Distribution distribution,
+                     uint64_t operation_count, double elapsed,
+                     ThreadResults &results) {
+    out << "{\n";
+    out << "  \"benchmark\": \"ycsb\",\n";
+    out << format("  \"workload\": \"%s\",\n", context.workload->name);
+    out << format("  \"phase\": \"%s\",\n", context.load ? "load" : "run");
+    out << format("  \"table\": \"%s\",\n", table.c_str());
+    out << format("  \"distribution\": \"%s\",\n",
+                  distribution_names[distribution]);
+    out << format("  \"threads\": %d,\n", (int)context.threads);
+    out << format("  \"target_ops_per_sec\": %d,\n", (int)context.target);
+    out << format("  \"coordinated_omission_corrected\": %s,\n",
+                  (!context.load && context.target > 0) ? "true" : "false");
+    out << format("  \"record_count\": %llu,\n", (Llu)context.record_count);
+    out << format("  \"operation_count\": %llu,\n", (Llu)operation_count);
+    out << format("  \"field_count\": %d,\n", (int)context.field_count);
+    out << format("  \"field_length\": %d,\n", (int)context.field_length);
+    out << format("  \"runtime_sec\": %.3f,\n", elapsed);
+    out << format("  \"operations_completed\": %llu,\n",
+                  (Llu)results.operations);
+    out << format("  \"throughput_ops_per_sec\": %.2f,\n",
+                  (double)results.operations / elapsed);
+    out << "  \"operations\": {";
+
+    bool first = true;
+    for (int i=0; i<OPERATION_MAX; i++) {
+      uint64_t count = results.latency[i].count();
+      if (context.load && i == INSERT)
+        count = results.operations;
+      if (count == 0 && results.errors[i] == 0)
+        continue;
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << format("    \"%s\": {\n", operation_names[i]);
+      out << format("      \"count\": %llu,\n", (Llu)count);
+      out << format("      \"errors\": %llu", (Llu)results.errors[i]);
+      if (!context.load) {
+        out << ",\n";
+        write_latency(out, "latency_us", results.latency[i]);
+        out << ",\n";
+        write_latency(out, "service_time_us", results.service_time[i]);
+      }
+      out << "\n    }";
+    }
+    out << "\n  }\n}\n";
+  }
+
+} // local namespace
+
+
+int main(int argc, char **argv) {
+  BenchmarkContext context;
+  Distribution distribution;
+  uint64_t operation_count;
+  String table_name;
+  ClientPtr client;
+  NamespacePtr ns;
+
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    if (!has("workload")) {
+      cout << cmdline_desc() << flush;
+      _exit(1);
+    }
+
+    String name = get_str("workload");
+    context.workload = 0;
+    for (const Workload *w = workloads; w->name; w++) {
+      if (name == w->name)
+        context.workload = w;
+    }
+    if (context.workload == 0)
+      HT_THROWF(Error::CONFIG_BAD_VALUE, "Unknown workload '%s'", name.c_str());
+
+    String phase = get_str("phase");
+    if (phase != "load" && phase != "run")
+      HT_THROWF(Error::CONFIG_BAD_VALUE, "Unknown phase '%s'", phase.c_str());
+
+    distribution = context.workload->distribution;
+    if (has("request-distribution")) {
+      String dist = get_str("request-distribution");
+      if (dist == "uniform")
+        distribution = UNIFORM;
+      else if (dist == "zipfian")
+        distribution = ZIPFIAN;
+      else if (dist == "latest")
+        distribution = LATEST;
+      else
+        HT_THROWF(Error::CONFIG_BAD_VALUE, "Unknown request distribution "
+                  "'%s'", dist.c_str());
+    }
+
+    double zipfian_constant = get_f64("zipfian-constant");
+    if (zipfian_constant <= 0.0 || zipfian_constant >= 1.0)
+      HT_THROW(Error::CONFIG_BAD_VALUE,
+               "zipfian-constant must be in the range (0, 1)");
+
+    table_name = get_str("table");
+    context.load = phase == "load";
+    context.record_count = get_i64("record-count");
+    context.threads = get_i32("threads");
+    context.target = get_i32("target");
+    context.field_count = get_i32("field-count");
+    context.field_length = get_i32("field-length");
+    context.max_scan_length = get_i32("max-scan-length");
+    context.seed = get_i32("seed");
+    operation_count = context.load ? context.record_count
+                                   : get_i64("operation-count");
+
+    if (context.record_count == 0 || context.threads <= 0 ||
+        context.field_count <= 0 || context.field_length <= 0 ||
+        context.max_scan_length <= 0)
+      HT_THROW(Error::CONFIG_BAD_VALUE, "record-count, threads, field-count, "
+               "field-length and max-scan-length must be positive");
+
+    client = new Hypertable::Client(System::locate_install_dir(argv[0]));
+    ns = client->open_namespace("/");
+    context.table = ns->open_table(table_name);
+  }
+  catch (Exception &e) {
+    cerr << "error: " << Error::get_text(e.code()) << " - " << e.what()
+         << endl;
+    _exit(1);
+  }
+
+  KeyChooser chooser(distribution, context.record_count,
+                     get_f64("zipfian-constant"), context.seed);
+  context.chooser = &chooser;
+
+  std::vector<ThreadResults> thread_results(context.threads);
+  boost::thread_group threads;
+
+  // build the shared generator before timing starts
+  if (!context.load)
+    chooser.next_key();
+
+  int64_t start = now_micros();
+
+  for (int32_t i=0; i<context.threads; i++) {
+    uint64_t count = operation_count / context.threads;
+    if ((uint64_t)i < operation_count % context.threads)
+      count++;
+    threads.create_thread(BenchmarkThread(context, i, count,
+                                          thread_results[i]));
+  }
+  threads.join_all();
+
+  double elapsed = (double)(now_micros() - start) / 1000000.0;
+
+  ThreadResults results;
+  for (size_t i=0; i<thread_results.size(); i++) {
+    results.operations += thread_results[i].operations;
+    for (int j=0; j<OPERATION_MAX; j++) {
+      results.latency[j].merge(thread_results[i].latency[j]);
+      results.service_time[j].merge(thread_results[i].service_time[j]);
+      results.errors[j] += thread_results[i].errors[j];
+    }
+  }
+
+  if (has("output")) {
+    ofstream out(get_str("output").c_str());
+    write_results(out, context, table_name, distribution, operation_count,
+                  elapsed, results);
+  }
+  else
+    write_results(cout, context, table_name, distribution, operation_count,
+                  elapsed, results);
+
+  cout << flush;
+  _exit(0); // don't bother with static objects
+}
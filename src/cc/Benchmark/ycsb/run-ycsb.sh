@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+#
+# Runs the YCSB core workloads A-F against a local single-node cluster and
+# writes one JSON result file per workload and phase to RESULTS_DIR.  The
+# table is recreated and reloaded before each workload so that the inserts
+# of workloads D and E do not affect the others.
+#
+
+HT_HOME=${INSTALL_DIR:-"$HOME/hypertable/current"}
+SCRIPT_DIR=`dirname $0`
+RECORD_COUNT=${RECORD_COUNT:-"1000000"}
+OPERATION_COUNT=${OPERATION_COUNT:-"1000000"}
+THREADS=${THREADS:-"16"}
+TARGET=${TARGET:-"0"}
+WORKLOADS=${WORKLOADS:-"a b c d e f"}
+RESULTS_DIR=${RESULTS_DIR:-"ycsb-results"}
+
+mkdir -p $RESULTS_DIR
+
+$HT_HOME/bin/start-test-servers.sh --clear --no-thriftbroker || exit 1
+
+for workload in $WORKLOADS; do
+
+  $HT_HOME/bin/hypertable --no-prompt < $SCRIPT_DIR/ycsb-create-table.hql \
+      || exit 1
+
+  $HT_HOME/bin/ht_ycsb $workload --phase=load --threads=$THREADS \
+      --record-count=$RECORD_COUNT \
+      --output=$RESULTS_DIR/workload-$workload-load.json || exit 1
+
+  $HT_HOME/bin/ht_ycsb $workload --phase=run --threads=$THREADS \
+      --record-count=$RECORD_COUNT --operation-count=$OPERATION_COUNT \
+      --target=$TARGET \
+      --output=$RESULTS_DIR/workload-$workload-run.json || exit 1
+
+done
+
+$HT_HOME/bin/stop-servers.sh
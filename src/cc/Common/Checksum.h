@@ -73,6 +73,30 @@ crc32(const void *data, size_t len);
 extern uint32_t
 crc32_update(uint32_t crc, const void *data, size_t len);
 
+/** Compute crc32c (Castagnoli) checksum.  Uses the SSE4.2 crc32
+ * instruction when the CPU supports it and a table driven
+ * implementation otherwise.
+ *
+ * @param data - input data
+ * @param len - input data length in bytes
+ */
+extern uint32_t
+crc32c(const void *data, size_t len);
+
+/** Update crc32c checksum incrementally
+ *
+ * @param crc - current crc32c checksum (0 to start)
+ * @param data - input data
+ * @param len - input data length in bytes
+ */
+extern uint32_t
+crc32c_update(uint32_t crc, const void *data, size_t len);
+
+/** Returns true if crc32c is computed with the SSE4.2 crc32 instruction
+ */
+extern bool
+crc32c_hardware_enabled();
+
 } // namespace Hypertable
 
 #endif /* HYPERTABLE_CHECKSUM_H */
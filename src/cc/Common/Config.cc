@@ -178,8 +178,19 @@ void DefaultPolicy::init_options() {
         "time, in milliseconds, before timing out requests (system wide)")
     ("Hypertable.MetaLog.SkipErrors", boo()->default_value(false), "Skipping "
         "errors instead of throwing exceptions on metalog errors")
+    ("Hypertable.MetaLog.Compaction.MinSize", i64()->default_value(4*MiB),
+        "Minimum metalog file size before it is considered for compaction")
+    ("Hypertable.MetaLog.Compaction.GarbageThreshold.Percentage",
+        i32()->default_value(50), "Rewrite a metalog as a snapshot of its live "
+        "entities once this percentage of it is superseded state")
     ("Hypertable.Network.Interface", str(),
      "Use this interface for network communication")
+    ("Hypertable.Network.Compression.Codec", str()->default_value("snappy"),
+     "Block codec used to compress scan results and updates sent to and "
+     "from RangeServers")
+    ("Hypertable.Network.Compression.Threshold", i32()->default_value(32*KiB),
+     "Compress scan result and update payloads of at least this many bytes "
+     "(0 disables compression)")
     ("CephBroker.Port", i16(),
      "Port number on which to listen (read by CephBroker only)")
     ("CephBroker.Workers", i32()->default_value(20),
@@ -278,6 +289,11 @@ void DefaultPolicy::init_options() {
     ("Hypertable.LoadBalancer.LoadavgThreshold", f64()->default_value(0.25),
         "Servers with loadavg above this much above the mean will be considered by the "
         "load balancer to be overloaded")
+    ("Hypertable.LoadBalancer.Algorithm", str()->default_value("load"),
+        "Algorithm used for scheduled load balancing (load, heat)")
+    ("Hypertable.LoadBalancer.Heat.Threshold", f64()->default_value(0.2),
+        "Servers whose read/write heat exceeds the mean by more than this "
+        "fraction are considered overloaded by the heat balancer")
     ("Hypertable.HqlInterpreter.Mutator.NoLogSync", boo()->default_value(false),
         "Suspends CommitLog sync operation on updates until command completion")
     ("Hypertable.RangeLocator.MetadataReadaheadCount", i32()->default_value(10),
@@ -298,6 +314,9 @@ void DefaultPolicy::init_options() {
         "all servers to trigger a scatter buffer flush")
     ("Hypertable.Scanner.QueueSize",
      i32()->default_value(5), "Size of Scanner ScanBlock queue")
+    ("Hypertable.Scanner.Parallelism",
+     i32()->default_value(8), "Number of ranges scanned concurrently by "
+        "scanners created with the parallel or unordered scanner flag")
     ("Hypertable.LocationCache.MaxEntries", i64()->default_value(1*M),
         "Size of range location cache in number of entries")
     ("Hypertable.Master.Host", str(),
@@ -357,6 +376,15 @@ void DefaultPolicy::init_options() {
         "CellStores in which merges will be considered")
     ("Hypertable.RangeServer.CellStore.Merge.RunLengthThreshold", i32()->default_value(10),
         "Trigger a merge if an adjacent run of merge candidate CellStores exceeds this length")
+    ("Hypertable.RangeServer.CellStore.Merge.TimeWindow", i32()->default_value(86400),
+        "Width in seconds of the time buckets used by the 'timewindow' compaction strategy")
+    ("Hypertable.RangeServer.ValueLog.MaxOpenFiles", i32()->default_value(256),
+        "Number of value log files kept open for reading values moved out "
+        "of CellStores")
+    ("Hypertable.RangeServer.BlockChecksum.CRC32C", boo()->default_value(false),
+        "Checksum newly written CellStore and commit log blocks with CRC32C "
+        "instead of fletcher32 (blocks are unreadable by servers that "
+        "predate CRC32C)")
     ("Hypertable.RangeServer.CellStore.DefaultBlockSize",
         i32()->default_value(64*KiB), "Default block size for cell stores")
     ("Hypertable.RangeServer.Data.DefaultReplication",
@@ -365,20 +393,50 @@ void DefaultPolicy::init_options() {
         str()->default_value("snappy"), "Default compressor for cell stores")
     ("Hypertable.RangeServer.CellStore.DefaultBloomFilter",
         str()->default_value("rows"), "Default bloom filter for cell stores")
+    ("Hypertable.RangeServer.CellStore.KeyCompression",
+        str()->default_value("prefix"), "Key compression scheme for new cell "
+        "stores, either 'prefix' or 'delta'.  Cell stores written with "
+        "'delta' cannot be read by servers that predate it")
     ("Hypertable.RangeServer.CellStore.SkipNotFound",
         boo()->default_value(false), "Skip over cell stores that are non-existent")
+    ("Hypertable.RangeServer.CellStore.Mmap", boo()->default_value(false),
+        "Memory-map uncompressed cell stores and scan them straight from the "
+        "page cache (only used with the local broker, see DfsBroker.Local.Root)")
+    ("Hypertable.RangeServer.CellStore.LazyIndex", boo()->default_value(false),
+        "Defer loading CellStore block indexes during startup so ranges come "
+        "online as soon as their commit logs are replayed; the indexes are "
+        "then loaded in the background or on first access")
     ("Hypertable.RangeServer.IgnoreClockSkewErrors",
         boo()->default_value(false), "Ignore clock skew errors")
     ("Hypertable.RangeServer.CommitInterval", i32()->default_value(50),
      "Default minimum group commit interval in milliseconds")
+    ("Hypertable.RangeServer.GroupCommit.Adaptive", boo()->default_value(false),
+     "Size the group commit window from observed sync cost and arrival rate "
+     "instead of flushing each table on its fixed interval")
+    ("Hypertable.RangeServer.GroupCommit.TargetLatency", i32()->default_value(20),
+     "Target latency in milliseconds (batch wait plus sync) for adaptive "
+     "group commit")
+    ("Hypertable.RangeServer.GroupCommit.FlushThreshold", i64()->default_value(4*MiB),
+     "Flush an adaptive group commit batch early once it holds this many bytes")
     ("Hypertable.RangeServer.BlockCache.Compressed", boo()->default_value(true),
         "Controls whether or not block cache stores compressed blocks")
     ("Hypertable.RangeServer.BlockCache.MinMemory", i64()->default_value(0),
         "Minimum size of block cache")
     ("Hypertable.RangeServer.BlockCache.MaxMemory", i64()->default_value(-1),
         "Maximum (target) size of block cache")
+    ("Hypertable.RangeServer.BlockCache.Ssd.Directory", str()->default_value(""),
+        "Local directory (ideally on SSD) for a second block cache tier that "
+        "holds compressed blocks read from the DFS")
+    ("Hypertable.RangeServer.BlockCache.Ssd.MaxSize", i64()->default_value(0),
+        "Maximum size of the SSD block cache file (0 disables the tier)")
+    ("Hypertable.RangeServer.BlockCache.Ssd.WriteBuffer", i64()->default_value(32*M),
+        "Maximum amount of block data waiting to be written to the SSD block "
+        "cache; blocks are dropped rather than queued beyond this")
     ("Hypertable.RangeServer.QueryCache.MaxMemory", i64()->default_value(50*M),
         "Maximum size of query cache")
+    ("Hypertable.RangeServer.RowCache.MaxMemory", i64()->default_value(0),
+        "Maximum size of the cache of CellStore rows used to serve single-row "
+        "scans (0 disables it)")
     ("Hypertable.RangeServer.Range.RowSize.Unlimited", boo()->default_value(false),
      "Marks range active and unsplittable upon encountering row overflow condition. "
      "Can cause ranges to grow extremely large.  Use with caution!")
@@ -386,6 +444,12 @@ void DefaultPolicy::init_options() {
         "Size of range in bytes before splitting")
     ("Hypertable.RangeServer.Range.MaximumSize", i64()->default_value(3*G),
         "Maximum size of a range in bytes before updates get throttled")
+    ("Hypertable.RangeServer.Range.SplitLoad.Rate", i32()->default_value(0),
+        "Request rate (scans + updates per second) above which a range is "
+        "split at its load median instead of waiting to reach SplitSize "
+        "(0 disables load splitting)")
+    ("Hypertable.RangeServer.Range.SplitLoad.MinimumSize", i64()->default_value(16*MiB),
+        "Minimum size of a range in bytes before it is split by load")
     ("Hypertable.RangeServer.Range.MetadataSplitSize", i64(), "Size of METADATA "
         "range in bytes before splitting (for testing)")
     ("Hypertable.RangeServer.Range.SplitOff", str()->default_value("high"),
@@ -410,6 +474,10 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.CommitLog.Compressor",
         str()->default_value("quicklz"),
        "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+    ("Hypertable.RangeServer.CommitLog.UserStreams", i32()->default_value(1),
+        "Number of commit log streams that USER table updates are spread "
+        "across by table, each written and synced by its own thread.  A "
+        "group commit still waits for every stream it touched")
     ("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval", i32()->default_value(0),
         "TESTING:  After update, if range needs maintenance, pause for this number of milliseconds")
     ("Hypertable.RangeServer.UpdateCoalesceLimit", i64()->default_value(5*M),
@@ -442,6 +510,10 @@ void DefaultPolicy::init_options() {
         "Millisecond delay before scheduling merging compactions in non-low memory mode")
     ("Hypertable.RangeServer.Maintenance.MoveCompactionsPerInterval", i32()->default_value(2),
         "Limit on number of major compactions due to move per maintenance interval")
+    ("Hypertable.RangeServer.Maintenance.Compaction.MaxBandwidth", i32()->default_value(0),
+        "Limit in MB/s on the CellStore data read by merging, major and GC "
+        "compactions, and on merging compactions scheduled per interval "
+        "(0 means unlimited)")
     ("Hypertable.RangeServer.Monitoring.DataDirectories", str()->default_value("/"),
         "Comma-separated list of directory mount points of disk volumes to monitor")
     ("Hypertable.RangeServer.Workers", i32()->default_value(50),
@@ -450,6 +522,9 @@ void DefaultPolicy::init_options() {
         "Number of Range Server communication reactor threads created")
     ("Hypertable.RangeServer.MaintenanceThreads", i32(),
         "Number of maintenance threads.  Default is min(2, number-of-cores).")
+    ("Hypertable.RangeServer.LoadThreads", i32()->default_value(8),
+        "Number of threads used to load ranges and deferred CellStore "
+        "indexes on startup")
     ("Hypertable.RangeServer.UpdateDelay", i32()->default_value(0),
         "Number of milliseconds to wait before carrying out an update (TESTING)")
     ("Hypertable.RangeServer.ProxyName", str()->default_value(""),
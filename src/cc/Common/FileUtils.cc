@@ -169,6 +169,31 @@ ssize_t FileUtils::write(int fd, const void *vptr, size_t n) {
   return n - nleft;
 }
 
+ssize_t FileUtils::pwrite(int fd, const void *vptr, size_t n, off_t offset) {
+  size_t nleft;
+  ssize_t nwritten;
+  const char *ptr;
+
+  ptr = (const char *)vptr;
+  nleft = n;
+  while (nleft > 0) {
+    if ((nwritten = ::pwrite(fd, ptr, nleft, offset)) <= 0) {
+      if (errno == EINTR)
+        nwritten = 0; /* and call pwrite() again */
+      else if (errno == EAGAIN)
+        break;
+      else {
+        return -1; /* error */
+      }
+    }
+
+    nleft -= nwritten;
+    ptr   += nwritten;
+    offset += nwritten;
+  }
+  return n - nleft;
+}
+
 ssize_t FileUtils::writev(int fd, const struct iovec *vector, int count) {
   ssize_t nwritten;
   while ((nwritten = ::writev(fd, vector, count)) <= 0) {
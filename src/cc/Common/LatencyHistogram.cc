@@ -0,0 +1,165 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Compat.h"
+#include "Error.h"
+#include "Logger.h"
+#include "LatencyHistogram.h"
+#include "Serialization.h"
+
+#include <cstring>
+
+using namespace Hypertable;
+
+void LatencyHistogram::clear() {
+  memset(m_buckets, 0, sizeof(m_buckets));
+  m_count = m_sum = m_max = 0;
+}
+
+/**
+ * Values below 2*SUB_BUCKET_COUNT map to themselves.  Above that, the
+ * value is shifted right until it fits in [SUB_BUCKET_COUNT,
+ * 2*SUB_BUCKET_COUNT) and the shift selects the group of buckets.
+ */
+size_t LatencyHistogram::bucket_index(uint64_t value) {
+  if (value < (uint64_t)(2 * SUB_BUCKET_COUNT))
+    return (size_t)value;
+  if (value >> MAX_VALUE_BITS)
+    return BUCKET_COUNT - 1;
+  int msb = 63 - __builtin_clzll(value);
+  int shift = msb - SUB_BUCKET_BITS;
+  return (size_t)shift * SUB_BUCKET_COUNT + (size_t)(value >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_lowest_value(size_t index) {
+  if (index < (size_t)(2 * SUB_BUCKET_COUNT))
+    return index;
+  size_t shift = index / SUB_BUCKET_COUNT - 1;
+  return (uint64_t)(index - shift * SUB_BUCKET_COUNT) << shift;
+}
+
+uint64_t LatencyHistogram::bucket_highest_value(size_t index) {
+  if (index < (size_t)(2 * SUB_BUCKET_COUNT))
+    return index;
+  size_t shift = index / SUB_BUCKET_COUNT - 1;
+  return bucket_lowest_value(index) + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (size_t i=0; i<BUCKET_COUNT; i++)
+    m_buckets[i] += other.m_buckets[i];
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  if (other.m_max > m_max)
+    m_max = other.m_max;
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram &earlier) {
+  for (size_t i=0; i<BUCKET_COUNT; i++)
+    m_buckets[i] -= earlier.m_buckets[i];
+  m_count -= earlier.m_count;
+  m_sum -= earlier.m_sum;
+  // Bound the maximum by the highest bucket still populated
+  size_t i = BUCKET_COUNT;
+  while (i > 0 && m_buckets[i-1] == 0)
+    i--;
+  if (i == 0)
+    m_max = 0;
+  else if (bucket_highest_value(i-1) < m_max)
+    m_max = bucket_highest_value(i-1);
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const {
+  if (m_count == 0)
+    return 0;
+  if (percentile > 100.0)
+    percentile = 100.0;
+  uint64_t target = (uint64_t)((percentile / 100.0) * m_count + 0.5);
+  if (target == 0)
+    target = 1;
+  uint64_t running = 0;
+  for (size_t i=0; i<BUCKET_COUNT; i++) {
+    running += m_buckets[i];
+    if (running >= target) {
+      uint64_t value = bucket_highest_value(i);
+      return value < m_max ? value : m_max;
+    }
+  }
+  return m_max;
+}
+
+/**
+ * Only non-empty buckets are encoded, as (index, count) pairs.
+ */
+size_t LatencyHistogram::encoded_length() const {
+  size_t len = 0;
+  uint32_t nonzero = 0;
+  for (size_t i=0; i<BUCKET_COUNT; i++) {
+    if (m_buckets[i]) {
+      len += Serialization::encoded_length_vi32(i) +
+        Serialization::encoded_length_vi64(m_buckets[i]);
+      nonzero++;
+    }
+  }
+  return len + Serialization::encoded_length_vi32(nonzero) +
+    Serialization::encoded_length_vi64(m_count) +
+    Serialization::encoded_length_vi64(m_sum) +
+    Serialization::encoded_length_vi64(m_max);
+}
+
+void LatencyHistogram::encode(uint8_t **bufp) const {
+  uint32_t nonzero = 0;
+  for (size_t i=0; i<BUCKET_COUNT; i++)
+    if (m_buckets[i])
+      nonzero++;
+  Serialization::encode_vi64(bufp, m_count);
+  Serialization::encode_vi64(bufp, m_sum);
+  Serialization::encode_vi64(bufp, m_max);
+  Serialization::encode_vi32(bufp, nonzero);
+  for (size_t i=0; i<BUCKET_COUNT; i++) {
+    if (m_buckets[i]) {
+      Serialization::encode_vi32(bufp, i);
+      Serialization::encode_vi64(bufp, m_buckets[i]);
+    }
+  }
+}
+
+void LatencyHistogram::decode(const uint8_t **bufp, size_t *remainp) {
+  clear();
+  m_count = Serialization::decode_vi64(bufp, remainp);
+  m_sum = Serialization::decode_vi64(bufp, remainp);
+  m_max = Serialization::decode_vi64(bufp, remainp);
+  uint32_t nonzero = Serialization::decode_vi32(bufp, remainp);
+  for (uint32_t i=0; i<nonzero; i++) {
+    uint32_t index = Serialization::decode_vi32(bufp, remainp);
+    uint64_t count = Serialization::decode_vi64(bufp, remainp);
+    if (index >= BUCKET_COUNT)
+      HT_THROWF(Error::PROTOCOL_ERROR, "Latency histogram bucket index %u "
+                "out of range", (unsigned)index);
+    m_buckets[index] = count;
+  }
+}
+
+bool LatencyHistogram::operator==(const LatencyHistogram &other) const {
+  return m_count == other.m_count && m_sum == other.m_sum &&
+    m_max == other.m_max &&
+    !memcmp(m_buckets, other.m_buckets, sizeof(m_buckets));
+}
@@ -0,0 +1,110 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_LATENCYHISTOGRAM_H
+#define HYPERTABLE_LATENCYHISTOGRAM_H
+
+extern "C" {
+#include <stddef.h>
+#include <stdint.h>
+}
+
+namespace Hypertable {
+
+  /**
+   * Log-linear latency histogram in the style of HdrHistogram.  Values
+   * are microseconds.  Each power-of-two interval is split into
+   * SUB_BUCKET_COUNT linear buckets, so any recorded value is reported
+   * with a relative error of at most 1/SUB_BUCKET_COUNT.  Values at or
+   * above 2^40 microseconds (about 12 days) land in the last bucket.
+   *
+   * A histogram is not thread safe; concurrent recording is handled by
+   * LatencyRecorder, which keeps one histogram per thread.
+   */
+  class LatencyHistogram {
+  public:
+    enum {
+      SUB_BUCKET_BITS = 4,
+      SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+      MAX_VALUE_BITS = 40,
+      BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT
+                     + 2 * SUB_BUCKET_COUNT
+    };
+
+    LatencyHistogram() { clear(); }
+
+    void clear();
+
+    /** Records a single latency measurement.
+     * @param usec latency in microseconds
+     */
+    void record(int64_t usec) {
+      uint64_t value = usec < 0 ? 0 : (uint64_t)usec;
+      m_buckets[bucket_index(value)]++;
+      m_count++;
+      m_sum += value;
+      if (value > m_max)
+        m_max = value;
+    }
+
+    /** Adds the contents of another histogram to this one. */
+    void merge(const LatencyHistogram &other);
+
+    /** Removes the contents of an earlier snapshot of the same histogram,
+     * leaving only what was recorded since.  The maximum cannot be
+     * un-merged exactly, so it is bounded by the highest populated bucket.
+     */
+    void subtract(const LatencyHistogram &earlier);
+
+    uint64_t count() const { return m_count; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? (double)m_sum / m_count : 0.0; }
+
+    /** Returns the latency at or below which the given percentage of
+     * measurements fall.
+     * @param percentile percentile in the range [0, 100]
+     * @return latency in microseconds
+     */
+    uint64_t percentile(double percentile) const;
+
+    size_t encoded_length() const;
+    void encode(uint8_t **bufp) const;
+    void decode(const uint8_t **bufp, size_t *remainp);
+
+    bool operator==(const LatencyHistogram &other) const;
+    bool operator!=(const LatencyHistogram &other) const {
+      return !(*this == other);
+    }
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_lowest_value(size_t index);
+    static uint64_t bucket_highest_value(size_t index);
+
+  private:
+    uint64_t m_buckets[BUCKET_COUNT];
+    uint64_t m_count;
+    uint64_t m_sum;
+    uint64_t m_max;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_LATENCYHISTOGRAM_H
@@ -0,0 +1,60 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Compat.h"
+#include "LatencyRecorder.h"
+
+using namespace Hypertable;
+
+LatencyRecorder::LatencyRecorder(size_t metric_count)
+  : m_metric_count(metric_count), m_slot(release_slot) {
+}
+
+LatencyRecorder::~LatencyRecorder() {
+  m_slot.reset();
+  for (size_t i=0; i<m_slots.size(); i++)
+    delete m_slots[i];
+}
+
+LatencyRecorder::Slot *LatencyRecorder::register_slot() {
+  Slot *slot = new Slot(m_metric_count);
+  {
+    ScopedLock lock(m_mutex);
+    m_slots.push_back(slot);
+  }
+  m_slot.reset(slot);
+  return slot;
+}
+
+/**
+ * Slots are read while their owning threads may still be writing to
+ * them.  Counters are word sized so a concurrent read sees either the
+ * old or the new value; a measurement in flight may be partially
+ * reflected, which is acceptable for monitoring.
+ */
+void LatencyRecorder::aggregate(std::vector<LatencyHistogram> &histograms) {
+  ScopedLock lock(m_mutex);
+  histograms.clear();
+  histograms.resize(m_metric_count);
+  for (size_t i=0; i<m_slots.size(); i++)
+    for (size_t j=0; j<m_metric_count; j++)
+      histograms[j].merge(m_slots[i]->histograms[j]);
+}
@@ -0,0 +1,80 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_LATENCYRECORDER_H
+#define HYPERTABLE_LATENCYRECORDER_H
+
+#include <vector>
+
+#include <boost/thread/tss.hpp>
+
+#include "LatencyHistogram.h"
+#include "Mutex.h"
+
+namespace Hypertable {
+
+  /**
+   * Records latencies for a fixed set of metrics into per-thread
+   * histograms.  Recording touches only the calling thread's histograms
+   * and takes no lock; the mutex is taken only the first time a thread
+   * records and when the histograms are aggregated.  Per-thread
+   * histograms outlive their threads so no measurements are lost.
+   */
+  class LatencyRecorder {
+  public:
+    LatencyRecorder(size_t metric_count);
+    ~LatencyRecorder();
+
+    /** Records a latency measurement for the given metric.
+     * @param metric metric index, less than the metric count
+     * @param usec latency in microseconds
+     */
+    void record(size_t metric, int64_t usec) {
+      Slot *slot = m_slot.get();
+      if (slot == 0)
+        slot = register_slot();
+      slot->histograms[metric].record(usec);
+    }
+
+    /** Merges the histograms of all threads.
+     * @param histograms filled in with one histogram per metric
+     */
+    void aggregate(std::vector<LatencyHistogram> &histograms);
+
+  private:
+    struct Slot {
+      Slot(size_t count) : histograms(count) { }
+      std::vector<LatencyHistogram> histograms;
+    };
+
+    static void release_slot(Slot *) { }
+
+    Slot *register_slot();
+
+    Mutex m_mutex;
+    size_t m_metric_count;
+    boost::thread_specific_ptr<Slot> m_slot;
+    std::vector<Slot *> m_slots;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_LATENCYRECORDER_H
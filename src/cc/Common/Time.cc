@@ -95,6 +95,19 @@ int64_t xtime_diff_millis(boost::xtime &early_xt, boost::xtime &late_xt) {
   return total_millis;
 }
 
+int64_t xtime_diff_micros(boost::xtime &early_xt, boost::xtime &late_xt) {
+  int64_t total_micros;
+
+  if (early_xt.sec > late_xt.sec ||
+      (early_xt.sec == late_xt.sec && early_xt.nsec > late_xt.nsec))
+    return 0;
+
+  total_micros = ((int64_t)late_xt.sec - (int64_t)early_xt.sec) * 1000000LL;
+  total_micros += ((int64_t)late_xt.nsec - (int64_t)early_xt.nsec) / 1000;
+
+  return total_micros;
+}
+
 std::ostream &hires_ts(std::ostream &out) {
   HiResTime now;
   return out << now.sec <<'.'<< setw(9) << setfill('0') << now.nsec;
@@ -0,0 +1,72 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Checksum.h"
+#include "Common/Logger.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace Hypertable;
+
+namespace {
+
+  /** Bitwise reference implementation of crc32c */
+  uint32_t crc32c_reference(const uint8_t *data, size_t len) {
+    uint32_t crc = ~0U;
+    while (len--) {
+      crc ^= *data++;
+      for (int k = 0; k < 8; k++)
+        crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+    }
+    return ~crc;
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+
+  HT_INFOF("crc32c hardware acceleration %s",
+           crc32c_hardware_enabled() ? "enabled" : "disabled");
+
+  // Check value from RFC 3720 and the usual test vector
+  HT_ASSERT(crc32c("123456789", 9) == 0xE3069283);
+  HT_ASSERT(crc32c("", 0) == 0);
+
+  std::vector<uint8_t> buf(4200);
+  srand(1);
+  for (size_t i=0; i<buf.size(); i++)
+    buf[i] = (uint8_t)rand();
+
+  // All alignments and tail lengths agree with the reference
+  for (size_t offset=0; offset<16; offset++) {
+    for (size_t len=0; len<4096; len += 13) {
+      uint32_t expected = crc32c_reference(&buf[offset], len);
+      HT_ASSERT(crc32c(&buf[offset], len) == expected);
+      uint32_t crc = crc32c(&buf[offset], len/3);
+      crc = crc32c_update(crc, &buf[offset+len/3], len - len/3);
+      HT_ASSERT(crc == expected);
+    }
+  }
+
+  return 0;
+}
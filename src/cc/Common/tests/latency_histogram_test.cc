@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include "Common/Compat.h"
+#include "Common/LatencyHistogram.h"
+#include "Common/LatencyRecorder.h"
+#include "Common/Logger.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+using namespace Hypertable;
+
+namespace {
+
+  LatencyRecorder *recorder;
+
+  void record_values() {
+    for (int64_t i=1; i<=1000; i++)
+      recorder->record(0, i);
+  }
+
+}
+
+int main(int argc, char *argv[]) {
+
+  // Bucket boundaries are contiguous and values map into their bucket
+  for (size_t i=1; i<LatencyHistogram::BUCKET_COUNT; i++)
+    HT_ASSERT(LatencyHistogram::bucket_lowest_value(i) ==
+              LatencyHistogram::bucket_highest_value(i-1) + 1);
+  for (uint64_t v=0; v<(1ULL<<20); v += 7) {
+    size_t index = LatencyHistogram::bucket_index(v);
+    HT_ASSERT(v >= LatencyHistogram::bucket_lowest_value(index) &&
+              v <= LatencyHistogram::bucket_highest_value(index));
+  }
+  HT_ASSERT(LatencyHistogram::bucket_index(1ULL<<50) ==
+            LatencyHistogram::BUCKET_COUNT - 1);
+
+  // Percentiles are within the bucket precision
+  LatencyHistogram hist;
+  for (int64_t i=1; i<=100000; i++)
+    hist.record(i);
+  HT_ASSERT(hist.count() == 100000);
+  HT_ASSERT(hist.max() == 100000);
+  uint64_t p50 = hist.percentile(50.0);
+  uint64_t p99 = hist.percentile(99.0);
+  HT_ASSERT(p50 >= 50000 && p50 <= 50000 + 50000/LatencyHistogram::SUB_BUCKET_COUNT);
+  HT_ASSERT(p99 >= 99000 && p99 <= 99000 + 99000/LatencyHistogram::SUB_BUCKET_COUNT);
+  HT_ASSERT(hist.percentile(100.0) == 100000);
+
+  // Serialization round trip
+  size_t len = hist.encoded_length();
+  std::vector<uint8_t> buf(len);
+  uint8_t *ptr = &buf[0];
+  hist.encode(&ptr);
+  HT_ASSERT((size_t)(ptr - &buf[0]) == len);
+  LatencyHistogram hist2;
+  const uint8_t *cptr = &buf[0];
+  hist2.decode(&cptr, &len);
+  HT_ASSERT(len == 0);
+  HT_ASSERT(hist == hist2);
+
+  // Per-thread recording, aggregated and differenced
+  recorder = new LatencyRecorder(2);
+  boost::thread_group threads;
+  for (int i=0; i<4; i++)
+    threads.create_thread(record_values);
+  threads.join_all();
+
+  std::vector<LatencyHistogram> earlier;
+  recorder->aggregate(earlier);
+  HT_ASSERT(earlier.size() == 2);
+  HT_ASSERT(earlier[0].count() == 4000);
+  HT_ASSERT(earlier[1].count() == 0);
+
+  // Aggregating is cumulative, so one reader does not reset another
+  std::vector<LatencyHistogram> histograms;
+  recorder->aggregate(histograms);
+  HT_ASSERT(histograms[0] == earlier[0]);
+
+  recorder->record(1, 5);
+  recorder->aggregate(histograms);
+  HT_ASSERT(histograms[0].count() == 4000);
+  HT_ASSERT(histograms[1].count() == 1);
+  for (size_t i=0; i<histograms.size(); i++)
+    histograms[i].subtract(earlier[i]);
+  HT_ASSERT(histograms[0].count() == 0);
+  HT_ASSERT(histograms[0].max() == 0);
+  HT_ASSERT(histograms[1].count() == 1);
+  HT_ASSERT(histograms[1].max() == 5);
+
+  delete recorder;
+  return 0;
+}
@@ -33,6 +33,18 @@ using namespace Hypertable;
 using namespace Serialization;
 
 const size_t BlockCompressionHeader::LENGTH;
+const uint8_t BlockCompressionHeader::CHECKSUM_CRC32C_FLAG;
+
+BlockCompressionHeader::ChecksumType
+BlockCompressionHeader::default_checksum_type = BlockCompressionHeader::FLETCHER32;
+
+
+uint32_t
+BlockCompressionHeader::compute_data_checksum(const void *data, size_t len) {
+  if (m_checksum_type == CRC32C)
+    return crc32c(data, len);
+  return fletcher32(data, len);
+}
 
 
 /**
@@ -42,7 +54,8 @@ void BlockCompressionHeader::encode(uint8_t **bufp) {
   memcpy(*bufp, m_magic, 10);
   (*bufp) += 10;
   *(*bufp)++ = (uint8_t)length();
-  *(*bufp)++ = (uint8_t)m_compression_type;
+  *(*bufp)++ = (uint8_t)m_compression_type |
+    (m_checksum_type == CRC32C ? CHECKSUM_CRC32C_FLAG : 0);
   encode_i32(bufp, m_data_checksum);
   encode_i32(bufp, m_data_length);
   encode_i32(bufp, m_data_zlength);
@@ -89,6 +102,12 @@ void BlockCompressionHeader::decode(const uint8_t **bufp, size_t *remainp) {
               ": %lu, expecting: %lu", (Lu)header_length, (Lu)length());
 
   m_compression_type = decode_byte(bufp, remainp);
+  if (m_compression_type & CHECKSUM_CRC32C_FLAG) {
+    m_checksum_type = CRC32C;
+    m_compression_type &= ~CHECKSUM_CRC32C_FLAG;
+  }
+  else
+    m_checksum_type = FLETCHER32;
 
   if (m_compression_type >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
     HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Unsupported compression type "
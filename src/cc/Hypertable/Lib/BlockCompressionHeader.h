@@ -32,12 +32,29 @@ namespace Hypertable {
 
     static const size_t LENGTH = 26;
 
+    /** Algorithm used for the data checksum.  It is recorded in the high
+     * bit of the compression type byte, so blocks written before CRC32C
+     * was introduced decode as FLETCHER32.
+     */
+    enum ChecksumType { FLETCHER32=0, CRC32C=1 };
+
+    static const uint8_t CHECKSUM_CRC32C_FLAG = 0x80;
+
+    /** Checksum type given to newly constructed headers.  Defaults to
+     * FLETCHER32 so that blocks stay readable by servers that predate
+     * CRC32C; set from Hypertable.RangeServer.BlockChecksum.CRC32C.
+     */
+    static ChecksumType default_checksum_type;
+
     BlockCompressionHeader() : m_data_length(0), m_data_zlength(0),
-        m_data_checksum(0), m_compression_type((uint16_t)-1) { }
+        m_data_checksum(0), m_compression_type((uint16_t)-1),
+        m_checksum_type(default_checksum_type) { }
 
     BlockCompressionHeader(const char *magic)
       : m_data_length(0), m_data_zlength(0), m_data_checksum(0),
-        m_compression_type((uint16_t)-1) { memcpy(m_magic, magic, 10); }
+        m_compression_type((uint16_t)-1), m_checksum_type(default_checksum_type) {
+      memcpy(m_magic, magic, 10);
+    }
 
     virtual ~BlockCompressionHeader() { return; }
 
@@ -58,6 +75,16 @@ namespace Hypertable {
     void     set_compression_type(uint16_t type) { m_compression_type = type; }
     uint16_t get_compression_type() { return m_compression_type; }
 
+    void     set_checksum_type(uint8_t type) { m_checksum_type = type; }
+    uint8_t  get_checksum_type() { return m_checksum_type; }
+
+    /** Computes the data checksum with the algorithm of this header
+     * @param data data to checksum
+     * @param len length of data
+     * @return checksum
+     */
+    uint32_t compute_data_checksum(const void *data, size_t len);
+
     virtual size_t length() { return LENGTH; }
     virtual void   encode(uint8_t **bufp);
     virtual void   write_header_checksum(uint8_t *base, uint8_t **bufp);
@@ -69,6 +96,7 @@ namespace Hypertable {
     uint32_t m_data_zlength;
     uint32_t m_data_checksum;
     uint16_t m_compression_type;
+    uint8_t  m_checksum_type;
   };
 
 }
@@ -61,12 +61,14 @@ CommitLog::~CommitLog() {
 
 void
 CommitLog::initialize(const String &log_dir, PropertiesPtr &props,
-                      CommitLogBase *init_log, bool is_meta) {
+                      CommitLogBase *init_log, bool is_meta,
+                      uint32_t stream, uint32_t stream_count) {
   String compressor;
 
   m_log_dir = log_dir;
   m_cur_fragment_length = 0;
   m_cur_fragment_num = 0;
+  m_fragment_num_stride = stream_count;
   m_needs_roll = false;
   m_replication = -1;
   m_purge_report_revision = TIMESTAMP_NULL;
@@ -108,6 +110,11 @@ CommitLog::initialize(const String &log_dir, PropertiesPtr &props,
     }
   }
 
+  // Round up to the next fragment number owned by this stream
+  HT_ASSERT(stream < stream_count);
+  m_cur_fragment_num += (stream + stream_count
+                         - (m_cur_fragment_num % stream_count)) % stream_count;
+
   if (m_range_reference_required)
     HT_INFOF("Range reference for '%s' is required", m_log_dir.c_str());
   else
@@ -219,7 +226,7 @@ int CommitLog::link_log(CommitLogBase *log_base) {
   header.set_compression_type(BlockCompressionCodec::NONE);
   header.set_data_length(log_dir.length() + 1);
   header.set_data_zlength(log_dir.length() + 1);
-  header.set_data_checksum(fletcher32(log_dir.c_str(), log_dir.length()+1));
+  header.set_data_checksum(header.compute_data_checksum(log_dir.c_str(), log_dir.length()+1));
 
   header.encode(&input.ptr);
   input.add(log_dir.c_str(), log_dir.length() + 1);
@@ -448,7 +455,7 @@ int CommitLog::roll(CommitLogFileInfo **clfip) {
     m_latest_revision = TIMESTAMP_MIN;
     m_cur_fragment_length = 0;
 
-    m_cur_fragment_num++;
+    m_cur_fragment_num += m_fragment_num_stride;
     m_cur_fragment_fname = m_log_dir + "/" + m_cur_fragment_num;
 
   }
@@ -517,14 +524,14 @@ void CommitLog::load_cumulative_size_map(CumulativeSizeMap &cumulative_size_map)
   if (m_latest_revision != TIMESTAMP_MIN) {
     frag_data.size = m_cur_fragment_length;
     frag_data.fragno = m_cur_fragment_num;
-    cumulative_size_map[m_latest_revision] = frag_data;
+    add_cumulative_fragment(cumulative_size_map, m_latest_revision, frag_data);
   }
 
   for (std::deque<CommitLogFileInfo *>::reverse_iterator iter
        = m_fragment_queue.rbegin(); iter != m_fragment_queue.rend(); ++iter) {
     frag_data.size = (*iter)->size;
     frag_data.fragno = (*iter)->num;
-    cumulative_size_map[(*iter)->revision] = frag_data;
+    add_cumulative_fragment(cumulative_size_map, (*iter)->revision, frag_data);
   }
 
   for (CumulativeSizeMap::reverse_iterator riter = cumulative_size_map.rbegin();
@@ -537,6 +544,22 @@ void CommitLog::load_cumulative_size_map(CumulativeSizeMap &cumulative_size_map)
 }
 
 
+/**
+ * Streams of the same log directory write fragments with the same revision,
+ * so a fragment whose revision is already in the map adds its size to that
+ * entry instead of replacing it.
+ */
+void CommitLog::add_cumulative_fragment(CumulativeSizeMap &cumulative_size_map,
+                                        int64_t revision,
+                                        const CumulativeFragmentData &frag_data) {
+  CumulativeSizeMap::iterator iter = cumulative_size_map.find(revision);
+  if (iter == cumulative_size_map.end())
+    cumulative_size_map[revision] = frag_data;
+  else
+    (*iter).second.size += frag_data.size;
+}
+
+
 void CommitLog::get_stats(const String &prefix, String &result) {
   ScopedLock lock(m_mutex);
 
@@ -62,6 +62,11 @@ namespace Hypertable {
    *<pre>
    * Hypertable.RangeServer.CommitLog.RollLimit
    *</pre>
+   *
+   * Several commit logs may write into the same directory as independent
+   * streams.  Stream <i>k</i> of <i>n</i> only uses fragment numbers that
+   * are congruent to <i>k</i> modulo <i>n</i>, so a CommitLogReader on the
+   * directory sees the fragments of all streams.
    */
 
   class CommitLog : public CommitLogBase {
@@ -77,12 +82,14 @@ namespace Hypertable {
      * @param props reference to properties map
      * @param init_log base log to pull fragments from
      * @param is_meta true for root, system and metadata logs
+     * @param stream index of this stream among those sharing log_dir
+     * @param stream_count number of streams sharing log_dir
      */
     CommitLog(FilesystemPtr &fs, const String &log_dir,
               PropertiesPtr &props, CommitLogBase *init_log = 0,
-              bool is_meta=true)
+              bool is_meta=true, uint32_t stream=0, uint32_t stream_count=1)
       : CommitLogBase(log_dir), m_fs(fs) {
-      initialize(log_dir, props, init_log, is_meta);
+      initialize(log_dir, props, init_log, is_meta, stream, stream_count);
     }
 
     /**
@@ -147,7 +154,10 @@ namespace Hypertable {
      * fragment is inserted into this map.  The key is the revision of the
      * fragment (e.g. the real revision of the most recent data in the fragment
      * file).  The value is a structure that contains information regarding how
-     * expensive it is to keep this fragment around.
+     * expensive it is to keep this fragment around.  Entries already in the
+     * map are kept, so the map of several streams can be built by calling
+     * this method on each of them; fragments with the same revision are
+     * combined into one entry.
      *
      * @param cumulative_size_map reference to map of log fragment priority data
      */
@@ -188,12 +198,16 @@ namespace Hypertable {
     static const char MAGIC_LINK[10];
 
   private:
-    void initialize(const String &log_dir,
-                    PropertiesPtr &, CommitLogBase *init_log, bool is_meta);
+    void initialize(const String &log_dir, PropertiesPtr &,
+                    CommitLogBase *init_log, bool is_meta,
+                    uint32_t stream=0, uint32_t stream_count=1);
     int roll(CommitLogFileInfo **clfip=0);
     int compress_and_write(DynamicBuffer &input, BlockCompressionHeader *header,
                            int64_t revision, bool sync);
     void remove_file_info(CommitLogFileInfo *fi);
+    static void add_cumulative_fragment(CumulativeSizeMap &cumulative_size_map,
+                                        int64_t revision,
+                                        const CumulativeFragmentData &frag_data);
 
     FilesystemPtr           m_fs;
     std::set<CommitLogFileInfo *> m_reap_set;
@@ -203,6 +217,7 @@ namespace Hypertable {
     int64_t                 m_cur_fragment_length;
     int64_t                 m_max_fragment_size;
     uint32_t                m_cur_fragment_num;
+    uint32_t                m_fragment_num_stride;
     int32_t                 m_fd;
     int32_t                 m_replication;
     bool                    m_needs_roll;
@@ -340,6 +340,7 @@ namespace {
     "      IN_MEMORY",
     "      | BLOCKSIZE int",
     "      | REPLICATION int",
+    "      | VALUE_LOG_THRESHOLD int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
     "",
@@ -471,6 +472,7 @@ namespace {
     "      | IN_MEMORY",
     "      | BLOCKSIZE int",
     "      | REPLICATION int",
+    "      | VALUE_LOG_THRESHOLD int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
     "",
@@ -510,6 +512,7 @@ namespace {
     "      | REPLICATION int",
     "      | COMPRESSOR compressor_spec",
     "      | GROUP_COMMIT_INTERVAL int",
+    "      | COMPACTION ('tiered' | 'leveled' | 'timewindow')",
     "",
     "Description",
     "-----------",
@@ -628,6 +631,7 @@ namespace {
     "  * REPLICATION int",
     "  * COMPRESSOR compressor_spec",
     "  * GROUP_COMMIT_INTERVAL int",
+    "  * COMPACTION ('tiered' | 'leveled' | 'timewindow')",
     "",
     "These are the same options as the ones in the column family and access group",
     "specification except that they act as defaults in the case where no",
@@ -646,6 +650,19 @@ namespace {
     "to 50ms.  The value specified for GROUP_COMMIT_INTERVAL will get rounded up to",
     "the nearest multiple of this property value.",
     "",
+    "The COMPACTION option selects how the RangeServer merges the CellStores of",
+    "each access group.  With 'tiered', the default, CellStores are merged once",
+    "a run of them grows longer than Hypertable.RangeServer.CellStore.Merge.",
+    "RunLengthThreshold, which keeps write amplification low.  With 'leveled',",
+    "any two adjacent CellStores that together fit in the target CellStore size",
+    "are merged, which rewrites more data but keeps the number of CellStores read",
+    "by each scan small.  With 'timewindow', intended for append-only time-series",
+    "tables, CellStores are grouped into windows of Hypertable.RangeServer.",
+    "CellStore.Merge.TimeWindow seconds by their newest timestamp.  Only the",
+    "current window is merged with the tiered rules; once a window closes its",
+    "CellStores are merged into one and never rewritten again, so with a TTL",
+    "whole windows expire and are dropped without being compacted.",
+    "",
     "Column Family Options",
     "---------------------",
     "",
@@ -731,6 +748,13 @@ namespace {
     "group.  The default is unspecified, which translates to whatever the default",
     "replication level is for the underlying file system.",
     "",
+    "The VALUE_LOG_THRESHOLD option moves values of at least the given number of",
+    "bytes out of the cell stores and into separate append-only value log files",
+    "when cell stores are written.  The cell stores keep only a small reference,",
+    "so merging compactions no longer rewrite large values.  Values are fetched",
+    "from the value log when they are scanned.  The default of 0 keeps all values",
+    "inline.",
+    "",
     "The COMPRESSOR option specifies the compression codec that should be used for",
     "cell store blocks within an access group.  See the Compressors section below",
     "for a description of each compression codec.",
@@ -808,7 +832,8 @@ namespace {
     "SELECT",
     "======",
     "",
-    "    SELECT ('*' | (column_predicate [',' column_predicate]*))",
+    "    SELECT ('*' | (column_predicate [',' column_predicate]*)",
+    "            | aggregate_spec)",
     "      FROM table_name",
     "      [where_clause]",
     "      [options_spec]",
@@ -831,6 +856,11 @@ namespace {
     "    | column_family ':' '^'column_qualifer_prefix",
     "    | column_family ':' '/'column_qualifier_regexp'/'",
     "",
+    "    aggregate_spec:",
+    "      COUNT '(' '*' ')'",
+    "      | (COUNT | SUM | MIN | MAX)",
+    "          '(' ('*' | column_predicate [',' column_predicate]*) ')'",
+    "",
     "    cell_spec: row ',' column",
     "",
     "    cell_predicate:",
@@ -847,6 +877,9 @@ namespace {
     "    column_value_predicate:",
     "      column_family '=' value",
     "      | column_family '=' '^' value",
+    "      | column_family ('<' | '<=' | '>' | '>=') (value | integer)",
+    "      | column_family BETWEEN value AND value",
+    "      | column_family BETWEEN integer AND integer",
     "",
     "    timestamp_predicate:",
     "      [timestamp relop] TIMESTAMP relop timestamp",
@@ -895,6 +928,17 @@ namespace {
     "    SELECT col FROM test WHERE col = \"foo\";",
     "    SELECT col FROM test WHERE col =^ \"prefix\";",
     "",
+    "The comparison operators and BETWEEN compare quoted values byte by byte and",
+    "unquoted integers numerically; cells whose value is not an integer never match",
+    "an integer comparison.  Counter columns are always compared numerically and",
+    "only support these operators.  Both bounds of BETWEEN are inclusive.  A cell",
+    "has to satisfy every comparison on its column, and at least one of any '='",
+    "or '=^' predicates, so a range can be given with two comparisons or BETWEEN:",
+    "",
+    "    SELECT col FROM test WHERE col >= \"m\";",
+    "    SELECT hits FROM test WHERE hits >= 100 AND hits <= 200;",
+    "    SELECT hits FROM test WHERE hits BETWEEN 100 AND 200;",
+    "",
     "The following examples are NOT valid because they select more than one ",
     "column family or because the column family in the select clause is different ",
     "from the one in the predicate (these limitations will be removed in future ",
@@ -983,6 +1027,16 @@ namespace {
     "",
     "     timestamp, row, column, value",
     "",
+    "AGGREGATES",
+    "",
+    "COUNT(*) returns the number of rows matched by the query.  COUNT, SUM, MIN",
+    "and MAX applied to columns return one line per column family containing",
+    "the family name and the aggregate; SUM, MIN and MAX interpret cell values",
+    "as decimal integers (counter columns are handled natively).  Aggregates",
+    "are computed by the RangeServers and only partial results are sent to the",
+    "client, so they cannot be combined with LIMIT, OFFSET, CELL_LIMIT,",
+    "KEYS_ONLY, RETURN_DELETES or cell predicates.",
+    "",
     "KEYS_ONLY",
     "",
     "The KEYS_ONLY option suppresses the output of the value.  It is somewhat",
@@ -186,6 +186,8 @@ cmd_create_table(NamespacePtr &ns, ParserState &state,
     schema->validate_compressor(state.table_compressor);
     schema->set_compressor(state.table_compressor);
     schema->set_group_commit_interval(state.group_commit_interval);
+    schema->validate_compaction_strategy(state.table_compaction_strategy);
+    schema->set_compaction_strategy(state.table_compaction_strategy);
 
     foreach_ht(Schema::AccessGroup *ag, state.ag_list) {
       schema->validate_compressor(ag->compressor);
@@ -352,6 +354,8 @@ cmd_select(NamespacePtr &ns, ConnectionManagerPtr &conn_manager,
 
   HT_ON_SCOPE_EXIT(&close_file, out_fd);
   Cell cell;
+  bool aggregate =
+    state.scan.builder.get().aggregate != ScanSpec::AGGREGATE_NONE;
   ::uint32_t nsec;
   time_t unix_time;
   struct tm tms;
@@ -371,6 +375,13 @@ cmd_select(NamespacePtr &ns, ConnectionManagerPtr &conn_manager,
 
       cb.total_values_size += cell.value_len;
     }
+    if (aggregate) {
+      if (cell.column_family)
+        fout << cell.column_family << "\t";
+      fout.write((const char *)cell.value, cell.value_len);
+      fout << "\n";
+      continue;
+    }
     if (state.scan.display_timestamps) {
       if (cb.format_ts_in_usecs) {
         fout << cell.timestamp << "\t";
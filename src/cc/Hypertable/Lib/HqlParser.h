@@ -263,6 +263,7 @@ namespace Hypertable {
       bool    current_timestamp_set;
       int current_relop;
       int buckets;
+      String current_lower_bound;
     };
 
     class ParserState {
@@ -293,6 +294,7 @@ namespace Hypertable {
       String header_file;
       int header_file_src;
       String table_compressor;
+      String table_compaction_strategy;
       ::uint32_t group_commit_interval;
       ::uint32_t table_blocksize;
       ::int32_t table_replication;
@@ -719,6 +721,14 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct set_access_group_value_log_threshold {
+      set_access_group_value_log_threshold(ParserState &state) : state(state) { }
+      void operator()(size_t threshold) const {
+        state.ag->value_log_threshold = threshold;
+      }
+      ParserState &state;
+    };
+
     struct set_access_group_replication {
       set_access_group_replication(ParserState &state) : state(state) { }
       void operator()(size_t replication) const {
@@ -850,6 +860,41 @@ namespace Hypertable {
        uint32_t operation;
     };
 
+    struct scan_set_column_predicate_lower_bound {
+      scan_set_column_predicate_lower_bound(ParserState &state)
+          : state(state) { }
+      void operator()(char const *str, char const *end) const {
+        state.scan.current_lower_bound = String(str, end-str);
+        trim_if(state.scan.current_lower_bound, boost::is_any_of("'\""));
+       }
+       ParserState &state;
+    };
+
+    struct scan_set_column_predicate_upper_bound {
+      scan_set_column_predicate_upper_bound(ParserState &state,
+          uint32_t operation) : state(state), operation(operation) { }
+      void operator()(char const *str, char const *end) const {
+        String s(str, end-str);
+        trim_if(s, boost::is_any_of("'\""));
+        state.scan.builder.add_column_predicate(
+            ColumnPredicate(state.current_column_family.c_str(), operation,
+                            state.scan.current_lower_bound.c_str(), s.c_str()));
+       }
+       ParserState &state;
+       uint32_t operation;
+    };
+
+    struct set_table_compaction_strategy {
+      set_table_compaction_strategy(ParserState &state) : state(state) { }
+      void operator()(char const *str, char const *end) const {
+        if (state.table_compaction_strategy != "")
+          HT_THROW(Error::HQL_PARSE_ERROR, "table compaction strategy multiply defined");
+        state.table_compaction_strategy = String(str, end-str);
+        trim_if(state.table_compaction_strategy, is_any_of("'\""));
+      }
+      ParserState &state;
+    };
+
     struct set_table_compressor {
       set_table_compressor(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -1598,6 +1643,16 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct scan_set_aggregate {
+      scan_set_aggregate(ParserState &state, int function)
+        : state(state), function(function) { }
+      void operator()(char const *str, char const *end) const {
+        state.scan.builder.set_aggregate(function);
+      }
+      ParserState &state;
+      int function;
+    };
+
     struct scan_set_keys_only {
       scan_set_keys_only(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -1877,6 +1932,7 @@ namespace Hypertable {
           Token SECOND       = as_lower_d["second"];
           Token IN_MEMORY    = as_lower_d["in_memory"];
           Token BLOCKSIZE    = as_lower_d["blocksize"];
+          Token VALUE_LOG_THRESHOLD = as_lower_d["value_log_threshold"];
           Token ACCESS       = as_lower_d["access"];
           Token GROUP        = as_lower_d["group"];
           Token INDEX        = as_lower_d["index"];
@@ -1930,6 +1986,7 @@ namespace Hypertable {
           Token VALUE        = as_lower_d["value"];
           Token VALUES       = as_lower_d["values"];
           Token COMPRESSOR   = as_lower_d["compressor"];
+          Token COMPACTION   = as_lower_d["compaction"];
           Token GROUP_COMMIT_INTERVAL   = as_lower_d["group_commit_interval"];
           Token DUMP         = as_lower_d["dump"];
           Token STATS        = as_lower_d["stats"];
@@ -1965,6 +2022,7 @@ namespace Hypertable {
           Token AND          = as_lower_d["and"];
           Token OR           = as_lower_d["or"];
           Token LIKE         = as_lower_d["like"];
+          Token BETWEEN      = as_lower_d["between"];
           Token NOESCAPE     = as_lower_d["noescape"];
           Token NO_ESCAPE    = as_lower_d["no_escape"];
           Token IDS          = as_lower_d["ids"];
@@ -1985,6 +2043,10 @@ namespace Hypertable {
           Token USER         = as_lower_d["user"];
           Token RANGES       = as_lower_d["ranges"];
           Token SYNC         = as_lower_d["sync"];
+          Token COUNT        = as_lower_d["count"];
+          Token SUM          = as_lower_d["sum"];
+          Token MIN          = as_lower_d["min"];
+          Token MAX          = as_lower_d["max"];
 
           /**
            * Start grammar definition
@@ -2329,6 +2391,8 @@ namespace Hypertable {
             = COMPRESSOR >> *EQUAL >> string_literal[
                 set_table_compressor(self.state)]
             | GROUP_COMMIT_INTERVAL >> *EQUAL >> uint_p[set_group_commit_interval(self.state)]
+            | COMPACTION >> *EQUAL >> string_literal[
+                set_table_compaction_strategy(self.state)]
             | table_option_in_memory[set_table_in_memory(self.state)]
             | table_option_blocksize
             | table_option_replication
@@ -2450,6 +2514,8 @@ namespace Hypertable {
             | in_memory_option[set_access_group_in_memory(self.state)]
             | blocksize_option
             | replication_option
+            | VALUE_LOG_THRESHOLD >> *EQUAL >> uint_p[
+                set_access_group_value_log_threshold(self.state)]
             | COMPRESSOR >> *EQUAL >> string_literal[
                 set_access_group_compressor(self.state)]
             | bloom_filter_option
@@ -2476,12 +2542,28 @@ namespace Hypertable {
 
           select_statement
             = SELECT >> !(CELLS)
-              >> ('*' | (column_selection >> *(COMMA >> column_selection)))
+              >> (aggregate_selection | '*'
+                  | (column_selection >> *(COMMA >> column_selection)))
               >> FROM >> user_identifier[set_table_name(self.state)]
               >> !where_clause
               >> *(option_spec)
             ;
 
+          aggregate_selection
+            = (COUNT >> LPAREN >> STAR >> RPAREN)[scan_set_aggregate(
+                  self.state, ScanSpec::AGGREGATE_COUNT_ROWS)]
+            | (((COUNT >> LPAREN)[scan_set_aggregate(self.state,
+                  ScanSpec::AGGREGATE_COUNT)]
+              | (SUM >> LPAREN)[scan_set_aggregate(self.state,
+                  ScanSpec::AGGREGATE_SUM)]
+              | (MIN >> LPAREN)[scan_set_aggregate(self.state,
+                  ScanSpec::AGGREGATE_MIN)]
+              | (MAX >> LPAREN)[scan_set_aggregate(self.state,
+                  ScanSpec::AGGREGATE_MAX)])
+              >> (STAR | (column_selection >> *(COMMA >> column_selection)))
+              >> RPAREN)
+            ;
+
           column_selection
             = (identifier[scan_add_column_family(self.state, 
                         EXACT_QUALIFIER)] >> QUALPREFIX >>
@@ -2560,6 +2642,46 @@ namespace Hypertable {
                 >> SW
                 >> string_literal[scan_set_column_predicate_value(self.state, 
                         ColumnPredicate::PREFIX_MATCH)]
+            | identifier[scan_set_column_predicate_name(self.state)] 
+                >> column_comparison
+            ;
+
+          integer_literal
+            = lexeme_d[!(ch_p('-') | '+') >> +digit_p]
+            ;
+
+          column_comparison
+            = LE >> string_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::LESS_OR_EQUAL)]
+            | LE >> integer_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::LESS_OR_EQUAL
+                        | ColumnPredicate::INTEGER_COMPARISON)]
+            | LT >> string_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::LESS_THAN)]
+            | LT >> integer_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::LESS_THAN
+                        | ColumnPredicate::INTEGER_COMPARISON)]
+            | GE >> string_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::GREATER_OR_EQUAL)]
+            | GE >> integer_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::GREATER_OR_EQUAL
+                        | ColumnPredicate::INTEGER_COMPARISON)]
+            | GT >> string_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::GREATER_THAN)]
+            | GT >> integer_literal[scan_set_column_predicate_value(self.state,
+                        ColumnPredicate::GREATER_THAN
+                        | ColumnPredicate::INTEGER_COMPARISON)]
+            | BETWEEN
+                >> string_literal[scan_set_column_predicate_lower_bound(self.state)]
+                >> AND
+                >> string_literal[scan_set_column_predicate_upper_bound(
+                        self.state, ColumnPredicate::BETWEEN)]
+            | BETWEEN
+                >> integer_literal[scan_set_column_predicate_lower_bound(self.state)]
+                >> AND
+                >> integer_literal[scan_set_column_predicate_upper_bound(
+                        self.state, ColumnPredicate::BETWEEN
+                        | ColumnPredicate::INTEGER_COMPARISON)]
             ;
 
           where_predicate
@@ -2688,7 +2810,10 @@ namespace Hypertable {
           BOOST_SPIRIT_DEBUG_RULE(column_name);
           BOOST_SPIRIT_DEBUG_RULE(column_option);
           BOOST_SPIRIT_DEBUG_RULE(column_predicate);
+          BOOST_SPIRIT_DEBUG_RULE(column_comparison);
+          BOOST_SPIRIT_DEBUG_RULE(integer_literal);
           BOOST_SPIRIT_DEBUG_RULE(column_selection);
+          BOOST_SPIRIT_DEBUG_RULE(aggregate_selection);
           BOOST_SPIRIT_DEBUG_RULE(create_definition);
           BOOST_SPIRIT_DEBUG_RULE(create_definitions);
           BOOST_SPIRIT_DEBUG_RULE(add_column_definition);
@@ -2810,7 +2935,8 @@ namespace Hypertable {
           describe_table_statement, show_statement, select_statement,
           where_clause, where_predicate,
           time_predicate, relop, row_interval, row_predicate, column_predicate,
-          value_predicate, column_selection,
+          column_comparison, integer_literal,
+          value_predicate, column_selection, aggregate_selection,
           option_spec, date_expression, unused_tokens, datetime, date, time, year,
           load_data_statement, load_data_input, load_data_option, insert_statement,
           insert_value_list, insert_value, delete_statement,
@@ -395,8 +395,7 @@ static String last;
                 it != m_tmp_keys.end(); ++it) 
           ssb.add_row((const char *)it->first.row);
         foreach_ht (const ColumnPredicate &cp, primary_spec.column_predicates)
-          ssb.add_column_predicate(cp.column_family, cp.operation,
-                  cp.value, cp.value_len);
+          ssb.add_column_predicate(cp);
 
         s = m_primary_table->create_scanner_async(this, ssb.get(), 
                 m_timeout_ms, Table::SCANNER_FLAG_IGNORE_INDEX);
@@ -472,8 +471,7 @@ static String last;
         ssb->set_max_versions(primary_spec.max_versions);
         ssb->set_return_deletes(primary_spec.return_deletes);
         foreach_ht (const ColumnPredicate &cp, primary_spec.column_predicates)
-          ssb->add_column_predicate(cp.column_family, cp.operation,
-                  cp.value, cp.value_len);
+          ssb->add_column_predicate(cp);
         if (primary_spec.value_regexp)
           ssb->set_value_regexp(primary_spec.value_regexp);
 
@@ -504,8 +502,7 @@ static String last;
       ssb->set_max_versions(primary_spec.max_versions);
       ssb->set_return_deletes(primary_spec.return_deletes);
       foreach_ht (const ColumnPredicate &cp, primary_spec.column_predicates)
-        ssb->add_column_predicate(cp.column_family, cp.operation,
-                cp.value, cp.value_len);
+        ssb->add_column_predicate(cp);
       if (primary_spec.value_regexp)
         ssb->set_value_regexp(primary_spec.value_regexp);
 
@@ -89,8 +89,7 @@ void IntervalScannerAsync::init(const ScanSpec &scan_spec) {
   m_scan_spec_builder.set_cell_offset(scan_spec.cell_offset);
 
   foreach_ht (const ColumnPredicate &cp, scan_spec.column_predicates)
-    m_scan_spec_builder.add_column_predicate(cp.column_family,
-            cp.operation, cp.value, cp.value_len);
+    m_scan_spec_builder.add_column_predicate(cp);
 
   for (size_t i=0; i<scan_spec.columns.size(); i++) {
     ScanSpec::parse_column(scan_spec.columns[i], family, qualifier, 
@@ -191,6 +190,7 @@ void IntervalScannerAsync::init(const ScanSpec &scan_spec) {
 
   m_scan_spec_builder.set_return_deletes(scan_spec.return_deletes);
   m_scan_spec_builder.set_keys_only(scan_spec.keys_only);
+  m_scan_spec_builder.set_aggregate(scan_spec.aggregate);
 
   // start scan asynchronously (can trigger table not found exceptions)
   m_create_scanner_row = m_start_row;
@@ -363,9 +363,11 @@ bool IntervalScannerAsync::retry_or_abort(bool refresh, bool hard, bool is_creat
     m_state = RESTART;
 
   if (m_state == RESTART) {
+    bool current = m_current;
     if (!has_outstanding_requests())
       restart_scan(refresh);
-    *move_to_next = false;
+    // a restarted aggregate scan ends here if every row was aggregated
+    *move_to_next = current && m_eos && m_state != ABORTED;
     return m_state != ABORTED;
   }
 
@@ -660,6 +662,56 @@ void IntervalScannerAsync::do_readahead() {
 }
 
 
+/**
+ * Partial aggregates cover whole rows, so rows up to and including the last
+ * one returned must not be scanned a second time.  The scan spec and the
+ * row set are trimmed so the restarted scan begins at the following row.
+ */
+bool IntervalScannerAsync::skip_aggregated_rows(const char *row) {
+  ScanSpec &spec = m_scan_spec_builder.get();
+
+  // rowset scans have one interval per row, starting at that row
+  if (!m_rowset.empty()) {
+    while (!m_rowset.empty() && strcmp(*m_rowset.begin(), row) <= 0)
+      m_rowset.erase(m_rowset.begin());
+    while (!spec.row_intervals.empty() &&
+           strcmp(spec.row_intervals.front().start, row) <= 0)
+      spec.row_intervals.erase(spec.row_intervals.begin());
+    if (m_rowset.empty())
+      return false;
+    m_create_scanner_row = *m_rowset.begin();
+    return true;
+  }
+
+  if (m_end_row.compare(row) <= 0)
+    return false;
+
+  if (!spec.row_intervals.empty()) {
+    m_aggregate_restart_row = row;
+    spec.row_intervals.front().start = m_aggregate_restart_row.c_str();
+    spec.row_intervals.front().start_inclusive = false;
+  }
+  else if (!spec.cell_intervals.empty()) {
+    // A cell interval cannot start at the beginning of a row, so start it
+    // at the first column family of the row that immediately follows
+    Schema::ColumnFamily *first = 0;
+    foreach_ht (Schema::ColumnFamily *cf, m_schema->get_column_families()) {
+      if (cf && !cf->deleted && (first == 0 || cf->id < first->id))
+        first = cf;
+    }
+    HT_ASSERT(first);
+    m_aggregate_restart_row = row;
+    m_aggregate_restart_row.append(1, 1);
+    m_aggregate_restart_column = first->name;
+    CellInterval &interval = spec.cell_intervals.front();
+    interval.start_row = m_aggregate_restart_row.c_str();
+    interval.start_column = m_aggregate_restart_column.c_str();
+    interval.start_inclusive = true;
+  }
+  return true;
+}
+
+
 void IntervalScannerAsync::restart_scan(bool refresh) {
 
   HT_ASSERT(m_state == RESTART);
@@ -671,8 +723,16 @@ void IntervalScannerAsync::restart_scan(bool refresh) {
     m_create_event_saved = false;
     m_create_event = 0;
 
-    if (m_last_key.row)
+    if (m_last_key.row) {
       m_create_scanner_row = m_last_key.row;
+      if (m_scan_spec_builder.get().aggregate != ScanSpec::AGGREGATE_NONE &&
+          !skip_aggregated_rows(m_last_key.row)) {
+        m_state = 0;
+        m_eos = true;
+        m_current = false;
+        return;
+      }
+    }
 
     m_state = 0;
     find_range_and_start_scan(m_create_scanner_row.c_str(), true);
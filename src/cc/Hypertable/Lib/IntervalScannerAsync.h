@@ -80,6 +80,7 @@ namespace Hypertable {
     void set_result(EventPtr &event, ScanCellsPtr &cells, bool is_create=false);
     void load_result(ScanCellsPtr &cells);
     void set_range_spec(DynamicBuffer &dbuf, RangeSpec &range);
+    bool skip_aggregated_rows(const char *row);
     void restart_scan(bool refresh=false);
 
     Comm               *m_comm;
@@ -116,6 +117,8 @@ namespace Hypertable {
     int                 m_state;
     Key                 m_last_key;
     DynamicBuffer       m_last_key_buf;
+    String              m_aggregate_restart_row;
+    String              m_aggregate_restart_column;
     bool                m_create_event_saved;
     bool                m_invalid_scanner_id_ok;
   };
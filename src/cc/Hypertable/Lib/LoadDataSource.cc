@@ -64,8 +64,8 @@ using namespace std;
 LoadDataSource::LoadDataSource(const String &header_fname, 
                                int row_uniquify_chars, 
                                int load_flags)
-  : m_type_mask(0), m_cur_line(0), m_line_buffer(0),
-    m_row_key_buffer(0), m_hyperformat(false), m_leading_timestamps(false),
+  : m_type_mask(0), m_cur_line(0), m_line_buffer(0), m_read_buffer(0),
+    m_read_offset(0), m_read_eof(false), m_row_key_buffer(0), m_hyperformat(false), m_leading_timestamps(false),
     m_timestamp_index(-1), m_timestamp(AUTO_ASSIGN), m_offset(0),
     m_zipped(false), m_rsgen(0), m_header_fname(header_fname),
     m_row_uniquify_chars(row_uniquify_chars),
@@ -140,6 +140,68 @@ LoadDataSource::get_header()
   return header;
 }
 
+bool LoadDataSource::get_next_line(char **linep, size_t *lenp) {
+  char *base, *newline;
+  size_t avail;
+
+  if (m_first_line_cached) {
+    m_line_buffer.clear();
+    m_line_buffer.add(m_first_line.c_str(), m_first_line.length()+1);
+    *linep = (char *)m_line_buffer.base;
+    *lenp = m_first_line.length();
+    m_first_line_cached = false;
+    return true;
+  }
+
+  while (true) {
+    base = (char *)m_read_buffer.base + m_read_offset;
+    avail = m_read_buffer.fill() - m_read_offset;
+
+    if (avail && (newline = (char *)memchr(base, '\n', avail)) != 0) {
+      *newline = 0;
+      *linep = base;
+      *lenp = newline - base;
+      m_read_offset += *lenp + 1;
+      return true;
+    }
+
+    if (m_read_eof) {
+      if (avail == 0)
+        return false;
+      // last line is not newline terminated, fill_read_buffer() has
+      // reserved space for the terminator
+      base[avail] = 0;
+      *linep = base;
+      *lenp = avail;
+      m_read_offset += avail;
+      return true;
+    }
+
+    fill_read_buffer();
+  }
+}
+
+void LoadDataSource::fill_read_buffer() {
+  size_t avail = m_read_buffer.fill() - m_read_offset;
+
+  if (m_read_offset) {
+    if (avail)
+      memmove(m_read_buffer.base, m_read_buffer.base + m_read_offset, avail);
+    m_read_buffer.ptr = m_read_buffer.base + avail;
+    m_read_offset = 0;
+  }
+
+  // one extra byte for terminating an unterminated last line
+  m_read_buffer.ensure(READ_CHUNK_SIZE + 1);
+
+  m_fin.read((char *)m_read_buffer.ptr, READ_CHUNK_SIZE);
+  streamsize nread = m_fin.gcount();
+  if (nread > 0)
+    m_read_buffer.ptr += nread;
+  if (!m_fin)
+    m_read_eof = true;
+}
+
 void
 LoadDataSource::init(const std::vector<String> &key_columns, const String &timestamp_column)
 {
@@ -299,7 +361,8 @@ bool
 LoadDataSource::next(KeySpec *keyp, uint8_t **valuep, uint32_t *value_lenp,
                      bool *is_deletep, uint32_t *consumedp) 
 {
-  String line;
+  char *line, *end;
+  size_t line_len;
   int index;
   char *base, *ptr, *colon;
 
@@ -311,17 +374,13 @@ LoadDataSource::next(KeySpec *keyp, uint8_t **valuep, uint32_t *value_lenp,
 
   if (m_hyperformat) {
 
-    while (get_next_line(line)) {
+    while (get_next_line(&line, &line_len)) {
       m_cur_line++;
 
       if (consumedp && !m_zipped)
-        *consumedp += line.length() + 1;
-
-      m_line_buffer.clear();
+        *consumedp += line_len + 1;
 
-      m_line_buffer.add(line.c_str(), strlen(line.c_str())+1);
-
-      base = (char *)m_line_buffer.base;
+      base = line;
 
       /**
        *  Get timestamp
@@ -487,22 +546,26 @@ LoadDataSource::next(KeySpec *keyp, uint8_t **valuep, uint32_t *value_lenp,
       return true;
     }
 
-    while (get_next_line(line)) {
+    while (get_next_line(&line, &line_len)) {
       m_cur_line++;
       index = 0;
 
       if (consumedp && !m_zipped)
-        *consumedp += line.length() + 1;
-
-      boost::trim(line);
-      if (line.length() == 0)
+        *consumedp += line_len + 1;
+
+      // trim in place
+      end = line + strlen(line);
+      while (end > line && isspace((unsigned char)end[-1]))
+        end--;
+      *end = 0;
+      while (line < end && isspace((unsigned char)*line))
+        line++;
+      if (line == end)
         continue;
 
-      m_line_buffer.clear();
-      m_line_buffer.add(line.c_str(), strlen(line.c_str())+1);
       m_values.clear();
 
-      base = (char *)m_line_buffer.base;
+      base = line;
 
       while ((ptr = strchr(base, '\t')) != 0) {
         *ptr++ = 0;
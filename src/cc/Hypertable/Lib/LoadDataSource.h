@@ -72,14 +72,25 @@ namespace Hypertable {
 
   protected:
 
-    bool get_next_line(String &line) {
-      if (m_first_line_cached) {
-        line = m_first_line;
-        m_first_line_cached = false;
-        return true;
-      }
-      return getline(m_fin, line);
-    }
+    /** Size of the chunks read from the input stream */
+    static const size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+    /**
+     * Returns the next line of input.  Input is read from m_fin in large
+     * chunks and lines are located with memchr() and handed back in place,
+     * NUL-terminated.  The returned pointer remains valid until the next
+     * call to get_next_line().
+     *
+     * @param linep address of pointer to hold beginning of line
+     * @param lenp address of variable to hold line length (excluding newline)
+     * @return true if a line was returned, false on end of input
+     */
+    bool get_next_line(char **linep, size_t *lenp);
+
+    /** Shifts unconsumed input to the front of m_read_buffer and appends
+     * the next chunk read from m_fin.
+     */
+    void fill_read_buffer();
 
     virtual void parse_header(const String& header,
                               const std::vector<String> &key_columns,
@@ -129,6 +140,9 @@ namespace Hypertable {
     boost::iostreams::filtering_istream m_fin;
     int64_t m_cur_line;
     DynamicBuffer m_line_buffer;
+    DynamicBuffer m_read_buffer;
+    size_t m_read_offset;
+    bool m_read_eof;
     DynamicBuffer m_row_key_buffer;
     bool m_hyperformat;
     bool m_leading_timestamps;
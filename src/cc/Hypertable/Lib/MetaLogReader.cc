@@ -145,6 +145,7 @@ bool Reader::load_file(const String &fname) {
   size_t file_length = m_fs->length(fname);
   int fd = m_fs->open_buffered(fname, 0, READAHEAD_BUFSZ, OUTSTANDING_READS);
   bool found_recover_entry = false;
+  size_t acknowledged_length = acknowledged(fname);
 
   m_entity_map.clear();
 
@@ -158,12 +159,24 @@ bool Reader::load_file(const String &fname) {
     size_t remaining;
     EntityHeader header;
     DynamicBuffer buf;
+    size_t entry_offset;
 
     buf.reserve(EntityHeader::LENGTH);
 
     while (m_cur_offset < file_length) {
 
       buf.clear();
+      entry_offset = m_cur_offset;
+
+      /**
+       * A flush cut short by a crash leaves a partial entry at the end of
+       * the file.  Everything before it was written completely, so the log
+       * is read as ending at the last complete entry.
+       */
+      if (m_cur_offset + EntityHeader::LENGTH > file_length) {
+        truncated_entry(fname, entry_offset, file_length, acknowledged_length);
+        break;
+      }
 
       size_t nread = m_fs->read(fd, buf.base, EntityHeader::LENGTH);
 
@@ -187,6 +200,16 @@ bool Reader::load_file(const String &fname) {
         continue;
       }
 
+      if (header.length < 0 || (header.flags & ~EntityHeader::FLAG_REMOVE))
+        HT_THROWF(Error::METALOG_ENTRY_TRUNCATED, "Corrupt entity header at "
+                  "offset %llu (length=%d, flags=0x%x)", (Llu)entry_offset,
+                  (int)header.length, (unsigned)header.flags);
+
+      if (m_cur_offset + header.length > file_length) {
+        truncated_entry(fname, entry_offset, file_length, acknowledged_length);
+        break;
+      }
+
       EntityPtr entity = m_definition->create(m_version, header);
 
       buf.clear();
@@ -227,6 +250,40 @@ bool Reader::load_file(const String &fname) {
 }
 
 
+/**
+ * The local backup is only appended to once a flush to the DFS has
+ * completed, so its length is the part of the log the writer knows to be
+ * complete.  Returns 0 when there is no backup to go by.
+ */
+size_t Reader::acknowledged(const String &fname) {
+  if (m_backup_path.empty())
+    return 0;
+  String backup_filename = m_backup_path + "/" +
+    fname.substr(fname.find_last_of('/') + 1);
+  if (!FileUtils::exists(backup_filename))
+    return 0;
+  return FileUtils::size(backup_filename);
+}
+
+
+/**
+ * Only an entry the writer never acknowledged can be cut short by a crash.
+ * An entry running past the end of the file that lies within the
+ * acknowledged part means the log is damaged, and is reported as before.
+ */
+void Reader::truncated_entry(const String &fname, size_t offset,
+                             size_t file_length, size_t acknowledged_length) {
+  if (offset < acknowledged_length)
+    HT_THROWF(Error::METALOG_ENTRY_TRUNCATED, "Entry at offset %llu runs past "
+              "end of file (%llu bytes) but was acknowledged (%llu bytes)",
+              (Llu)offset, (Llu)file_length, (Llu)acknowledged_length);
+  HT_WARNF("Truncating %s log file %s to its last complete entry, dropping "
+           "%llu bytes at offset %llu", m_definition->name(), fname.c_str(),
+           (Llu)(file_length - offset), (Llu)offset);
+  m_cur_offset = offset;
+}
+
+
 void Reader::read_header(int fd) {
   MetaLog::Header header;
   uint8_t buf[Header::LENGTH];
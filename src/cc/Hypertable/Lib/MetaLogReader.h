@@ -51,6 +51,9 @@ namespace Hypertable {
 
       bool verify_backup(int32_t file_num);
       void read_header(int fd);
+      size_t acknowledged(const String &fname);
+      void truncated_entry(const String &fname, size_t offset,
+                           size_t file_length, size_t acknowledged_length);
 
       FilesystemPtr m_fs;
       MetaLog::DefinitionPtr m_definition;
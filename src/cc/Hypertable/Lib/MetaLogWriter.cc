@@ -27,6 +27,10 @@
 #include <algorithm>
 #include <cassert>
 
+extern "C" {
+#include <fcntl.h>
+}
+
 #include <boost/algorithm/string.hpp>
 #include <boost/shared_array.hpp>
 
@@ -39,6 +43,7 @@ using namespace Hypertable::MetaLog;
 namespace {
   const int32_t DFS_BUFFER_SIZE = -1;
   const int64_t DFS_BLOCK_SIZE = -1;
+  const size_t KEEP_LOG_FILES = 10;
 }
 
 bool Writer::skip_recover_entry = false;
@@ -46,7 +51,8 @@ bool Writer::skip_recover_entry = false;
 
 Writer::Writer(FilesystemPtr &fs, DefinitionPtr &definition, const String &path,
                std::vector<EntityPtr> &initial_entities) :
-  m_fs(fs), m_definition(definition), m_fd(-1), m_offset(0) {
+  m_fs(fs), m_definition(definition), m_fd(-1), m_offset(0), m_live_bytes(0),
+  m_pending_seq(0), m_flushed_seq(0), m_failed_seq(0), m_flushing(false) {
 
   HT_EXPECT(Config::properties, Error::FAILED_EXPECTATION);
 
@@ -63,35 +69,43 @@ Writer::Writer(FilesystemPtr &fs, DefinitionPtr &definition, const String &path,
   if (!FileUtils::exists(m_backup_path))
     FileUtils::mkdirs(m_backup_path);
 
+  m_compaction_min_size = Config::properties->get_i64("Hypertable.MetaLog.Compaction.MinSize");
+  m_compaction_garbage_pct = Config::properties->get_i32("Hypertable.MetaLog.Compaction.GarbageThreshold.Percentage");
+
   std::vector<int32_t> file_ids;
   int32_t next_id;
 
   scan_log_directory(m_fs, m_path, file_ids, &next_id);
 
-  purge_old_log_files(file_ids, 10);
+  purge_old_log_files(file_ids, KEEP_LOG_FILES);
 
   // get replication
-  int replication = Config::properties->get_i32("Hypertable.Metadata.Replication");
+  m_replication = Config::properties->get_i32("Hypertable.Metadata.Replication");
 
   // Open DFS file
+  m_file_id = next_id;
   m_filename = m_path + "/" + next_id;
-  m_fd = m_fs->create(m_filename, 0, DFS_BUFFER_SIZE, replication, DFS_BLOCK_SIZE);
+  m_fd = m_fs->create(m_filename, 0, DFS_BUFFER_SIZE, m_replication, DFS_BLOCK_SIZE);
 
   // Open backup file
   m_backup_filename = m_backup_path + "/" + next_id;
   m_backup_fd = ::open(m_backup_filename.c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644);
 
-  write_header();
+  write_header(m_fd, m_backup_fd, m_filename);
+  m_offset = Header::LENGTH;
 
-  // Write existing entries
+  // Write existing entries, followed by the "Recover" entity, in one flush
+  std::vector<Entity *> entities;
+  entities.reserve(initial_entities.size() + 1);
   foreach_ht (EntityPtr &entity, initial_entities)
-    record_state(entity.get());
+    entities.push_back(entity.get());
 
-  // Write "Recover" entity
-  if (!skip_recover_entry) {
-    EntityRecover recover_entity;
-    record_state(&recover_entity);
-  }
+  EntityRecover recover_entity;
+  if (!skip_recover_entry)
+    entities.push_back(&recover_entity);
+
+  if (!entities.empty())
+    record_state(entities);
 
 }
 
@@ -101,6 +115,11 @@ Writer::~Writer() {
 
 void Writer::close() {
   ScopedLock lock(m_mutex);
+
+  // Let an in-progress flush complete
+  while (m_flushing)
+    m_cond.wait(lock);
+
   try {
     if (m_fd != -1) {
       m_fs->close(m_fd);
@@ -116,8 +135,11 @@ void Writer::close() {
 }
 
 
+/**
+ * Called from the constructor, before the writer is shared, and by the
+ * flush leader after a compaction, so takes no lock itself.
+ */
 void Writer::purge_old_log_files(std::vector<int32_t> &file_ids, size_t keep_count) {
-  ScopedLock lock(m_mutex);
 
   // reverse sort
   sort(file_ids.rbegin(), file_ids.rend());
@@ -140,7 +162,7 @@ void Writer::purge_old_log_files(std::vector<int32_t> &file_ids, size_t keep_cou
 }
 
 
-void Writer::write_header() {
+void Writer::write_header(int fd, int backup_fd, const String &filename) {
   StaticBuffer buf(Header::LENGTH);
   uint8_t backup_buf[Header::LENGTH];
   Header header;
@@ -158,37 +180,18 @@ void Writer::write_header() {
   assert((ptr-buf.base) == Header::LENGTH);
   memcpy(backup_buf, buf.base, Header::LENGTH);
 
-  if (m_fs->append(m_fd, buf, Filesystem::O_FLUSH) != Header::LENGTH)
+  if (m_fs->append(fd, buf, Filesystem::O_FLUSH) != Header::LENGTH)
     HT_THROWF(Error::DFSBROKER_IO_ERROR, "Error writing %s "
               "metalog header to file: %s", m_definition->name(),
-              m_filename.c_str());
+              filename.c_str());
 
-  FileUtils::write(m_backup_fd, backup_buf, Header::LENGTH);
-  m_offset += Header::LENGTH;
+  FileUtils::write(backup_fd, backup_buf, Header::LENGTH);
 }
 
 
 void Writer::record_state(Entity *entity) {
-  ScopedLock lock(m_mutex);
-  size_t length = EntityHeader::LENGTH + (entity->marked_for_removal() ? 0 : entity->encoded_length());
-  StaticBuffer buf(length);
-  boost::shared_array<uint8_t> backup_buf( new uint8_t [length] );
-  uint8_t *ptr = buf.base;
-
-  if (m_fd == -1)
-    HT_THROWF(Error::CLOSED, "MetaLog '%s' has been closed", m_path.c_str());
-  
-  if (entity->marked_for_removal())
-    entity->header.encode( &ptr );
-  else
-    entity->encode_entry( &ptr );
-
-  HT_ASSERT((ptr-buf.base) == (ptrdiff_t)buf.size);
-  memcpy(backup_buf.get(), buf.base, buf.size);
-
-  m_fs->append(m_fd, buf, Filesystem::O_FLUSH);
-  FileUtils::write(m_backup_fd, backup_buf.get(), buf.size);
-  m_offset += buf.size;
+  std::vector<Entity *> entities(1, entity);
+  record_state(entities);
 }
 
 void Writer::record_state(std::vector<Entity *> &entities) {
@@ -201,78 +204,243 @@ void Writer::record_state(std::vector<Entity *> &entities) {
   foreach_ht (Entity *entity, entities)
     length += EntityHeader::LENGTH + (entity->marked_for_removal() ? 0 : entity->encoded_length());
 
-  {
-    StaticBuffer buf(length);
-    boost::shared_array<uint8_t> backup_buf( new uint8_t [length] );
-    uint8_t *ptr = buf.base;
-
-    foreach_ht (Entity *entity, entities) {
-      if (entity->marked_for_removal())
-        entity->header.encode( &ptr );
-      else
-        entity->encode_entry( &ptr );
-    }
-
-    HT_ASSERT((ptr-buf.base) == (ptrdiff_t)buf.size);
-    memcpy(backup_buf.get(), buf.base, buf.size);
+  m_pending.ensure(length);
 
-    m_fs->append(m_fd, buf, Filesystem::O_FLUSH);
-    FileUtils::write(m_backup_fd, backup_buf.get(), buf.size);
-    m_offset += buf.size;
+  foreach_ht (Entity *entity, entities) {
+    if (entity->marked_for_removal())
+      entity->header.encode( &m_pending.ptr );
+    else
+      entity->encode_entry( &m_pending.ptr );
   }
+
+  commit(lock);
 }
 
 
 void Writer::record_removal(Entity *entity) {
+  std::vector<Entity *> entities(1, entity);
+  record_removal(entities);
+}
+
+
+void Writer::record_removal(std::vector<Entity *> &entities) {
   ScopedLock lock(m_mutex);
-  StaticBuffer buf(EntityHeader::LENGTH);
-  uint8_t backup_buf[EntityHeader::LENGTH];
-  uint8_t *ptr = buf.base;
+  size_t length = entities.size() * EntityHeader::LENGTH;
 
   if (m_fd == -1)
     HT_THROWF(Error::CLOSED, "MetaLog '%s' has been closed", m_path.c_str());
 
-  entity->header.flags |= EntityHeader::FLAG_REMOVE;
-  entity->header.length = 0;
-  entity->header.checksum = 0;
+  m_pending.ensure(length);
 
-  entity->header.encode( &ptr );
+  for (size_t i=0; i<entities.size(); i++) {
+    entities[i]->header.flags |= EntityHeader::FLAG_REMOVE;
+    entities[i]->header.length = 0;
+    entities[i]->header.checksum = 0;
+    entities[i]->header.encode( &m_pending.ptr );
+  }
 
-  HT_ASSERT((ptr-buf.base) == (ptrdiff_t)buf.size);
-  memcpy(backup_buf, buf.base, buf.size);
+  commit(lock);
+}
 
-  m_fs->append(m_fd, buf, Filesystem::O_FLUSH);
-  FileUtils::write(m_backup_fd, backup_buf, buf.size);
-  m_offset += buf.size;
 
+/**
+ * Applies the entries of a flushed batch to m_live.  Only batches that were
+ * written successfully are applied, so a compaction never snapshots a state
+ * that did not make it into the log.
+ */
+void Writer::update_live_state(const uint8_t *base, size_t length) {
+  const uint8_t *end = base + length;
+  EntityHeader header;
+
+  while (base < end) {
+    const uint8_t *ptr = base;
+    size_t remaining = EntityHeader::LENGTH;
+    header.decode(&ptr, &remaining);
+    size_t entry_length = EntityHeader::LENGTH + header.length;
+    update_live_state(header, base, entry_length);
+    base += entry_length;
+  }
+  HT_ASSERT(base == end);
 }
 
 
-void Writer::record_removal(std::vector<Entity *> &entities) {
-  ScopedLock lock(m_mutex);
-  size_t length = entities.size() * EntityHeader::LENGTH;
+void Writer::update_live_state(const EntityHeader &header, const uint8_t *base,
+                               size_t length) {
+  if (header.type == EntityType::RECOVER)
+    return;
+  LiveMap::iterator iter = m_live.find(header);
+  if (iter != m_live.end()) {
+    m_live_bytes -= iter->second.length();
+    if (header.flags & EntityHeader::FLAG_REMOVE) {
+      m_live.erase(iter);
+      return;
+    }
+    iter->second.assign((const char *)base, length);
+  }
+  else if ((header.flags & EntityHeader::FLAG_REMOVE) == 0)
+    m_live[header].assign((const char *)base, length);
+  else
+    return;
+  m_live_bytes += length;
+}
 
-  if (m_fd == -1)
-    HT_THROWF(Error::CLOSED, "MetaLog '%s' has been closed", m_path.c_str());
 
-  {
-    StaticBuffer buf(length);
+/**
+ * Group commit: records encoded into m_pending by concurrent callers are
+ * written with a single append + flush.  The first caller to find no flush
+ * in progress becomes the leader and writes everything pending; the others
+ * wait until a flush covering their records has completed.
+ */
+void Writer::commit(ScopedLock &lock) {
+  int64_t seq = ++m_pending_seq;
+
+  while (m_flushed_seq < seq) {
+
+    if (m_flushing) {
+      m_cond.wait(lock);
+      continue;
+    }
+
+    if (m_fd == -1)
+      HT_THROWF(Error::CLOSED, "MetaLog '%s' has been closed", m_path.c_str());
+
+    m_flushing = true;
+    int64_t batch_seq = m_pending_seq;
+    size_t length = m_pending.fill();
+    StaticBuffer buf(m_pending);
     boost::shared_array<uint8_t> backup_buf( new uint8_t [length] );
-    uint8_t *ptr = buf.base;
+    memcpy(backup_buf.get(), buf.base, length);
 
-    for (size_t i=0; i<entities.size(); i++) {
-      entities[i]->header.flags |= EntityHeader::FLAG_REMOVE;
-      entities[i]->header.length = 0;
-      entities[i]->header.checksum = 0;
-      entities[i]->header.encode( &ptr );
+    lock.unlock();
+    try {
+      m_fs->append(m_fd, buf, Filesystem::O_FLUSH);
+      FileUtils::write(m_backup_fd, backup_buf.get(), length);
+    }
+    catch (Exception &e) {
+      lock.lock();
+      m_failed_seq = m_flushed_seq = batch_seq;
+      m_flushing = false;
+      m_cond.notify_all();
+      throw;
     }
+    lock.lock();
+
+    m_offset += length;
+    m_flushed_seq = batch_seq;
+    update_live_state(backup_buf.get(), length);
 
-    HT_ASSERT((ptr-buf.base) == (ptrdiff_t)buf.size);
-    memcpy(backup_buf.get(), buf.base, buf.size);
+    if (needs_compaction())
+      compact(lock);
+
+    m_flushing = false;
+    m_cond.notify_all();
+  }
 
-    m_fs->append(m_fd, buf, Filesystem::O_FLUSH);
-    FileUtils::write(m_backup_fd, backup_buf.get(), buf.size);
-    m_offset += buf.size;
+  if (seq <= m_failed_seq)
+    HT_THROWF(Error::DFSBROKER_IO_ERROR, "Error flushing %s metalog '%s'",
+              m_definition->name(), m_filename.c_str());
+}
+
+
+bool Writer::needs_compaction() {
+  if (m_offset < m_compaction_min_size)
+    return false;
+  int64_t garbage = m_offset - Header::LENGTH - m_live_bytes;
+  return garbage * 100 > m_compaction_garbage_pct * m_offset;
+}
+
+
+/**
+ * Rewrites the log as a fresh snapshot of the live entity states into the
+ * next log file.  The snapshot ends with a "Recover" entity, so a snapshot
+ * that was cut short is rejected by the Reader, which then falls back to
+ * the previous file.  Called by the flush leader with m_mutex held; the
+ * lock is released for the DFS I/O while m_flushing keeps other flushes
+ * and close() from touching the log file.
+ */
+void Writer::compact(ScopedLock &lock) {
+  int32_t next_id = m_file_id + 1;
+  String filename = m_path + "/" + next_id;
+  String backup_filename = m_backup_path + "/" + next_id;
+  int fd = -1, backup_fd = -1;
+
+  EntityRecover recover_entity;
+  size_t length = m_live_bytes + EntityHeader::LENGTH +
+    recover_entity.encoded_length();
+  StaticBuffer buf(length);
+  uint8_t *ptr = buf.base;
+  for (LiveMap::iterator iter = m_live.begin(); iter != m_live.end(); ++iter) {
+    memcpy(ptr, iter->second.data(), iter->second.length());
+    ptr += iter->second.length();
+  }
+  recover_entity.encode_entry(&ptr);
+  HT_ASSERT((size_t)(ptr-buf.base) == length);
+
+  boost::shared_array<uint8_t> backup_buf( new uint8_t [length] );
+  memcpy(backup_buf.get(), buf.base, length);
+
+  lock.unlock();
+
+  try {
+    fd = m_fs->create(filename, 0, DFS_BUFFER_SIZE, m_replication, DFS_BLOCK_SIZE);
+    backup_fd = ::open(backup_filename.c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644);
+    write_header(fd, backup_fd, filename);
+    m_fs->append(fd, buf, Filesystem::O_FLUSH);
+    FileUtils::write(backup_fd, backup_buf.get(), length);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << "Problem compacting " << m_definition->name() << " metalog "
+                 << m_filename << " into " << filename << " - " << e << HT_END;
+    // Keep appending to the old file
+    try {
+      if (fd != -1)
+        m_fs->close(fd);
+      m_fs->remove(filename);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+    }
+    if (backup_fd != -1)
+      ::close(backup_fd);
+    FileUtils::unlink(backup_filename);
+    lock.lock();
+    // Don't retry on every flush
+    m_compaction_min_size = m_offset * 2;
+    return;
+  }
+
+  lock.lock();
+  int64_t old_offset = m_offset;
+  String old_filename = m_filename;
+  std::swap(fd, m_fd);
+  std::swap(backup_fd, m_backup_fd);
+  m_offset = Header::LENGTH + length;
+  m_file_id = next_id;
+  m_filename = filename;
+  m_backup_filename = backup_filename;
+  lock.unlock();
+
+  HT_INFOF("Compacted %s metalog %s (%lld bytes) into %s (%lld bytes)",
+           m_definition->name(), old_filename.c_str(), (Lld)old_offset,
+           filename.c_str(), (Lld)(Header::LENGTH + length));
+
+  try {
+    m_fs->close(fd);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+  }
+  ::close(backup_fd);
+
+  try {
+    std::vector<int32_t> file_ids;
+    int32_t unused;
+    scan_log_directory(m_fs, m_path, file_ids, &unused);
+    purge_old_log_files(file_ids, KEEP_LOG_FILES);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
   }
 
+  lock.lock();
 }
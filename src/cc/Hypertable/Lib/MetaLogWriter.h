@@ -26,8 +26,13 @@
 #include "Common/Mutex.h"
 #include "Common/ReferenceCount.h"
 
+#include <map>
 #include <vector>
 
+#include <boost/thread/condition.hpp>
+
+#include "Common/DynamicBuffer.h"
+
 #include "MetaLogDefinition.h"
 #include "MetaLogEntity.h"
 
@@ -35,6 +40,12 @@ namespace Hypertable {
 
   namespace MetaLog {
 
+    /**
+     * Appends entity state changes to a MetaLog.  Concurrent record_state()
+     * and record_removal() calls are batched into a single flush, and the
+     * log is rewritten as a snapshot of the live entities once the garbage
+     * in it crosses Hypertable.MetaLog.Compaction.GarbageThreshold.Percentage.
+     */
     class Writer : public ReferenceCount {
     public:
       Writer(FilesystemPtr &fs, DefinitionPtr &definition, const String &path,
@@ -49,21 +60,43 @@ namespace Hypertable {
       static bool skip_recover_entry;
 
     private:
-      void write_header();
+      typedef std::map<EntityHeader, String> LiveMap;
+
+      void write_header(int fd, int backup_fd, const String &filename);
       void purge_old_log_files(std::vector<int32_t> &file_ids, size_t keep_count);
-      void initialize_new_log_file(int32_t next_id);
+      void update_live_state(const uint8_t *base, size_t length);
+      void update_live_state(const EntityHeader &header, const uint8_t *base,
+                             size_t length);
+      void commit(ScopedLock &lock);
+      bool needs_compaction();
+      void compact(ScopedLock &lock);
 
       Mutex m_mutex;
+      boost::condition m_cond;
       FilesystemPtr m_fs;
       DefinitionPtr m_definition;
       String  m_path;
       String  m_filename;
       int m_fd;
-      int32_t m_backup_fileno;
+      int32_t m_file_id;
       String  m_backup_path;
       String  m_backup_filename;
       int m_backup_fd;
-      int m_offset;
+      int64_t m_offset;
+      int32_t m_replication;
+
+      // Latest encoded state of each live entity, for compaction
+      LiveMap m_live;
+      int64_t m_live_bytes;
+      int64_t m_compaction_min_size;
+      int32_t m_compaction_garbage_pct;
+
+      // Group commit state
+      DynamicBuffer m_pending;
+      int64_t m_pending_seq;
+      int64_t m_flushed_seq;
+      int64_t m_failed_seq;
+      bool m_flushing;
     };
     typedef intrusive_ptr<Writer> WriterPtr;
     
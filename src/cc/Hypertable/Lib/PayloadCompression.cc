@@ -0,0 +1,177 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "AsyncComm/Protocol.h"
+
+#include "CompressorFactory.h"
+#include "PayloadCompression.h"
+
+using namespace Hypertable;
+
+const char PayloadCompression::MAGIC[10] =
+  { 'P','a','y','l','o','a','d','-','-','-' };
+
+Mutex PayloadCompression::ms_mutex;
+bool PayloadCompression::ms_initialized = false;
+uint32_t PayloadCompression::ms_threshold = 0;
+BlockCompressionCodec::Type PayloadCompression::ms_codec_type =
+  BlockCompressionCodec::NONE;
+BlockCompressionCodec::Args PayloadCompression::ms_codec_args;
+std::set<CommAddress> PayloadCompression::ms_accepting;
+
+
+void PayloadCompression::initialize() {
+  String spec = "snappy";
+  int32_t threshold = 32*1024;
+
+  if (Config::properties) {
+    spec = Config::properties->get_str("Hypertable.Network.Compression.Codec",
+                                       spec);
+    threshold = Config::properties->get_i32(
+        "Hypertable.Network.Compression.Threshold", threshold);
+  }
+
+  ms_codec_type = CompressorFactory::parse_block_codec_spec(spec,
+                                                            ms_codec_args);
+  if (threshold > 0 && ms_codec_type != BlockCompressionCodec::NONE)
+    ms_threshold = threshold;
+  ms_initialized = true;
+}
+
+
+bool PayloadCompression::enabled() {
+  ScopedLock lock(ms_mutex);
+  if (!ms_initialized)
+    initialize();
+  return ms_threshold > 0;
+}
+
+
+void PayloadCompression::compress(CommBufPtr &cbuf, size_t offset) {
+
+  if (!enabled())
+    return;
+
+  size_t header_len = cbuf->header.encoded_length();
+  size_t data_len = cbuf->data.size - header_len;
+  size_t payload_len = data_len + cbuf->ext.size;
+
+  if (payload_len < ms_threshold || payload_len <= offset)
+    return;
+
+  HT_ASSERT(offset <= data_len);
+
+  DynamicBuffer input(payload_len - offset);
+  input.add_unchecked(cbuf->data.base + header_len + offset, data_len - offset);
+  if (cbuf->ext.size)
+    input.add_unchecked(cbuf->ext.base, cbuf->ext.size);
+
+  BlockCompressionCodecPtr codec =
+    CompressorFactory::create_block_codec(ms_codec_type, ms_codec_args);
+  BlockCompressionHeader header(MAGIC);
+  DynamicBuffer output;
+
+  codec->deflate(input, output, header);
+
+  // not worth sending compressed
+  if (header.get_compression_type() == BlockCompressionCodec::NONE ||
+      output.fill() >= input.fill())
+    return;
+
+  CommHeader comm_header = cbuf->header;
+  comm_header.flags |= CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED;
+
+  CommBufPtr new_cbuf = new CommBuf(comm_header, offset + output.fill());
+  if (offset)
+    new_cbuf->append_bytes(cbuf->data.base + header_len, offset);
+  new_cbuf->append_bytes(output.base, output.fill());
+
+  cbuf = new_cbuf;
+}
+
+
+void PayloadCompression::inflate(EventPtr &event, size_t offset) {
+
+  if ((event->header.flags & CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED) == 0)
+    return;
+
+  if (event->payload_len < offset)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Compressed payload length "
+              "(%lu) shorter than uncompressed prefix (%lu)",
+              (Lu)event->payload_len, (Lu)offset);
+
+  DynamicBuffer input(0, false);
+  input.base = (uint8_t *)event->payload + offset;
+  input.ptr = input.base + (event->payload_len - offset);
+  input.size = input.fill();
+
+  BlockCompressionHeader header;
+  const uint8_t *ptr = input.base;
+  size_t remaining = input.fill();
+
+  header.decode(&ptr, &remaining);
+
+  if (!header.check_magic(MAGIC))
+    HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, "Bad compressed payload magic");
+
+  BlockCompressionCodecPtr codec = CompressorFactory::create_block_codec(
+      (BlockCompressionCodec::Type)header.get_compression_type());
+  DynamicBuffer output;
+
+  codec->inflate(input, output, header);
+
+  uint8_t *payload = new uint8_t [offset + output.fill()];
+  memcpy(payload, event->payload, offset);
+  memcpy(payload + offset, output.base, output.fill());
+
+  delete [] event->payload;
+  event->payload = payload;
+  event->payload_len = offset + output.fill();
+  event->header.flags &= CommHeader::FLAGS_MASK_PAYLOAD_COMPRESSED;
+}
+
+
+bool PayloadCompression::accepted(const CommAddress &addr) {
+  ScopedLock lock(ms_mutex);
+  return ms_accepting.count(addr) > 0;
+}
+
+
+void PayloadCompression::record_response(const CommAddress &addr,
+                                         EventPtr &event) {
+
+  // Error responses are built from the request flags by any server version
+  if (event->type != Event::MESSAGE ||
+      Protocol::response_code(event.get()) != Error::OK)
+    return;
+
+  ScopedLock lock(ms_mutex);
+  if (event->header.flags & CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED)
+    ms_accepting.insert(addr);
+  else
+    ms_accepting.erase(addr);
+}
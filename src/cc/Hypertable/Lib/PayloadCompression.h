@@ -0,0 +1,109 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_PAYLOADCOMPRESSION_H
+#define HYPERTABLE_PAYLOADCOMPRESSION_H
+
+#include <set>
+
+#include "Common/Mutex.h"
+
+#include "AsyncComm/CommAddress.h"
+#include "AsyncComm/CommBuf.h"
+#include "AsyncComm/Event.h"
+
+#include "BlockCompressionCodec.h"
+
+namespace Hypertable {
+
+  /** Compression of RangeServer message payloads on the wire.  A client
+   * sets CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED on CREATE_SCANNER and
+   * FETCH_SCANBLOCK requests and the RangeServer compresses scan blocks in
+   * its response.  Update requests are only compressed once the RangeServer
+   * has advertised that it can inflate them by setting
+   * CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED in an update response, so older
+   * servers, which echo the request flags unchanged, keep receiving
+   * uncompressed updates.  Compressed payloads carry
+   * CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED and leave a fixed-length prefix
+   * (e.g. the response error code) uncompressed so that it can be inspected
+   * before inflating.  The codec and minimum payload size are taken from
+   * the Hypertable.Network.Compression properties.
+   */
+  class PayloadCompression {
+  public:
+
+    /** Returns <i>true</i> if payload compression is enabled, i.e.
+     * Hypertable.Network.Compression.Threshold is non-zero
+     */
+    static bool enabled();
+
+    /** Compresses the payload of a message.  The message is left unchanged
+     * if compression is disabled, the payload is smaller than the threshold,
+     * or it does not compress.  Otherwise <code>cbuf</code> is replaced with
+     * a message holding the first <code>offset</code> bytes of the payload
+     * followed by the compressed remainder.
+     *
+     * @param cbuf message to compress, header and payload fully populated
+     * @param offset length of uncompressed payload prefix
+     */
+    static void compress(CommBufPtr &cbuf, size_t offset=0);
+
+    /** Inflates the payload of a message received with
+     * CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED set, replacing the event
+     * payload with the uncompressed one and clearing the flag.  Does
+     * nothing if the flag is not set.
+     *
+     * @param event message event
+     * @param offset length of uncompressed payload prefix
+     */
+    static void inflate(EventPtr &event, size_t offset=0);
+
+    /** Returns <i>true</i> if <code>addr</code> is known to accept
+     * compressed update payloads.
+     *
+     * @param addr address of RangeServer
+     */
+    static bool accepted(const CommAddress &addr);
+
+    /** Records whether or not <code>addr</code> accepts compressed update
+     * payloads, based on the flags of a response received from it.
+     *
+     * @param addr address of RangeServer
+     * @param event response event
+     */
+    static void record_response(const CommAddress &addr, EventPtr &event);
+
+    static const char MAGIC[10];
+
+  private:
+    static void initialize();
+
+    static Mutex ms_mutex;
+    static bool ms_initialized;
+    static uint32_t ms_threshold;
+    static BlockCompressionCodec::Type ms_codec_type;
+    static BlockCompressionCodec::Args ms_codec_args;
+    static std::set<CommAddress> ms_accepting;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_PAYLOADCOMPRESSION_H
@@ -27,6 +27,7 @@
 
 #include "AsyncComm/DispatchHandlerSynchronizer.h"
 
+#include "PayloadCompression.h"
 #include "RangeServerClient.h"
 #include "ScanBlock.h"
 
@@ -176,6 +177,8 @@ RangeServerClient::update(const CommAddress &addr, const TableIdentifier &table,
     uint32_t count, StaticBuffer &buffer, uint32_t flags, DispatchHandler *handler) {
   CommBufPtr cbp(RangeServerProtocol::create_request_update(table, count,
                                                             buffer, flags));
+  if (PayloadCompression::accepted(addr))
+    PayloadCompression::compress(cbp);
   send_message(addr, cbp, handler, m_default_timeout_ms);
 }
 
@@ -185,6 +188,8 @@ RangeServerClient::update(const CommAddress &addr, const TableIdentifier &table,
                           DispatchHandler *handler, Timer &timer) {
   CommBufPtr cbp(RangeServerProtocol::create_request_update(table, count,
                                                             buffer, flags));
+  if (PayloadCompression::accepted(addr))
+    PayloadCompression::compress(cbp);
   send_message(addr, cbp, handler, timer.remaining());
 }
 
@@ -210,12 +215,15 @@ RangeServerClient::do_update(const CommAddress &addr, const TableIdentifier &tab
   EventPtr event;
   CommBufPtr cbp(RangeServerProtocol::create_request_update(table, count,
                                                             buffer, flags));
+  if (PayloadCompression::accepted(addr))
+    PayloadCompression::compress(cbp);
   send_message(addr, cbp, &sync_handler, timeout_ms);
 
   if (!sync_handler.wait_for_reply(event))
     HT_THROW((int)Protocol::response_code(event), 
             String("RangeServer update() failure : ") 
                 + Protocol::string_format_message(event));
+  PayloadCompression::record_response(addr, event);
 }
 
 void
@@ -616,6 +624,36 @@ RangeServerClient::do_relinquish_range(const CommAddress &addr, const TableIdent
              + Protocol::string_format_message(event));
 }
 
+void RangeServerClient::import_cellstores(const CommAddress &addr,
+                   const TableIdentifier &table, const RangeSpec &range,
+                   const String &ag_name, const std::vector<String> &files) {
+  do_import_cellstores(addr, table, range, ag_name, files, m_default_timeout_ms);
+}
+
+void RangeServerClient::import_cellstores(const CommAddress &addr,
+                   const TableIdentifier &table, const RangeSpec &range,
+                   const String &ag_name, const std::vector<String> &files,
+                   Timer &timer) {
+  do_import_cellstores(addr, table, range, ag_name, files, timer.remaining());
+}
+
+void
+RangeServerClient::do_import_cellstores(const CommAddress &addr,
+                   const TableIdentifier &table, const RangeSpec &range,
+                   const String &ag_name, const std::vector<String> &files,
+                   uint32_t timeout_ms) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event;
+  CommBufPtr cbp(RangeServerProtocol::create_request_import_cellstores(table,
+                     range, ag_name, files));
+  send_message(addr, cbp, &sync_handler, timeout_ms);
+
+  if (!sync_handler.wait_for_reply(event))
+    HT_THROW((int)Protocol::response_code(event),
+             String("RangeServer import_cellstores() failure : ")
+             + Protocol::string_format_message(event));
+}
+
 void RangeServerClient::heapcheck(const CommAddress &addr, String &outfile) {
   DispatchHandlerSynchronizer sync_handler;
   EventPtr event;
@@ -544,6 +544,33 @@ namespace Hypertable {
     void relinquish_range(const CommAddress &addr, const TableIdentifier &table,
                           const RangeSpec &range, Timer &timer);
 
+    /** Issues an "import cellstores" request synchronously.  Attaches the
+     * given pre-built CellStore files to access group <code>ag_name</code>
+     * of the range.
+     *
+     * @param addr address of RangeServer
+     * @param table table identifier
+     * @param range range specification
+     * @param ag_name access group name
+     * @param files DFS paths of the CellStore files to import
+     */
+    void import_cellstores(const CommAddress &addr, const TableIdentifier &table,
+                           const RangeSpec &range, const String &ag_name,
+                           const std::vector<String> &files);
+
+    /** Issues an "import cellstores" request synchronously, with timer.
+     *
+     * @param addr address of RangeServer
+     * @param table table identifier
+     * @param range range specification
+     * @param ag_name access group name
+     * @param files DFS paths of the CellStore files to import
+     * @param timer timer
+     */
+    void import_cellstores(const CommAddress &addr, const TableIdentifier &table,
+                           const RangeSpec &range, const String &ag_name,
+                           const std::vector<String> &files, Timer &timer);
+
     /** Issues a "heapcheck" request.  This call blocks until it receives a
      * response from the server.
      *
@@ -650,6 +677,9 @@ namespace Hypertable {
                            uint32_t timeout_ms);
     void do_relinquish_range(const CommAddress &addr, const TableIdentifier &table,
                              const RangeSpec &range, uint32_t timeout_ms);
+    void do_import_cellstores(const CommAddress &addr, const TableIdentifier &table,
+                              const RangeSpec &range, const String &ag_name,
+                              const std::vector<String> &files, uint32_t timeout_ms);
 
     void send_message(const CommAddress &addr, CommBufPtr &cbp,
                       DispatchHandler *handler, uint32_t timeout_ms);
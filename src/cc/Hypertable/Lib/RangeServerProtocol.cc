@@ -23,6 +23,7 @@
 #include "AsyncComm/CommBuf.h"
 #include "AsyncComm/CommHeader.h"
 
+#include "PayloadCompression.h"
 #include "RangeServerProtocol.h"
 
 namespace Hypertable {
@@ -54,11 +55,14 @@ namespace Hypertable {
     "relinquish range",
     "heapcheck",
     "metadata sync",
+    "initialize",
     "replay fragments",
     "phantom receive",
     "phantom update",
     "phantom prepare ranges",
     "phantom commit ranges",
+    "import cellstores",
+    "create aggregate scanner",
     (const char *)0
   };
 
@@ -181,9 +185,15 @@ namespace Hypertable {
   CommBuf *RangeServerProtocol::
   create_request_create_scanner(const TableIdentifier &table,
       const RangeSpec &range, const ScanSpec &scan_spec) {
-    CommHeader header(COMMAND_CREATE_SCANNER);
+    // Aggregate scans use their own command so that RangeServers that
+    // cannot aggregate reject them instead of returning the raw cells
+    CommHeader header(scan_spec.aggregate == ScanSpec::AGGREGATE_NONE ?
+                      COMMAND_CREATE_SCANNER :
+                      COMMAND_CREATE_AGGREGATE_SCANNER);
     if (table.is_system()) // If system table, set the urgent bit
       header.flags |= CommHeader::FLAGS_BIT_URGENT;
+    if (PayloadCompression::enabled())
+      header.flags |= CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED;
     CommBuf *cbuf = new CommBuf(header, table.encoded_length()
         + range.encoded_length() + scan_spec.encoded_length());
     table.encode(cbuf->get_data_ptr_address());
@@ -203,6 +213,8 @@ namespace Hypertable {
   CommBuf *RangeServerProtocol::create_request_fetch_scanblock(int scanner_id) {
     CommHeader header(COMMAND_FETCH_SCANBLOCK);
     header.gid = scanner_id;
+    if (PayloadCompression::enabled())
+      header.flags |= CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED;
     CommBuf *cbuf = new CommBuf(header, 4);
     cbuf->append_i32(scanner_id);
     return cbuf;
@@ -347,6 +359,26 @@ namespace Hypertable {
     return cbuf;
   }
 
+  CommBuf *
+  RangeServerProtocol::create_request_import_cellstores(const TableIdentifier &table,
+                                                        const RangeSpec &range,
+                                                        const String &ag_name,
+                                                        const std::vector<String> &files) {
+    CommHeader header(COMMAND_IMPORT_CELLSTORES);
+    size_t len = table.encoded_length() + range.encoded_length()
+      + encoded_length_vstr(ag_name) + 4;
+    foreach_ht(const String &file, files)
+      len += encoded_length_vstr(file);
+    CommBuf *cbuf = new CommBuf(header, len);
+    table.encode(cbuf->get_data_ptr_address());
+    range.encode(cbuf->get_data_ptr_address());
+    cbuf->append_vstr(ag_name);
+    cbuf->append_i32(files.size());
+    foreach_ht(const String &file, files)
+      cbuf->append_vstr(file);
+    return cbuf;
+  }
+
   CommBuf *RangeServerProtocol::create_request_heapcheck(const String &outfile) {
     CommHeader header(COMMAND_HEAPCHECK);
     header.flags |= CommHeader::FLAGS_BIT_URGENT;
@@ -67,7 +67,9 @@ namespace Hypertable {
     static const uint64_t COMMAND_PHANTOM_UPDATE           = 27;
     static const uint64_t COMMAND_PHANTOM_PREPARE_RANGES   = 28;
     static const uint64_t COMMAND_PHANTOM_COMMIT_RANGES    = 29;
-    static const uint64_t COMMAND_MAX                      = 30;
+    static const uint64_t COMMAND_IMPORT_CELLSTORES        = 30;
+    static const uint64_t COMMAND_CREATE_AGGREGATE_SCANNER = 31;
+    static const uint64_t COMMAND_MAX                      = 32;
 
     static const char *m_command_strings[];
 
@@ -288,6 +290,21 @@ namespace Hypertable {
     static CommBuf *create_request_relinquish_range(const TableIdentifier &table,
                                                     const RangeSpec &range);
 
+    /** Creates an "import cellstores" request message.  The files must be
+     * pre-built, sorted CellStores residing in the DFS that contain only
+     * cells belonging to the given range.
+     *
+     * @param table table identifier
+     * @param range range specification
+     * @param ag_name name of access group to which the files are added
+     * @param files DFS paths of the CellStore files to import
+     * @return protocol message
+     */
+    static CommBuf *create_request_import_cellstores(const TableIdentifier &table,
+                                                     const RangeSpec &range,
+                                                     const String &ag_name,
+                                                     const std::vector<String> &files);
+
     /** Creates a "heapcheck" request message.
      *
      * @param outfile name of file to dump heap stats to
@@ -26,6 +26,7 @@
 #include "AsyncComm/Protocol.h"
 #include "Common/Serialization.h"
 
+#include "PayloadCompression.h"
 #include "ScanBlock.h"
 
 using namespace Hypertable;
@@ -45,8 +46,8 @@ ScanBlock::ScanBlock() : m_flags(0x0001), m_scanner_id(-1),
  *
  */
 int ScanBlock::load(EventPtr &event_ptr) {
-  const uint8_t *decode_ptr = event_ptr->payload + 4;
-  size_t decode_remain = event_ptr->payload_len - 4;
+  const uint8_t *decode_ptr;
+  size_t decode_remain;
   uint32_t len;
 
   m_event = event_ptr;
@@ -57,6 +58,10 @@ int ScanBlock::load(EventPtr &event_ptr) {
     return m_error;
 
   try {
+    // everything following the error code may be compressed
+    PayloadCompression::inflate(event_ptr, 4);
+    decode_ptr = event_ptr->payload + 4;
+    decode_remain = event_ptr->payload_len - 4;
     m_flags = decode_i16(&decode_ptr, &decode_remain);
     m_scanner_id = decode_i32(&decode_ptr, &decode_remain);
     m_skipped_rows = decode_i32(&decode_ptr, &decode_remain);
@@ -35,23 +35,36 @@ using namespace std;
 using namespace Hypertable;
 using namespace Serialization;
 
+/**
+ * The upper bound is only serialized for BETWEEN, which keeps the encoding
+ * of the other operations unchanged.
+ */
 size_t ColumnPredicate::encoded_length() const {
-  return sizeof(uint32_t)
+  size_t len = sizeof(uint32_t)
           + encoded_length_vstr(column_family) 
           + encoded_length_vstr(value_len);
+  if ((operation & OPERATION_MASK) == BETWEEN)
+    len += encoded_length_vstr(end_value_len);
+  return len;
 }
 
 void ColumnPredicate::encode(uint8_t **bufp) const {
   encode_vstr(bufp, column_family);
   encode_i32(bufp, operation);
   encode_vstr(bufp, value, value_len);
+  if ((operation & OPERATION_MASK) == BETWEEN)
+    encode_vstr(bufp, end_value, end_value_len);
 }
 
 void ColumnPredicate::decode(const uint8_t **bufp, size_t *remainp) {
   HT_TRY("decoding column predicate",
     column_family = decode_vstr(bufp, remainp);
     operation = decode_i32(bufp, remainp);
-    value = decode_vstr(bufp, remainp, &value_len));
+    value = decode_vstr(bufp, remainp, &value_len);
+    end_value = 0;
+    end_value_len = 0;
+    if ((operation & OPERATION_MASK) == BETWEEN)
+      end_value = decode_vstr(bufp, remainp, &end_value_len));
 }
 
 size_t RowInterval::encoded_length() const {
@@ -99,6 +112,12 @@ void CellInterval::decode(const uint8_t **bufp, size_t *remainp) {
     end_inclusive = decode_bool(bufp, remainp));
 }
 
+/**
+ * The aggregate function is only serialized when one is set, so scans
+ * without aggregation encode as they did before it was added.  It is the
+ * last field and the scan spec ends the "create scanner" request, so its
+ * presence is given by the remaining length.
+ */
 size_t ScanSpec::encoded_length() const {
   size_t len = encoded_length_vi32(row_limit) +
                encoded_length_vi32(cell_limit) +
@@ -113,6 +132,9 @@ size_t ScanSpec::encoded_length() const {
                encoded_length_vi32(row_offset) +
                encoded_length_vi32(cell_offset);
 
+  if (aggregate != AGGREGATE_NONE)
+    len += encoded_length_vi32(aggregate);
+
   foreach_ht(const char *c, columns) len += encoded_length_vstr(c);
   foreach_ht(const RowInterval &ri, row_intervals) len += ri.encoded_length();
   foreach_ht(const CellInterval &ci, cell_intervals) len += ci.encoded_length();
@@ -143,6 +165,8 @@ void ScanSpec::encode(uint8_t **bufp) const {
   encode_bool(bufp, scan_and_filter_rows);
   encode_vi32(bufp, row_offset);
   encode_vi32(bufp, cell_offset);
+  if (aggregate != AGGREGATE_NONE)
+    encode_vi32(bufp, aggregate);
 }
 
 void ScanSpec::decode(const uint8_t **bufp, size_t *remainp) {
@@ -176,7 +200,8 @@ void ScanSpec::decode(const uint8_t **bufp, size_t *remainp) {
     value_regexp = decode_vstr(bufp, remainp);
     scan_and_filter_rows = decode_bool(bufp, remainp);
     row_offset = decode_vi32(bufp, remainp);
-    cell_offset = decode_vi32(bufp, remainp));
+    cell_offset = decode_vi32(bufp, remainp);
+    aggregate = *remainp ? decode_vi32(bufp, remainp) : AGGREGATE_NONE);
 }
 
 
@@ -240,6 +265,7 @@ ostream &Hypertable::operator<<(ostream &os, const ScanSpec &scan_spec) {
   os <<" scan_and_filter_rows=" << scan_spec.scan_and_filter_rows;
   os <<" row_offset=" << scan_spec.row_offset;
   os <<" cell_offset=" << scan_spec.cell_offset;
+  os <<" aggregate=" << scan_spec.aggregate;
 
   if (!scan_spec.row_intervals.empty()) {
     os << "\n rows=";
@@ -253,9 +279,13 @@ ostream &Hypertable::operator<<(ostream &os, const ScanSpec &scan_spec) {
   }
   if (!scan_spec.column_predicates.empty()) {
     os << "\n column_predicates=";
-    foreach_ht(const ColumnPredicate &cp, scan_spec.column_predicates)
+    foreach_ht(const ColumnPredicate &cp, scan_spec.column_predicates) {
       os << " (" << cp.column_family << " " << cp.operation << " " 
-         << cp.value << ")";
+         << cp.value;
+      if (cp.end_value)
+        os << " " << cp.end_value;
+      os << ")";
+    }
   }
   if (!scan_spec.columns.empty()) {
     os << "\n columns=(";
@@ -281,7 +311,7 @@ ScanSpec::ScanSpec(CharArena &arena, const ScanSpec &ss)
     time_interval(ss.time_interval.first, ss.time_interval.second),
     return_deletes(ss.return_deletes), keys_only(ss.keys_only),
     row_regexp(arena.dup(ss.row_regexp)), value_regexp(arena.dup(ss.value_regexp)),
-    scan_and_filter_rows(ss.scan_and_filter_rows) {
+    scan_and_filter_rows(ss.scan_and_filter_rows), aggregate(ss.aggregate) {
   columns.reserve(ss.columns.size());
   row_intervals.reserve(ss.row_intervals.size());
   cell_intervals.reserve(ss.cell_intervals.size());
@@ -299,7 +329,7 @@ ScanSpec::ScanSpec(CharArena &arena, const ScanSpec &ss)
                       ci.end_row, ci.end_column, ci.end_inclusive);
 
   foreach_ht(const ColumnPredicate &cp, ss.column_predicates)
-    add_column_predicate(arena, cp.column_family, cp.operation, cp.value);
+    add_column_predicate(arena, cp);
 }
 
 void ScanSpec::parse_column(const char *column_str, String &family, 
@@ -342,6 +372,22 @@ void ScanSpec::parse_column(const char *column_str, String &family,
 }
 
 void ScanSpec::throw_if_invalid() const {
+  if (aggregate != AGGREGATE_NONE) {
+    if (aggregate < AGGREGATE_COUNT_ROWS || aggregate > AGGREGATE_MAX)
+      HT_THROWF(Error::BAD_SCAN_SPEC, "Unknown aggregate function %d",
+                (int)aggregate);
+    if (row_limit || cell_limit || cell_limit_per_family ||
+        row_offset || cell_offset)
+      HT_THROW(Error::BAD_SCAN_SPEC, "Aggregate scans cannot be combined "
+               "with limits or offsets");
+    if (!cell_intervals.empty())
+      HT_THROW(Error::BAD_SCAN_SPEC, "Aggregate scans cannot be combined "
+               "with cell intervals");
+    if (keys_only || return_deletes)
+      HT_THROW(Error::BAD_SCAN_SPEC, "Aggregate scans cannot be combined "
+               "with KEYS_ONLY or RETURN_DELETES");
+  }
+
   // check if the ColumnPredicate column is identical to the retrieved column
   if (columns.empty() || column_predicates.empty())
     return;
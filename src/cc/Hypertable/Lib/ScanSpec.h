@@ -34,6 +34,11 @@ namespace Hypertable {
 /**
  * Represents a column predicate (... WHERE cf = "value").  
  * c-string data members are not managed so caller must handle (de)allocation.
+ *
+ * The comparison operations compare values as byte strings, or as signed
+ * decimal integers if INTEGER_COMPARISON is or'ed into the operation.
+ * Values of counter columns are always compared as integers.  For BETWEEN,
+ * value holds the lower and end_value the upper bound, both inclusive.
  */
 class ColumnPredicate {
 public:
@@ -41,20 +46,37 @@ public:
     NO_OPERATION = 0,
     EXACT_MATCH,
     PREFIX_MATCH,
-    CONTAINS
+    CONTAINS,
+    LESS_THAN,
+    LESS_OR_EQUAL,
+    GREATER_THAN,
+    GREATER_OR_EQUAL,
+    BETWEEN
+  };
+
+  enum {
+    OPERATION_MASK     = 0x00FF,
+    INTEGER_COMPARISON = 0x0100
   };
 
   ColumnPredicate() : column_family(0), operation(0),
-    value(0), value_len(0) { }
+    value(0), value_len(0), end_value(0), end_value_len(0) { }
 
   ColumnPredicate(const char *_column_family, uint32_t _operation,
           const char *_value, uint32_t _value_len = 0)
     : column_family(_column_family), operation(_operation),
-       value(_value), value_len(_value_len) {
+       value(_value), value_len(_value_len), end_value(0), end_value_len(0) {
     if (!value_len && value)
       value_len = strlen(value);
   }
 
+  ColumnPredicate(const char *_column_family, uint32_t _operation,
+          const char *_value, const char *_end_value)
+    : column_family(_column_family), operation(_operation),
+       value(_value), value_len(_value ? strlen(_value) : 0),
+       end_value(_end_value), end_value_len(_end_value ? strlen(_end_value) : 0) {
+  }
+
   ColumnPredicate(const uint8_t **bufp, size_t *remainp) {
     decode(bufp, remainp);
   }
@@ -63,10 +85,18 @@ public:
   void encode(uint8_t **bufp) const;
   void decode(const uint8_t **bufp, size_t *remainp);
 
+  /** Returns true if the operation compares values by order */
+  bool is_comparison() const {
+    uint32_t op = operation & OPERATION_MASK;
+    return op >= LESS_THAN && op <= BETWEEN;
+  }
+
   const char *column_family;
   uint32_t operation;
   const char *value;
   uint32_t value_len;
+  const char *end_value;
+  uint32_t end_value_len;
 };
 
 /**
@@ -143,12 +173,24 @@ typedef std::vector<ColumnPredicate, ColumnPredicateAlloc> ColumnPredicates;
  */
 class ScanSpec {
 public:
+  /** Aggregate functions that may be pushed down to the RangeServers.
+   * Each range returns partial aggregates which TableScanner merges. */
+  enum {
+    AGGREGATE_NONE = 0,
+    AGGREGATE_COUNT_ROWS,
+    AGGREGATE_COUNT,
+    AGGREGATE_SUM,
+    AGGREGATE_MIN,
+    AGGREGATE_MAX
+  };
+
   ScanSpec()
     : row_limit(0), cell_limit(0), cell_limit_per_family(0), 
       row_offset(0), cell_offset(0), max_versions(0),
       time_interval(TIMESTAMP_MIN, TIMESTAMP_MAX),
       return_deletes(false), keys_only(false),
-      row_regexp(0), value_regexp(0), scan_and_filter_rows(false) { }
+      row_regexp(0), value_regexp(0), scan_and_filter_rows(false),
+      aggregate(AGGREGATE_NONE) { }
   ScanSpec(CharArena &arena)
     : row_limit(0), cell_limit(0), cell_limit_per_family(0), 
       row_offset(0), cell_offset(0), max_versions(0), columns(CstrAlloc(arena)),
@@ -157,7 +199,8 @@ public:
       column_predicates(ColumnPredicateAlloc(arena)),
       time_interval(TIMESTAMP_MIN, TIMESTAMP_MAX),
       return_deletes(false), keys_only(false),
-      row_regexp(0), value_regexp(0), scan_and_filter_rows(false) { }
+      row_regexp(0), value_regexp(0), scan_and_filter_rows(false),
+      aggregate(AGGREGATE_NONE) { }
   ScanSpec(CharArena &arena, const ScanSpec &);
   ScanSpec(const uint8_t **bufp, size_t *remainp) { decode(bufp, remainp); }
 
@@ -183,6 +226,7 @@ public:
     row_regexp = 0;
     value_regexp = 0;
     scan_and_filter_rows = false;
+    aggregate = AGGREGATE_NONE;
   }
 
   /** 
@@ -211,9 +255,12 @@ public:
     other.value_regexp = value_regexp;
     other.scan_and_filter_rows = scan_and_filter_rows;
     other.column_predicates = column_predicates;
+    other.aggregate = aggregate;
   }
 
   bool cacheable() {
+    if (aggregate != AGGREGATE_NONE)
+      return false;
     if (row_intervals.size() == 1) {
       HT_ASSERT(row_intervals[0].start && row_intervals[0].end);
       if (!strcmp(row_intervals[0].start, row_intervals[0].end))
@@ -331,6 +378,21 @@ public:
     column_predicates.push_back(cp);
   }
 
+  void add_column_predicate(CharArena &arena, const ColumnPredicate &src) {
+    ColumnPredicate cp;
+    cp.column_family = arena.dup(src.column_family);
+    cp.operation = src.operation;
+    if (src.value) {
+      cp.value = arena.dup(src.value);
+      cp.value_len = src.value_len;
+    }
+    if (src.end_value) {
+      cp.end_value = arena.dup(src.end_value);
+      cp.end_value_len = src.end_value_len;
+    }
+    column_predicates.push_back(cp);
+  }
+
   void set_time_interval(int64_t start, int64_t end) {
     time_interval.first = start;
     time_interval.second = end;
@@ -363,6 +425,7 @@ public:
   const char *row_regexp;
   const char *value_regexp;
   bool scan_and_filter_rows;
+  int32_t aggregate;
 };
 
 /**
@@ -473,6 +536,16 @@ public:
             value, value_len);
   }
 
+  /**
+   * Adds a copy of a column predicate to the scan, including the upper
+   * bound of a BETWEEN predicate
+   *
+   * @param cp column predicate to copy
+   */
+  void add_column_predicate(const ColumnPredicate &cp) {
+    m_scan_spec.add_column_predicate(m_arena, cp);
+  }
+
   /**
    * Adds a row to be returned in the scan
    *
@@ -569,6 +642,15 @@ public:
     m_scan_spec.scan_and_filter_rows = val;
   }
 
+  /**
+   * Aggregate the scanned cells on the RangeServers instead of returning
+   * them.  COUNT_ROWS counts rows, the other functions produce one value
+   * per column family; SUM, MIN and MAX interpret values as integers.
+   */
+  void set_aggregate(int32_t function) {
+    m_scan_spec.aggregate = function;
+  }
+
   /**
    * Clears the state.
    */
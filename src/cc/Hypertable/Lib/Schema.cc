@@ -139,6 +139,7 @@ Schema::Schema(const Schema &src_schema)
   m_generation = src_schema.m_generation;
   m_compressor = src_schema.m_compressor;
   m_group_commit_interval = src_schema.m_group_commit_interval;
+  m_compaction_strategy = src_schema.m_compaction_strategy;
   m_next_column_id = src_schema.m_next_column_id;
   m_max_column_family_id = src_schema.m_max_column_family_id;
   m_need_id_assignment = src_schema.m_need_id_assignment;
@@ -153,6 +154,7 @@ Schema::Schema(const Schema &src_schema)
     ag->counter = src_ag->counter;
     ag->replication = src_ag->replication;
     ag->blocksize = src_ag->blocksize;
+    ag->value_log_threshold = src_ag->value_log_threshold;
     ag->compressor = src_ag->compressor;
     ag->bloom_filter = src_ag->bloom_filter;
 
@@ -251,6 +253,17 @@ const PropertiesDesc &Schema::bloom_filter_spec_desc() {
 }
 
 
+void Schema::validate_compaction_strategy(const String &strategy) {
+  if (strategy.empty())
+    return;
+
+  if (strcasecmp(strategy.c_str(), "tiered") &&
+      strcasecmp(strategy.c_str(), "leveled") &&
+      strcasecmp(strategy.c_str(), "timewindow"))
+    HT_THROWF(Error::BAD_SCHEMA, "Invalid compaction strategy '%s', "
+              "expected 'tiered', 'leveled' or 'timewindow'", strategy.c_str());
+}
+
 void Schema::validate_compressor(const String &compressor) {
   if (compressor.empty())
     return;
@@ -300,6 +313,15 @@ void Schema::start_element_handler(void *userdata,
         ms_schema->set_compressor((String)atts[i+1]);
       else if (!strcasecmp(atts[i], "group_commit_interval"))
         ms_schema->set_group_commit_interval(atoi(atts[i+1]));
+      else if (!strcasecmp(atts[i], "compaction")) {
+        try {
+          validate_compaction_strategy(atts[i+1]);
+          ms_schema->set_compaction_strategy((String)atts[i+1]);
+        }
+        catch (Exception &e) {
+          ms_schema->set_error_string(e.what());
+        }
+      }
       else
         ms_schema->set_error_string((String)"Unrecognized 'Schema' attribute : "
                                      + atts[i]);
@@ -484,6 +506,14 @@ void Schema::set_access_group_parameter(const char *param, const char *value) {
       else
         m_open_access_group->replication = (int32_t)replication;
     }
+    else if (!strcasecmp(param, "valueLogThreshold")) {
+      long long threshold = strtoll(value, 0, 10);
+      if (threshold < 0 || threshold >= 4294967296LL)
+        set_error_string((String)"Invalid value (" + value
+                          + ") for AccessGroup attribute '" + param + "'");
+      else
+        m_open_access_group->value_log_threshold = (uint32_t)threshold;
+    }
     else if (!strcasecmp(param, "compressor")) {
       m_open_access_group->compressor = value;
       boost::trim(m_open_access_group->compressor);
@@ -658,6 +688,9 @@ void Schema::render(String &output, bool with_ids) {
   if (m_group_commit_interval > 0)
     output += format(" group_commit_interval=\"%u\"", m_group_commit_interval);
 
+  if (m_compaction_strategy != "")
+    output += format(" compaction=\"%s\"", m_compaction_strategy.c_str());
+
   output += ">\n";
 
   foreach_ht(const AccessGroup *ag, m_access_groups) {
@@ -675,6 +708,9 @@ void Schema::render(String &output, bool with_ids) {
     if (ag->blocksize > 0)
       output += format(" blksz=\"%u\"", ag->blocksize);
 
+    if (ag->value_log_threshold > 0)
+      output += format(" valueLogThreshold=\"%u\"", ag->value_log_threshold);
+
     if (ag->compressor != "")
       output += format(" compressor=\"%s\"", ag->compressor.c_str());
 
@@ -802,6 +838,9 @@ void Schema::render_hql_create_table(const String &table_name, String &output) {
     if (ag->blocksize != 0)
       ag_string += format(" BLOCKSIZE %u", ag->blocksize);
 
+    if (ag->value_log_threshold != 0)
+      ag_string += format(" VALUE_LOG_THRESHOLD %u", ag->value_log_threshold);
+
     if (ag->compressor != "")
       ag_string += format(" COMPRESSOR \"%s\"", ag->compressor.c_str());
 
@@ -843,6 +882,9 @@ void Schema::render_hql_create_table(const String &table_name, String &output) {
   if (m_group_commit_interval > 0)
     output += format(" GROUP_COMMIT_INTERVAL %u", m_group_commit_interval);
 
+  if (m_compaction_strategy != "")
+    output += format(" COMPACTION \"%s\"", m_compaction_strategy.c_str());
+
   output += "\n";
 }
 
@@ -69,7 +69,7 @@ namespace Hypertable {
 
     struct AccessGroup {
       AccessGroup() : name(), in_memory(false), counter(false), 
-        replication(-1), blocksize(0),
+        replication(-1), blocksize(0), value_log_threshold(0),
         bloom_filter(), columns() { }
 
       String   name;
@@ -77,6 +77,9 @@ namespace Hypertable {
       bool     counter;
       int16_t  replication;
       uint32_t blocksize;
+      /** Values at least this large are moved to value log files during
+       * compaction; 0 keeps all values inline */
+      uint32_t value_log_threshold;
       String compressor;
       String bloom_filter;
       ColumnFamilies columns;
@@ -180,6 +183,16 @@ namespace Hypertable {
     }
     uint32_t get_group_commit_interval() { return m_group_commit_interval; }
 
+    /** Sets the merging compaction strategy, either "tiered" (the default),
+     * "leveled" or "timewindow".
+     */
+    void set_compaction_strategy(const String &strategy) {
+      m_compaction_strategy = strategy;
+    }
+    const String &get_compaction_strategy() { return m_compaction_strategy; }
+
+    static void validate_compaction_strategy(const String &strategy);
+
     typedef hash_map<String, ColumnFamily *> ColumnFamilyMap;
     typedef hash_map<String, AccessGroup *> AccessGroupMap;
 
@@ -204,6 +217,7 @@ namespace Hypertable {
     String         m_compressor;
     std::vector<int>  m_counter_flags;
     uint32_t       m_group_commit_interval;
+    String         m_compaction_strategy;
 
     static void
     start_element_handler(void *userdata, const XML_Char *name,
@@ -28,16 +28,35 @@ using namespace Hypertable;
 
 namespace {
   enum Group {
-    PRIMARY_GROUP = 0
+    PRIMARY_GROUP = 0,
+    LATENCY_GROUP = 1
   };
+
+  const char *latency_metric_names[] = {
+    "create_scanner",
+    "fetch_scanblock",
+    "update",
+    "commit_log_sync",
+    "update.qualify",
+    "update.commit",
+    "update.add",
+    (const char *)0
+  };
+}
+
+const char *StatsRangeServer::latency_metric_name(int metric) {
+  if (metric < 0 || metric >= LATENCY_METRIC_MAX)
+    return "unknown";
+  return latency_metric_names[metric];
 }
 
-StatsRangeServer::StatsRangeServer() : StatsSerializable(RANGE_SERVER, 1), timestamp(TIMESTAMP_MIN) {
+StatsRangeServer::StatsRangeServer() : StatsSerializable(RANGE_SERVER, 2), timestamp(TIMESTAMP_MIN) {
   group_ids[0] = PRIMARY_GROUP;
+  group_ids[1] = LATENCY_GROUP;
 }
 
 
-StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RANGE_SERVER, 1), timestamp(TIMESTAMP_MIN) {
+StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RANGE_SERVER, 2), timestamp(TIMESTAMP_MIN) {
   const char *base, *ptr;
   String datadirs = props->get_str("Hypertable.RangeServer.Monitoring.DataDirectories");
   String dir;
@@ -60,6 +79,7 @@ StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RAN
                         StatsSystem::DISK|StatsSystem::SWAP|StatsSystem::NET|
                         StatsSystem::PROC | StatsSystem::FS, dirs);
   group_ids[0] = PRIMARY_GROUP;
+  group_ids[1] = LATENCY_GROUP;
 }
 
 StatsRangeServer::StatsRangeServer(const StatsRangeServer &other) : StatsSerializable(other.id, other.group_count) {
@@ -91,6 +111,7 @@ StatsRangeServer::StatsRangeServer(const StatsRangeServer &other) : StatsSeriali
   live = other.live;
   system = other.system;
   tables = other.tables;
+  latency = other.latency;
 }
 
 bool StatsRangeServer::operator==(const StatsRangeServer &other) const {
@@ -127,6 +148,12 @@ bool StatsRangeServer::operator==(const StatsRangeServer &other) const {
     if (tables[i] != other.tables[i])
       return false;
   }
+  if (latency.size() != other.latency.size())
+    return false;
+  for (size_t i=0; i<latency.size(); i++) {
+    if (latency[i] != other.latency[i])
+      return false;
+  }
   return true;
 }
 
@@ -143,6 +170,12 @@ size_t StatsRangeServer::encoded_length_group(int group) const {
       len += tables[i].encoded_length();
     return len;
   }
+  else if (group == LATENCY_GROUP) {
+    size_t len = Serialization::encoded_length_vi32(latency.size());
+    for (size_t i=0; i<latency.size(); i++)
+      len += latency[i].encoded_length();
+    return len;
+  }
   else
     HT_FATALF("Invalid group number (%d)", group);
   return 0;
@@ -180,6 +213,11 @@ void StatsRangeServer::encode_group(int group, uint8_t **bufp) const {
     for (size_t i=0; i<tables.size(); i++)
       tables[i].encode(bufp);
   }
+  else if (group == LATENCY_GROUP) {
+    Serialization::encode_vi32(bufp, latency.size());
+    for (size_t i=0; i<latency.size(); i++)
+      latency[i].encode(bufp);
+  }
   else
     HT_FATALF("Invalid group number (%d)", group);
 }
@@ -220,6 +258,13 @@ void StatsRangeServer::decode_group(int group, uint16_t len, const uint8_t **buf
       tables.push_back(table);
     }
   }
+  else if (group == LATENCY_GROUP) {
+    size_t latency_count = Serialization::decode_vi32(bufp, remainp);
+    latency.clear();
+    latency.resize(latency_count);
+    for (size_t i=0; i<latency_count; i++)
+      latency[i].decode(bufp, remainp);
+  }
   else {
     HT_WARNF("Unrecognized StatsRangeServer group %d, skipping...", group);
     (*bufp) += len;
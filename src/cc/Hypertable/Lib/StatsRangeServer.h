@@ -26,6 +26,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include "Common/LatencyHistogram.h"
 #include "Common/Properties.h"
 #include "Common/ReferenceCount.h"
 #include "Common/StatsSerializable.h"
@@ -43,6 +44,22 @@ namespace Hypertable {
     
   public:
 
+    /** Request types and update pipeline stages for which latency
+     * histograms are kept.
+     */
+    enum LatencyMetric {
+      LATENCY_CREATE_SCANNER = 0,
+      LATENCY_FETCH_SCANBLOCK,
+      LATENCY_UPDATE,
+      LATENCY_COMMIT_LOG_SYNC,
+      LATENCY_UPDATE_QUALIFY,
+      LATENCY_UPDATE_COMMIT,
+      LATENCY_UPDATE_ADD,
+      LATENCY_METRIC_MAX
+    };
+
+    static const char *latency_metric_name(int metric);
+
     StatsRangeServer();
 
     StatsRangeServer(PropertiesPtr &props);
@@ -91,6 +108,9 @@ namespace Hypertable {
     StatsSystem system;
     std::vector<StatsTable> tables;
     StatsTableMap table_map;
+    /// Latencies recorded since the server started, indexed by
+    /// LatencyMetric; subtract an earlier sample for an interval
+    std::vector<LatencyHistogram> latency;
 
   protected:
     virtual size_t encoded_length_group(int group) const;
@@ -88,6 +88,10 @@ void Table::initialize() {
   m_scanner_queue_size = m_props->get_i32("Hypertable.Scanner.QueueSize");
   HT_ASSERT(m_scanner_queue_size > 0);
 
+  m_scanner_parallelism = m_props->get_i32("Hypertable.Scanner.Parallelism");
+  if (m_scanner_parallelism == 0)
+    m_scanner_parallelism = 1;
+
 
   // Convert table name to ID string
 
@@ -192,7 +196,7 @@ Table::create_scanner(const ScanSpec &scan_spec, uint32_t timeout_ms,
   scan_spec.throw_if_invalid();
 
   return new TableScanner(m_comm, this, m_range_locator, scan_spec,
-                          timeout_ms ? timeout_ms : m_timeout_ms);
+                          timeout_ms ? timeout_ms : m_timeout_ms, flags);
 }
 
 TableScannerAsync *
@@ -61,7 +61,9 @@ namespace Hypertable {
       OPEN_FLAG_REFRESH_TABLE_CACHE          = 0x02,
       OPEN_FLAG_NO_AUTO_TABLE_REFRESH        = 0x04,
 
-      SCANNER_FLAG_IGNORE_INDEX              = 0x01
+      SCANNER_FLAG_IGNORE_INDEX              = 0x01,
+      SCANNER_FLAG_PARALLEL                  = 0x02,
+      SCANNER_FLAG_UNORDERED                 = 0x04
     };
 
     enum {
@@ -128,6 +130,12 @@ namespace Hypertable {
                                             uint32_t timeout_ms = 0,
                                             int32_t flags = 0);
 
+    /**
+     * Returns the number of ranges a scanner created with
+     * SCANNER_FLAG_PARALLEL or SCANNER_FLAG_UNORDERED scans concurrently
+     */
+    size_t scanner_parallelism() { return m_scanner_parallelism; }
+
     void get_identifier(TableIdentifier *table_id_p) {
       memcpy(table_id_p, &m_table, sizeof(TableIdentifier));
     }
@@ -259,6 +267,7 @@ namespace Hypertable {
     bool                   m_stale;
     String                 m_toplevel_dir;
     size_t                 m_scanner_queue_size;
+    size_t                 m_scanner_parallelism;
     TablePtr               m_index_table;
     TablePtr               m_qualifier_index_table;
     Namespace             *m_namespace;
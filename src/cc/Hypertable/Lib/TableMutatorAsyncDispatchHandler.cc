@@ -25,6 +25,7 @@
 #include "Common/Error.h"
 #include "Common/Logger.h"
 
+#include "PayloadCompression.h"
 #include "TableMutatorAsyncDispatchHandler.h"
 #include "TableMutatorAsyncHandler.h"
 
@@ -49,6 +50,7 @@ void TableMutatorAsyncDispatchHandler::handle(EventPtr &event_ptr) {
   int32_t error;
 
   if (event_ptr->type == Event::MESSAGE) {
+    PayloadCompression::record_response(m_send_buffer->addr, event_ptr);
     error = Protocol::response_code(event_ptr);
     if (error != Error::OK) {
       if (m_auto_refresh &&
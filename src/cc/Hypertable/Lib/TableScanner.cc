@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 #include "Common/Error.h"
@@ -38,14 +40,19 @@ using namespace Hypertable;
 
 TableScanner::TableScanner(Comm *comm, Table *table,
     RangeLocatorPtr &range_locator, const ScanSpec &scan_spec,
-    uint32_t timeout_ms)
+    uint32_t timeout_ms, int32_t flags)
   : m_callback(this), m_cur_cells(0), m_cur_cells_index(0), m_cur_cells_size(0),
-    m_error(Error::OK), m_eos(false) {
+    m_error(Error::OK), m_eos(false), m_aggregate(scan_spec.aggregate),
+    m_aggregated(false) {
+
+  // Partial aggregates can be merged in any order
+  if (m_aggregate != ScanSpec::AGGREGATE_NONE)
+    flags |= Table::SCANNER_FLAG_UNORDERED;
 
   m_queue = new TableScannerQueue();
   ApplicationQueueInterfacePtr app_queue = (ApplicationQueueInterface *)m_queue.get();
   m_scanner = new TableScannerAsync(comm, app_queue, table, range_locator, 
-                                    scan_spec, timeout_ms, &m_callback);
+                                    scan_spec, timeout_ms, &m_callback, flags);
 }
 
 
@@ -57,6 +64,14 @@ bool TableScanner::next(Cell &cell) {
     return true;
   }
 
+  if (m_aggregate != ScanSpec::AGGREGATE_NONE)
+    return next_aggregate(cell);
+
+  return fetch_next(cell);
+}
+
+bool TableScanner::fetch_next(Cell &cell) {
+
   if (m_eos)
     return false;
 
@@ -87,6 +102,50 @@ bool TableScanner::next(Cell &cell) {
   }
 }
 
+bool TableScanner::next_aggregate(Cell &cell) {
+
+  if (!m_aggregated) {
+    Cell partial;
+    while (fetch_next(partial)) {
+      String name;
+      if (m_aggregate != ScanSpec::AGGREGATE_COUNT_ROWS && partial.column_family)
+        name = partial.column_family;
+      String text((const char *)partial.value, partial.value_len);
+      int64_t value = strtoll(text.c_str(), 0, 10);
+      AggregateValue &agg = m_aggregates[name];
+      if (agg.count == 0)
+        agg.value = value;
+      else if (m_aggregate == ScanSpec::AGGREGATE_MIN)
+        agg.value = std::min(agg.value, value);
+      else if (m_aggregate == ScanSpec::AGGREGATE_MAX)
+        agg.value = std::max(agg.value, value);
+      else
+        agg.value += value;
+      agg.count++;
+    }
+    // an empty table still has a row count
+    if (m_aggregates.empty() && m_aggregate == ScanSpec::AGGREGATE_COUNT_ROWS)
+      m_aggregates[""];
+    m_aggregate_iter = m_aggregates.begin();
+    m_aggregated = true;
+  }
+
+  if (m_aggregate_iter == m_aggregates.end())
+    return false;
+
+  AggregateValue &agg = m_aggregate_iter->second;
+  agg.text = format("%lld", (Lld)agg.value);
+  cell = Cell();
+  cell.row_key = "";
+  cell.column_family = m_aggregate_iter->first.empty() ? 0 :
+    m_aggregate_iter->first.c_str();
+  cell.column_qualifier = "";
+  cell.value = (const uint8_t *)agg.text.c_str();
+  cell.value_len = agg.text.length();
+  ++m_aggregate_iter;
+  return true;
+}
+
 void TableScanner::unget(const Cell &cell) {
   if (m_ungot.row_key)
     HT_THROW_(Error::DOUBLE_UNGET);
@@ -23,6 +23,7 @@
 #define HYPERTABLE_TABLESCANNERSYNC_H
 
 #include <list>
+#include <map>
 #include "Common/ReferenceCount.h"
 #include "TableScannerQueue.h"
 #include "TableScannerAsync.h"
@@ -46,9 +47,10 @@ namespace Hypertable {
      * @param scan_spec reference to scan specification object
      * @param timeout_ms maximum time in milliseconds to allow scanner
      *        methods to execute before throwing an exception
+     * @param flags scanner flags
      */
     TableScanner(Comm *comm, Table *table,  RangeLocatorPtr &range_locator,
-                 const ScanSpec &scan_spec, uint32_t timeout_ms);
+                 const ScanSpec &scan_spec, uint32_t timeout_ms, int32_t flags=0);
 
     /**
      * Cancel asynchronous scanner and keep dealing with RangeServer responses
@@ -108,6 +110,24 @@ namespace Hypertable {
      */
     void scan_error(int error, const String &error_msg);
 
+    /** Returns the next cell as delivered by the RangeServers. */
+    bool fetch_next(Cell &cell);
+
+    /**
+     * Returns the next merged aggregate.  The first call drains the scan
+     * and merges the partial aggregates returned for each range into one
+     * cell per column family (one cell in total for COUNT_ROWS).
+     */
+    bool next_aggregate(Cell &cell);
+
+    struct AggregateValue {
+      AggregateValue() : value(0), count(0) { }
+      int64_t value;
+      int64_t count;
+      String text;
+    };
+    typedef std::map<String, AggregateValue> AggregateMap;
+
     TableCallback m_callback;
     TableScannerQueuePtr m_queue;
     TableScannerAsyncPtr m_scanner;
@@ -118,6 +138,10 @@ namespace Hypertable {
     String m_error_msg;
     bool m_eos;
     Cell m_ungot;
+    int32_t m_aggregate;
+    bool m_aggregated;
+    AggregateMap m_aggregates;
+    AggregateMap::iterator m_aggregate_iter;
   };
   typedef intrusive_ptr<TableScanner> TableScannerPtr;
 
@@ -25,6 +25,8 @@
 #include "Common/Error.h"
 #include "Common/String.h"
 
+#include "AsyncComm/ApplicationHandler.h"
+
 #include "Table.h"
 #include "TableScannerAsync.h"
 #include "IndexScannerCallback.h"
@@ -36,6 +38,22 @@ extern "C" {
 
 using namespace Hypertable;
 
+namespace {
+
+  /**
+   * Runs TableScannerAsync::start_partition_scanners() from the application
+   * queue, so that range locations are never looked up from a dispatch
+   * callback or with the scanner mutex held.
+   */
+  class PartitionStartHandler : public ApplicationHandler {
+  public:
+    PartitionStartHandler(TableScannerAsync *scanner) : m_scanner(scanner) { }
+    virtual void run() { m_scanner->start_partition_scanners(); }
+  private:
+    TableScannerAsync *m_scanner;
+  };
+
+}
 
 /**
  *
@@ -45,7 +63,12 @@ TableScannerAsync::TableScannerAsync(Comm *comm,
       RangeLocatorPtr &range_locator, const ScanSpec &scan_spec, 
       uint32_t timeout_ms, ResultCallback *cb, int flags)
   : m_bytes_scanned(0), m_current_scanner(0), m_outstanding(0), 
-    m_error(Error::OK), m_cancelled(false), m_use_index(false)
+    m_error(Error::OK), m_cancelled(false), m_use_index(false),
+    m_comm(comm), m_app_queue(app_queue), m_range_locator(range_locator),
+    m_parallel(false), m_unordered(false), m_parallelism(1),
+    m_partitions_done(true), m_partitions_pending(0),
+    m_partitions_starting(false), m_partition_row_inclusive(true),
+    m_partition_end_inclusive(false)
 {
   ScopedLock lock(m_mutex);
   ScanSpecBuilder index_spec;
@@ -79,8 +102,15 @@ TableScannerAsync::TableScannerAsync(Comm *comm,
 
   m_cb = cb;
   m_table = table;
+  m_timeout_ms = timeout_ms;
   m_scan_spec_builder = *pspec;
 
+  if (use_partitions(*pspec, flags)) {
+    m_parallel = true;
+    m_unordered = (flags & Table::SCANNER_FLAG_UNORDERED) != 0;
+    m_parallelism = table->scanner_parallelism();
+  }
+
   init(comm, app_queue, table, range_locator, *pspec, timeout_ms, cb);
 }
 
@@ -217,6 +247,166 @@ void TableScannerAsync::add_index_row(ScanSpecBuilder &ssb, const char *row)
                     ri.end, ri.end_inclusive);
 }
 
+/**
+ * Partitioned (parallel) scanning applies to a full table scan or a single
+ * row interval.  Limits and offsets are enforced per interval scanner, so
+ * scans that carry them are not split.
+ */
+bool TableScannerAsync::use_partitions(const ScanSpec &scan_spec, int flags) {
+  if ((flags & (Table::SCANNER_FLAG_PARALLEL|Table::SCANNER_FLAG_UNORDERED)) == 0)
+    return false;
+  return !m_use_index && scan_spec.cell_intervals.empty() &&
+    scan_spec.row_intervals.size() <= 1 && !scan_spec.scan_and_filter_rows &&
+    scan_spec.row_limit == 0 && scan_spec.cell_limit == 0 &&
+    scan_spec.row_offset == 0 && scan_spec.cell_offset == 0;
+}
+
+void TableScannerAsync::init_partitions(const ScanSpec &scan_spec) {
+  m_partitions_done = false;
+  if (scan_spec.row_intervals.empty()) {
+    m_partition_row = "";
+    m_partition_row_inclusive = true;
+    m_partition_end_row = Key::END_ROW_MARKER;
+    m_partition_end_inclusive = false;
+  }
+  else {
+    const RowInterval &ri = scan_spec.row_intervals[0];
+    m_partition_row = ri.start ? ri.start : "";
+    m_partition_row_inclusive = ri.start_inclusive;
+    if (ri.end == 0 || ri.end[0] == 0)
+      m_partition_end_row = Key::END_ROW_MARKER;
+    else
+      m_partition_end_row = ri.end;
+    m_partition_end_inclusive = ri.end_inclusive;
+  }
+}
+
+/**
+ * Reserves <code>count</code> partition scanners and, unless a start is
+ * already queued or running, hands the work to the application queue.
+ * Reserved scanners are counted in m_outstanding so that end of scan is not
+ * signalled while a partition is still to be started.  Caller must hold
+ * m_mutex.
+ */
+void TableScannerAsync::reserve_partition_scanners(size_t count) {
+  m_partitions_pending += (int)count;
+  m_outstanding += (int)count;
+  if (!m_partitions_starting) {
+    m_partitions_starting = true;
+    m_app_queue->add(new PartitionStartHandler(this));
+  }
+}
+
+/**
+ * Creates interval scanners for the next partitions until the reserved
+ * scanners are used up.  Each partition covers the remainder of the range
+ * containing the partition start row (ranges that split meanwhile are
+ * handled by the interval scanner).  The range is located with m_mutex
+ * released; the interval scanner then finds it in the location cache.  Only
+ * one thread runs this at a time (m_partitions_starting), so the partition
+ * cursor does not change while the lock is dropped.  In ordered mode only
+ * the scanner next in line is current; the others hold the first block of
+ * their range until they become current, which bounds the reordering buffer
+ * to one block per partition.  In unordered mode every scanner delivers as
+ * results arrive.
+ */
+void TableScannerAsync::start_partition_scanners() {
+  ScopedLock lock(m_mutex);
+  TableIdentifierManaged table_id;
+  SchemaPtr schema;
+  RangeLocationInfo range_info;
+  bool failed = false;
+
+  m_table->get(table_id, schema);
+
+  while (m_partitions_pending > 0) {
+    if (m_error != Error::OK || is_cancelled())
+      m_partitions_done = true;
+    if (m_partitions_done)
+      break;
+
+    String row = m_partition_row;
+    if (!m_partition_row_inclusive)
+      row.append(1, 1);
+
+    try {
+      lock.unlock();
+      Timer timer(m_timeout_ms, true);
+      m_range_locator->find_loop(&table_id, row.c_str(), &range_info, timer,
+                                 false);
+      lock.lock();
+
+      if (m_error != Error::OK || is_cancelled())
+        continue;
+
+      ScanSpec partition_spec;
+      RowInterval ri;
+      bool last = false;
+      m_scan_spec_builder.get().base_copy(partition_spec);
+      ri.start = m_partition_row.c_str();
+      ri.start_inclusive = m_partition_row_inclusive;
+      if (m_partition_end_row.compare(range_info.end_row) <= 0) {
+        ri.end = m_partition_end_row.c_str();
+        ri.end_inclusive = m_partition_end_inclusive;
+        last = true;
+      }
+      else {
+        ri.end = range_info.end_row.c_str();
+        ri.end_inclusive = true;
+      }
+      partition_spec.row_intervals.push_back(ri);
+
+      // in ordered mode the new partition is current if every partition
+      // before it has been delivered
+      int scanner_id = (int)m_interval_scanners.size();
+      bool current = m_unordered || scanner_id == 0 ||
+        (m_current_scanner == scanner_id-1 &&
+         m_interval_scanners[scanner_id-1] == 0);
+      IntervalScannerAsyncPtr ri_scanner =
+        new IntervalScannerAsync(m_comm, m_app_queue, m_table,
+                                 m_range_locator, partition_spec,
+                                 m_timeout_ms, current, this, scanner_id);
+      m_interval_scanners.push_back(ri_scanner);
+      if (current && !m_unordered)
+        m_current_scanner = scanner_id;
+
+      // the reservation is now held by the scanner
+      m_partitions_pending--;
+      m_partitions_done = last;
+      m_partition_row = range_info.end_row;
+      m_partition_row_inclusive = false;
+    }
+    catch (Exception &e) {
+      if (!lock.owns_lock())
+        lock.lock();
+      HT_ERROR_OUT << e << HT_END;
+      if (m_error == Error::OK) {
+        m_error = e.code();
+        m_error_msg = e.what();
+        failed = true;
+      }
+      m_partitions_done = true;
+    }
+  }
+
+  m_partitions_starting = false;
+
+  // release reservations that no partition is left for
+  m_outstanding -= m_partitions_pending;
+  m_partitions_pending = 0;
+
+  if (failed)
+    maybe_callback_error(0, false);
+  else if (m_outstanding == 0) {
+    if (m_error != Error::OK)
+      maybe_callback_error(0, false);
+    else {
+      ScanCellsPtr cells = new ScanCells;
+      maybe_callback_ok(0, false, true, cells);
+    }
+  }
+}
+
 void TableScannerAsync::init(Comm *comm, ApplicationQueueInterfacePtr &app_queue, 
         Table *table, RangeLocatorPtr &range_locator, 
         const ScanSpec &scan_spec, uint32_t timeout_ms, ResultCallback *cb)
@@ -231,7 +421,11 @@ void TableScannerAsync::init(Comm *comm, ApplicationQueueInterfacePtr &app_queue
   m_cb->register_scanner(this);
 
   try {
-    if (scan_spec.row_intervals.empty()) {
+    if (m_parallel) {
+      init_partitions(scan_spec);
+      reserve_partition_scanners(m_parallelism);
+    }
+    else if (scan_spec.row_intervals.empty()) {
       if (scan_spec.cell_intervals.empty()) {
         ri_scanner = 0;
         ri_scanner = new IntervalScannerAsync(comm, app_queue, table, 
@@ -510,6 +704,10 @@ void TableScannerAsync::maybe_callback_ok(int scanner_id, bool next, bool do_cal
     HT_ASSERT(m_outstanding>0 && m_interval_scanners[scanner_id] != 0);
     m_outstanding--;
     m_interval_scanners[scanner_id] = 0;
+
+    // replace the finished partition scanner
+    if (!m_partitions_done && m_error == Error::OK && !is_cancelled())
+      reserve_partition_scanners(1);
   }
 
   if (m_outstanding == 0) {
@@ -541,6 +739,11 @@ String TableScannerAsync::get_table_name() const {
 }
 
 void TableScannerAsync::move_to_next_interval_scanner(int current_scanner) {
+
+  // every scanner of an unordered scan is current
+  if (m_unordered)
+    return;
+
   bool next = true;
   bool cancelled = is_cancelled();
   bool do_callback;
@@ -574,9 +777,11 @@ void TableScannerAsync::move_to_next_interval_scanner(int current_scanner) {
   }
 
   // if we skipped ALL outstanding scanners then make sure the "eos" marker
-  // is sent to the caller, and m_outstanding is decremented
+  // is sent to the caller, and m_outstanding is decremented (a reserved
+  // partition scanner signals it once it is released instead)
   if (next 
       && m_outstanding == 1
+      && m_partitions_pending == 0
       && current_scanner == ((int)m_interval_scanners.size() - 1) 
       && !cells) {
     cells = new ScanCells;
@@ -127,6 +127,14 @@ namespace Hypertable {
      * Returns scanspec for this scanner
      */
     const ScanSpec &get_scan_spec() { return m_scan_spec_builder.get(); }
+
+    /**
+     * Starts the partition scanners reserved for a parallel scan.  Called
+     * from the application queue; takes m_mutex itself but releases it
+     * while range locations are looked up.
+     */
+    void start_partition_scanners();
+
   private:
     friend class IndexScannerCallback;
 
@@ -141,6 +149,9 @@ namespace Hypertable {
     bool use_index(TablePtr table, const ScanSpec &primary_spec, 
             ScanSpecBuilder &index_spec, bool *use_qualifier);
     void add_index_row(ScanSpecBuilder &ssb, const char *row);
+    bool use_partitions(const ScanSpec &scan_spec, int flags);
+    void init_partitions(const ScanSpec &scan_spec);
+    void reserve_partition_scanners(size_t count);
 
     std::vector<IntervalScannerAsyncPtr>  m_interval_scanners;
     uint32_t            m_timeout_ms;
@@ -159,6 +170,22 @@ namespace Hypertable {
     ScanSpecBuilder     m_scan_spec_builder;
     bool                m_cancelled;
     bool                m_use_index;
+
+    // Parallel scans: the row interval is split at range boundaries into
+    // partitions, up to m_parallelism of which are scanned concurrently
+    Comm               *m_comm;
+    ApplicationQueueInterfacePtr m_app_queue;
+    RangeLocatorPtr     m_range_locator;
+    bool                m_parallel;
+    bool                m_unordered;
+    size_t              m_parallelism;
+    bool                m_partitions_done;
+    int                 m_partitions_pending;
+    bool                m_partitions_starting;
+    String              m_partition_row;
+    bool                m_partition_row_inclusive;
+    String              m_partition_end_row;
+    bool                m_partition_end_inclusive;
   };
 
   typedef intrusive_ptr<TableScannerAsync> TableScannerAsyncPtr;
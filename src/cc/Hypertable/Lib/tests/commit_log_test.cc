@@ -55,6 +55,7 @@ namespace {
 
   void test1(DfsBroker::Client *dfs_client);
   void test_link(DfsBroker::Client *dfs_client);
+  void test_streams(DfsBroker::Client *dfs_client);
   void write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                      CommitLogBase *link_log);
   void read_entries(DfsBroker::Client *dfs_client, CommitLogReader *log_reader,
@@ -85,6 +86,7 @@ int main(int argc, char **argv) {
 
     //test1(dfs);
     test_link(dfs.get());
+    test_streams(dfs.get());
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -205,6 +207,79 @@ namespace {
     HT_ASSERT(sum_read == sum_written);
   }
 
+  void test_streams(DfsBroker::Client *dfs_client) {
+    String log_dir = "/hypertable/test_log/streams";
+    CommitLog *logs[3];
+    CommitLogReaderPtr log_reader_ptr;
+    uint64_t sum_written = 0;
+    uint64_t sum_read = 0;
+    FilesystemPtr fs = dfs_client;
+
+    dfs_client->rmdir(log_dir);
+    dfs_client->mkdirs(log_dir);
+
+    // Three streams sharing one directory, written alternately so that
+    // each rolls several fragments
+    for (uint32_t i=0; i<3; i++)
+      logs[i] = new CommitLog(fs, log_dir, properties, 0, false, i, 3);
+    for (size_t i=0; i<3; i++) {
+      for (size_t j=0; j<3; j++)
+        write_entries(logs[j], 20, &sum_written, 0);
+    }
+    for (size_t i=0; i<3; i++)
+      delete logs[i];
+
+    // A reader on the directory sees the fragments of every stream
+    log_reader_ptr = new CommitLogReader(fs, log_dir);
+    read_entries(dfs_client, log_reader_ptr.get(), &sum_read);
+    HT_ASSERT(sum_read == sum_written);
+
+    // Reopening with the existing fragments handed to the first stream
+    // must not reuse any fragment number
+    for (uint32_t i=0; i<3; i++)
+      logs[i] = new CommitLog(fs, log_dir, properties,
+                              i == 0 ? log_reader_ptr.get() : 0, false, i, 3);
+    for (size_t j=0; j<3; j++)
+      write_entries(logs[j], 20, &sum_written, 0);
+    for (size_t i=0; i<3; i++)
+      delete logs[i];
+
+    sum_read = 0;
+    log_reader_ptr = new CommitLogReader(fs, log_dir);
+    read_entries(dfs_client, log_reader_ptr.get(), &sum_read);
+    HT_ASSERT(sum_read == sum_written);
+
+    // Streams written in the same batch share its revision; the combined
+    // cumulative size map must count the fragments of both
+    dfs_client->rmdir(log_dir);
+    dfs_client->mkdirs(log_dir);
+    for (uint32_t i=0; i<2; i++)
+      logs[i] = new CommitLog(fs, log_dir, properties, 0, false, i, 2);
+    {
+      CommitLog::CumulativeSizeMap size_map[2], combined;
+      uint32_t payload[64];
+      DynamicBuffer dbuf;
+      int64_t revision = logs[0]->get_timestamp();
+
+      memset(payload, 0, sizeof(payload));
+      dbuf.base = (uint8_t *)payload;
+      dbuf.own = false;
+      for (uint32_t i=0; i<2; i++) {
+        dbuf.ptr = dbuf.base + (i+1)*sizeof(payload)/2;
+        HT_ASSERT(logs[i]->write(dbuf, revision) == Error::OK);
+        logs[i]->load_cumulative_size_map(size_map[i]);
+        logs[i]->load_cumulative_size_map(combined);
+        HT_ASSERT(size_map[i].size() == 1);
+      }
+      HT_ASSERT(combined.size() == 1);
+      HT_ASSERT(combined[revision].cumulative_size ==
+                size_map[0][revision].cumulative_size +
+                size_map[1][revision].cumulative_size);
+    }
+    for (size_t i=0; i<2; i++)
+      delete logs[i];
+  }
+
   void
   write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                 CommitLogBase *link_log) {
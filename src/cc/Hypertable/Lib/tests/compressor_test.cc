@@ -124,5 +124,37 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (header.get_checksum_type() != BlockCompressionHeader::FLETCHER32) {
+    HT_ERROR("Blocks should be checksummed with fletcher32 by default");
+    return 1;
+  }
+
+  // blocks checksummed with CRC32C are recognized on read
+
+  header.set_checksum_type(BlockCompressionHeader::CRC32C);
+
+  output2.free();
+
+  try {
+    compressor->deflate(input, output1, header);
+    header.set_checksum_type(BlockCompressionHeader::FLETCHER32);
+    compressor->inflate(output1, output2, header);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  if (header.get_checksum_type() != BlockCompressionHeader::CRC32C) {
+    HT_ERRORF("Checksum type not preserved by %s codec", argv[1]);
+    return 1;
+  }
+
+  if (input.fill() != output2.fill() ||
+      memcmp(input.base, output2.base, input.fill())) {
+    HT_ERRORF("Input does not match output after %s codec", argv[0]);
+    return 1;
+  }
+
   return 0;
 }
@@ -23,20 +23,32 @@
 #include "Common/FileUtils.h"
 #include "Common/Init.h"
 #include "Common/InetAddr.h"
+#include "Common/Path.h"
 #include "Common/Random.h"
 #include "Common/StringExt.h"
 #include "Common/Serialization.h"
+#include "Common/StaticBuffer.h"
 #include "DfsBroker/Lib/Client.h"
 #include "AsyncComm/Comm.h"
 #include "AsyncComm/ReactorFactory.h"
 #include "AsyncComm/ConnectionManager.h"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <map>
+
+#include <boost/thread/thread.hpp>
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
 
 
 #include "Hypertable/Lib/Config.h"
 
+#include "Hypertable/Lib/MetaLog.h"
 #include "Hypertable/Lib/MetaLogDefinition.h"
 #include "Hypertable/Lib/MetaLogEntity.h"
 #include "Hypertable/Lib/MetaLogReader.h"
@@ -63,6 +75,8 @@ namespace Hypertable {
       }
       virtual void display(ostream &os) { os << "value=" << value; }
       void increment() { value++; }
+      int32_t get_type() { return header.type; }
+      int32_t get_value() { return value; }
 
     private:
       String m_name;
@@ -122,6 +136,43 @@ namespace {
     }
   }
 
+  const int NUM_WORKERS = 8;
+  const int WORKER_ENTITIES = 16;
+
+  vector<MetaLog::EntityPtr> g_worker_entities[NUM_WORKERS];
+
+  // Records state changes of its own entities, concurrently with the others
+  struct StateChanger {
+    StateChanger(MetaLog::Writer *writer, int worker)
+      : writer(writer), worker(worker) { }
+    void operator()() {
+      vector<MetaLog::EntityPtr> &entities = g_worker_entities[worker];
+      for (size_t i=0; i<200; i++) {
+        MetaLog::EntityGeneric *entity =
+          (MetaLog::EntityGeneric *)entities[i % entities.size()].get();
+        entity->increment();
+        if ((i%10) == 0) {
+          vector<MetaLog::Entity *> batch;
+          batch.push_back(entity);
+          batch.push_back(entities[(i+1) % entities.size()].get());
+          writer->record_state(batch);
+        }
+        else
+          writer->record_state(entity);
+      }
+      writer->record_removal(entities[0].get());
+    }
+    MetaLog::Writer *writer;
+    int worker;
+  };
+
+  void write_backup(const String &fname, const uint8_t *buf, size_t len) {
+    int fd = ::open(fname.c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644);
+    HT_ASSERT(fd >= 0);
+    FileUtils::write(fd, buf, len);
+    ::close(fd);
+  }
+
   void display_entities(ofstream &out) {
     for (size_t i=0; i<g_entities.size(); i++) {
       if (g_entities[i])
@@ -225,6 +276,116 @@ main(int ac, char *av[]) {
       HT_ASSERT(FileUtils::size("metalog_test3.out") == FileUtils::size("metalog_test2.golden"));
     }
 
+    /**
+     *  Copy the latest log with a partial entry appended, as left by a
+     *  crash during a flush; the copy must read the same as the original.
+     *  Its backup only covers the complete entries, as the flush of the
+     *  partial one was never acknowledged.
+     */
+
+    Path data_dir = get_str("Hypertable.DataDirectory");
+    String backup_dir = (data_dir /= String("/run/log_backup/") +
+                         g_test_definition->name() + "/" +
+                         g_test_definition->backup_label()).string();
+
+    {
+      String logdir = testdir + "/" + g_test_definition->name();
+      std::vector<int32_t> file_ids;
+      int32_t next_id;
+      MetaLog::scan_log_directory(fs, logdir, file_ids, &next_id);
+      std::sort(file_ids.begin(), file_ids.end());
+      String fname = logdir + "/" + file_ids.back();
+      size_t length = fs->length(fname);
+      size_t partial = MetaLog::EntityHeader::LENGTH + 1;
+      StaticBuffer buf(length + partial);
+      int fd = fs->open(fname, 0);
+      HT_ASSERT(fs->read(fd, buf.base, length) == length);
+      fs->close(fd);
+      memcpy(buf.base + length, buf.base + MetaLog::Header::LENGTH, partial);
+      write_backup(backup_dir + "/" + next_id, buf.base, length);
+      StaticBuffer copy(length + partial);
+      memcpy(copy.base, buf.base, length + partial);
+      fd = fs->create(logdir + "/" + next_id, 0, -1, -1, -1);
+      fs->append(fd, buf);
+      fs->close(fd);
+
+      ofstream out("metalog_test4.out");
+      reader = new MetaLog::Reader(fs, g_test_definition, logdir);
+      g_entities.clear();
+      reader->get_entities(g_entities);
+      display_entities(out);
+      reader = 0;
+      HT_ASSERT(FileUtils::size("metalog_test4.out") == FileUtils::size("metalog_test2.golden"));
+
+      // An entry that runs past the end of the file but was acknowledged
+      // means the log is damaged and must not be read as truncated
+      fd = fs->create(logdir + "/" + (next_id+1), 0, -1, -1, -1);
+      write_backup(backup_dir + "/" + (next_id+1), copy.base, length + partial);
+      fs->append(fd, copy);
+      fs->close(fd);
+      try {
+        reader = new MetaLog::Reader(fs, g_test_definition, logdir);
+        HT_ERROR("Acknowledged partial entry read as truncated");
+        return 1;
+      }
+      catch (Exception &e) {
+        HT_ASSERT(e.code() == Error::METALOG_ENTRY_TRUNCATED);
+      }
+      reader = 0;
+    }
+
+    /**
+     *  Record state changes from several threads at once with compaction
+     *  kicking in along the way; the log must end up compacted into newer
+     *  files and read back with the final state of every entity
+     */
+
+    {
+      String logdir = testdir + "/compaction";
+      vector<MetaLog::EntityPtr> initial_entities;
+      boost::thread_group threads;
+
+      properties->set("Hypertable.MetaLog.Compaction.MinSize", (int64_t)4096);
+      properties->set("Hypertable.MetaLog.Compaction.GarbageThreshold.Percentage",
+                      (int32_t)50);
+      MetaLog::Writer::skip_recover_entry = false;
+
+      for (int i=0; i<NUM_WORKERS; i++)
+        for (int j=0; j<WORKER_ENTITIES; j++)
+          g_worker_entities[i].push_back(new MetaLog::EntityGeneric(1000*(i+1) + j));
+
+      writer = new MetaLog::Writer(fs, g_test_definition, logdir,
+                                   initial_entities);
+      for (int i=0; i<NUM_WORKERS; i++)
+        threads.create_thread(StateChanger(writer.get(), i));
+      threads.join_all();
+      writer = 0;
+
+      std::vector<int32_t> file_ids;
+      int32_t next_id;
+      MetaLog::scan_log_directory(fs, logdir, file_ids, &next_id);
+      HT_ASSERT(file_ids.size() > 1);
+
+      std::map<int32_t, int32_t> expected;
+      for (int i=0; i<NUM_WORKERS; i++)
+        for (int j=1; j<WORKER_ENTITIES; j++) {
+          MetaLog::EntityGeneric *entity =
+            (MetaLog::EntityGeneric *)g_worker_entities[i][j].get();
+          expected[entity->get_type()] = entity->get_value();
+        }
+
+      reader = new MetaLog::Reader(fs, g_test_definition, logdir);
+      g_entities.clear();
+      reader->get_entities(g_entities);
+      reader = 0;
+      HT_ASSERT(g_entities.size() == expected.size());
+      foreach_ht (MetaLog::EntityPtr &entity, g_entities) {
+        MetaLog::EntityGeneric *generic = (MetaLog::EntityGeneric *)entity.get();
+        HT_ASSERT(expected.count(generic->get_type()));
+        HT_ASSERT(expected[generic->get_type()] == generic->get_value());
+      }
+    }
+
     if (!has("save"))
       fs->rmdir(testdir);
   }
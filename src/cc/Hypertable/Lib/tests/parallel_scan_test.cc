@@ -0,0 +1,186 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "Common/Usage.h"
+
+#include "Hypertable/Lib/Client.h"
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+
+  const char *schema =
+  "<Schema>"
+  "  <AccessGroup name=\"default\">"
+  "    <ColumnFamily>"
+  "      <Name>data</Name>"
+  "    </ColumnFamily>"
+  "  </AccessGroup>"
+  "</Schema>";
+
+  const char *usage[] = {
+    "usage: parallel_scan_test [<num_rows>]",
+    "",
+    "Loads <num_rows> rows into the ParallelScanTest table and checks that",
+    "scanners created with the parallel and unordered scanner flags return",
+    "the same cells as a serial scan, for a full table scan and for a row",
+    "interval, and that a parallel scanner can be destroyed before it is",
+    "done.  Run against servers with a small split size so that the table",
+    "has more ranges than the scanner parallelism.",
+    0
+  };
+
+  String make_row(size_t i) {
+    char buf[32];
+    sprintf(buf, "row%08u", (unsigned)i);
+    return buf;
+  }
+
+  void scan(TablePtr &table, ScanSpecBuilder &ssb, int32_t flags,
+            vector<String> &rows) {
+    TableScannerPtr scanner = table->create_scanner(ssb.get(), 0, flags);
+    Cell cell;
+    rows.clear();
+    while (scanner->next(cell))
+      rows.push_back(cell.row_key);
+  }
+
+  void compare(const char *what, const vector<String> &expected,
+               const vector<String> &rows) {
+    if (rows.size() != expected.size()) {
+      cout << what << ": expected " << expected.size() << " cells, got "
+           << rows.size() << endl;
+      _exit(1);
+    }
+    for (size_t i=0; i<rows.size(); i++) {
+      if (rows[i] != expected[i]) {
+        cout << what << ": expected " << expected[i] << " at position " << i
+             << ", got " << rows[i] << endl;
+        _exit(1);
+      }
+    }
+  }
+
+  void check(const char *what, TablePtr &table, ScanSpecBuilder &ssb,
+             const vector<String> &expected) {
+    vector<String> rows;
+
+    scan(table, ssb, 0, rows);
+    compare(what, expected, rows);
+
+    // ordered partitions are delivered in row order
+    scan(table, ssb, Table::SCANNER_FLAG_PARALLEL, rows);
+    compare(what, expected, rows);
+
+    scan(table, ssb, Table::SCANNER_FLAG_UNORDERED, rows);
+    sort(rows.begin(), rows.end());
+    compare(what, expected, rows);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  size_t num_rows = 100000;
+
+  if (argc > 2 ||
+      (argc == 2 && (!strcmp(argv[1], "--help") || !strcmp(argv[1], "-?"))))
+    Usage::dump_and_exit(usage);
+
+  if (argc == 2)
+    num_rows = atoi(argv[1]);
+
+  try {
+    Client *hypertable = new Client(argv[0], "./hypertable.cfg");
+    NamespacePtr ns = hypertable->open_namespace("/");
+    TablePtr table;
+    ScanSpecBuilder ssb;
+    vector<String> expected;
+    char value[200];
+
+    memset(value, 'v', sizeof(value));
+
+    ns->drop_table("ParallelScanTest", true);
+    ns->create_table("ParallelScanTest", schema);
+    table = ns->open_table("ParallelScanTest");
+
+    {
+      TableMutatorPtr mutator = table->create_mutator();
+      KeySpec key;
+      key.column_family = "data";
+      for (size_t i=0; i<num_rows; i++) {
+        String row = make_row(i);
+        key.row = row.c_str();
+        key.row_len = row.length();
+        mutator->set(key, value, sizeof(value));
+        expected.push_back(row);
+      }
+      mutator->flush();
+    }
+
+    cout << "Full table scan with parallelism "
+         << table->scanner_parallelism() << endl;
+    check("full table scan", table, ssb, expected);
+
+    // the row interval starts and ends in the middle of a range
+    size_t begin = num_rows / 4, end = (num_rows * 3) / 4;
+    String start_row = make_row(begin);
+    String end_row = make_row(end);
+    vector<String> interval(expected.begin() + begin + 1,
+                            expected.begin() + end + 1);
+    ssb.clear();
+    ssb.add_row_interval(start_row.c_str(), false, end_row.c_str(), true);
+    cout << "Row interval (" << start_row << ", " << end_row << "]" << endl;
+    check("row interval", table, ssb, interval);
+
+    // destroying a scanner with partitions outstanding cancels them
+    ssb.clear();
+    for (int32_t flags = Table::SCANNER_FLAG_PARALLEL;
+         flags <= Table::SCANNER_FLAG_UNORDERED; flags <<= 1) {
+      TableScannerPtr scanner = table->create_scanner(ssb.get(), 0, flags);
+      Cell cell;
+      for (size_t i=0; i<10 && scanner->next(cell); i++)
+        ;
+    }
+
+    table = 0;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    _exit(1);
+  }
+
+  cout << "Test passed" << endl;
+  _exit(0);
+}
@@ -0,0 +1,124 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+
+#include "Common/Usage.h"
+
+#include "AsyncComm/CommBuf.h"
+#include "AsyncComm/Event.h"
+#include "AsyncComm/Protocol.h"
+
+#include "Hypertable/Lib/PayloadCompression.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  const char *usage[] = {
+    "usage: payload_compression_test",
+    "",
+    "Validates compression of RangeServer message payloads.",
+    0
+  };
+
+  /** Builds a scan block style response: error code, fixed fields, then
+   * the cells in an external buffer
+   */
+  CommBuf *make_response(CommHeader &header, size_t ext_len) {
+    StaticBuffer ext(ext_len);
+    for (size_t i=0; i<ext_len; i++)
+      ext.base[i] = (uint8_t)("row00042 column:qualifier value "[i % 32]);
+    CommBuf *cbuf = new CommBuf(header, 8, ext);
+    cbuf->append_i32(Error::OK);
+    cbuf->append_i32(42);
+    return cbuf;
+  }
+
+  /** Returns the payload of a message as it is received */
+  EventPtr receive(CommBufPtr &cbuf) {
+    size_t header_len = cbuf->header.encoded_length();
+    EventPtr event = new Event(Event::MESSAGE);
+    uint8_t *payload = new uint8_t [cbuf->header.total_len - header_len];
+    memcpy(payload, cbuf->data.base + header_len, cbuf->data.size - header_len);
+    if (cbuf->ext.size)
+      memcpy(payload + cbuf->data.size - header_len, cbuf->ext.base,
+             cbuf->ext.size);
+    event->header = cbuf->header;
+    event->payload = payload;
+    event->payload_len = cbuf->header.total_len - header_len;
+    return event;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  CommHeader header(1);
+
+  if (argc != 1)
+    Usage::dump_and_exit(usage);
+
+  HT_ASSERT(PayloadCompression::enabled());
+
+  // small payloads are sent as-is
+  CommBufPtr cbuf = make_response(header, 100);
+  CommBuf *original = cbuf.get();
+  PayloadCompression::compress(cbuf, 4);
+  HT_ASSERT(cbuf.get() == original);
+  HT_ASSERT((cbuf->header.flags & CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED) == 0);
+
+  // large payloads are compressed past the error code and inflate back
+  cbuf = make_response(header, 256*1024);
+  EventPtr expected = receive(cbuf);
+  PayloadCompression::compress(cbuf, 4);
+  HT_ASSERT(cbuf->header.flags & CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED);
+  HT_ASSERT(cbuf->header.total_len < expected->payload_len);
+
+  EventPtr event = receive(cbuf);
+  HT_ASSERT(Protocol::response_code(event) == Error::OK);
+  PayloadCompression::inflate(event, 4);
+  HT_ASSERT((event->header.flags & CommHeader::FLAGS_BIT_PAYLOAD_COMPRESSED) == 0);
+  if (event->payload_len != expected->payload_len ||
+      memcmp(event->payload, expected->payload, event->payload_len)) {
+    cout << "Error: inflated payload does not match original" << endl;
+    exit(1);
+  }
+
+  // uncompressed payloads are left alone
+  PayloadCompression::inflate(expected, 4);
+  HT_ASSERT(expected->payload_len == event->payload_len);
+
+  // update compression is only used once the server has advertised it
+  CommAddress addr;
+  addr.set_proxy("rs1");
+  HT_ASSERT(!PayloadCompression::accepted(addr));
+  event->header.flags |= CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED;
+  PayloadCompression::record_response(addr, event);
+  HT_ASSERT(PayloadCompression::accepted(addr));
+  event->header.flags &= CommHeader::FLAGS_MASK_ACCEPT_COMPRESSED;
+  PayloadCompression::record_response(addr, event);
+  HT_ASSERT(!PayloadCompression::accepted(addr));
+
+  return 0;
+}
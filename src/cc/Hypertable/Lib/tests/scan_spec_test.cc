@@ -24,6 +24,7 @@
 #include <iostream>
 
 #include "Common/md5.h"
+#include "Common/Serialization.h"
 #include "Common/Usage.h"
 
 #include "Hypertable/Lib/Client.h"
@@ -81,5 +82,95 @@ int main(int argc, char **argv) {
   assert(fired==true);
   fired=false;
 
+  // not allowed: aggregate in combination with a row limit
+  try {
+    ScanSpecBuilder ssb;
+    ssb.set_aggregate(ScanSpec::AGGREGATE_COUNT_ROWS);
+    ssb.set_row_limit(10);
+    ssb.get().throw_if_invalid();
+  }
+  catch (Exception &e) {
+    if (e.code()!=Error::BAD_SCAN_SPEC) {
+      std::cout << e << std::endl;
+      _exit(1);
+    }
+    fired=true;
+  }
+
+  assert(fired==true);
+  fired=false;
+
+  // aggregate survives a round trip through the wire format
+  {
+    ScanSpecBuilder ssb;
+    ssb.set_aggregate(ScanSpec::AGGREGATE_SUM);
+    ssb.add_column("counter");
+    ssb.get().throw_if_invalid();
+    DynamicBuffer buf(ssb.get().encoded_length());
+    ssb.get().encode(&buf.ptr);
+    const uint8_t *decode_ptr = buf.base;
+    size_t remain = buf.fill();
+    ScanSpec decoded(&decode_ptr, &remain);
+    if (decoded.aggregate != ScanSpec::AGGREGATE_SUM || remain != 0) {
+      std::cout << "aggregate not preserved by encode/decode" << std::endl;
+      _exit(1);
+    }
+  }
+
+  // without an aggregate the encoding is the one older servers expect
+  {
+    ScanSpecBuilder ssb;
+    ssb.add_column("counter");
+    ssb.set_cell_offset(3);
+    DynamicBuffer buf(ssb.get().encoded_length());
+    ssb.get().encode(&buf.ptr);
+    if (buf.fill() != ssb.get().encoded_length() ||
+        *(buf.ptr - 1) != 3) {
+      std::cout << "scan spec without aggregate ends in aggregate field"
+                << std::endl;
+      _exit(1);
+    }
+    const uint8_t *decode_ptr = buf.base;
+    size_t remain = buf.fill();
+    ScanSpec decoded(&decode_ptr, &remain);
+    if (decoded.aggregate != ScanSpec::AGGREGATE_NONE ||
+        decoded.cell_offset != 3 || remain != 0) {
+      std::cout << "scan spec without aggregate not decoded" << std::endl;
+      _exit(1);
+    }
+  }
+
+  // BETWEEN carries its upper bound, other predicates encode as before
+  {
+    ColumnPredicate between("v", ColumnPredicate::BETWEEN |
+                            ColumnPredicate::INTEGER_COMPARISON, "10", "20");
+    ColumnPredicate exact("v", ColumnPredicate::EXACT_MATCH, "10");
+    DynamicBuffer buf(between.encoded_length() + exact.encoded_length());
+    between.encode(&buf.ptr);
+    exact.encode(&buf.ptr);
+    if (buf.fill() != between.encoded_length() + exact.encoded_length() ||
+        exact.encoded_length() != 4 + Serialization::encoded_length_vstr("v")
+        + Serialization::encoded_length_vstr("10")) {
+      std::cout << "column predicate encoded length mismatch" << std::endl;
+      _exit(1);
+    }
+    const uint8_t *decode_ptr = buf.base;
+    size_t remain = buf.fill();
+    ColumnPredicate decoded_between(&decode_ptr, &remain);
+    ColumnPredicate decoded_exact(&decode_ptr, &remain);
+    if (remain != 0 ||
+        decoded_between.operation != between.operation ||
+        String(decoded_between.value, decoded_between.value_len) != "10" ||
+        String(decoded_between.end_value,
+               decoded_between.end_value_len) != "20" ||
+        decoded_exact.operation != ColumnPredicate::EXACT_MATCH ||
+        String(decoded_exact.value, decoded_exact.value_len) != "10" ||
+        decoded_exact.end_value != 0) {
+      std::cout << "column predicate not preserved by encode/decode"
+                << std::endl;
+      _exit(1);
+    }
+  }
+
   _exit(0);
 }
@@ -121,6 +121,41 @@ int main(int argc, char **argv) {
 
   delete schema;
 
+  // Every compaction strategy survives a render and reparse
+  const char *strategies[] = { "tiered", "leveled", "timewindow", 0 };
+  for (int i=0; strategies[i] != 0; ++i) {
+    schema = new Schema();
+    schema->set_compaction_strategy(strategies[i]);
+    schema->open_access_group();
+    schema->set_access_group_parameter("name", "default");
+    schema->open_column_family();
+    schema->set_column_family_parameter("Name", "metric");
+    schema->close_column_family();
+    schema->close_access_group();
+    schemastr = "";
+    schema->render(schemastr);
+    delete schema;
+
+    schema = Schema::new_instance(schemastr.c_str(), schemastr.length());
+    if (!schema->is_valid()) {
+      HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+      exit(1);
+    }
+    HT_ASSERT(schema->get_compaction_strategy() == strategies[i]);
+    delete schema;
+  }
+
+  const char *bad_strategy = "<Schema compaction=\"sideways\">\n"
+    "  <AccessGroup name=\"default\">\n"
+    "    <ColumnFamily>\n"
+    "      <Name>metric</Name>\n"
+    "    </ColumnFamily>\n"
+    "  </AccessGroup>\n"
+    "</Schema>\n";
+  schema = Schema::new_instance(bad_strategy, strlen(bad_strategy));
+  HT_ASSERT(!schema->is_valid());
+  delete schema;
+
   if (!golden)
     harness.validate_and_exit("schemaTest.golden");
 
@@ -0,0 +1,242 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Common/Compat.h"
+
+#include <algorithm>
+
+#include "BalanceAlgorithmHeat.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  struct GtMeasurementTimestamp {
+    bool operator()(const RangeMeasurement *x, const RangeMeasurement *y) const {
+      return x->timestamp > y->timestamp;
+    }
+  };
+
+}
+
+
+BalanceAlgorithmHeat::BalanceAlgorithmHeat(ContextPtr &context,
+                                           std::vector<RangeServerStatistics> &statistics)
+  : m_context(context) {
+
+  m_heat_threshold = m_context->props->get_f64("Hypertable.LoadBalancer.Heat.Threshold");
+
+  foreach_ht (RangeServerStatistics &rs, statistics)
+    m_rsstats[rs.location] = rs;
+}
+
+
+void BalanceAlgorithmHeat::compute_plan(BalancePlanPtr &plan,
+                                        std::vector<RangeServerConnectionPtr> &balanced) {
+  vector<ServerMetrics> server_metrics;
+  RSMetrics rs_metrics(m_context->rs_metrics_table);
+  rs_metrics.get_server_metrics(server_metrics);
+
+  vector<ServerHeat> servers;
+  set<String> disk_full;
+  double total_request_rate = 0;
+  double total_byte_rate = 0;
+
+  servers.reserve(server_metrics.size());
+
+  set<String> measured;
+
+  foreach_ht (const ServerMetrics &sm, server_metrics) {
+    measured.insert(sm.get_id());
+
+    // only assign ranges if this RangeServer is connected
+    if (!is_connected(sm.get_id())) {
+      HT_INFOF("RangeServer %s not connected, skipping", sm.get_id().c_str());
+      continue;
+    }
+
+    StatisticsSet::iterator it = m_rsstats.find(sm.get_id());
+    if (it != m_rsstats.end() && !m_context->can_accept_ranges(it->second))
+      disk_full.insert(sm.get_id());
+
+    servers.push_back(ServerHeat());
+    ServerHeat &sh = servers.back();
+    sh.server_id = sm.get_id();
+
+    RangeMetricsMap range_metrics;
+    rs_metrics.get_range_metrics(sh.server_id.c_str(), range_metrics);
+    foreach_ht (const RangeMetricsMap::value_type &vv, range_metrics) {
+      RangeHeat rh;
+      calculate_range_heat(vv.second, rh);
+      total_request_rate += rh.request_rate;
+      total_byte_rate += rh.byte_rate;
+      sh.ranges.push_back(rh);
+    }
+  }
+
+  // Servers that have not written to RS_METRICS yet (e.g. ones that just
+  // joined) carry no heat and are the first choice as destinations
+  foreach_ht (StatisticsSet::value_type &vv, m_rsstats) {
+    if (measured.count(vv.first) || !is_connected(vv.first) ||
+        !m_context->can_accept_ranges(vv.second))
+      continue;
+    HT_INFOF("RangeServer %s has no metrics, adding with zero heat",
+             vv.first.c_str());
+    servers.push_back(ServerHeat());
+    servers.back().server_id = vv.first;
+  }
+
+  if (servers.size() < 2 || (total_request_rate == 0 && total_byte_rate == 0)) {
+    HT_INFO_OUT << "No balancing required, num_servers=" << servers.size()
+        << ", total_request_rate=" << total_request_rate
+        << ", total_byte_rate=" << total_byte_rate << HT_END;
+    return;
+  }
+
+  // Normalize request and byte rates against the cluster totals
+  double total_heat = 0;
+  foreach_ht (ServerHeat &sh, servers) {
+    foreach_ht (RangeHeat &rh, sh.ranges) {
+      if (total_request_rate > 0)
+        rh.heat += rh.request_rate / total_request_rate;
+      if (total_byte_rate > 0)
+        rh.heat += rh.byte_rate / total_byte_rate;
+      sh.heat += rh.heat;
+    }
+    total_heat += sh.heat;
+    sort(sh.ranges.begin(), sh.ranges.end(), GtRangeHeat());
+  }
+
+  double mean_heat = total_heat / servers.size();
+  double max_heat = mean_heat * (1.0 + m_heat_threshold);
+
+  HT_INFO_OUT << "mean_heat=" << mean_heat << ", num_servers=" << servers.size()
+      << ", heat_threshold=" << m_heat_threshold << HT_END;
+
+  ServerSetAscHeat servers_asc_heat;
+  foreach_ht (ServerHeat &sh, servers)
+    servers_asc_heat.insert(&sh);
+
+  while (servers_asc_heat.size() >= 2) {
+    ServerSetAscHeat::iterator hottest_it = servers_asc_heat.end();
+    --hottest_it;
+    ServerHeat *hottest = *hottest_it;
+
+    if (hottest->heat <= max_heat)
+      break;
+
+    // the hottest server won't be a source or destination after this pass
+    servers_asc_heat.erase(hottest_it);
+
+    HT_INFOF("Hottest server %s heat=%.6f", hottest->server_id.c_str(),
+             hottest->heat);
+
+    foreach_ht (RangeHeat &rh, hottest->ranges) {
+      if (hottest->heat <= max_heat || rh.heat == 0)
+        break;
+      if (!rh.moveable)
+        continue;
+
+      ServerSetAscHeat::iterator coldest_it = servers_asc_heat.begin();
+      while (coldest_it != servers_asc_heat.end() &&
+             disk_full.count((*coldest_it)->server_id))
+        ++coldest_it;
+      if (coldest_it == servers_asc_heat.end())
+        break;
+      ServerHeat *coldest = *coldest_it;
+
+      // Moving a range at least as hot as the gap just relocates the hot
+      // spot; leave it for the RangeServer to split by load
+      if (rh.heat >= hottest->heat - coldest->heat) {
+        HT_INFO_OUT << "Range " << rh << " too hot to move, waiting for "
+            "load split" << HT_END;
+        continue;
+      }
+
+      if (coldest->heat + rh.heat > max_heat)
+        continue;
+
+      RangeMoveSpecPtr move = new RangeMoveSpec(hottest->server_id.c_str(),
+          coldest->server_id.c_str(), rh.table_id.c_str(),
+          rh.start_row.c_str(), rh.end_row.c_str());
+      HT_INFO_OUT << "Added move to plan: " << *(move.get()) << " " << rh << HT_END;
+      plan->moves.push_back(move);
+
+      hottest->heat -= rh.heat;
+      servers_asc_heat.erase(coldest_it);
+      coldest->heat += rh.heat;
+      servers_asc_heat.insert(coldest);
+    }
+  }
+}
+
+
+bool BalanceAlgorithmHeat::is_connected(const String &location) {
+  RangeServerConnectionPtr rsc;
+  if (!m_context->rsc_manager)
+    return true;
+  return m_context->rsc_manager->find_server_by_location(location, rsc) &&
+    rsc->connected() && !rsc->get_removed() && !rsc->is_recovering();
+}
+
+
+void BalanceAlgorithmHeat::calculate_range_heat(const RangeMetrics &metrics,
+                                                RangeHeat &rh) {
+  bool start_row_set;
+
+  rh.table_id = metrics.get_table_id();
+  rh.start_row = metrics.get_start_row(&start_row_set);
+  rh.end_row = metrics.get_end_row();
+  rh.moveable = metrics.is_moveable();
+
+  // Exponentially decay older measurements so that a range that just
+  // became hot is acted on at the next balance
+  const vector<RangeMeasurement> &measurements = metrics.get_measurements();
+  vector<const RangeMeasurement *> by_time;
+  by_time.reserve(measurements.size());
+  foreach_ht (const RangeMeasurement &measurement, measurements)
+    by_time.push_back(&measurement);
+  sort(by_time.begin(), by_time.end(), GtMeasurementTimestamp());
+
+  double weight = 1.0;
+  double total_weight = 0;
+  foreach_ht (const RangeMeasurement *measurement, by_time) {
+    rh.request_rate += weight * (measurement->update_rate + measurement->scan_rate);
+    rh.byte_rate += weight * (measurement->byte_read_rate + measurement->byte_write_rate);
+    total_weight += weight;
+    weight /= 2.0;
+  }
+  if (total_weight > 0) {
+    rh.request_rate /= total_weight;
+    rh.byte_rate /= total_weight;
+  }
+}
+
+
+/** @relates BalanceAlgorithmHeat::RangeHeat */
+ostream &Hypertable::operator<<(ostream &out,
+                                const BalanceAlgorithmHeat::RangeHeat &rh) {
+  out << "{RangeHeat: table_id=" << rh.table_id << ", start_row="
+      << rh.start_row << ", end_row=" << rh.end_row << ", request_rate="
+      << rh.request_rate << ", byte_rate=" << rh.byte_rate << ", heat="
+      << rh.heat << "}";
+  return out;
+}
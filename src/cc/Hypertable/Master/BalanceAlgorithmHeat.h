@@ -0,0 +1,112 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_BALANCEALGORITHMHEAT_H
+#define HYPERTABLE_BALANCEALGORITHMHEAT_H
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "BalanceAlgorithm.h"
+#include "RSMetrics.h"
+#include "RangeServerStatistics.h"
+#include "Context.h"
+
+namespace Hypertable {
+
+  /**
+   * Balances ranges by observed read/write "heat".  The heat of a range is
+   * derived from the per-range request rates (updates + scans) and byte
+   * rates (bytes scanned + bytes written) recorded in sys/RS_METRICS, with
+   * recent measurements weighted more heavily than older ones.  Both
+   * components are normalized against the cluster-wide totals so that
+   * neither dominates.  Ranges are moved from the hottest servers to the
+   * coldest ones until every server is within the configured threshold of
+   * the mean.  Servers that have statistics but no RS_METRICS rows yet take
+   * part with zero heat.  A range that is too hot to be moved without
+   * simply relocating the hot spot is left in place; the RangeServer splits
+   * such ranges at their load median (see
+   * Hypertable.RangeServer.Range.SplitLoad.Rate) and the halves are picked
+   * up by a subsequent balance.
+   */
+  class BalanceAlgorithmHeat : public BalanceAlgorithm {
+  public:
+
+    BalanceAlgorithmHeat(ContextPtr &context,
+                         std::vector<RangeServerStatistics> &statistics);
+
+    virtual void compute_plan(BalancePlanPtr &plan,
+                              std::vector<RangeServerConnectionPtr> &balanced);
+
+    class RangeHeat {
+    public:
+      RangeHeat() : request_rate(0), byte_rate(0), heat(0), moveable(false) { }
+      String table_id;
+      String start_row;
+      String end_row;
+      double request_rate;
+      double byte_rate;
+      double heat;
+      bool moveable;
+    };
+
+    struct GtRangeHeat {
+      bool operator()(const RangeHeat &x, const RangeHeat &y) const {
+        return x.heat > y.heat;
+      }
+    };
+
+    class ServerHeat {
+    public:
+      ServerHeat() : heat(0) { }
+      String server_id;
+      double heat;
+      std::vector<RangeHeat> ranges;
+    };
+
+  private:
+
+    struct LtServerHeat {
+      bool operator()(const ServerHeat *x, const ServerHeat *y) const {
+        if (x->heat != y->heat)
+          return x->heat < y->heat;
+        return x->server_id < y->server_id;
+      }
+    };
+    typedef std::set<ServerHeat *, LtServerHeat> ServerSetAscHeat;
+
+    bool is_connected(const String &location);
+    void calculate_range_heat(const RangeMetrics &metrics, RangeHeat &rh);
+
+    typedef std::map<String, RangeServerStatistics> StatisticsSet;
+    StatisticsSet m_rsstats;
+    ContextPtr m_context;
+    double m_heat_threshold;
+  };
+
+  std::ostream &operator<<(std::ostream &out,
+                           const BalanceAlgorithmHeat::RangeHeat &rh);
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_BALANCEALGORITHMHEAT_H
@@ -21,6 +21,7 @@
 #include "Common/Compat.h"
 
 #include "BalanceAlgorithmEvenRanges.h"
+#include "BalanceAlgorithmHeat.h"
 #include "BalanceAlgorithmLoad.h"
 #include "BalanceAlgorithmOffload.h"
 #include "LoadBalancer.h"
@@ -45,6 +46,10 @@ LoadBalancer::LoadBalancer(ContextPtr context)
   m_loadavg_threshold = 
             m_context->props->get_f64("Hypertable.LoadBalancer.LoadavgThreshold");
 
+  m_default_algorithm =
+    m_context->props->get_str("Hypertable.LoadBalancer.Algorithm");
+  boost::to_lower(m_default_algorithm);
+
   time_t t = time(0) +
     m_context->props->get_i32("Hypertable.LoadBalancer.BalanceDelay.Initial");
 
@@ -131,7 +136,7 @@ void LoadBalancer::create_plan(BalancePlanPtr &plan,
       if (m_new_server_added && now >= m_next_balance_time_new_server)
         name = "table_ranges";
       else if (now >= m_next_balance_time_load)
-        name = "load";
+        name = m_default_algorithm;
       else
         HT_THROW(Error::MASTER_BALANCE_PREVENTED, "Balance not needed");
     }
@@ -157,6 +162,8 @@ void LoadBalancer::create_plan(BalancePlanPtr &plan,
       algo = new BalanceAlgorithmEvenRanges(m_context, m_statistics);
     else if (name == "load")
       algo = new BalanceAlgorithmLoad(m_context, m_statistics);
+    else if (name == "heat")
+      algo = new BalanceAlgorithmHeat(m_context, m_statistics);
     else
       HT_THROWF(Error::MASTER_BALANCE_PREVENTED,
                 "Unrecognized algorithm - %s", name.c_str());
@@ -60,6 +60,7 @@ namespace Hypertable {
     time_t m_next_balance_time_load;
     time_t m_next_balance_time_new_server;
     double m_loadavg_threshold;
+    String m_default_algorithm;
     uint32_t m_new_server_balance_delay;
     bool m_new_server_added;
     bool m_enabled;
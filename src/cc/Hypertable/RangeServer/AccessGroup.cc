@@ -28,6 +28,7 @@
 
 #include "Common/Error.h"
 #include "Common/md5.h"
+#include "Common/Time.h"
 
 #include "AccessGroup.h"
 #include "CellCache.h"
@@ -53,7 +54,9 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier,
     m_earliest_cached_revision_saved(TIMESTAMP_MAX),
     m_latest_stored_revision(TIMESTAMP_MIN), m_collisions(0),
     m_file_tracker(identifier, schema, range, ag->name), m_is_root(false),
-    m_recovering(false), m_needs_merging(false) {
+    m_recovering(false), m_needs_merging(false),
+    m_row_cache_generation(0),
+    m_value_log_threshold(ag->value_log_threshold) {
 
   m_table_name = m_identifier.id;
   m_start_row = range->start_row;
@@ -74,6 +77,9 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier,
                && !strcmp(range->end_row, Key::END_ROOT_ROW));
   m_in_memory = ag->in_memory;
 
+  m_merge_runs.set_strategy(schema->get_compaction_strategy());
+  m_expiration.set_schema(ag);
+
   m_cellstore_props = new Properties();
   m_cellstore_props->set("compressor", ag->compressor.size() ?
       ag->compressor : schema->get_compressor());
@@ -90,6 +96,8 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier,
   }
   m_bloom_filter_disabled = BLOOM_FILTER_DISABLED ==
       m_cellstore_props->get<BloomFilterMode>("bloom-filter-mode");
+
+  invalidate_row_cache();
 }
 
 
@@ -105,6 +113,8 @@ void AccessGroup::update_schema(SchemaPtr &schema,
   ScopedLock lock(m_mutex);
   std::set<uint8_t>::iterator iter;
 
+  invalidate_row_cache();
+
   m_garbage_tracker.set_schema(schema, ag);
 
   if (schema->get_generation() > m_schema->get_generation()) {
@@ -127,9 +137,25 @@ void AccessGroup::update_schema(SchemaPtr &schema,
 
     // Update schema ptr
     m_schema = schema;
+    m_merge_runs.set_strategy(schema->get_compaction_strategy());
+    m_expiration.set_schema(ag);
   }
 }
 
+
+/**
+ * Returns true if every cell of the store has outlived the TTLs of the
+ * access group (see CellStoreExpiration).
+ * @param now current time in nanoseconds since the epoch
+ */
+bool AccessGroup::cell_store_expired(const CellStoreInfo &csinfo, int64_t now) {
+  if (m_in_memory)
+    return false;
+  return m_expiration.expired(csinfo.expiration_time, csinfo.timestamp_min,
+                              csinfo.timestamp_max, now);
+}
+
+
 /**
  * This should be called with the CellCache locked Also, at the end of
  * compaction processing, when m_cell_cache gets reset to a new value, the
@@ -175,41 +201,61 @@ CellListScanner *AccessGroup::create_scanner(ScanContextPtr &scan_context) {
   }
 
   try {
-    ScopedLock lock(m_mutex);
-    uint64_t initial_bytes_read;
+    String cache_name;
+    CellCachePtr cached_row;
+    std::vector<CellStoreInfo> row_stores;
+    bool load_row = false;
+    int64_t row_generation = 0;
+    SchemaPtr row_schema;
 
-    m_cell_cache_manager->add_scanners(scanner, scan_context);
+    {
+      ScopedLock lock(m_mutex);
+      uint64_t initial_bytes_read;
+      int64_t now = m_expiration.ttl() ? get_ts64() : 0;
+
+      m_cell_cache_manager->add_scanners(scanner, scan_context);
+
+      if (!m_in_memory) {
+        bool bloom_filter_disabled;
+
+        if (Global::row_cache && scan_context->single_row &&
+            !scan_context->start_row.empty() &&
+            scan_context->start_row == scan_context->end_row &&
+            !m_stores.empty()) {
+          cache_name = m_table_name + "(" + m_name + ")";
+          cached_row = Global::row_cache->lookup(cache_name,
+                  scan_context->start_row.c_str(), m_row_cache_generation);
+          if (cached_row)
+            scanner->add_scanner(cached_row->create_scanner(scan_context));
+          else {
+            load_row = true;
+            row_generation = m_row_cache_generation;
+            row_schema = m_schema;
+            gather_row_stores(scan_context->start_row, row_stores);
+            foreach_ht (CellStoreInfo &csinfo, row_stores)
+              callback.add_file(csinfo.cs->get_filename());
+          }
+        }
 
-    if (!m_in_memory) {
-      bool bloom_filter_disabled;
+        for (size_t i=0; !cached_row && !load_row && i<m_stores.size(); ++i) {
 
-      for (size_t i=0; i<m_stores.size(); ++i) {
+          if (scan_context->time_interval.first > m_stores[i].timestamp_max ||
+              scan_context->time_interval.second < m_stores[i].timestamp_min)
+            continue;
 
-        if (scan_context->time_interval.first > m_stores[i].timestamp_max ||
-            scan_context->time_interval.second < m_stores[i].timestamp_min)
-          continue;
+          // Nothing visible left, the store is waiting to be dropped
+          if (now && cell_store_expired(m_stores[i], now))
+            continue;
 
-        bloom_filter_disabled = boost::any_cast<uint8_t>(m_stores[i].cs->get_trailer()->get("bloom_filter_mode")) == BLOOM_FILTER_DISABLED;
+          bloom_filter_disabled = boost::any_cast<uint8_t>(m_stores[i].cs->get_trailer()->get("bloom_filter_mode")) == BLOOM_FILTER_DISABLED;
 
-        initial_bytes_read = m_stores[i].cs->bytes_read();
+          initial_bytes_read = m_stores[i].cs->bytes_read();
 
-        // Query bloomfilter only if it is enabled and a start row has been specified
-        // (ie query is not something like select bar from foo;)
-        if (bloom_filter_disabled ||
-            !scan_context->single_row ||
-            scan_context->start_row == "") {
-          if (m_stores[i].shadow_cache) {
-            scanner->add_scanner(m_stores[i].shadow_cache->create_scanner(scan_context));
-            m_stores[i].shadow_cache_hits++;
-          }
-          else
-            scanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
-          callback.add_file(m_stores[i].cs->get_filename());
-        }
-        else {
-          m_stores[i].bloom_filter_accesses++;
-          if (m_stores[i].cs->may_contain(scan_context)) {
-            m_stores[i].bloom_filter_maybes++;
+          // Query bloomfilter only if it is enabled and a start row has been specified
+          // (ie query is not something like select bar from foo;)
+          if (bloom_filter_disabled ||
+              !scan_context->single_row ||
+              scan_context->start_row == "") {
             if (m_stores[i].shadow_cache) {
               scanner->add_scanner(m_stores[i].shadow_cache->create_scanner(scan_context));
               m_stores[i].shadow_cache_hits++;
@@ -218,13 +264,43 @@ CellListScanner *AccessGroup::create_scanner(ScanContextPtr &scan_context) {
               scanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
             callback.add_file(m_stores[i].cs->get_filename());
           }
-        }
+          else {
+            m_stores[i].bloom_filter_accesses++;
+            if (m_stores[i].cs->may_contain(scan_context)) {
+              m_stores[i].bloom_filter_maybes++;
+              if (m_stores[i].shadow_cache) {
+                scanner->add_scanner(m_stores[i].shadow_cache->create_scanner(scan_context));
+                m_stores[i].shadow_cache_hits++;
+              }
+              else
+                scanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
+              callback.add_file(m_stores[i].cs->get_filename());
+            }
+          }
+
+          if (m_stores[i].cs->bytes_read() > initial_bytes_read)
+            scanner->add_disk_read(m_stores[i].cs->bytes_read() - initial_bytes_read);
 
-        if (m_stores[i].cs->bytes_read() > initial_bytes_read)
-          scanner->add_disk_read(m_stores[i].cs->bytes_read() - initial_bytes_read);
+        }
 
+        // Cell stores may hold references into any of the value logs
+        if (!callback.get_file_vector().empty()) {
+          std::vector<String> value_logs;
+          m_value_logs.get_files(value_logs);
+          foreach_ht (const String &fname, value_logs)
+            callback.add_file(fname);
+        }
       }
     }
+
+    // The row is read from the CellStores gathered above without holding
+    // m_mutex, so that updates and other scans are not held up by the DFS
+    if (load_row) {
+      cached_row = load_cached_row(cache_name, scan_context->start_row,
+                                   row_generation, row_schema, row_stores,
+                                   scanner);
+      scanner->add_scanner(cached_row->create_scanner(scan_context));
+    }
   }
   catch (Exception &e) {
     ScopedLock lock(m_outstanding_scanner_mutex);
@@ -241,6 +317,103 @@ CellListScanner *AccessGroup::create_scanner(ScanContextPtr &scan_context) {
   return scanner;
 }
 
+/**
+ * Collects the CellStores that may hold cells of a row, for
+ * load_cached_row().  Called with m_mutex held; only the bloom filters,
+ * which are in memory, are consulted.
+ */
+void AccessGroup::gather_row_stores(const String &row,
+                                    std::vector<CellStoreInfo> &stores) {
+  ScanSpecBuilder ssb;
+  ssb.add_row_interval(row.c_str(), true, row.c_str(), true);
+  ScanContextPtr row_context = new ScanContext(TIMESTAMP_MAX, &ssb.get(),
+                                               0, m_schema);
+
+  for (size_t i=0; i<m_stores.size(); ++i) {
+    if (boost::any_cast<uint8_t>(m_stores[i].cs->get_trailer()->get("bloom_filter_mode")) != BLOOM_FILTER_DISABLED) {
+      m_stores[i].bloom_filter_accesses++;
+      if (!m_stores[i].cs->may_contain(row_context))
+        continue;
+      m_stores[i].bloom_filter_maybes++;
+    }
+    if (m_stores[i].shadow_cache)
+      m_stores[i].shadow_cache_hits++;
+    stores.push_back(m_stores[i]);
+  }
+}
+
+
+/**
+ * Reads the CellStore cells of a row into a CellCache and adds it to the
+ * row cache.  The row is read with all column families, versions and
+ * delete records of this access group so that the cached copy can serve
+ * any single-row scan.  Called without m_mutex; the stores were gathered
+ * by gather_row_stores() under it, and if they have been replaced since,
+ * the generation no longer matches and the entry is never served.
+ */
+CellCachePtr AccessGroup::load_cached_row(const String &cache_name,
+        const String &row, int64_t generation, SchemaPtr &schema,
+        std::vector<CellStoreInfo> &stores, CellListScanner *mscanner) {
+  ScanSpecBuilder ssb;
+  ssb.add_row_interval(row.c_str(), true, row.c_str(), true);
+  ssb.set_return_deletes(true);
+  ScanContextPtr row_context = new ScanContext(TIMESTAMP_MAX, &ssb.get(),
+                                               0, schema);
+  DynamicBuffer buf;
+  size_t cell_count = 0;
+  Key key;
+  ByteString value;
+  CellCachePtr cells;
+
+  for (size_t i=0; i<stores.size(); ++i) {
+    CellListScannerPtr scanner;
+    uint64_t initial_bytes_read = stores[i].cs->bytes_read();
+
+    if (stores[i].shadow_cache)
+      scanner = stores[i].shadow_cache->create_scanner(row_context);
+    else
+      scanner = stores[i].cs->create_scanner(row_context);
+
+    while (scanner->get(key, value)) {
+      buf.add(key.serial.ptr, key.length);
+      buf.add(value.ptr, value.length());
+      cell_count++;
+      scanner->forward();
+    }
+
+    if (stores[i].cs->bytes_read() > initial_bytes_read)
+      mscanner->add_disk_read(stores[i].cs->bytes_read() - initial_bytes_read);
+  }
+
+  // The row cache accounts for this memory itself.  Size the arena for
+  // this one row instead of the CellCache default.
+  cells = new CellCache(false);
+  cells->arena().set_page_size(buf.fill() + cell_count * 64 + 256);
+  cells->lock();
+  for (const uint8_t *ptr = buf.base; ptr < buf.ptr; ) {
+    key.load(SerializedKey(ptr));
+    ptr += key.length;
+    value.ptr = ptr;
+    ptr += value.length();
+    cells->add(key, value);
+  }
+  cells->unlock();
+
+  Global::row_cache->insert(cache_name, row.c_str(), generation, cells);
+  return cells;
+}
+
+
+/**
+ * Called whenever m_stores changes so that rows cached from the previous
+ * set of CellStores are no longer served.
+ */
+void AccessGroup::invalidate_row_cache() {
+  if (Global::row_cache)
+    m_row_cache_generation = Global::row_cache->new_generation();
+}
+
+
 bool AccessGroup::include_in_scan(ScanContextPtr &scan_context) {
   ScopedLock lock(m_mutex);
   for (std::set<uint8_t>::iterator iter = m_column_families.begin();
@@ -267,6 +440,15 @@ void AccessGroup::split_row_estimate_data_stored(SplitRowDataMapT &split_row_dat
 }
 
 
+void AccessGroup::split_row_estimate_data_accessed(SplitRowDataMapT &split_row_data) {
+  ScopedLock lock(m_mutex);
+  if (!m_in_memory) {
+    foreach_ht (CellStoreInfo &csinfo, m_stores)
+      csinfo.cs->split_row_access_data(split_row_data);
+  }
+}
+
+
 uint64_t AccessGroup::disk_usage() {
   ScopedLock lock(m_mutex);
   uint64_t du = (m_in_memory) ? 0 : m_disk_usage;
@@ -343,9 +525,12 @@ AccessGroup::MaintenanceData *AccessGroup::get_maintenance_data(ByteArena &arena
   mdata->outstanding_scanners = m_outstanding_scanner_count;
   mdata->in_memory = m_in_memory;
 
+  int64_t now_ns = (int64_t)now * 1000000000LL;
   CellStoreMaintenanceData **tailp = 0;
   mdata->csdata = 0;
   for (size_t i=0; i<m_stores.size(); i++) {
+    if (cell_store_expired(m_stores[i], now_ns))
+      mdata->expired_files++;
     if (mdata->csdata == 0) {
       mdata->csdata = (CellStoreMaintenanceData *)arena.alloc(sizeof(CellStoreMaintenanceData));
       mdata->csdata->cs = m_stores[i].cs.get();
@@ -363,6 +548,8 @@ AccessGroup::MaintenanceData *AccessGroup::get_maintenance_data(ByteArena &arena
     mdata->bloom_filter_accesses += m_stores[i].bloom_filter_accesses;
     mdata->bloom_filter_maybes += m_stores[i].bloom_filter_maybes;
     mdata->bloom_filter_fps += m_stores[i].bloom_filter_fps;
+    if (m_stores[i].cs->disk_usage_estimated())
+      mdata->disk_usage_estimated = true;
     if (!m_in_memory) {
       mdata->cell_count += m_stores[i].cell_count;
       mdata->key_bytes += m_stores[i].key_bytes;
@@ -389,20 +576,64 @@ AccessGroup::MaintenanceData *AccessGroup::get_maintenance_data(ByteArena &arena
   mdata->gc_needed = m_garbage_tracker.check_needed(mdata->deletes, mdata->mem_used, now);
   mdata->needs_merging = m_needs_merging;
 
+  size_t merge_offset, merge_length;
+  if (m_needs_merging && find_merge_run(&merge_offset, &merge_length)) {
+    mdata->merge_length = merge_length;
+    for (size_t i=merge_offset; i<merge_offset+merge_length; i++)
+      mdata->merge_bytes += m_stores[i].cs->disk_usage();
+  }
+
   mdata->maintenance_flags = 0;
 
   return mdata;
 }
 
 
+/**
+ * The indexes are read from the DFS without holding m_mutex, so scans and
+ * updates of the access group carry on meanwhile, and are then installed
+ * under the lock.
+ */
+void AccessGroup::load_deferred_indexes() {
+  std::vector<CellStorePtr> pending;
+
+  {
+    ScopedLock lock(m_mutex);
+    foreach_ht (CellStoreInfo &csinfo, m_stores) {
+      if (csinfo.cs->index_deferred())
+        pending.push_back(csinfo.cs);
+    }
+  }
+
+  foreach_ht (CellStorePtr &cs, pending) {
+    DynamicBuffer fixed, variable;
+
+    cs->read_deferred_index(fixed, variable);
+
+    ScopedLock lock(m_mutex);
+    // skip cell stores removed by a compaction in the meantime
+    for (size_t i=0; i<m_stores.size(); i++) {
+      if (m_stores[i].cs == cs) {
+        cs->install_deferred_index(fixed, variable);
+        break;
+      }
+    }
+  }
+
+  if (!pending.empty()) {
+    ScopedLock lock(m_mutex);
+    recompute_compression_ratio();
+  }
+}
+
+
 void AccessGroup::add_cell_store(CellStorePtr &cellstore) {
   ScopedLock lock(m_mutex);
 
   m_disk_usage += cellstore->disk_usage();
 
   // Record the latest stored revision
-  int64_t revision = boost::any_cast<int64_t>
-    (cellstore->get_trailer()->get("revision"));
+  int64_t revision = cellstore->get_revision();
   if (revision > m_latest_stored_revision)
     m_latest_stored_revision = revision;
 
@@ -414,6 +645,7 @@ void AccessGroup::add_cell_store(CellStorePtr &cellstore) {
   }
 
   m_stores.push_back( cellstore );
+  invalidate_row_cache();
 
   int64_t total_index_entries = 0;
   recompute_compression_ratio(&total_index_entries);
@@ -423,8 +655,164 @@ void AccessGroup::add_cell_store(CellStorePtr &cellstore) {
   m_file_tracker.add_live_noupdate(cellstore->get_filename(), total_index_entries);
 }
 
+void AccessGroup::add_value_log(const String &fname) {
+  ScopedLock lock(m_mutex);
+
+  m_value_logs.load(fname, Global::dfs->length(fname));
+
+  int64_t total_index_entries = 0;
+  recompute_compression_ratio(&total_index_entries);
+
+  m_file_tracker.add_live_noupdate(fname, total_index_entries);
+}
+
+void AccessGroup::prepare_import(const std::vector<String> &files,
+                                 int64_t revision,
+                                 std::vector<CellStorePtr> &imported) {
+  std::vector<String> cs_files;
+  std::vector<String> removed_files;
+  int64_t total_index_entries = 0;
+
+  if (m_in_memory)
+    HT_THROWF(Error::NOT_ALLOWED, "Import into IN_MEMORY access group %s(%s)",
+              m_range_name.c_str(), m_name.c_str());
+
+  {
+    ScopedLock lock(m_mutex);
+    for (size_t i=0; i<files.size(); i++)
+      cs_files.push_back(CellStore::imported_name(
+                           format("%s/tables/%s/%s/%s/cs%d",
+                                  Global::toplevel_dir.c_str(),
+                                  m_identifier.id, m_name.c_str(),
+                                  m_range_dir.c_str(), m_next_cs_id++),
+                           revision));
+    recompute_compression_ratio(&total_index_entries);
+    m_file_tracker.add_references(cs_files);
+    m_file_tracker.update_live("", removed_files, m_next_cs_id,
+                               total_index_entries);
+  }
+
+  /**
+   * The destinations go into the Files column as blocked entries before
+   * the files are moved.  The files are renamed rather than copied; the
+   * revision of their cells is carried in the destination name (see
+   * CellStore::imported_name) and applied by the scanners.
+   */
+  try {
+    m_file_tracker.update_files_column();
+    for (size_t i=0; i<files.size(); i++) {
+      HT_INFOF("Importing CellStore %s into %s(%s) as %s", files[i].c_str(),
+               m_range_name.c_str(), m_name.c_str(), cs_files[i].c_str());
+      Global::dfs->rename(files[i], cs_files[i]);
+      CellStorePtr cellstore = CellStoreFactory::open(cs_files[i],
+                               m_start_row.c_str(), m_end_row.c_str());
+      if (cellstore->get_revision_override() != revision)
+        HT_THROWF(Error::NOT_ALLOWED, "Unable to import %s, only version 6 "
+                  "CellStores can be imported", files[i].c_str());
+      imported.push_back(cellstore);
+    }
+  }
+  catch (Exception &e) {
+    discard_import(files, cs_files);
+    throw;
+  }
+}
+
+
+int64_t AccessGroup::install_import(std::vector<CellStorePtr> &imported) {
+  ScopedLock lock(m_mutex);
+  std::vector<String> cs_files;
+  std::vector<String> removed_files;
+  int64_t latest_revision = TIMESTAMP_MIN;
+
+  /**
+   * Imported cells bypass the commit log, so the stored revision may only
+   * move forward when nothing older is sitting in the cell cache, otherwise
+   * commit log replay would skip those cached updates.
+   */
+  if (m_earliest_cached_revision != TIMESTAMP_MAX ||
+      m_earliest_cached_revision_saved != TIMESTAMP_MAX)
+    HT_THROWF(Error::RANGESERVER_REVISION_ORDER_ERROR,
+              "Cell cache of %s(%s) not empty at CellStore import",
+              m_range_name.c_str(), m_name.c_str());
+
+  for (size_t i=0; i<imported.size(); i++) {
+    int64_t revision = imported[i]->get_revision();
+    if (revision > latest_revision)
+      latest_revision = revision;
+    cs_files.push_back(imported[i]->get_filename());
+  }
+
+  // METADATA is written before the stores are added so that a failure
+  // leaves the access group as it was
+  int64_t total_index_entries = 0;
+  recompute_compression_ratio(&total_index_entries);
+  for (size_t i=0; i<imported.size(); i++)
+    total_index_entries += (int64_t)imported[i]->block_count();
+  for (size_t i=0; i<cs_files.size(); i++)
+    m_file_tracker.update_live(cs_files[i], removed_files, m_next_cs_id,
+                               total_index_entries);
+  m_file_tracker.remove_references(cs_files);
+  try {
+    m_file_tracker.update_files_column();
+  }
+  catch (Exception &e) {
+    m_file_tracker.add_references(cs_files);
+    m_file_tracker.update_live("", cs_files, m_next_cs_id,
+                               total_index_entries);
+    throw;
+  }
+
+  for (size_t i=0; i<imported.size(); i++) {
+    m_stores.push_back( imported[i] );
+    m_garbage_tracker.accumulate_expirable( m_stores.back().expirable_data );
+  }
+  invalidate_row_cache();
+
+  if (latest_revision > m_latest_stored_revision)
+    m_latest_stored_revision = latest_revision;
+
+  recompute_compression_ratio(0);
+
+  m_needs_merging = find_merge_run();
+
+  return latest_revision;
+}
+
+
+void AccessGroup::discard_import(const std::vector<String> &files,
+                                 std::vector<CellStorePtr> &imported) {
+  std::vector<String> cs_files;
+  foreach_ht (CellStorePtr &cellstore, imported)
+    cs_files.push_back(cellstore->get_filename());
+  discard_import(files, cs_files);
+}
+
+
+void AccessGroup::discard_import(const std::vector<String> &files,
+                                 const std::vector<String> &cs_files) {
+  for (size_t i=0; i<cs_files.size(); i++) {
+    try {
+      if (Global::dfs->exists(cs_files[i]))
+        Global::dfs->rename(cs_files[i], files[i]);
+    }
+    catch (Exception &e) {
+      HT_WARNF("Problem restoring abandoned import %s to %s - %s",
+               cs_files[i].c_str(), files[i].c_str(), e.what());
+    }
+  }
+  m_file_tracker.remove_references(cs_files);
+  try {
+    m_file_tracker.update_files_column();
+  }
+  catch (Exception &e) {
+    HT_WARN_OUT << e << HT_END;
+  }
+}
+
 void AccessGroup::compute_garbage_stats(uint64_t *input_bytesp, uint64_t *output_bytesp) {
   ScanContextPtr scan_context = new ScanContext(m_schema);
+  scan_context->resolve_value_refs = false;
   MergeScannerPtr mscanner = new MergeScannerAccessGroup(m_table_name,
                 scan_context);
   ByteString value;
@@ -447,6 +835,45 @@ void AccessGroup::compute_garbage_stats(uint64_t *input_bytesp, uint64_t *output
 }
 
 
+size_t AccessGroup::drop_expired_cell_stores() {
+  std::vector<String> removed_files;
+  int64_t total_index_entries = 0;
+
+  {
+    ScopedLock lock(m_mutex);
+    std::vector<CellStoreInfo> new_stores;
+    int64_t now = get_ts64();
+
+    new_stores.reserve(m_stores.size());
+    for (size_t i=0; i<m_stores.size(); i++) {
+      if (cell_store_expired(m_stores[i], now)) {
+        removed_files.push_back(m_stores[i].cs->get_filename());
+        m_garbage_tracker.accumulate_expirable( -m_stores[i].expirable_data );
+      }
+      else
+        new_stores.push_back(m_stores[i]);
+    }
+
+    if (removed_files.empty())
+      return 0;
+
+    m_stores.swap(new_stores);
+    invalidate_row_cache();
+    recompute_compression_ratio(&total_index_entries);
+    m_needs_merging = find_merge_run();
+  }
+
+  m_file_tracker.update_live("", removed_files, m_next_cs_id, total_index_entries);
+  m_file_tracker.update_files_column();
+
+  foreach_ht (String &fname, removed_files)
+    HT_INFOF("Dropped expired cell store %s from %s(%s)", fname.c_str(),
+             m_range_name.c_str(), m_name.c_str());
+
+  return removed_files.size();
+}
+
+
 void AccessGroup::run_compaction(int maintenance_flags) {
   ByteString bskey;
   ByteString value;
@@ -464,6 +891,18 @@ void AccessGroup::run_compaction(int maintenance_flags) {
   bool garbage_check_performed = false;
   size_t merge_offset=0, merge_length=0;
   String added_file;
+  ValueLogWriterPtr value_log;
+  std::set<String> rewrite_value_logs;
+
+  if (MaintenanceFlag::expired_compaction(maintenance_flags)) {
+    drop_expired_cell_stores();
+    // Nothing else was requested, so skip the minor compaction too
+    if ((maintenance_flags & ~MaintenanceFlag::COMPACT_EXPIRED) == 0) {
+      ScopedLock lock(m_mutex);
+      merge_caches();
+      return;
+    }
+  }
 
   while (abort_loop) {
     ScopedLock lock(m_mutex);
@@ -526,12 +965,24 @@ void AccessGroup::run_compaction(int maintenance_flags) {
       ScopedLock lock(m_mutex);
       ScanContextPtr scan_context = new ScanContext(m_schema);
 
+      // Value log references are copied as is, see below
+      scan_context->resolve_value_refs = false;
+
       cs_file = format("%s/tables/%s/%s/%s/cs%d",
                        Global::toplevel_dir.c_str(),
                        m_identifier.id, m_name.c_str(),
                        m_range_dir.c_str(),
                        m_next_cs_id++);
 
+      if (m_value_log_threshold && !m_in_memory) {
+        String vlog_file = format("%s/tables/%s/%s/%s/vlog%d",
+                                  Global::toplevel_dir.c_str(),
+                                  m_identifier.id, m_name.c_str(),
+                                  m_range_dir.c_str(), m_next_cs_id++);
+        value_log = new ValueLogWriter(Global::dfs.get(), vlog_file,
+            m_cellstore_props->get_i32("replication", int32_t(-1)));
+      }
+
       /**
        * Check for garbage and if threshold reached, change minor to major
        * compaction
@@ -581,6 +1032,13 @@ void AccessGroup::run_compaction(int maintenance_flags) {
         }
       }
       else if (major || gc) {
+        /**
+         * Values still referenced in value logs that were more than half
+         * garbage after the last full compaction get rewritten, so that
+         * those logs can be dropped
+         */
+        if (value_log)
+          m_value_logs.get_rewrite_candidates(rewrite_value_logs);
         mscanner = new MergeScannerAccessGroup(m_table_name, scan_context, 
                         false, true);
         scanner = mscanner;
@@ -601,10 +1059,29 @@ void AccessGroup::run_compaction(int maintenance_flags) {
 
     cellstore->create(cs_file.c_str(), max_num_entries, m_cellstore_props, &m_identifier);
 
+    // Only compactions that rewrite CellStores are throttled; minor
+    // compactions free memory and must not be held back
+    CompactionThrottle *throttle =
+      (minor || m_in_memory) ? 0 : Global::compaction_throttle;
+    int64_t unthrottled_bytes = 0;
+
+    ValueLogCompactor vlog_compactor(Global::value_log_reader,
+                                     value_log.get(), m_value_log_threshold,
+                                     rewrite_value_logs);
+
     while (scanner->get(key, value)) {
+      vlog_compactor.process(key,
+          m_schema->column_is_counter(key.column_family_code), value);
       cellstore->add(key, value);
       if (m_in_memory)
         filtered_cache->add(key, value);
+      if (throttle) {
+        unthrottled_bytes += key.length + value.length();
+        if (unthrottled_bytes >= 1048576) {
+          throttle->consume(unthrottled_bytes);
+          unthrottled_bytes = 0;
+        }
+      }
       scanner->forward();
     }
 
@@ -616,6 +1093,10 @@ void AccessGroup::run_compaction(int maintenance_flags) {
     if (maintenance_flags & MaintenanceFlag::SPLIT)
       trailer->flags |= CellStoreTrailerV6::SPLIT;
 
+    // The values must be durable before any reference to them is
+    if (value_log)
+      value_log->close();
+
     cellstore->finalize(&m_identifier);
 
     /**
@@ -626,6 +1107,17 @@ void AccessGroup::run_compaction(int maintenance_flags) {
     {
       ScopedLock lock(m_mutex);
 
+      /**
+       * A compaction of all cell stores sees every live reference, so value
+       * logs that are no longer referenced can be dropped
+       */
+      if ((major || gc) && mscanner && !m_in_memory)
+        m_value_logs.set_live_bytes(vlog_compactor.live_bytes(),
+                                    removed_files);
+
+      if (value_log && !value_log->empty())
+        m_value_logs.add(value_log->get_filename(), value_log->size());
+
       if (merging) {
         std::vector<CellStoreInfo> new_stores;
         new_stores.reserve(m_stores.size() - (merge_length-1));
@@ -706,9 +1198,13 @@ void AccessGroup::run_compaction(int maintenance_flags) {
         }
       }
 
+      invalidate_row_cache();
       recompute_compression_ratio(&total_index_entries);
     }
 
+    if (value_log && !value_log->empty())
+      m_file_tracker.add_live_noupdate(value_log->get_filename(),
+                                       total_index_entries);
     m_file_tracker.update_live(added_file, removed_files, m_next_cs_id, total_index_entries);
     m_file_tracker.update_files_column();
 
@@ -822,6 +1318,7 @@ void AccessGroup::shrink(String &split_row, bool drop_high) {
       }
       m_stores = new_stores;
     }
+    invalidate_row_cache();
 
     // This recomputes m_disk_usage as well
     recompute_compression_ratio();
@@ -930,6 +1427,11 @@ void AccessGroup::range_dir_initialize() {
           if (id >= m_next_cs_id)
             m_next_cs_id = id+1;
         }
+        else if (!strncmp(fname, "vlog", 4)) {
+          id = atoi(&fname[4]);
+          if (id >= m_next_cs_id)
+            m_next_cs_id = id+1;
+        }
       }
     }
   }
@@ -946,6 +1448,7 @@ void AccessGroup::range_dir_initialize() {
 }
 
 void AccessGroup::recompute_compression_ratio(int64_t *total_index_entriesp) {
+  double file_bytes = 0.0;
   m_disk_usage = 0;
   m_compression_ratio = 0.0;
   if (total_index_entriesp)
@@ -957,59 +1460,38 @@ void AccessGroup::recompute_compression_ratio(int64_t *total_index_entriesp) {
     double disk_usage = m_stores[i].cs->disk_usage();
     m_disk_usage += (uint64_t)disk_usage;
     m_compression_ratio += disk_usage / m_stores[i].cs->compression_ratio();
+    if (m_stores[i].cs->fraction_covered() > 0.0)
+      file_bytes += disk_usage / m_stores[i].cs->fraction_covered();
   }
   if (m_disk_usage != 0)
     m_compression_ratio = (double)m_disk_usage / m_compression_ratio;
   else
     m_compression_ratio = 1.0;
+  // Value logs are not compressed but count towards range size.  After a
+  // split both ranges list the same logs, so until a full compaction has
+  // measured the references, a log is charged by this range's share of
+  // its CellStore files.
+  double share = 1.0;
+  if (file_bytes > 0.0 && m_disk_usage < file_bytes)
+    share = (double)m_disk_usage / file_bytes;
+  m_disk_usage += m_value_logs.disk_usage(share);
 }
 
 
 bool AccessGroup::find_merge_run(size_t *indexp, size_t *lenp) {
-  size_t index = 0;
-  size_t count = 0;
-  size_t i = 0;
-  int64_t running_total = 0;
 
   if (m_in_memory || m_stores.size() == 0)
     return false;
 
-  do {
-    count++;
-    running_total += m_stores[i].cs->disk_usage();
-
-    if (running_total >= Global::cellstore_target_size_max) {
-      if (count > (size_t)Global::merge_cellstore_run_length_threshold) {
-        if (indexp)
-          *indexp = index;
-        if (lenp)
-           *lenp = count-1;
-        return true;
-      }
-      index = i+1;
-      count = 0;
-      running_total = 0;
-    }
-    else if (running_total >= Global::cellstore_target_size_min &&
-             count > 1) {
-      if (indexp)
-        *indexp = index;
-      if (lenp)
-        *lenp = count;
-      return true;
-    }
-    i++;
-  } while (i < m_stores.size());
-
-  if (count > (size_t)Global::merge_cellstore_run_length_threshold) {
-    if (indexp)
-      *indexp = index;
-    if (lenp)
-      *lenp = count;
-    return true;
-  }
-
-  return false;
+  int64_t now = get_ts64();
+  std::vector<MergeRunSelector::StoreInfo> stores;
+  stores.reserve(m_stores.size());
+  foreach_ht (const CellStoreInfo &csinfo, m_stores)
+    stores.push_back(MergeRunSelector::StoreInfo(csinfo.cs->disk_usage(),
+                                                 csinfo.timestamp_min,
+                                                 csinfo.timestamp_max,
+                                                 cell_store_expired(csinfo, now)));
+  return m_merge_runs.find(stores, now, indexp, lenp);
 }
 
 
@@ -1021,6 +1503,9 @@ bool AccessGroup::needs_merging() {
   if (m_in_memory || m_stores.size() == 0)
     return false;
 
+  if (m_merge_runs.time_window() > 0)
+    return find_merge_run();
+
   for (i = m_stores.size()-1; i>=0; i--) {
     count++;
     running_total += m_stores[i].cs->disk_usage();
@@ -1031,7 +1516,7 @@ bool AccessGroup::needs_merging() {
       return true;
   }
 
-  if (i < 0 && count > (size_t)Global::merge_cellstore_run_length_threshold)
+  if (i < 0 && count > (size_t)m_merge_runs.run_length_threshold())
     return true;
 
   /** Search from the beginning **/
@@ -1044,7 +1529,7 @@ bool AccessGroup::needs_merging() {
     running_total += m_stores[i].cs->disk_usage();
 
     if (running_total >= Global::cellstore_target_size_max) {
-      if (count > (size_t)Global::merge_cellstore_run_length_threshold)
+      if (count > (size_t)m_merge_runs.run_length_threshold())
         return true;
       count = 0;
       running_total = 0;
@@ -1056,7 +1541,7 @@ bool AccessGroup::needs_merging() {
     i++;
   } while (i < (int)m_stores.size());
 
-  if (count > (size_t)Global::merge_cellstore_run_length_threshold)
+  if (count > (size_t)m_merge_runs.run_length_threshold())
     return true;
 
   return false;
@@ -1082,11 +1567,12 @@ void AccessGroup::dump_keys(std::ofstream &out) {
   Schema::ColumnFamily *cf;
   const char *family;
   KeySet keys;
+  ByteArena arena;
 
   // write header line
   out << "\n" << m_full_name << " Keys:\n";
 
-  m_cell_cache_manager->populate_key_set(keys);
+  m_cell_cache_manager->populate_key_set(keys, arena);
 
   for (KeySet::iterator iter = keys.begin();
        iter != keys.end(); ++iter) {
@@ -1130,5 +1616,9 @@ std::ostream &Hypertable::operator<<(std::ostream &os, const AccessGroup::Mainte
   os << "in_memory=" << (mdata.in_memory ? "true" : "false") << "\n";
   os << "gc_needed=" << (mdata.gc_needed ? "true" : "false") << "\n";
   os << "needs_merging=" << (mdata.needs_merging ? "true" : "false") << "\n";
+  os << "disk_usage_estimated=" << (mdata.disk_usage_estimated ? "true" : "false") << "\n";
+  os << "merge_length=" << mdata.merge_length << "\n";
+  os << "merge_bytes=" << mdata.merge_bytes << "\n";
+  os << "expired_files=" << mdata.expired_files << "\n";
   return os;
 }
@@ -43,10 +43,13 @@
 #include "AccessGroupGarbageTracker.h"
 #include "CellCacheManager.h"
 #include "CellStore.h"
+#include "CellStoreExpiration.h"
 #include "CellStoreTrailerV6.h"
 #include "CellStoreInfo.h"
 #include "LiveFileTracker.h"
 #include "MaintenanceFlag.h"
+#include "MergeRunSelector.h"
+#include "ValueLog.h"
 
 
 namespace Hypertable {
@@ -97,6 +100,10 @@ namespace Hypertable {
       bool     in_memory;
       bool     gc_needed;
       bool     needs_merging;
+      bool     disk_usage_estimated;
+      uint32_t merge_length;
+      int64_t  merge_bytes;
+      uint32_t expired_files;
     };
 
     AccessGroup(const TableIdentifier *identifier, SchemaPtr &schema,
@@ -108,6 +115,8 @@ namespace Hypertable {
 
     void split_row_estimate_data_stored(SplitRowDataMapT &split_row_data);
 
+    void split_row_estimate_data_accessed(SplitRowDataMapT &split_row_data);
+
     virtual int64_t get_total_entries() {
       boost::mutex::scoped_lock lock(m_mutex);
       int64_t total = m_cell_cache_manager->get_total_entries();
@@ -138,8 +147,62 @@ namespace Hypertable {
     void space_usage(int64_t *memp, int64_t *diskp);
     void add_cell_store(CellStorePtr &cellstore);
 
+    /** Registers a value log file listed in the METADATA Files column so
+     * that it is kept live until no cell store references it.
+     *
+     * @param fname absolute DFS path of the value log
+     */
+    void add_value_log(const String &fname);
+
+    /** First step of attaching pre-built CellStore files to this access
+     * group.  Each file is moved into the access group's directory under
+     * a name that records the server-assigned <code>revision</code>, which
+     * scanners apply to every cell; the stores are not yet visible to
+     * scans.  Updates may continue meanwhile.
+     *
+     * @param files DFS paths of the CellStore files to import
+     * @param revision revision for the imported cells
+     * @param imported filled in with the opened stores
+     */
+    void prepare_import(const std::vector<String> &files, int64_t revision,
+                        std::vector<CellStorePtr> &imported);
+
+    /** Adds the stores opened by prepare_import() to the store vector and
+     * rewrites the METADATA Files column once for the whole batch.  The
+     * caller must block updates and flush the cell cache first.
+     *
+     * @param imported CellStores returned by prepare_import()
+     * @return latest revision of the imported files
+     */
+    int64_t install_import(std::vector<CellStorePtr> &imported);
+
+    /** Moves the files imported by prepare_import() back to their original
+     * paths when the import cannot be installed, so that it can be retried.
+     *
+     * @param files DFS paths passed to prepare_import()
+     * @param imported CellStores returned by prepare_import()
+     */
+    void discard_import(const std::vector<String> &files,
+                        std::vector<CellStorePtr> &imported);
+
+    /** Loads the block indexes of cell stores whose index loading was
+     * deferred at open time and recomputes the disk usage of the access
+     * group.  The indexes are read without the access group lock, which is
+     * only taken to install each one.
+     */
+    void load_deferred_indexes();
+
     void compute_garbage_stats(uint64_t *input_bytesp, uint64_t *output_bytesp);
 
+    /** Removes cell stores whose contents have all outlived their column
+     * family TTL.  The files are dropped from the store vector and the
+     * METADATA Files column without reading or rewriting any data, and are
+     * garbage collected once no scanner references them.
+     *
+     * @return number of cell stores dropped
+     */
+    size_t drop_expired_cell_stores();
+
     void run_compaction(int maintenance_flags);
 
     uint64_t purge_memory(MaintenanceFlag::Map &subtask_map);
@@ -185,7 +248,17 @@ namespace Hypertable {
     void recompute_compression_ratio(int64_t *total_index_entriesp=0);
     bool find_merge_run(size_t *indexp=0, size_t *lenp=0);
     bool needs_merging();
+    bool cell_store_expired(const CellStoreInfo &csinfo, int64_t now);
     void sort_cellstores_by_timestamp();
+    void gather_row_stores(const String &row,
+                           std::vector<CellStoreInfo> &stores);
+    CellCachePtr load_cached_row(const String &cache_name, const String &row,
+                                 int64_t generation, SchemaPtr &schema,
+                                 std::vector<CellStoreInfo> &stores,
+                                 CellListScanner *mscanner);
+    void invalidate_row_cache();
+    void discard_import(const std::vector<String> &files,
+                        const std::vector<String> &cs_files);
 
     Mutex                m_mutex;
     Mutex                m_outstanding_scanner_mutex;
@@ -219,6 +292,11 @@ namespace Hypertable {
     bool                 m_recovering;
     bool                 m_bloom_filter_disabled;
     bool                 m_needs_merging;
+    MergeRunSelector     m_merge_runs;
+    int64_t              m_row_cache_generation;
+    CellStoreExpiration  m_expiration;
+    uint32_t             m_value_log_threshold;
+    ValueLogSet          m_value_logs;
 
   };
   typedef boost::intrusive_ptr<AccessGroup> AccessGroupPtr;
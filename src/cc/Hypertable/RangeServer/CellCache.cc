@@ -37,17 +37,17 @@ using namespace Hypertable;
 using namespace std;
 
 
-CellCache::CellCache()
-  : m_arena_base(), m_arena(m_arena_base), m_cell_map(std::less<const SerializedKey>(), Alloc(m_arena)),
+CellCache::CellCache(bool tracked)
+  : m_arena_base((size_t)Config::get_i32("Hypertable.RangeServer.AccessGroup"
+                                         ".CellCache.PageSize"),
+                 CellCachePageAllocator(tracked)),
+    m_arena(m_arena_base), m_cell_map(std::less<const CellCacheKey>(), Alloc(m_arena)),
     m_deletes(0), m_collisions(0), m_key_bytes(0), m_value_bytes(0),
     m_frozen(false), m_have_counter_deletes(false) {
-  assert(Config::properties); // requires Config::init* first
-  m_arena.set_page_size((size_t)
-      Config::get_i32("Hypertable.RangeServer.AccessGroup.CellCache.PageSize"));
 }
 
 CellCache::CellCache(CellCacheArena &arena)
-  : m_arena(arena), m_cell_map(std::less<const SerializedKey>(), Alloc(m_arena)),
+  : m_arena(arena), m_cell_map(std::less<const CellCacheKey>(), Alloc(m_arena)),
     m_deletes(0), m_collisions(0), m_key_bytes(0), m_value_bytes(0),
     m_frozen(false), m_have_counter_deletes(false) {
   assert(Config::properties); // requires Config::init* first
@@ -56,37 +56,98 @@ CellCache::CellCache(CellCacheArena &arena)
 }
 
 
+SerializedKey CellCacheKey::serialized(ByteArena &arena) const {
+  if (!shared_row())
+    return SerializedKey(ptr);
+  const char *r = row();
+  size_t row_len = strlen(r) + 1;
+  const uint8_t *t;
+  uint8_t control;
+  size_t tail_len = tail(&t, &control);
+  size_t len = 1 + row_len + tail_len;
+  uint8_t *base = arena.alloc(Serialization::encoded_length_vi32(len) + len);
+  uint8_t *dst = base;
+  Serialization::encode_vi32(&dst, len);
+  *dst++ = control;
+  memcpy(dst, r, row_len);
+  memcpy(dst + row_len, t, tail_len);
+  return SerializedKey(base);
+}
+
+size_t CellCacheKey::encoded_length(const Key &key, bool shared) {
+  if (!shared)
+    return key.length;
+  const uint8_t *rest = (const uint8_t *)key.row + key.row_len + 1;
+  size_t len = key.length - (rest - key.serial.ptr) + 1;
+  return 1 + sizeof(const char *) + Serialization::encoded_length_vi32(len)
+    + len;
+}
+
+void CellCacheKey::encode(const Key &key, const char *row, uint8_t *dst) {
+  if (row == 0) {
+    memcpy(dst, key.serial.ptr, key.length);
+    return;
+  }
+  const uint8_t *rest = (const uint8_t *)key.row + key.row_len + 1;
+  size_t rest_len = key.length - (rest - key.serial.ptr);
+  *dst++ = 0;
+  memcpy(dst, &row, sizeof(const char *));
+  dst += sizeof(const char *);
+  Serialization::encode_vi32(&dst, rest_len + 1);
+  *dst++ = key.control;
+  memcpy(dst, rest, rest_len);
+}
+
+
 /**
+ * The map is searched with the caller's SerializedKey, which is itself a
+ * valid CellCacheKey.  If the cell lands next to a cell of the same row,
+ * the new record references that cell's row when doing so is shorter
+ * than storing the row again.
  */
 void CellCache::add(const Key &key, const ByteString value) {
-  SerializedKey new_key;
   uint8_t *ptr;
-  size_t total_len = key.length + value.length();
+  const char *row = 0;
+  CellCacheKey search_key(key.serial.ptr);
 
   m_key_bytes += key.length;
   m_value_bytes += value.length();
 
   assert(!m_frozen);
 
-  new_key.ptr = ptr = m_arena.alloc(total_len);
-
-  memcpy(ptr, key.serial.ptr, key.length);
-  ptr += key.length;
-
-  value.write(ptr);
-
-  CellMap::value_type v(new_key, key.length);
-  std::pair<CellMap::iterator, bool> r = m_cell_map.insert(v);
-  if (!r.second) {
-    m_cell_map.erase(r.first);
-    m_cell_map.insert(v);
+  CellMap::iterator iter = m_cell_map.lower_bound(search_key);
+  if (iter != m_cell_map.end() && !(search_key < (*iter).first)) {
+    row = (*iter).first.row();
+    m_cell_map.erase(iter++);
     m_collisions++;
-    HT_WARNF("Collision detected key insert (row = %s)", new_key.row());
+    HT_WARNF("Collision detected key insert (row = %s)", key.row);
   }
   else {
     if (key.flag <= FLAG_DELETE_CELL_VERSION)
       m_deletes++;
+    CellMap::iterator prev = iter;
+    if (iter != m_cell_map.end() && !strcmp((*iter).first.row(), key.row))
+      row = (*iter).first.row();
+    else if (iter != m_cell_map.begin() &&
+             !strcmp((*--prev).first.row(), key.row))
+      row = (*prev).first.row();
+  }
+
+  size_t key_len = key.length;
+  if (row) {
+    size_t shared_len = CellCacheKey::encoded_length(key, true);
+    if (shared_len < key_len)
+      key_len = shared_len;
+    else
+      row = 0;
   }
+
+  ptr = m_arena.alloc(key_len + value.length());
+  CellCacheKey new_key(ptr);
+  CellCacheKey::encode(key, row, ptr);
+  value.write(ptr + key_len);
+
+  m_cell_map.insert(iter, CellMap::value_type(new_key, key_len));
 }
 
 
@@ -108,24 +169,32 @@ void CellCache::add_counter(const Key &key, const ByteString value) {
 
   HT_ASSERT(*value.ptr == 8);
 
-  CellMap::iterator iter = m_cell_map.lower_bound(key.serial);
+  CellMap::iterator iter = m_cell_map.lower_bound(CellCacheKey(key.serial.ptr));
 
   if (iter == m_cell_map.end()) {
     add(key, value);
     return;
   }
 
-  const uint8_t *ptr;
+  if (strcmp((*iter).first.row(), key.row)) {
+    add(key, value);
+    return;
+  }
+
+  const uint8_t *tail, *ptr;
+  uint8_t control;
+  const uint8_t *rest = (const uint8_t *)key.row + key.row_len + 1;
+  size_t rest_len = key.length - (rest - key.serial.ptr);
 
-  size_t len = (*iter).first.decode_length(&ptr);
+  size_t len = (*iter).first.tail(&tail, &control);
 
   // If the lengths differ, assume they're different keys and do a normal add
-  if (len + (ptr-(*iter).first.ptr) != key.length) {
+  if (len != rest_len) {
     add(key, value);
     return;
   }
 
-  if (memcmp(ptr+1, key.row, (key.flag_ptr+1)-(const uint8_t *)key.row)) {
+  if (memcmp(tail, rest, (key.flag_ptr+1)-rest)) {
     add(key, value);
     return;
   }
@@ -146,9 +215,8 @@ void CellCache::add_counter(const Key &key, const ByteString value) {
   /*
    * copy timestamp/revision info from insert key to the one in the map
    */
-  size_t offset = (key.flag_ptr-((const uint8_t *)key.serial.ptr)) + 1;
-  len = (*iter).second - offset;
-  memcpy(((uint8_t *)(*iter).first.ptr) + offset, key.flag_ptr+1, len);
+  size_t offset = (key.flag_ptr+1) - rest;
+  memcpy((uint8_t *)tail + offset, key.flag_ptr+1, rest_len - offset);
 
   // read old value
   ptr = old_value.ptr+1;
@@ -175,7 +243,7 @@ void CellCache::split_row_estimate_data(SplitRowDataMapT &split_row_data) {
     row = iter->first.row();
     if (last_row == 0)
       last_row = row;
-    if (strcmp(row, last_row) != 0) {
+    if (row != last_row && strcmp(row, last_row) != 0) {
       CstrToInt64MapT::iterator iter = split_row_data.find(last_row);
       if (iter == split_row_data.end())
         split_row_data[last_row] = last_count;
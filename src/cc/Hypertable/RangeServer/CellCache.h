@@ -22,10 +22,12 @@
 #ifndef HYPERTABLE_CELLCACHE_H
 #define HYPERTABLE_CELLCACHE_H
 
+#include <cstring>
 #include <map>
 #include <set>
 
 #include "Common/Mutex.h"
+#include "Common/PageArena.h"
 
 #include "CellListScanner.h"
 #include "CellList.h"
@@ -44,16 +46,133 @@ namespace Hypertable {
 
   typedef std::set<Key, key_revision_lt> KeySet;
 
+  /**
+   * Key of a CellCache entry.  It points into an arena record that is
+   * followed by the value.  A record is normally a plain SerializedKey.
+   * When a cell is added next to a cell of the same row and the row is
+   * longer than a pointer, the record instead references that row:
+   *
+   *   [0][row pointer][vi32 length][control][family][qualifier\0][flag][ts][rev]
+   *
+   * The leading zero cannot start a SerializedKey, whose length is never
+   * zero.  Cells of short rows, and rows holding a single cell, therefore
+   * take exactly as much memory as a SerializedKey.  Keys are ordered as
+   * their SerializedKeys would be.
+   */
+  class CellCacheKey {
+  public:
+    CellCacheKey() : ptr(0) { }
+    CellCacheKey(const uint8_t *buf) : ptr(buf) { }
+
+    bool shared_row() const { return *ptr == 0; }
+
+    const char *row() const {
+      if (shared_row()) {
+        const char *r;
+        memcpy(&r, ptr + 1, sizeof(r));
+        return r;
+      }
+      return SerializedKey(ptr).row();
+    }
+
+    /** Returns the length of the key portion that follows the row
+     * terminator, which starts with the column family code.
+     * @param tailp set to the start of that portion
+     * @param controlp set to the control byte
+     */
+    size_t tail(const uint8_t **tailp, uint8_t *controlp) const {
+      const uint8_t *p;
+      size_t len;
+      if (shared_row()) {
+        p = ptr + 1 + sizeof(const char *);
+        len = Serialization::decode_vi32(&p);
+        *controlp = *p;
+        *tailp = p + 1;
+        return len - 1;
+      }
+      len = SerializedKey(ptr).decode_length(&p);
+      *controlp = *p;
+      size_t row_len = strlen((const char *)p + 1) + 1;
+      *tailp = p + 1 + row_len;
+      return len - 1 - row_len;
+    }
+
+    uint8_t column_family_code() const {
+      const uint8_t *t;
+      uint8_t control;
+      tail(&t, &control);
+      return t[0];
+    }
+
+    uint8_t flag() const {
+      const uint8_t *t;
+      uint8_t control;
+      tail(&t, &control);
+      return t[strlen((const char *)t + 1) + 2];
+    }
+
+    /** Returns the key as a SerializedKey.  A record that references its
+     * row is rebuilt into <code>arena</code>, other records are returned
+     * in place.
+     */
+    SerializedKey serialized(ByteArena &arena) const;
+
+    /** Returns the record length for <code>key</code>.
+     * @param key key to encode
+     * @param shared <i>true</i> for the form that references the row
+     */
+    static size_t encoded_length(const Key &key, bool shared);
+
+    /** Writes the record for <code>key</code> to <code>dst</code>, which
+     * must hold encoded_length() bytes.
+     * @param key key to encode
+     * @param row row string to reference, or 0 for a plain SerializedKey
+     * @param dst destination buffer
+     */
+    static void encode(const Key &key, const char *row, uint8_t *dst);
+
+    const uint8_t *ptr;
+  };
+
+  inline bool operator<(const CellCacheKey k1, const CellCacheKey k2) {
+    const char *row1 = k1.row(), *row2 = k2.row();
+    if (row1 != row2) {
+      int cmp = strcmp(row1, row2);
+      if (cmp)
+        return cmp < 0;
+    }
+    // Rows are equal, so compare the remainder as SerializedKey::compare
+    const uint8_t *t1, *t2;
+    uint8_t c1, c2;
+    int len1 = k1.tail(&t1, &c1);
+    int len2 = k2.tail(&t2, &c2);
+    if (c1 != c2) {
+      // see Key.h
+      if (c1 >= 0x80 && c1 != 0xD0)
+        len1 -= 8;
+      if (c2 >= 0x80 && c2 != 0xD0)
+        len2 -= 8;
+    }
+    int cmp = memcmp(t1, t2, (len1 < len2) ? len1 : len2);
+    return (cmp == 0) ? len1 < len2 : cmp < 0;
+  }
+
 
   /**
    * Represents  a sorted list of key/value pairs in memory.
    * All updates get written to the CellCache and later get "compacted"
-   * into a CellStore on disk.
+   * into a CellStore on disk.  Keys are stored as CellCacheKey records,
+   * which let cells of a row share one copy of a long row key.
    */
   class CellCache : public CellList {
 
   public:
-    CellCache();
+    /**
+     * @param tracked if <i>false</i> the arena memory is not charged to
+     * Global::memory_tracker, for caches whose memory is accounted
+     * elsewhere such as the rows held by the RowCache
+     */
+    CellCache(bool tracked = true);
     CellCache(CellCacheArena &arena);
     virtual ~CellCache() { m_cell_map.clear(); }
     /**
@@ -117,11 +236,14 @@ namespace Hypertable {
 
     void merge(CellCache *other);
 
-    void populate_key_set(KeySet &keys) {
+    /** Adds all keys to <code>keys</code>.  Keys that reference their row
+     * are rebuilt in <code>arena</code>, which must outlive the set.
+     */
+    void populate_key_set(KeySet &keys, ByteArena &arena) {
       Key key;
       for (CellMap::const_iterator iter = m_cell_map.begin();
 	   iter != m_cell_map.end(); ++iter) {
-	key.load((*iter).first);
+	key.load((*iter).first.serialized(arena));
 	keys.insert(key);
       }
     }
@@ -130,10 +252,10 @@ namespace Hypertable {
 
     friend class CellCacheScanner;
 
-    typedef std::pair<const SerializedKey, uint32_t> Value;
+    typedef std::pair<const CellCacheKey, uint32_t> Value;
     typedef CellCacheAllocator<Value> Alloc;
-    typedef std::map<const SerializedKey, uint32_t,
-                     std::less<const SerializedKey>, Alloc> CellMap;
+    typedef std::map<const CellCacheKey, uint32_t,
+                     std::less<const CellCacheKey>, Alloc> CellMap;
 
   protected:
 
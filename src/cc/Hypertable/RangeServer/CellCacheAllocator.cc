@@ -24,12 +24,14 @@
 namespace Hypertable {
 
 void *CellCachePageAllocator::allocate(size_t sz) {
-  Global::memory_tracker->add(sz);
+  if (m_tracked)
+    Global::memory_tracker->add(sz);
   return std::malloc(sz);
 }
 
 void CellCachePageAllocator::freed(size_t sz) {
-  Global::memory_tracker->subtract(sz);
+  if (m_tracked)
+    Global::memory_tracker->subtract(sz);
 }
 
 } // namespace Hypertable
@@ -24,9 +24,15 @@
 
 namespace Hypertable {
 
+/**
+ * Page allocator that charges CellCache memory to Global::memory_tracker,
+ * unless constructed untracked for memory that is accounted elsewhere.
+ */
 struct CellCachePageAllocator : DefaultPageAllocator {
+  CellCachePageAllocator(bool tracked = true) : m_tracked(tracked) { }
   void *allocate(size_t sz);
   void freed(size_t sz);
+  bool m_tracked;
 };
 
 typedef PageArena<uint8_t, CellCachePageAllocator> CellCacheArena;
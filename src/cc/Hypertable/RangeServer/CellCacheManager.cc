@@ -198,9 +198,9 @@ void CellCacheManager::freeze() {
   m_write_cache = new CellCache(m_read_cache->arena());
 }
 
-void CellCacheManager::populate_key_set(KeySet &keys) {
+void CellCacheManager::populate_key_set(KeySet &keys, ByteArena &arena) {
   if (m_immutable_cache)
-    m_immutable_cache->populate_key_set(keys);
-  m_read_cache->populate_key_set(keys);
-  m_write_cache->populate_key_set(keys);
+    m_immutable_cache->populate_key_set(keys, arena);
+  m_read_cache->populate_key_set(keys, arena);
+  m_write_cache->populate_key_set(keys, arena);
 }
@@ -101,7 +101,7 @@ namespace Hypertable {
 
     void freeze();
 
-    void populate_key_set(KeySet &keys);
+    void populate_key_set(KeySet &keys, ByteArena &arena);
 
   private:
     CellCachePtr m_read_cache;
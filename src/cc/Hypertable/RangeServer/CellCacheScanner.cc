@@ -42,7 +42,6 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache,
     m_in_deletes(false), m_eos(false), m_keys_only(false) {
   ScopedLock lock(m_cell_cache_mutex);
   DynamicBuffer current_buf;
-  Key current;
   String tmp_str;
 
   m_keys_only = (scan_ctx->spec) ? (scan_ctx->spec->keys_only && !scan_ctx->spec->value_regexp) : false;
@@ -71,13 +70,10 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache,
                           scan_ctx->start_key.row, 0,
                           "", TIMESTAMP_MAX, 0);
 
-    current.serial.ptr = current_buf.base;
-
-    for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(current.serial);
+    for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(CellCacheKey(current_buf.base));
          iter != m_cell_cache_ptr->m_cell_map.end(); ++iter) {
-      current.load(iter->first);
-      if (current.flag != FLAG_DELETE_ROW ||
-          strcmp(current.row, scan_ctx->start_key.row))
+      if (iter->first.flag() != FLAG_DELETE_ROW ||
+          strcmp(iter->first.row(), scan_ctx->start_key.row))
         break;
       m_deletes.insert(CellCache::CellMap::value_type(iter->first, iter->second));
     }
@@ -90,23 +86,20 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache,
                             scan_ctx->start_key.column_family_code,
                             "", TIMESTAMP_MAX, 0);
 
-      current.serial.ptr = current_buf.base;
-
-      for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(current.serial);
+      for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(CellCacheKey(current_buf.base));
            iter != m_cell_cache_ptr->m_cell_map.end(); ++iter) {
-        current.load(iter->first);
-        if (current.flag != FLAG_DELETE_COLUMN_FAMILY ||
-            current.column_family_code != scan_ctx->start_key.column_family_code ||
-            strcmp(current.row, scan_ctx->start_key.row))
+        if (iter->first.flag() != FLAG_DELETE_COLUMN_FAMILY ||
+            iter->first.column_family_code() != scan_ctx->start_key.column_family_code ||
+            strcmp(iter->first.row(), scan_ctx->start_key.row))
           break;
         m_deletes.insert(CellCache::CellMap::value_type(iter->first, iter->second));
       }
     }
   }
 
-  m_start_iter = m_cell_cache_ptr->m_cell_map.lower_bound(scan_ctx->start_serkey);
+  m_start_iter = m_cell_cache_ptr->m_cell_map.lower_bound(CellCacheKey(scan_ctx->start_serkey.ptr));
   if (m_start_iter != m_cell_cache_ptr->m_cell_map.end())
-    m_end_iter = m_cell_cache_ptr->m_cell_map.lower_bound(scan_ctx->end_serkey);
+    m_end_iter = m_cell_cache_ptr->m_cell_map.lower_bound(CellCacheKey(scan_ctx->end_serkey.ptr));
   else
     m_end_iter = m_cell_cache_ptr->m_cell_map.end();
   m_cur_iter = m_start_iter;
@@ -117,12 +110,9 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache,
   }
 
   while (m_cur_iter != m_end_iter) {
-    m_cur_entry.key.load( (*m_cur_iter).first );
-    if (m_cur_entry.key.flag == FLAG_DELETE_ROW
-        || m_scan_context_ptr->family_mask[m_cur_entry.key.column_family_code]) {
-      m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + (*m_cur_iter).second;
+    if (m_cur_iter->first.flag() == FLAG_DELETE_ROW
+        || m_scan_context_ptr->family_mask[m_cur_iter->first.column_family_code()])
       return;
-    }
     ++m_cur_iter;
   }
   m_eos = true;
@@ -152,15 +142,25 @@ void CellCacheScanner::forward() {
 }
 
 
+/**
+ * Keys that reference their row are rebuilt into m_key_arena, which is
+ * reset each time the entry cache is refilled.
+ */
+void CellCacheScanner::load_entry(const CellCache::Value &v) {
+  m_cur_entry.key.load(v.first.serialized(m_key_arena));
+  m_cur_entry.value.ptr = v.first.ptr + v.second;
+}
+
+
 bool CellCacheScanner::internal_get() {
 
   if (m_in_deletes) {
-    m_cur_entry.key.load( (*m_delete_iter).first );
-    m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + (*m_delete_iter).second;
+    load_entry(*m_delete_iter);
     return true;
   }
 
   if (!m_eos) {
+    load_entry(*m_cur_iter);
     if (m_keys_only)
       m_cur_entry.value = (ByteString)0;
     return true;
@@ -175,24 +175,16 @@ void CellCacheScanner::internal_forward() {
 
   if (m_in_deletes) {
     ++m_delete_iter;
-    if (m_delete_iter == m_deletes.end()) {
+    if (m_delete_iter == m_deletes.end())
       m_in_deletes = false;
-      // reset current entry since its loaded with the last entry in m_deletes
-      m_cur_entry.key.load( (*m_cur_iter).first );
-      m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + (*m_cur_iter).second;
-    }
     return;
   }
 
   ++m_cur_iter;
   while (m_cur_iter != m_end_iter) {
-
-    m_cur_entry.key.load( (*m_cur_iter).first );
-    if (m_cur_entry.key.flag == FLAG_DELETE_ROW
-        || m_scan_context_ptr->family_mask[m_cur_entry.key.column_family_code]) {
-      m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + (*m_cur_iter).second;
+    if (m_cur_iter->first.flag() == FLAG_DELETE_ROW
+        || m_scan_context_ptr->family_mask[m_cur_iter->first.column_family_code()])
       return;
-    }
     ++m_cur_iter;
   }
   m_eos = true;
@@ -208,6 +200,7 @@ void CellCacheScanner::load_entry_cache() {
 
   m_entry_cache_next = 0;
   m_entry_cache.clear();
+  m_key_arena.free();
 
   if (m_eos)
     return;
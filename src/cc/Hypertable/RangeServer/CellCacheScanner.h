@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_CELLCACHESCANNER_H
 #define HYPERTABLE_CELLCACHESCANNER_H
 
+#include "Common/PageArena.h"
+
 #include "CellCache.h"
 #include "CellListScanner.h"
 #include "ScanContext.h"
@@ -41,13 +43,14 @@ namespace Hypertable {
 
     virtual uint64_t get_disk_read() { return 0; }
 
-    typedef std::map<const SerializedKey, uint32_t> CellCacheMap;
+    typedef std::map<const CellCacheKey, uint32_t> CellCacheMap;
 
   private:
 
     bool internal_get();
     void internal_forward();
     void load_entry_cache();
+    void load_entry(const CellCache::Value &v);
 
     class CellCacheEntry {
     public:
@@ -65,6 +68,7 @@ namespace Hypertable {
     CellCacheEntry                 m_cur_entry;
     std::vector<CellCacheEntry>    m_entry_cache;
     size_t                         m_entry_cache_next;
+    ByteArena                      m_key_arena;
     CellCacheMap                   m_deletes;
     bool                           m_in_deletes;
     bool                           m_eos;
@@ -20,6 +20,12 @@
  */
 
 #include "Common/Compat.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/any.hpp>
+
 #include "CellStore.h"
 #include "KeyDecompressorNone.h"
 
@@ -43,3 +49,24 @@ void CellStore::set_replaced_files(const std::vector<String> &old_files) {
 const std::vector<String> &CellStore::get_replaced_files() {
   return m_replaced_files;
 }
+
+int64_t CellStore::get_revision() {
+  if (m_revision_override)
+    return m_revision_override;
+  return boost::any_cast<int64_t>(get_trailer()->get("revision"));
+}
+
+String CellStore::imported_name(const String &fname, int64_t revision) {
+  return format("%s.r%lld", fname.c_str(), (Lld)revision);
+}
+
+int64_t CellStore::imported_revision(const String &fname) {
+  const char *base = strrchr(fname.c_str(), '/');
+  base = base ? base + 1 : fname.c_str();
+  if (strncmp(base, "cs", 2))
+    return 0;
+  const char *suffix = strstr(base, ".r");
+  if (suffix == 0)
+    return 0;
+  return strtoll(suffix + 2, 0, 10);
+}
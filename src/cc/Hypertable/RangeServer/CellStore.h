@@ -55,7 +55,7 @@ namespace Hypertable {
       uint64_t block_index_access_counter;
     };
 
-    CellStore() : m_block_count(0), m_bytes_read(0) { }
+    CellStore() : m_block_count(0), m_bytes_read(0), m_revision_override(0) { }
 
     virtual ~CellStore() { return; }
 
@@ -71,6 +71,15 @@ namespace Hypertable {
       HT_FATAL("Not implemented!");
     }
 
+    /** Populates <code>split_row_data</code> with rows and block read
+     * counts recorded in the block index since it was loaded.  Cell stores
+     * that do not track block reads leave the map untouched.
+     * @param split_row_data Reference to accumulator map holding rows and
+     * access counts
+     * @note <code>split_row_data</code> should not be cleared
+     */
+    virtual void split_row_access_data(SplitRowDataMapT &split_row_data) { }
+
     virtual int64_t get_total_entries() = 0;
 
     virtual CellListScanner *
@@ -154,6 +163,49 @@ namespace Hypertable {
      */
     virtual uint64_t disk_usage() = 0;
 
+    /**
+     * Returns true if the value returned by disk_usage() is an upper bound
+     * because loading of the block index was deferred when the cell store
+     * was opened (see Global::defer_cellstore_index_load).
+     */
+    virtual bool disk_usage_estimated() { return false; }
+
+    /**
+     * Returns the fraction of the cell store file charged to this object by
+     * disk_usage().  It is less than one when the cell store is opened with
+     * a restricted range, for example after a split.
+     */
+    virtual double fraction_covered() { return 1.0; }
+
+    /**
+     * Returns true if loading of the block index was deferred when the cell
+     * store was opened and the index has not been loaded since.
+     */
+    virtual bool index_deferred() { return false; }
+
+    /**
+     * Reads the block index whose loading was deferred when the cell store
+     * was opened into <code>fixed</code> and <code>variable</code>.  It only
+     * reads the file and leaves the cell store untouched, so it may be
+     * called without holding the access group lock.
+     *
+     * @param fixed filled in with the fixed part of the index
+     * @param variable filled in with the variable part of the index
+     */
+    virtual void read_deferred_index(DynamicBuffer &fixed,
+                                     DynamicBuffer &variable) { }
+
+    /**
+     * Installs an index read by read_deferred_index(), making disk_usage()
+     * exact.  The buffers are dropped if the index was loaded on demand in
+     * the meantime.
+     *
+     * @param fixed fixed part of the index
+     * @param variable variable part of the index
+     */
+    virtual void install_deferred_index(DynamicBuffer &fixed,
+                                        DynamicBuffer &variable) { }
+
     /**
      * Returns the number of CellStore blocks covered by this object.
      * @return block count
@@ -189,6 +241,46 @@ namespace Hypertable {
      */
     virtual CellStoreTrailer *get_trailer() = 0;
 
+    /**
+     * Returns the revision of the cell store, which is the trailer revision
+     * unless the revision has been overridden
+     *
+     * @return cell store revision
+     */
+    int64_t get_revision();
+
+    /**
+     * Makes every cell returned by this cell store's scanners carry
+     * <code>revision</code> instead of the revision it was written with.
+     * Used for CellStores built outside the server and imported.
+     *
+     * @param revision revision to assign, or 0 for none
+     */
+    void set_revision_override(int64_t revision) {
+      m_revision_override = revision;
+    }
+
+    int64_t get_revision_override() { return m_revision_override; }
+
+    /**
+     * Returns the name under which a CellStore imported with
+     * <code>revision</code> is installed.  The revision is kept in the name
+     * so that it is recorded in the METADATA Files column along with it.
+     *
+     * @param fname name the cell store would otherwise have
+     * @param revision revision assigned on import
+     * @return name of the imported cell store
+     */
+    static String imported_name(const String &fname, int64_t revision);
+
+    /**
+     * Returns the revision recorded in the name of an imported cell store
+     *
+     * @param fname cell store file name
+     * @return assigned revision, or 0 if the cell store was not imported
+     */
+    static int64_t imported_revision(const String &fname);
+
     /**
      * Creates a block compression codec suitable for decompressing
      * the cell store's blocks
@@ -243,6 +335,15 @@ namespace Hypertable {
      */
     virtual int32_t reopen_fd() = 0;
 
+    /**
+     * Returns a pointer to the read-only memory mapping of the CellStore
+     * file, or 0 if the file is not mapped.  Only stores written with the
+     * NONE block codec are mapped, so data blocks can be scanned in place.
+     *
+     * @return base of file mapping or 0
+     */
+    virtual const uint8_t *mapped_data() { return 0; }
+
     /**
      * Returns the amount of memory consumed by the bloom filter
      *
@@ -302,6 +403,7 @@ namespace Hypertable {
     IndexMemoryStats m_index_stats;
     std::vector <String> m_replaced_files;
     TableIdentifierManaged m_table_identifier;
+    int64_t m_revision_override;
   };
 
   typedef intrusive_ptr<CellStore> CellStorePtr;
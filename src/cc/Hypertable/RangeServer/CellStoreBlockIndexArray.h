@@ -77,6 +77,7 @@ namespace Hypertable {
     bool operator!=(const CellStoreBlockIndexIteratorArray &other) {
       return m_iter != other.m_iter;
     }
+    ArrayIteratorT array_iterator() const { return m_iter; }
   protected:
     ArrayIteratorT m_iter;
   };
@@ -150,6 +151,11 @@ namespace Hypertable {
 
       HT_ASSERT(key_ptr <= variable.ptr);
 
+      m_access_counts.clear();
+      m_access_counts.resize(m_array.size(), 0);
+      m_verified.clear();
+      m_verified.resize(m_array.size(), 0);
+
       if (!m_array.empty()) {
         HT_ASSERT(variable_start < variable_end);
 
@@ -258,8 +264,59 @@ namespace Hypertable {
       }
     }
 
+    /** Records a read of the block referenced by an index entry.  The
+     * counts are only approximate since concurrent scanners update them
+     * without synchronization.
+     * @param iter Iterator referencing the block index entry
+     */
+    void record_access(const iterator &iter) {
+      size_t i = iter.array_iterator() - m_array.begin();
+      if (i < m_access_counts.size())
+        m_access_counts[i]++;
+    }
+
+    /** Returns true if the checksum of the block referenced by an index
+     * entry was verified since the index was loaded.  Used for blocks read
+     * in place from a file mapping, which bypass the block codec.
+     * @param iter Iterator referencing the block index entry
+     */
+    bool block_verified(const iterator &iter) {
+      size_t i = iter.array_iterator() - m_array.begin();
+      return i < m_verified.size() && m_verified[i];
+    }
+
+    /** Records that the checksum of a block has been verified.  Concurrent
+     * scanners may both verify a block before either records it.
+     * @param iter Iterator referencing the block index entry
+     */
+    void set_block_verified(const iterator &iter) {
+      size_t i = iter.array_iterator() - m_array.begin();
+      if (i < m_verified.size())
+        m_verified[i] = 1;
+    }
+
+    /** Accumulates per-row block access counts.  Each block's access count
+     * is attributed to the row of its index entry, so the resulting map
+     * describes where in the key space reads have landed.
+     * @param split_row_data Reference to accumulator map holding row
+     * and access counts
+     */
+    void row_access_estimate(CellList::SplitRowDataMapT &split_row_data) {
+      for (size_t i=0; i<m_array.size() && i<m_access_counts.size(); i++) {
+        if (m_access_counts[i] == 0)
+          continue;
+        const char *row = m_array[i].key.row();
+        CstrToInt64MapT::iterator iter = split_row_data.find(row);
+        if (iter == split_row_data.end())
+          split_row_data[row] = m_access_counts[i];
+        else
+          iter->second += m_access_counts[i];
+      }
+    }
+
     size_t memory_used() {
-      return m_keydata.size + (m_array.size() * (sizeof(ElementT)));
+      return m_keydata.size + (m_array.size() * (sizeof(ElementT))) +
+        (m_access_counts.size() * sizeof(uint32_t)) + m_verified.size();
     }
 
     int64_t disk_used() { return m_disk_used; }
@@ -290,6 +347,8 @@ namespace Hypertable {
 
     void clear() {
       m_array.clear();
+      m_access_counts.clear();
+      m_verified.clear();
       m_keydata.free();
       m_middle_key.ptr = 0;
       m_fraction_covered = 0.0;
@@ -297,6 +356,8 @@ namespace Hypertable {
 
   private:
     ArrayT m_array;
+    std::vector<uint32_t> m_access_counts;
+    std::vector<uint8_t> m_verified;
     StaticBuffer m_keydata;
     SerializedKey m_middle_key;
     int64_t m_end_of_last_block;
@@ -0,0 +1,51 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include "CellStoreExpiration.h"
+
+using namespace Hypertable;
+
+
+void CellStoreExpiration::set_schema(Schema::AccessGroup *ag) {
+  m_ttl = 0;
+  foreach_ht(Schema::ColumnFamily *cf, ag->columns) {
+    if (cf->deleted)
+      continue;
+    if (cf->ttl == 0) {
+      m_ttl = 0;
+      return;
+    }
+    if ((int64_t)cf->ttl * 1000000000LL > m_ttl)
+      m_ttl = (int64_t)cf->ttl * 1000000000LL;
+  }
+}
+
+
+bool CellStoreExpiration::expired(int64_t expiration_time,
+                                  int64_t timestamp_min,
+                                  int64_t timestamp_max, int64_t now) const {
+  if (m_ttl == 0 || expiration_time == TIMESTAMP_NULL ||
+      timestamp_min > timestamp_max)
+    return false;
+  return expiration_time < now && timestamp_max < now - m_ttl;
+}
@@ -0,0 +1,71 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_CELLSTOREEXPIRATION_H
+#define HYPERTABLE_CELLSTOREEXPIRATION_H
+
+#include "Hypertable/Lib/KeySpec.h"
+#include "Hypertable/Lib/Schema.h"
+
+namespace Hypertable {
+
+  /**
+   * Decides whether every cell of a CellStore has outlived its TTL so the
+   * store can be dropped without being read.  The age bound is the longest
+   * TTL of the access group: a delete tombstone carries no TTL of its own
+   * and must be kept for as long as any cell it may shadow can still be
+   * visible.  A tombstone only shadows cells with timestamps up to its own,
+   * so once the newest cell of a store is older than the longest TTL, the
+   * cells shadowed by its tombstones have expired as well.
+   */
+  class CellStoreExpiration {
+  public:
+    CellStoreExpiration() : m_ttl(0) { }
+
+    /** Recomputes the age bound from the column families of the access
+     * group.  Access groups with a column family lacking a TTL are never
+     * eligible.
+     *
+     * @param ag access group specification
+     */
+    void set_schema(Schema::AccessGroup *ag);
+
+    /** Returns the age bound in nanoseconds, or 0 if stores never expire */
+    int64_t ttl() const { return m_ttl; }
+
+    /** Returns true if a store with the given trailer values holds only
+     * expired cells.
+     *
+     * @param expiration_time trailer expiration time
+     * @param timestamp_min oldest cell timestamp in the store
+     * @param timestamp_max newest cell timestamp in the store
+     * @param now current time in nanoseconds since the epoch
+     */
+    bool expired(int64_t expiration_time, int64_t timestamp_min,
+                 int64_t timestamp_max, int64_t now) const;
+
+  private:
+    int64_t m_ttl;
+  };
+
+}
+
+#endif // HYPERTABLE_CELLSTOREEXPIRATION_H
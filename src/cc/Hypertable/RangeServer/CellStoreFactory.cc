@@ -114,6 +114,7 @@ CellStore *CellStoreFactory::open(const String &name,
     }
 
     cellstore_v6 = new CellStoreV6(Global::dfs.get());
+    cellstore_v6->set_revision_override(CellStore::imported_revision(name));
     cellstore_v6->open(name, start, end, fd, file_length, &trailer_v6);
     if (!cellstore_v6)
       HT_ERRORF("Failed to open CellStore %s [%s..%s], length=%llu",
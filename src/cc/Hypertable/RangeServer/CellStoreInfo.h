@@ -46,7 +46,8 @@ namespace Hypertable {
     }
     CellStoreInfo() : cell_count(0), shadow_cache_ecr(TIMESTAMP_MAX),
                       shadow_cache_hits(0), bloom_filter_accesses(0),
-                      bloom_filter_maybes(0), bloom_filter_fps(0) { }
+                      bloom_filter_maybes(0), bloom_filter_fps(0),
+                      expiration_time(TIMESTAMP_MAX) { }
 
     void init_from_trailer() {
       int divisor = 0;
@@ -76,6 +77,12 @@ namespace Hypertable {
       catch (std::exception &e) {
         key_bytes = value_bytes = 0;
       }
+      try {
+        expiration_time = boost::any_cast<int64_t>(cs->get_trailer()->get("expiration_time"));
+      }
+      catch (std::exception &e) {
+        expiration_time = TIMESTAMP_MAX;
+      }
     }
     CellStorePtr cs;
     CellCachePtr shadow_cache;
@@ -90,6 +97,7 @@ namespace Hypertable {
     int64_t timestamp_min;
     int64_t timestamp_max;
     int64_t expirable_data;
+    int64_t expiration_time;
     int64_t total_data;
   };
 
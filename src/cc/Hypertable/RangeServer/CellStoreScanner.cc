@@ -33,6 +33,7 @@
 #include "CellStoreScannerInterval.h"
 #include "CellStoreScannerIntervalBlockIndex.h"
 #include "CellStoreScannerIntervalReadahead.h"
+#include "ValueLog.h"
 
 using namespace Hypertable;
 
@@ -40,10 +41,13 @@ using namespace Hypertable;
 template <typename IndexT>
 CellStoreScanner<IndexT>::CellStoreScanner(CellStore *cellstore, ScanContextPtr &scan_ctx, IndexT *index) :
   CellListScanner(scan_ctx), m_cellstore(cellstore), m_interval_index(0),
-  m_interval_max(0), m_keys_only(false), m_eos(false) {
+  m_interval_max(0), m_resolved_ref(0),
+  m_revision_override(cellstore->get_revision_override()), m_keys_only(false),
+  m_eos(false) {
   SerializedKey start_key, end_key;
 
   m_keys_only = (scan_ctx->spec) ? (scan_ctx->spec->keys_only && !scan_ctx->spec->value_regexp) : false;
+  m_resolve_value_refs = scan_ctx->resolve_value_refs && Global::value_log_reader;
 
   memset(m_interval_scanners, 0, 3*sizeof(CellStoreScannerInterval *));
 
@@ -166,6 +170,10 @@ bool CellStoreScanner<IndexT>::get(Key &key, ByteString &value) {
   if (m_interval_scanners[m_interval_index]->get(key, value)) {
     if (m_keys_only)
       value = 0;
+    else if (m_resolve_value_refs)
+      resolve_value(value);
+    if (m_revision_override)
+      override_revision(key);
     return true;
   }
 
@@ -175,6 +183,10 @@ bool CellStoreScanner<IndexT>::get(Key &key, ByteString &value) {
     if (m_interval_scanners[m_interval_index]->get(key, value)) {
       if (m_keys_only)
         value = 0;
+      else if (m_resolve_value_refs)
+        resolve_value(value);
+      if (m_revision_override)
+        override_revision(key);
       return true;
     }
     m_interval_index++;
@@ -198,8 +210,39 @@ template <typename IndexT>
 void CellStoreScanner<IndexT>::forward() {
   if (m_eos)
     return;
+  m_resolved_ref = 0;
   m_interval_scanners[m_interval_index]->forward();
 }
 
+
+/**
+ * get() may be called more than once for the same cell, so the value last
+ * read from the value log is kept until the scanner moves forward.
+ */
+template <typename IndexT>
+void CellStoreScanner<IndexT>::resolve_value(ByteString &value) {
+  if (!ValueLogReference::is_reference(value))
+    return;
+  if (value.ptr != m_resolved_ref) {
+    ByteString resolved;
+    Global::value_log_reader->read(value, m_value_buf, resolved);
+    m_resolved_ref = value.ptr;
+  }
+  value.ptr = m_value_buf.base;
+}
+
+/**
+ * All cells of an imported cell store were written with the same revision,
+ * so giving them all another one keeps them in order.
+ */
+template <typename IndexT>
+void CellStoreScanner<IndexT>::override_revision(Key &key) {
+  m_override_key_buf.clear();
+  create_key_and_append(m_override_key_buf, key.flag, key.row,
+                        key.column_family_code, key.column_qualifier,
+                        key.timestamp, m_revision_override);
+  key.load(SerializedKey(m_override_key_buf.base));
+}
+
 template class CellStoreScanner<CellStoreBlockIndexArray<uint32_t> >;
 template class CellStoreScanner<CellStoreBlockIndexArray<int64_t> >;
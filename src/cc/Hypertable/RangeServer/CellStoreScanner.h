@@ -45,11 +45,19 @@ namespace Hypertable {
     virtual uint64_t get_disk_read();
 
   private:
+    void resolve_value(ByteString &value);
+    void override_revision(Key &key);
+
     CellStorePtr              m_cellstore;
     CellStoreScannerInterval *m_interval_scanners[3];
     size_t                    m_interval_index;
     size_t                    m_interval_max;
     DynamicBuffer             m_key_buf;
+    DynamicBuffer             m_value_buf;
+    const uint8_t            *m_resolved_ref;
+    DynamicBuffer             m_override_key_buf;
+    int64_t                   m_revision_override;
+    bool                      m_resolve_value_refs;
     bool                      m_keys_only;
     bool                      m_eos;
   };
@@ -48,6 +48,7 @@ CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(C
 
   m_end_row = (m_end_key) ? m_end_key.row() : Key::END_ROW_MARKER;
   m_fd = m_cellstore->get_fd();
+  m_mapped_data = m_cellstore->mapped_data();
 
   if (m_start_key && (m_iter = m_index->lower_bound(m_start_key)) == m_index->end())
     return;
@@ -93,7 +94,7 @@ CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(C
 
 template <typename IndexT>
 CellStoreScannerIntervalBlockIndex<IndexT>::~CellStoreScannerIntervalBlockIndex() {
-  if (m_block.base != 0) {
+  if (m_block.base != 0 && m_mapped_data == 0) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
     else
@@ -177,7 +178,9 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
 
   // If we're at the end of the current block, deallocate and move to next
   if (m_block.base != 0 && eob) {
-    if (m_cached)
+    if (m_mapped_data)
+      ;
+    else if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
     else
       delete [] m_block.base;
@@ -196,6 +199,7 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     uint32_t len;
 
     m_block.offset = m_iter.value();
+    m_index->record_access(m_iter);
 
     IndexIteratorT it_next = m_iter;
     ++it_next;
@@ -211,13 +215,16 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     }
 
     /**
-     * Cache lookup / block read
+     * Mapped block (uncompressed, scanned in place) / cache lookup / block read
      */
-    if (Global::block_cache == 0 || Global::block_cache->compressed() ||
+    if (m_mapped_data)
+      load_mapped_block(&len);
+    else if (Global::block_cache == 0 || Global::block_cache->compressed() ||
         !Global::block_cache->checkout(m_file_id, m_block.offset,
 				       (uint8_t **)&m_block.base, &len)) {
       bool second_try = false;
       bool checked_out = false;
+      bool from_dfs = false;
     try_again:
       try {
         DynamicBuffer buf;
@@ -227,8 +234,13 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
 				           (uint8_t **)&buf.base, &len)) {
 	  buf.grow(m_block.zlength, true);
 
-	  /** Read compressed block **/
-	  Global::dfs->pread(m_fd, buf.base, m_block.zlength, m_block.offset, second_try);
+	  /** Read compressed block from the SSD cache tier or the DFS **/
+	  if (second_try || Global::ssd_block_cache == 0 ||
+              !Global::ssd_block_cache->read(m_file_id, m_block.offset,
+                                             buf.base, m_block.zlength)) {
+	    Global::dfs->pread(m_fd, buf.base, m_block.zlength, m_block.offset, second_try);
+            from_dfs = true;
+          }
 
 	  checked_out = false;
 	}
@@ -253,6 +265,11 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
           HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC,
                    "Error inflating cell store block - magic string mismatch");
 
+        /** Keep a compressed copy on local disk once it has inflated cleanly **/
+        if (from_dfs && Global::ssd_block_cache)
+          Global::ssd_block_cache->insert(m_file_id, m_block.offset,
+                                          (uint8_t *)buf.base, m_block.zlength);
+
         /** Insert or checkin compressed block into cache  **/
         if (Global::block_cache && Global::block_cache->compressed()) {
           if (checked_out)
@@ -299,6 +316,50 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
   return false;
 }
 
+/**
+ * Points m_block at the data of the current block inside the CellStore file
+ * mapping.  Blocks of a mapped store are stored with the NONE codec, so the
+ * data follows the block header verbatim and no copy or block cache entry is
+ * needed.  The data checksum is verified the first time a block is read after
+ * the index is loaded, as the codec would on every read.  Pages evicted
+ * afterwards and faulted in again from disk are not verified again.
+ */
+template <typename IndexT>
+void CellStoreScannerIntervalBlockIndex<IndexT>::load_mapped_block(uint32_t *lenp) {
+  BlockCompressionHeader header;
+  const uint8_t *ptr = m_mapped_data + m_block.offset;
+  size_t remaining = m_block.zlength;
+
+  header.decode(&ptr, &remaining);
+
+  if (!header.check_magic(CellStore::DATA_BLOCK_MAGIC))
+    HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC,
+             "Error reading mapped cell store block - magic string mismatch");
+
+  if (header.get_compression_type() != BlockCompressionCodec::NONE ||
+      header.get_data_zlength() > remaining ||
+      header.get_data_length() != header.get_data_zlength())
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Bad mapped block header "
+              "in cell store %s at offset %lld",
+              m_cellstore->get_filename().c_str(), (Lld)m_block.offset);
+
+  if (!m_index->block_verified(m_iter)) {
+    uint32_t checksum = header.compute_data_checksum(ptr,
+                                                     header.get_data_zlength());
+    if (checksum != header.get_data_checksum())
+      HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Mapped block "
+                "checksum mismatch in cell store %s at offset %lld, "
+                "header=%lx, computed=%lx",
+                m_cellstore->get_filename().c_str(), (Lld)m_block.offset,
+                (Lu)header.get_data_checksum(), (Lu)checksum);
+    m_index->set_block_verified(m_iter);
+  }
+
+  m_block.base = ptr;
+  *lenp = header.get_data_length();
+  m_cached = false;
+}
+
 
 template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<uint32_t> >;
 template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<int64_t> >;
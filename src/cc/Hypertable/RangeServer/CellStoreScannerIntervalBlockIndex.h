@@ -48,6 +48,7 @@ namespace Hypertable {
   private:
 
     bool fetch_next_block(bool eob=false);
+    void load_mapped_block(uint32_t *lenp);
 
     CellStorePtr          m_cellstore;
     IndexT               *m_index;
@@ -63,6 +64,7 @@ namespace Hypertable {
     BlockCompressionCodec *m_zcodec;
     KeyDecompressor      *m_key_decompressor;
     int32_t               m_fd;
+    const uint8_t        *m_mapped_data;
     bool                  m_cached;
     bool                  m_check_for_range_end;
     int                   m_file_id;
@@ -110,6 +110,7 @@ namespace Hypertable {
       else if (prop == "alignment")             return alignment;
       else if (prop == "compression_ratio")     return compression_ratio;
       else if (prop == "compression_type")      return compression_type;
+      else if (prop == "key_compression_scheme") return key_compression_scheme;
       else if (prop == "bloom_filter_mode")     return bloom_filter_mode;
       else if (prop == "bloom_filter_hash_count") return bloom_filter_hash_count;
       else                                      return boost::any();
@@ -22,9 +22,18 @@
 #include "Common/Compat.h"
 #include <cassert>
 
+#include <cerrno>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/scoped_array.hpp>
 
+extern "C" {
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
 #include "Common/Config.h"
 #include "Common/Error.h"
 #include "Common/Logger.h"
@@ -47,7 +56,9 @@
 #include "FileBlockCache.h"
 #include "Global.h"
 #include "Config.h"
+#include "KeyCompressorDelta.h"
 #include "KeyCompressorPrefix.h"
+#include "KeyDecompressorDelta.h"
 #include "KeyDecompressorPrefix.h"
 
 using namespace std;
@@ -62,10 +73,12 @@ CellStoreV6::CellStoreV6(Filesystem *filesys, Schema *schema)
   : m_filesys(filesys), m_schema(schema), m_fd(-1), m_filename(),
     m_64bit_index(false), m_compressor(0), m_buffer(0),
     m_outstanding_appends(0), m_offset(0), m_file_length(0),
-    m_disk_usage(0), m_file_id(0), m_uncompressed_blocksize(0),
+    m_disk_usage(0), m_disk_usage_estimated(false), m_index_deferred(false),
+    m_file_id(0), m_uncompressed_blocksize(0),
     m_bloom_filter_mode(BLOOM_FILTER_DISABLED), m_bloom_filter(0),
     m_bloom_filter_items(0), m_filter_false_positive_prob(0.0),
-    m_restricted_range(false), m_column_ttl(0), m_replaced_files_loaded(false) {
+    m_restricted_range(false), m_column_ttl(0), m_replaced_files_loaded(false),
+    m_mapped_data(0) {
   m_file_id = FileBlockCache::get_next_file_id();
   assert(sizeof(float) == 4);
 }
@@ -78,6 +91,8 @@ CellStoreV6::~CellStoreV6() {
     delete m_bloom_filter_items;
     if (m_fd != -1)
       m_filesys->close(m_fd);
+    if (m_mapped_data)
+      munmap(m_mapped_data, m_file_length);
     delete [] m_column_ttl;
   }
   catch (Exception &e) {
@@ -95,6 +110,8 @@ BlockCompressionCodec *CellStoreV6::create_block_compression_codec() {
 }
 
 KeyDecompressor *CellStoreV6::create_key_decompressor() {
+  if (m_trailer.key_compression_scheme == KeyCompressionType::DELTA)
+    return new KeyDecompressorDelta();
   return new KeyDecompressorPrefix();
 }
 
@@ -108,6 +125,15 @@ void CellStoreV6::split_row_estimate_data(SplitRowDataMapT &split_row_data) {
     m_index_map32.unique_row_count_estimate(split_row_data, keys_per_block);
 }
 
+void CellStoreV6::split_row_access_data(SplitRowDataMapT &split_row_data) {
+  if (m_index_stats.block_index_memory == 0)
+    return;
+  if (m_64bit_index)
+    m_index_map64.row_access_estimate(split_row_data);
+  else
+    m_index_map32.row_access_estimate(split_row_data);
+}
+
 CellListScanner *CellStoreV6::create_scanner(ScanContextPtr &scan_ctx) {
   bool need_index =  m_restricted_range || scan_ctx->restricted_range || scan_ctx->single_row;
 
@@ -146,8 +172,6 @@ CellStoreV6::create(const char *fname, size_t max_entries,
   int64_t blocksize = props->get("blocksize", uint32_t(0));
   String compressor = props->get("compressor", String());
 
-  m_key_compressor = new KeyCompressorPrefix();
-
   assert(Config::properties); // requires Config::init* first
   int32_t replication = get_replication(props, table_id);
 
@@ -180,6 +204,16 @@ CellStoreV6::create(const char *fname, size_t max_entries,
   m_trailer.blocksize = blocksize;
   m_uncompressed_blocksize = blocksize;
 
+  if (!strcasecmp(Config::get_str("Hypertable.RangeServer.CellStore"
+                                  ".KeyCompression").c_str(), "delta")) {
+    m_key_compressor = new KeyCompressorDelta();
+    m_trailer.key_compression_scheme = KeyCompressionType::DELTA;
+  }
+  else {
+    m_key_compressor = new KeyCompressorPrefix();
+    m_trailer.key_compression_scheme = KeyCompressionType::PREFIX;
+  }
+
   // set up the "column_ttl" vector
   HT_ASSERT(m_schema);
   Schema::ColumnFamilies &column_families = m_schema->get_column_families();
@@ -563,8 +597,6 @@ void CellStoreV6::finalize(TableIdentifier *table_identifier) {
   else
     m_trailer.compression_ratio = m_compressed_data / m_uncompressed_data;
 
-  m_trailer.key_compression_scheme = KeyCompressionType::PREFIX;
-
   /**
    * Chop the Index buffers down to the exact length
    */
@@ -849,14 +881,62 @@ CellStoreV6::open(const String &fname, const String &start_row,
               "length=%llu, file='%s'", (unsigned)m_fd, (Lld)m_trailer.fix_index_offset,
            (Lld)m_trailer.var_index_offset, (Llu)m_file_length, fname.c_str());
 
-  // This is necessary to get m_disk_usage and m_block_count set properly
-  load_block_index();
+  // Loading the block index is necessary to get m_disk_usage and
+  // m_block_count set properly.  When deferred, the whole file is charged
+  // to this store, which is exact unless the range is restricted to part
+  // of the file.
+  if (Global::defer_cellstore_index_load) {
+    m_disk_usage = m_file_length;
+    m_block_count = m_trailer.index_entries;
+    m_disk_usage_estimated = m_restricted_range;
+    m_index_deferred = true;
+  }
+  else
+    load_block_index();
+
+  if (!Global::cellstore_mmap_root.empty() &&
+      m_trailer.compression_type == BlockCompressionCodec::NONE)
+    map_file();
 
   Global::memory_tracker->add( sizeof(CellStoreV6) + sizeof(CellStoreInfo) );
 
 }
 
 
+/**
+ * Maps the CellStore file through the local filesystem.  If the file is not
+ * visible locally (e.g. the broker runs on another host) or its size does not
+ * match, the store is left unmapped and is read through the broker.
+ */
+void CellStoreV6::map_file() {
+  String path = Global::cellstore_mmap_root;
+  if (m_filename[0] != '/')
+    path += "/";
+  path += m_filename;
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    HT_DEBUGF("Unable to open '%s' for mapping - %s", path.c_str(),
+              strerror(errno));
+    return;
+  }
+
+  struct stat statbuf;
+  if (fstat(fd, &statbuf) == 0 && statbuf.st_size == m_file_length) {
+    void *base = mmap(0, m_file_length, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+      HT_WARNF("mmap('%s', %lld) failed - %s", path.c_str(),
+               (Lld)m_file_length, strerror(errno));
+    else
+      m_mapped_data = (uint8_t *)base;
+  }
+  else
+    HT_DEBUGF("Not mapping '%s', size mismatch", path.c_str());
+
+  ::close(fd);
+}
+
+
 
 void
 CellStoreV6::rescope(const String &start_row, const String &end_row) {
@@ -891,6 +971,19 @@ CellStoreV6::rescope(const String &start_row, const String &end_row) {
 
 
 void CellStoreV6::load_block_index() {
+  HT_ASSERT(m_index_stats.block_index_memory == 0);
+  read_block_index(m_index_builder.fixed_buf(), m_index_builder.variable_buf());
+  install_block_index(m_index_builder.fixed_buf(),
+                      m_index_builder.variable_buf());
+}
+
+
+/**
+ * Reads and inflates the block index.  Only reads the file and the trailer,
+ * so it may run concurrently with scans of this cell store.
+ */
+void CellStoreV6::read_block_index(DynamicBuffer &fixed,
+                                   DynamicBuffer &variable) {
   int64_t amount, index_amount;
   int64_t len = 0;
   BlockCompressionCodecPtr compressor;
@@ -899,8 +992,6 @@ void CellStoreV6::load_block_index() {
   bool inflating_fixed=true;
   bool second_try = false;
 
-  HT_ASSERT(m_index_stats.block_index_memory == 0);
-
   compressor = create_block_compression_codec();
 
   amount = index_amount = m_trailer.filter_offset - m_trailer.fix_index_offset;
@@ -919,9 +1010,7 @@ void CellStoreV6::load_block_index() {
                 m_filename.c_str(), (Lld)amount, (Lld)len);
     /** inflate fixed index **/
     buf.ptr += (m_trailer.var_index_offset - m_trailer.fix_index_offset);
-    compressor->inflate(buf, m_index_builder.fixed_buf(), header);
-
-    m_bytes_read += m_index_builder.fixed_buf().fill();
+    compressor->inflate(buf, fixed, header);
 
     inflating_fixed = false;
 
@@ -934,9 +1023,7 @@ void CellStoreV6::load_block_index() {
     vbuf.base = buf.ptr;
     vbuf.ptr = buf.ptr + amount;
 
-    compressor->inflate(vbuf, m_index_builder.variable_buf(), header);
-
-    m_bytes_read += m_index_builder.variable_buf().fill();
+    compressor->inflate(vbuf, variable, header);
 
     if (!header.check_magic(INDEX_VARIABLE_BLOCK_MAGIC))
       HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, m_filename);
@@ -960,11 +1047,17 @@ void CellStoreV6::load_block_index() {
     second_try = true;
     goto try_again;
   }
+}
+
+
+void CellStoreV6::install_block_index(DynamicBuffer &fixed,
+                                      DynamicBuffer &variable) {
+
+  m_bytes_read += fixed.fill() + variable.fill();
 
   /** Set up index **/
   if (m_64bit_index) {
-    m_index_map64.load(m_index_builder.fixed_buf(),
-                       m_index_builder.variable_buf(),
+    m_index_map64.load(fixed, variable,
                        m_trailer.fix_index_offset, m_start_row, m_end_row);
     m_index_stats.block_index_memory = m_index_map64.memory_used();
     m_disk_usage = m_index_map64.disk_used() + 
@@ -973,8 +1066,7 @@ void CellStoreV6::load_block_index() {
     m_block_count = m_index_map64.index_entries();
   }
   else {
-    m_index_map32.load(m_index_builder.fixed_buf(),
-                       m_index_builder.variable_buf(),
+    m_index_map32.load(fixed, variable,
                        m_trailer.fix_index_offset, m_start_row, m_end_row);
     m_index_stats.block_index_memory = m_index_map32.memory_used();
     m_disk_usage = m_index_map32.disk_used() + 
@@ -983,12 +1075,33 @@ void CellStoreV6::load_block_index() {
     m_block_count = m_index_map32.index_entries();
   }
 
-  m_index_builder.release_fixed_buf();
+  fixed.free();
+
+  m_disk_usage_estimated = false;
+  m_index_deferred = false;
 
   Global::memory_tracker->add( m_index_stats.block_index_memory );
 }
 
 
+void CellStoreV6::read_deferred_index(DynamicBuffer &fixed,
+                                      DynamicBuffer &variable) {
+  read_block_index(fixed, variable);
+}
+
+
+void CellStoreV6::install_deferred_index(DynamicBuffer &fixed,
+                                         DynamicBuffer &variable) {
+  // Loaded on demand by a scan in the meantime
+  if (!m_index_deferred || m_index_stats.block_index_memory != 0) {
+    fixed.free();
+    variable.free();
+    return;
+  }
+  install_block_index(fixed, variable);
+}
+
+
 bool CellStoreV6::may_contain(ScanContextPtr &scan_context) {
 
   if (m_bloom_filter_mode == BLOOM_FILTER_DISABLED)
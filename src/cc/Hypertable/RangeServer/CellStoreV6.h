@@ -96,8 +96,20 @@ namespace Hypertable {
     }
     virtual bool may_contain(ScanContextPtr &);
     virtual uint64_t disk_usage() { return m_disk_usage; }
+    virtual bool disk_usage_estimated() { return m_disk_usage_estimated; }
+    virtual double fraction_covered() {
+      if (m_file_length <= 0 || m_disk_usage >= m_file_length)
+        return 1.0;
+      return (double)m_disk_usage / (double)m_file_length;
+    }
+    virtual bool index_deferred() { return m_index_deferred; }
+    virtual void read_deferred_index(DynamicBuffer &fixed,
+                                     DynamicBuffer &variable);
+    virtual void install_deferred_index(DynamicBuffer &fixed,
+                                        DynamicBuffer &variable);
     virtual float compression_ratio() { return m_trailer.compression_ratio; }
     virtual void split_row_estimate_data(SplitRowDataMapT &split_row_data);
+    virtual void split_row_access_data(SplitRowDataMapT &split_row_data);
     virtual int64_t get_total_entries() { return m_trailer.total_entries; }
     virtual std::string &get_filename() { return m_filename; }
     virtual int get_file_id() { return m_file_id; }
@@ -126,12 +138,17 @@ namespace Hypertable {
       return m_fd;
     }
 
+    virtual const uint8_t *mapped_data() { return m_mapped_data; }
+
     virtual CellStoreTrailer *get_trailer() { return &m_trailer; }
 
   protected:
     void create_bloom_filter(bool is_approx = false);
     void load_bloom_filter();
+    void map_file();
     void load_block_index();
+    void read_block_index(DynamicBuffer &fixed, DynamicBuffer &variable);
+    void install_block_index(DynamicBuffer &fixed, DynamicBuffer &variable);
     void load_replaced_files();
 
     typedef BlobHashSet<> BloomFilterItems;
@@ -153,6 +170,8 @@ namespace Hypertable {
     int64_t                m_offset;
     int64_t                m_file_length;
     int64_t                m_disk_usage;
+    bool                   m_disk_usage_estimated;
+    bool                   m_index_deferred;
     int                    m_file_id;
     float                  m_uncompressed_data;
     float                  m_compressed_data;
@@ -170,6 +189,7 @@ namespace Hypertable {
     bool                   m_restricted_range;
     int64_t               *m_column_ttl;
     bool                   m_replaced_files_loaded;
+    uint8_t               *m_mapped_data;
   };
 
   typedef intrusive_ptr<CellStoreV6> CellStoreV6Ptr;
@@ -0,0 +1,185 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <boost/bind.hpp>
+
+#include <poll.h>
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/MurmurHash.h"
+
+#include "CommitLogStreams.h"
+
+using namespace Hypertable;
+
+CommitLogStreams::CommitLogStreams(const std::vector<CommitLog *> &logs)
+  : m_streams(logs.size()), m_outstanding(0), m_written(false),
+    m_shutdown(false) {
+  HT_ASSERT(!logs.empty());
+  for (size_t i=0; i<logs.size(); i++)
+    m_streams[i].log = logs[i];
+  if (m_streams.size() > 1) {
+    for (size_t i=0; i<m_streams.size(); i++)
+      m_threads.push_back(new Thread(boost::bind(&CommitLogStreams::run,
+                                                 this, i)));
+  }
+}
+
+CommitLogStreams::~CommitLogStreams() {
+  {
+    ScopedLock lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+  }
+  foreach_ht (Thread *thread, m_threads) {
+    thread->join();
+    delete thread;
+  }
+}
+
+size_t CommitLogStreams::stream(const char *table_id) const {
+  if (m_streams.size() == 1)
+    return 0;
+  return murmurhash2(table_id, strlen(table_id), 0) % m_streams.size();
+}
+
+CommitLogStreams::Write *
+CommitLogStreams::add_write(size_t stream, DynamicBuffer *buffer,
+                            int64_t revision) {
+  if (m_written) {
+    for (size_t i=0; i<m_streams.size(); i++)
+      m_streams[i].writes.clear();
+    m_written = false;
+  }
+  Stream &s = m_streams[stream];
+  s.writes.push_back(Write(buffer, revision));
+  return &s.writes.back();
+}
+
+bool CommitLogStreams::sync_requested() const {
+  for (size_t i=0; i<m_streams.size(); i++) {
+    if (m_streams[i].sync)
+      return true;
+  }
+  return false;
+}
+
+void CommitLogStreams::write() {
+  std::vector<size_t> active;
+  if (m_written)
+    return;
+  for (size_t i=0; i<m_streams.size(); i++) {
+    if (!m_streams[i].writes.empty())
+      active.push_back(i);
+  }
+  dispatch(active, WRITE);
+  m_written = true;
+}
+
+int CommitLogStreams::sync() {
+  std::vector<size_t> active;
+  for (size_t i=0; i<m_streams.size(); i++) {
+    if (m_streams[i].sync)
+      active.push_back(i);
+    m_streams[i].sync = false;
+  }
+  dispatch(active, SYNC);
+  foreach_ht (size_t i, active) {
+    if (m_streams[i].sync_error != Error::OK)
+      return m_streams[i].sync_error;
+  }
+  return Error::OK;
+}
+
+void CommitLogStreams::dispatch(const std::vector<size_t> &active, int ops) {
+
+  if (active.empty())
+    return;
+
+  // Avoid the thread handoff when only one stream has work
+  if (active.size() == 1) {
+    process(m_streams[active[0]], ops);
+    return;
+  }
+
+  ScopedLock lock(m_mutex);
+  foreach_ht (size_t i, active)
+    m_streams[i].ops = ops;
+  m_outstanding = active.size();
+  m_cond.notify_all();
+  while (m_outstanding > 0)
+    m_cond.wait(lock);
+}
+
+void CommitLogStreams::run(size_t stream) {
+  Stream &s = m_streams[stream];
+  int ops;
+
+  while (true) {
+    {
+      ScopedLock lock(m_mutex);
+      while (s.ops == 0 && !m_shutdown)
+        m_cond.wait(lock);
+      if (m_shutdown)
+        return;
+      ops = s.ops;
+    }
+
+    process(s, ops);
+
+    {
+      ScopedLock lock(m_mutex);
+      s.ops = 0;
+      HT_ASSERT(m_outstanding > 0);
+      if (--m_outstanding == 0)
+        m_cond.notify_all();
+    }
+  }
+}
+
+void CommitLogStreams::process(Stream &s, int ops) {
+
+  if (ops & WRITE) {
+    foreach_ht (Write &w, s.writes) {
+      if ((w.error = s.log->write(*w.buffer, w.revision, false)) != Error::OK)
+        HT_ERRORF("Problem writing %d bytes to commit log (%s) - %s",
+                  (int)w.buffer->fill(), s.log->get_log_dir().c_str(),
+                  Error::get_text(w.error));
+    }
+  }
+
+  if (ops & SYNC) {
+    int error;
+    size_t retry_count = 0;
+    while ((error = s.log->sync()) != Error::OK) {
+      HT_ERRORF("Problem sync'ing user log fragment (%s) - %s",
+                s.log->get_current_fragment_file().c_str(),
+                Error::get_text(error));
+      if (++retry_count == 6)
+        break;
+      poll(0, 0, 10000);
+    }
+    s.sync_error = error;
+  }
+}
@@ -0,0 +1,142 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_COMMITLOGSTREAMS_H
+#define HYPERTABLE_COMMITLOGSTREAMS_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/condition.hpp>
+
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Mutex.h"
+#include "Common/ReferenceCount.h"
+#include "Common/Thread.h"
+
+#include "Hypertable/Lib/CommitLog.h"
+
+namespace Hypertable {
+
+  /** Writes USER updates to a set of commit log streams in parallel.
+   * Tables are assigned to streams by hashing the table id.  Each stream
+   * has its own writer thread which performs the writes and syncs queued
+   * for it, so the writes and syncs of different streams overlap.  write()
+   * and sync() return only when every stream they dispatched to is done,
+   * and all streams are synced on the same group commit schedule.  This
+   * does not remove head-of-line blocking: a slow sync on one stream
+   * delays the batch that touched it and every batch behind it.  With a
+   * single stream the work is done on the calling thread.
+   */
+  class CommitLogStreams : public ReferenceCount {
+  public:
+
+    class Write {
+    public:
+      Write(DynamicBuffer *buf, int64_t rev)
+        : buffer(buf), revision(rev), error(Error::OK) { }
+      DynamicBuffer *buffer;
+      int64_t revision;
+      int error;
+    };
+
+    /** Starts a writer thread for each stream.  The commit logs are not
+     * owned by this object.
+     *
+     * @param logs commit log of each stream
+     */
+    CommitLogStreams(const std::vector<CommitLog *> &logs);
+
+    /** Stops the writer threads */
+    virtual ~CommitLogStreams();
+
+    /** Returns the stream that updates of a table are written to
+     *
+     * @param table_id table identifier string
+     * @return stream index
+     */
+    size_t stream(const char *table_id) const;
+
+    /** Queues a write of <code>buffer</code> to a stream.  The returned
+     * object holds the result once write() returns and remains valid until
+     * add_write() is called after that.
+     *
+     * @param stream stream index
+     * @param buffer block of updates
+     * @param revision most recent revision in buffer
+     * @return pointer to the queued write
+     */
+    Write *add_write(size_t stream, DynamicBuffer *buffer, int64_t revision);
+
+    /** Marks a stream as needing a sync on the next call to sync() */
+    void request_sync(size_t stream) { m_streams[stream].sync = true; }
+
+    /** Returns true if any stream needs a sync */
+    bool sync_requested() const;
+
+    /** Performs the writes queued since the last call, one thread per
+     * stream, and returns when all of them have completed.  Errors are
+     * reported in the Write objects.
+     */
+    void write();
+
+    /** Syncs the streams that have had a sync requested since the last
+     * call, one thread per stream, and returns when all of them have
+     * completed.  Failed syncs are retried and logged.
+     *
+     * @return Error::OK on success or the error of a failed sync
+     */
+    int sync();
+
+  private:
+
+    enum { WRITE = 1, SYNC = 2 };
+
+    class Stream {
+    public:
+      Stream() : log(0), sync(false), sync_error(Error::OK), ops(0) { }
+      CommitLog *log;
+      std::deque<Write> writes;
+      bool sync;
+      int sync_error;
+      // Work handed to the writer thread, protected by m_mutex
+      int ops;
+    };
+
+    void dispatch(const std::vector<size_t> &active, int ops);
+    void run(size_t stream);
+    void process(Stream &stream, int ops);
+
+    Mutex m_mutex;
+    boost::condition m_cond;
+    std::vector<Stream> m_streams;
+    std::vector<Thread *> m_threads;
+    size_t m_outstanding;
+    bool m_written;
+    bool m_shutdown;
+  };
+
+  typedef intrusive_ptr<CommitLogStreams> CommitLogStreamsPtr;
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMMITLOGSTREAMS_H
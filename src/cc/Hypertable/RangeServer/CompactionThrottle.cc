@@ -0,0 +1,72 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+extern "C" {
+#include <poll.h>
+}
+
+#include "CompactionThrottle.h"
+
+using namespace Hypertable;
+
+CompactionThrottle::CompactionThrottle(int64_t bytes_per_second)
+  : m_rate(bytes_per_second), m_available(bytes_per_second),
+    m_wait_millis(0) {
+}
+
+/**
+ * The bucket is allowed to go negative so a large request is admitted at
+ * once; the caller then sleeps for as long as it takes the bucket to climb
+ * back to zero.  Later callers see the debt and wait their turn behind it.
+ */
+void CompactionThrottle::consume(int64_t bytes) {
+  if (m_rate <= 0)
+    return;
+
+  int64_t wait_millis = reserve(bytes, HiResTime());
+
+  if (wait_millis > 0)
+    poll(0, 0, (int)wait_millis);
+}
+
+int64_t CompactionThrottle::reserve(int64_t bytes, HiResTime now) {
+  int64_t wait_millis = 0;
+
+  if (m_rate <= 0)
+    return 0;
+
+  ScopedLock lock(m_mutex);
+  int64_t elapsed = xtime_diff_millis(m_last_refill, now);
+  if (elapsed > 0) {
+    m_available += (m_rate * elapsed) / 1000;
+    if (m_available > m_rate)
+      m_available = m_rate;
+    m_last_refill = now;
+  }
+  m_available -= bytes;
+  if (m_available < 0) {
+    wait_millis = ((-m_available) * 1000) / m_rate;
+    m_wait_millis += wait_millis;
+  }
+  return wait_millis;
+}
@@ -0,0 +1,74 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONTHROTTLE_H
+#define HYPERTABLE_COMPACTIONTHROTTLE_H
+
+#include "Common/Mutex.h"
+#include "Common/Time.h"
+
+namespace Hypertable {
+
+  /**
+   * Token bucket that limits the rate at which compactions read and
+   * rewrite CellStore data.  All compaction threads share one bucket, so
+   * the limit applies to the RangeServer as a whole.  Up to one second's
+   * worth of bytes may be consumed in a burst.
+   */
+  class CompactionThrottle {
+  public:
+    /**
+     * @param bytes_per_second sustained rate, zero disables throttling
+     */
+    CompactionThrottle(int64_t bytes_per_second);
+
+    /** Charges <code>bytes</code> against the budget, sleeping until the
+     * bucket has refilled enough to cover them.
+     */
+    void consume(int64_t bytes);
+
+    /** Charges <code>bytes</code> against the budget as of time
+     * <code>now</code> without sleeping.
+     *
+     * @param bytes number of bytes to charge
+     * @param now current time, not earlier than that of the previous call
+     * @return milliseconds the caller should wait
+     */
+    int64_t reserve(int64_t bytes, HiResTime now);
+
+    int64_t rate() const { return m_rate; }
+
+    /** Returns the total number of milliseconds callers have been made to
+     * wait.
+     */
+    int64_t wait_millis() { ScopedLock lock(m_mutex); return m_wait_millis; }
+
+  private:
+    Mutex     m_mutex;
+    int64_t   m_rate;
+    int64_t   m_available;
+    int64_t   m_wait_millis;
+    HiResTime m_last_refill;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONTHROTTLE_H
@@ -51,6 +51,7 @@ extern "C" {
 #include "RequestHandlerStatus.h"
 #include "RequestHandlerDropRange.h"
 #include "RequestHandlerRelinquishRange.h"
+#include "RequestHandlerImportCellStores.h"
 #include "RequestHandlerShutdown.h"
 #include "RequestHandlerCommitLogSync.h"
 #include "RequestHandlerWaitForMaintenance.h"
@@ -122,6 +123,7 @@ void ConnectionHandler::handle(EventPtr &event) {
                                            event);
         break;
       case RangeServerProtocol::COMMAND_CREATE_SCANNER:
+      case RangeServerProtocol::COMMAND_CREATE_AGGREGATE_SCANNER:
         handler = new RequestHandlerCreateScanner(m_comm,
             m_range_server_ptr.get(), event);
         break;
@@ -207,6 +209,11 @@ void ConnectionHandler::handle(EventPtr &event) {
                                                         event);
         break;
 
+      case RangeServerProtocol::COMMAND_IMPORT_CELLSTORES:
+        handler = new RequestHandlerImportCellStores(m_comm, m_range_server_ptr.get(),
+                                                     event);
+        break;
+
       default:
         HT_THROWF(PROTOCOL_ERROR, "Unimplemented command (%llu)",
                   (Llu)event->header.command);
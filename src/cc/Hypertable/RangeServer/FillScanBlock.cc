@@ -20,10 +20,139 @@
  */
 
 #include "Common/Compat.h"
+#include "Common/String.h"
+
+#include <algorithm>
+#include <cstdlib>
+
 #include "FillScanBlock.h"
 
 namespace Hypertable {
 
+  namespace {
+
+    /** Partial aggregates are small, so an aggregate block consumes this
+     * many times the scan buffer size before replying. */
+    const int64_t AGGREGATE_SCAN_FACTOR = 8;
+
+    /** Returns false if the value is not a decimal integer; such cells
+     * are left out of SUM, MIN and MAX rather than counted as zero. */
+    bool aggregate_operand(ScanContext *scan_context, const Key &key,
+                           const ByteString &value, int64_t *operand) {
+      const uint8_t *ptr;
+      size_t len = value.decode_length(&ptr);
+      if (scan_context->family_info[key.column_family_code].counter &&
+          key.flag == FLAG_INSERT && len == 8) {
+        *operand = (int64_t)Serialization::decode_i64(&ptr, &len);
+        return true;
+      }
+      return CellFilterInfo::parse_integer((const char *)ptr, len, operand);
+    }
+
+    /**
+     * Consumes cells from the scanner and writes partial aggregates instead
+     * of the cells themselves.  A block always ends on a row boundary so
+     * that COUNT_ROWS never counts a row twice, and the partial cells carry
+     * the last row consumed so the client can resume after it.
+     */
+    bool FillAggregateBlock(CellListScannerPtr &scanner, DynamicBuffer &dbuf,
+                            int64_t buffer_size) {
+      ScanContext *scan_context = scanner->scan_context();
+      int32_t function = scan_context->spec->aggregate;
+      int64_t budget = buffer_size * AGGREGATE_SCAN_FACTOR;
+      int64_t scanned = 0;
+      int64_t rows = 0;
+      int64_t values[256];
+      int64_t counts[256];
+      Key key, last_key;
+      ByteString value;
+      DynamicBuffer last_key_buf;
+      String row;
+      bool more = true;
+      uint8_t *ptr;
+
+      memset(counts, 0, sizeof(counts));
+      memset(&last_key, 0, sizeof(last_key));
+
+      while ((more = scanner->get(key, value))) {
+        if (scanned >= budget && strcmp(key.row, row.c_str()))
+          break;
+
+        // drop duplicates
+        if (last_key.row && key.timestamp == last_key.timestamp &&
+            key.column_family_code == last_key.column_family_code &&
+            !strcmp(key.row, last_key.row) &&
+            !strcmp(key.column_qualifier, last_key.column_qualifier)) {
+          scanner->forward();
+          continue;
+        }
+        last_key_buf.clear();
+        last_key_buf.add(key.serial.ptr, key.length);
+        last_key.load(SerializedKey(last_key_buf.base));
+
+        if (rows == 0 || strcmp(key.row, row.c_str())) {
+          row = key.row;
+          rows++;
+        }
+
+        if (function != ScanSpec::AGGREGATE_COUNT_ROWS) {
+          uint8_t cf = key.column_family_code;
+          int64_t operand = 1;
+          if (function != ScanSpec::AGGREGATE_COUNT &&
+              !aggregate_operand(scan_context, key, value, &operand)) {
+            scanned += key.length + value.length();
+            scanner->forward();
+            continue;
+          }
+          if (counts[cf] == 0)
+            values[cf] = operand;
+          else if (function == ScanSpec::AGGREGATE_MIN)
+            values[cf] = std::min(values[cf], operand);
+          else if (function == ScanSpec::AGGREGATE_MAX)
+            values[cf] = std::max(values[cf], operand);
+          else
+            values[cf] += operand;
+          counts[cf]++;
+        }
+
+        scanned += key.length + value.length();
+        scanner->forward();
+      }
+
+      dbuf.reserve(4 + 1024);
+      // skip encoded length
+      dbuf.ptr = dbuf.base + 4;
+
+      if (rows) {
+        char numbuf[24];
+        for (size_t cf=0; cf<256; cf++) {
+          int64_t result;
+          uint8_t family = cf;
+          if (function == ScanSpec::AGGREGATE_COUNT_ROWS) {
+            result = rows;
+            family = last_key.column_family_code;
+          }
+          else if (counts[cf])
+            result = values[cf];
+          else
+            continue;
+          create_key_and_append(dbuf, FLAG_INSERT, row.c_str(), family, "",
+                                last_key.timestamp, last_key.revision);
+          sprintf(numbuf, "%lld", (Lld)result);
+          append_as_byte_string(dbuf, numbuf, strlen(numbuf));
+          if (function == ScanSpec::AGGREGATE_COUNT_ROWS)
+            break;
+        }
+      }
+
+      ptr = dbuf.base;
+      Serialization::encode_i32(&ptr, dbuf.fill() - 4);
+
+      return more;
+    }
+
+  }
+
   bool
   FillScanBlock(CellListScannerPtr &scanner, DynamicBuffer &dbuf, int64_t buffer_size) {
     Key key, last_key;
@@ -43,6 +172,9 @@ namespace Hypertable {
 
     assert(dbuf.base == 0);
 
+    if (scan_context->spec->aggregate != ScanSpec::AGGREGATE_NONE)
+      return FillAggregateBlock(scanner, dbuf, buffer_size);
+
     memset(&last_key, 0, sizeof(last_key));
 
     while ((more = scanner->get(key, value))) {
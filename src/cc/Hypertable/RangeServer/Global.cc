@@ -42,6 +42,7 @@ namespace Hypertable {
   bool                   Global::verbose = false;
   bool                   Global::row_size_unlimited = false;
   CommitLog             *Global::user_log = 0;
+  std::vector<CommitLog *> Global::user_logs;
   CommitLog             *Global::system_log = 0;
   CommitLog             *Global::metadata_log = 0;
   CommitLog             *Global::root_log = 0;
@@ -50,11 +51,17 @@ namespace Hypertable {
   LocationInitializerPtr Global::location_initializer;
   int64_t                Global::range_split_size = 0;
   int64_t                Global::range_maximum_size = 0;
+  int32_t                Global::range_split_load_rate = 0;
+  int64_t                Global::range_split_load_minimum_size = 0;
   int32_t                Global::access_group_garbage_compaction_threshold = 0;
   int32_t                Global::access_group_max_mem = 0;
   int32_t                Global::cell_cache_scanner_cache_size = 0;
   ScannerMap             Global::scanner_map;
   FileBlockCache        *Global::block_cache = 0;
+  SsdBlockCache         *Global::ssd_block_cache = 0;
+  RowCache              *Global::row_cache = 0;
+  CompactionThrottle    *Global::compaction_throttle = 0;
+  ValueLogReader        *Global::value_log_reader = 0;
   TablePtr               Global::metadata_table = 0;
   TablePtr               Global::rs_metrics_table = 0;
   int64_t                Global::range_metadata_split_size = 0;
@@ -69,8 +76,11 @@ namespace Hypertable {
   uint64_t               Global::access_counter = 0;
   bool                   Global::enable_shadow_cache = true;
   std::string            Global::toplevel_dir;
+  std::string            Global::cellstore_mmap_root;
+  bool                   Global::defer_cellstore_index_load = false;
   int32_t                Global::metrics_interval = 0;
   int32_t                Global::merge_cellstore_run_length_threshold = 0;
+  int64_t                Global::merge_cellstore_time_window = 0;
   bool                   Global::ignore_clock_skew_errors = false;
   ConnectionManagerPtr   Global::conn_manager;
   std::vector<MetaLog::EntityTaskPtr>  Global::work_queue;
@@ -23,6 +23,7 @@
 #define HYPERTABLE_RANGESERVER_GLOBAL_H
 
 #include <string>
+#include <vector>
 
 #include <boost/thread/thread.hpp>
 
@@ -41,13 +42,17 @@
 #include "Hypertable/Lib/Client.h"
 #include "Hypertable/Lib/Types.h"
 
+#include "CompactionThrottle.h"
 #include "FileBlockCache.h"
 #include "LocationInitializer.h"
 #include "MaintenanceQueue.h"
 #include "MemoryTracker.h"
 #include "MetaLogEntityTask.h"
+#include "RowCache.h"
+#include "SsdBlockCache.h"
 #include "ScannerMap.h"
 #include "TableInfo.h"
+#include "ValueLog.h"
 
 namespace Hypertable {
 
@@ -66,6 +71,8 @@ namespace Hypertable {
     static bool           verbose;
     static bool           row_size_unlimited;
     static CommitLog     *user_log;
+    // All USER commit log streams, user_log is the first
+    static std::vector<CommitLog *> user_logs;
     static CommitLog     *system_log;
     static CommitLog     *metadata_log;
     static CommitLog     *root_log;
@@ -74,11 +81,17 @@ namespace Hypertable {
     static LocationInitializerPtr location_initializer;
     static int64_t        range_split_size;
     static int64_t        range_maximum_size;
+    static int32_t        range_split_load_rate;
+    static int64_t        range_split_load_minimum_size;
     static int32_t        access_group_garbage_compaction_threshold;
     static int32_t        access_group_max_mem;
     static int32_t        cell_cache_scanner_cache_size;
     static ScannerMap     scanner_map;
     static Hypertable::FileBlockCache *block_cache;
+    static Hypertable::SsdBlockCache *ssd_block_cache;
+    static Hypertable::RowCache *row_cache;
+    static Hypertable::CompactionThrottle *compaction_throttle;
+    static Hypertable::ValueLogReader *value_log_reader;
     static TablePtr       metadata_table;
     static TablePtr       rs_metrics_table;
     static int64_t        range_metadata_split_size;
@@ -97,8 +110,11 @@ namespace Hypertable {
     static uint64_t       access_counter;
     static bool           enable_shadow_cache;
     static std::string    toplevel_dir;
+    static std::string    cellstore_mmap_root;
+    static bool           defer_cellstore_index_load;
     static int32_t        metrics_interval;
     static int32_t        merge_cellstore_run_length_threshold;
+    static int64_t        merge_cellstore_time_window;
     static bool           ignore_clock_skew_errors;
     static ConnectionManagerPtr conn_manager;
     static std::vector<MetaLog::EntityTaskPtr> work_queue;
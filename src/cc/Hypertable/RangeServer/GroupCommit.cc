@@ -20,6 +20,7 @@
  */
 #include "Common/Compat.h"
 #include "Common/Config.h"
+#include "Common/Time.h"
 
 #include "GroupCommit.h"
 #include "RangeServer.h"
@@ -28,10 +29,23 @@
 using namespace Hypertable;
 using namespace Hypertable::Config;
 
-GroupCommit::GroupCommit(RangeServer *range_server) : m_range_server(range_server), m_counter(0) {
+namespace {
+  // Weight given to the newest sample in the sync cost / arrival averages
+  const double EWMA_WEIGHT = 0.2;
+}
 
-  m_commit_interval = get_i32("Hypertable.RangeServer.CommitInterval");
+GroupCommit::GroupCommit(RangeServer *range_server)
+  : m_range_server(range_server), m_counter(0), m_sync_cost(0.0),
+    m_arrival_rate(0.0), m_arrivals(0), m_pending_bytes(0),
+    m_pending_max_window(0) {
 
+  m_commit_interval = get_i32("Hypertable.RangeServer.CommitInterval");
+  m_adaptive = get_bool("Hypertable.RangeServer.GroupCommit.Adaptive");
+  m_target_latency =
+    (int64_t)get_i32("Hypertable.RangeServer.GroupCommit.TargetLatency") * 1000;
+  m_flush_threshold = get_i64("Hypertable.RangeServer.GroupCommit.FlushThreshold");
+  boost::xtime_get(&m_last_trigger, TIME_UTC_);
+  memset(&m_window_start, 0, sizeof(m_window_start));
 }
 
 
@@ -46,6 +60,17 @@ void GroupCommit::add(EventPtr &event, SchemaPtr &schema, const TableIdentifier
   request->count = count;
   request->event = event;
 
+  if (m_adaptive) {
+    if (m_table_map.empty()) {
+      boost::xtime_get(&m_window_start, TIME_UTC_);
+      m_pending_max_window = (int64_t)schema->get_group_commit_interval() * 1000;
+    }
+    else if ((int64_t)schema->get_group_commit_interval() * 1000 < m_pending_max_window)
+      m_pending_max_window = (int64_t)schema->get_group_commit_interval() * 1000;
+    m_arrivals++;
+    m_pending_bytes += buffer.size;
+  }
+
   if ((iter = m_table_map.find(*table)) == m_table_map.end()) {
     TableIdentifier tid;
 
@@ -62,20 +87,30 @@ void GroupCommit::add(EventPtr &event, SchemaPtr &schema, const TableIdentifier
     tu->requests.push_back(request);
 
     m_table_map[tid] = tu;
-    return;
+  }
+  else {
+    if (expire_time.sec > (*iter).second->expire_time.sec)
+      (*iter).second->expire_time = expire_time;
+    (*iter).second->total_count += count;
+    (*iter).second->total_buffer_size += buffer.size;
+    (*iter).second->requests.push_back(request);
   }
 
-  if (expire_time.sec > (*iter).second->expire_time.sec)
-    (*iter).second->expire_time = expire_time;
-  (*iter).second->total_count += count;
-  (*iter).second->total_buffer_size += buffer.size;
-  (*iter).second->requests.push_back(request);
+  // Don't let a burst wait out the window once the batch is large enough
+  if (m_adaptive && m_pending_bytes >= (uint64_t)m_flush_threshold)
+    flush_all();
 }
 
 
 
 void GroupCommit::trigger() {
   ScopedLock lock(m_mutex);
+
+  if (m_adaptive) {
+    trigger_adaptive();
+    return;
+  }
+
   std::vector<TableUpdate *> updates;
   boost::xtime expire_time;
 
@@ -102,3 +137,64 @@ void GroupCommit::trigger() {
     m_range_server->batch_update(updates, expire_time);
 
 }
+
+
+/**
+ * The batch window is the part of the target latency left over after the
+ * expected sync cost, bounded by the smallest group commit interval of the
+ * pending tables.  If requests arrive too slowly for another one to be
+ * expected within the window, waiting only adds latency, so the batch is
+ * flushed right away.
+ */
+void GroupCommit::trigger_adaptive() {
+  boost::xtime now;
+  boost::xtime_get(&now, TIME_UTC_);
+
+  int64_t elapsed = xtime_diff_micros(m_last_trigger, now);
+  if (elapsed > 0) {
+    double rate = (double)m_arrivals / elapsed;
+    m_arrival_rate = EWMA_WEIGHT*rate + (1.0-EWMA_WEIGHT)*m_arrival_rate;
+    m_arrivals = 0;
+    m_last_trigger = now;
+  }
+
+  if (m_table_map.empty())
+    return;
+
+  int64_t window = m_target_latency - (int64_t)m_sync_cost;
+  if (window > m_pending_max_window)
+    window = m_pending_max_window;
+  if (window < 0 || m_arrival_rate * window < 1.0)
+    window = 0;
+
+  if (xtime_diff_micros(m_window_start, now) >= window)
+    flush_all();
+}
+
+
+void GroupCommit::flush_all() {
+  std::vector<TableUpdate *> updates;
+  boost::xtime expire_time;
+
+  // Clear to Jan 1, 1970
+  memset(&expire_time, 0, sizeof(expire_time));
+
+  for (TableUpdateMap::iterator iter = m_table_map.begin();
+       iter != m_table_map.end(); ++iter) {
+    if (iter->second->expire_time.sec > expire_time.sec)
+      expire_time = iter->second->expire_time;
+    updates.push_back(iter->second);
+  }
+  m_table_map.clear();
+  m_pending_bytes = 0;
+
+  // All tables of the window go out in one batch and share a single sync
+  if (!updates.empty())
+    m_range_server->batch_update(updates, expire_time);
+}
+
+
+void GroupCommit::record_sync(int64_t usec) {
+  ScopedLock lock(m_mutex);
+  m_sync_cost = EWMA_WEIGHT*usec + (1.0-EWMA_WEIGHT)*m_sync_cost;
+}
@@ -47,6 +47,12 @@ namespace Hypertable {
   };
 
   /**
+   * Batches updates for tables with a group commit interval.  By default
+   * each table is flushed on its own fixed interval.  In adaptive mode
+   * (Hypertable.RangeServer.GroupCommit.Adaptive) all pending tables are
+   * flushed together once the window derived from the target latency,
+   * the observed sync cost and the arrival rate has elapsed, or as soon as
+   * the batch reaches the flush threshold.
    */
   class GroupCommit : public GroupCommitInterface {
 
@@ -55,14 +61,30 @@ namespace Hypertable {
     virtual void add(EventPtr &event, SchemaPtr &schema, const TableIdentifier *table,
                      uint32_t count, StaticBuffer &buffer, uint32_t flags);
     virtual void trigger();
+    virtual void record_sync(int64_t usec);
 
   private:
+    void trigger_adaptive();
+    void flush_all();
+
     Mutex         m_mutex;
     RangeServer  *m_range_server;
     uint32_t      m_commit_interval;
     int           m_counter;
     FlyweightString m_flyweight_strings;
 
+    // Adaptive mode state, times in microseconds
+    bool          m_adaptive;
+    int64_t       m_target_latency;
+    int64_t       m_flush_threshold;
+    double        m_sync_cost;
+    double        m_arrival_rate;
+    uint32_t      m_arrivals;
+    boost::xtime  m_last_trigger;
+    boost::xtime  m_window_start;
+    uint64_t      m_pending_bytes;
+    int64_t       m_pending_max_window;
+
     typedef std::map<TableIdentifier, TableUpdate *, lttid> TableUpdateMap;
     TableUpdateMap m_table_map;
   };
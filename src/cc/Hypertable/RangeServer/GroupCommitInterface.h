@@ -138,6 +138,11 @@ namespace Hypertable {
     virtual void add(EventPtr &event, SchemaPtr &schema, const TableIdentifier *table,
                      uint32_t count, StaticBuffer &buffer, uint32_t flags) = 0;
     virtual void trigger() = 0;
+
+    /** Reports the duration of a user commit log sync.
+     * @param usec sync duration in microseconds
+     */
+    virtual void record_sync(int64_t usec) { }
   };
   typedef boost::intrusive_ptr<GroupCommitInterface> GroupCommitInterfacePtr;
 }
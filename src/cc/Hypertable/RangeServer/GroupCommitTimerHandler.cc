@@ -43,6 +43,15 @@ GroupCommitTimerHandler::GroupCommitTimerHandler(Comm *comm, RangeServer *range_
 
   m_commit_interval = get_i32("Hypertable.RangeServer.CommitInterval");
 
+  // Adaptive group commit needs a tick well below the target latency
+  if (get_bool("Hypertable.RangeServer.GroupCommit.Adaptive")) {
+    int32_t tick = get_i32("Hypertable.RangeServer.GroupCommit.TargetLatency") / 4;
+    if (tick < 1)
+      tick = 1;
+    if (tick < m_commit_interval)
+      m_commit_interval = tick;
+  }
+
   if ((error = m_comm->set_timer(m_commit_interval, this)) != Error::OK)
     HT_FATALF("Problem setting timer - %s", Error::get_text(error));
 
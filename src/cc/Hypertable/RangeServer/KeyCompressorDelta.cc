@@ -0,0 +1,122 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Serialization.h"
+
+#include "KeyCompressorDelta.h"
+
+using namespace Hypertable;
+
+const uint32_t KeyCompressorDelta::MAX_DICTIONARY_SIZE;
+
+namespace {
+  inline uint64_t zigzag_delta(int64_t value, int64_t last) {
+    int64_t delta = (int64_t)((uint64_t)value - (uint64_t)last);
+    return ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+  }
+}
+
+
+void KeyCompressorDelta::reset() {
+  m_compressed_key.clear();
+  m_uncompressed_key.clear();
+  m_last_row.clear();
+  m_qualifiers.clear();
+  m_qualifiers.key_alloc().free();
+  m_qualifier_count = 0;
+  m_last_timestamp = 0;
+  m_last_revision = 0;
+}
+
+
+void KeyCompressorDelta::add(const Key &key) {
+  const uint8_t *row = (const uint8_t *)key.row;
+  size_t row_match = 0;
+  size_t n = std::min((size_t)key.row_len, m_last_row.fill());
+
+  HT_ASSERT(key.serial.ptr);
+
+  while (row_match < n && m_last_row.base[row_match] == row[row_match])
+    row_match++;
+
+  m_body.clear();
+  m_body.ensure(40 + key.row_len + key.column_qualifier_len);
+
+  *m_body.ptr++ = key.control;
+  Serialization::encode_vi32(&m_body.ptr, row_match);
+  Serialization::encode_vi32(&m_body.ptr, key.row_len - row_match);
+  m_body.add_unchecked(row + row_match, key.row_len - row_match);
+  *m_body.ptr++ = key.column_family_code;
+
+  CstrHashMap<uint32_t>::iterator iter = m_qualifiers.find(key.column_qualifier);
+  if (iter != m_qualifiers.end())
+    Serialization::encode_vi32(&m_body.ptr, iter->second + 1);
+  else {
+    Serialization::encode_vi32(&m_body.ptr, 0);
+    Serialization::encode_vi32(&m_body.ptr, key.column_qualifier_len);
+    m_body.add_unchecked(key.column_qualifier, key.column_qualifier_len);
+    if (m_qualifier_count < MAX_DICTIONARY_SIZE)
+      m_qualifiers.insert(key.column_qualifier, m_qualifier_count++);
+  }
+
+  *m_body.ptr++ = key.flag;
+
+  if (key.control & Key::HAVE_TIMESTAMP) {
+    Serialization::encode_vi64(&m_body.ptr,
+                               zigzag_delta(key.timestamp, m_last_timestamp));
+    m_last_timestamp = key.timestamp;
+  }
+  if (has_revision(key.control)) {
+    Serialization::encode_vi64(&m_body.ptr,
+                               zigzag_delta(key.revision, m_last_revision));
+    m_last_revision = key.revision;
+  }
+
+  m_compressed_key.clear();
+  m_compressed_key.ensure(5 + m_body.fill());
+  Serialization::encode_vi32(&m_compressed_key.ptr, m_body.fill());
+  m_compressed_key.add_unchecked(m_body.base, m_body.fill());
+
+  // The block index needs the uncompressed form of the last key of a
+  // block after the next key has been added, so keep a copy
+  m_uncompressed_key.clear();
+  m_uncompressed_key.add(key.serial.ptr, key.length);
+
+  m_last_row.ptr = m_last_row.base + row_match;
+  m_last_row.add(row + row_match, key.row_len - row_match);
+}
+
+size_t KeyCompressorDelta::length() {
+  return m_compressed_key.fill();
+}
+
+size_t KeyCompressorDelta::length_uncompressed() {
+  return m_uncompressed_key.fill();
+}
+
+void KeyCompressorDelta::write(uint8_t *buf) {
+  memcpy(buf, m_compressed_key.base, m_compressed_key.fill());
+}
+
+void KeyCompressorDelta::write_uncompressed(uint8_t *buf) {
+  memcpy(buf, m_uncompressed_key.base, m_uncompressed_key.fill());
+}
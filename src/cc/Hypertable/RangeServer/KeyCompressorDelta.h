@@ -0,0 +1,83 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_KEYCOMPRESSORDELTA_H
+#define HYPERTABLE_KEYCOMPRESSORDELTA_H
+
+#include "Common/CstrHashMap.h"
+#include "Common/DynamicBuffer.h"
+
+#include "KeyCompressor.h"
+
+namespace Hypertable {
+
+  /**
+   * Key compressor that encodes each field of a key against the previous
+   * key of the same block.  The row is prefix compressed, column
+   * qualifiers are replaced by an index into a per-block dictionary once
+   * they have been seen, and the timestamp and revision are stored as
+   * zigzag varint deltas.  A compressed key has the layout:
+   *
+   *   vi32 length, control, vi32 row prefix length, vi32 row suffix
+   *   length, row suffix, column family, vi32 qualifier reference
+   *   [, vi32 qualifier length, qualifier], flag [, timestamp delta]
+   *   [, revision delta]
+   *
+   * A qualifier reference of zero means the qualifier follows inline and
+   * is appended to the dictionary, otherwise it is the dictionary index
+   * plus one.
+   */
+  class KeyCompressorDelta : public KeyCompressor {
+  public:
+    /** Maximum number of qualifiers held in the per-block dictionary */
+    static const uint32_t MAX_DICTIONARY_SIZE = 4096;
+
+    /** Returns true if a key with the given control byte carries a
+     * revision separate from its timestamp
+     */
+    static bool has_revision(uint8_t control) {
+      if ((control & Key::HAVE_TIMESTAMP) && (control & Key::REV_IS_TS))
+        return false;
+      return (control & Key::HAVE_REVISION) != 0;
+    }
+
+    KeyCompressorDelta() { reset(); }
+    virtual void reset();
+    virtual void add(const Key &key);
+    virtual size_t length();
+    virtual size_t length_uncompressed();
+    virtual void write(uint8_t *buf);
+    virtual void write_uncompressed(uint8_t *buf);
+  private:
+    DynamicBuffer m_body;
+    DynamicBuffer m_compressed_key;
+    DynamicBuffer m_uncompressed_key;
+    DynamicBuffer m_last_row;
+    CstrHashMap<uint32_t> m_qualifiers;
+    uint32_t      m_qualifier_count;
+    int64_t       m_last_timestamp;
+    int64_t       m_last_revision;
+  };
+  typedef intrusive_ptr<KeyCompressorDelta> KeyCompressorDeltaPtr;
+
+}
+
+#endif // HYPERTABLE_KEYCOMPRESSORDELTA_H
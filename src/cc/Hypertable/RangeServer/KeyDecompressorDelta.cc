@@ -0,0 +1,131 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Serialization.h"
+
+#include "KeyCompressorDelta.h"
+#include "KeyDecompressorDelta.h"
+
+using namespace Hypertable;
+
+namespace {
+  inline int64_t unzigzag_delta(uint64_t encoded, int64_t last) {
+    int64_t delta = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+    return (int64_t)((uint64_t)last + (uint64_t)delta);
+  }
+}
+
+
+void KeyDecompressorDelta::reset() {
+  m_key.clear();
+  m_row.clear();
+  m_dictionary.clear();
+  m_qualifiers.clear();
+  m_last_timestamp = 0;
+  m_last_revision = 0;
+  m_serialized_key.ptr = 0;
+}
+
+const uint8_t *KeyDecompressorDelta::add(const uint8_t *next_base) {
+  const uint8_t *ptr;
+  SerializedKey serkey(next_base);
+  size_t remaining = serkey.decode_length(&ptr);
+  const uint8_t *end = ptr + remaining;
+  const char *qualifier;
+  uint32_t qualifier_len;
+
+  uint8_t control = Serialization::decode_byte(&ptr, &remaining);
+  uint32_t row_match = Serialization::decode_vi32(&ptr, &remaining);
+  uint32_t row_suffix = Serialization::decode_vi32(&ptr, &remaining);
+
+  HT_ASSERT(row_match <= m_row.fill() && row_suffix <= remaining);
+  m_row.ptr = m_row.base + row_match;
+  m_row.add(ptr, row_suffix);
+  ptr += row_suffix;
+  remaining -= row_suffix;
+
+  uint8_t column_family_code = Serialization::decode_byte(&ptr, &remaining);
+
+  uint32_t reference = Serialization::decode_vi32(&ptr, &remaining);
+  if (reference == 0) {
+    qualifier_len = Serialization::decode_vi32(&ptr, &remaining);
+    HT_ASSERT(qualifier_len <= remaining);
+    if (m_qualifiers.size() < KeyCompressorDelta::MAX_DICTIONARY_SIZE) {
+      m_qualifiers.push_back(std::make_pair((uint32_t)m_dictionary.fill(),
+                                            qualifier_len));
+      m_dictionary.add(ptr, qualifier_len);
+    }
+    qualifier = (const char *)ptr;
+    ptr += qualifier_len;
+    remaining -= qualifier_len;
+  }
+  else {
+    HT_ASSERT(reference <= m_qualifiers.size());
+    qualifier = (const char *)m_dictionary.base + m_qualifiers[reference-1].first;
+    qualifier_len = m_qualifiers[reference-1].second;
+  }
+
+  uint8_t flag = Serialization::decode_byte(&ptr, &remaining);
+
+  uint32_t length = 1 + m_row.fill() + 1 + 1 + qualifier_len + 1 + 1;
+  if (control & Key::HAVE_TIMESTAMP) {
+    m_last_timestamp = unzigzag_delta(Serialization::decode_vi64(&ptr, &remaining),
+                                      m_last_timestamp);
+    length += 8;
+  }
+  if (KeyCompressorDelta::has_revision(control)) {
+    m_last_revision = unzigzag_delta(Serialization::decode_vi64(&ptr, &remaining),
+                                     m_last_revision);
+    length += 8;
+  }
+  HT_ASSERT(ptr == end);
+
+  m_key.clear();
+  m_key.ensure(5 + length);
+  Serialization::encode_vi32(&m_key.ptr, length);
+  *m_key.ptr++ = control;
+  m_key.add_unchecked(m_row.base, m_row.fill());
+  *m_key.ptr++ = 0;
+  *m_key.ptr++ = column_family_code;
+  if (qualifier_len)
+    m_key.add_unchecked(qualifier, qualifier_len);
+  *m_key.ptr++ = 0;
+  *m_key.ptr++ = flag;
+  if (control & Key::HAVE_TIMESTAMP)
+    Key::encode_ts64(&m_key.ptr, m_last_timestamp,
+                     (control & Key::TS_CHRONOLOGICAL) ? false : true);
+  if (KeyCompressorDelta::has_revision(control))
+    Key::encode_ts64(&m_key.ptr, m_last_revision);
+
+  m_serialized_key.ptr = m_key.base;
+  return end;
+}
+
+
+bool KeyDecompressorDelta::less_than(SerializedKey serialized_key) {
+  return m_serialized_key < serialized_key;
+}
+
+
+void KeyDecompressorDelta::load(Key &key) {
+  key.load(m_serialized_key);
+}
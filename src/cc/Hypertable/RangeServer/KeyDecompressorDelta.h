@@ -0,0 +1,58 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_KEYDECOMPRESSORDELTA_H
+#define HYPERTABLE_KEYDECOMPRESSORDELTA_H
+
+#include <utility>
+#include <vector>
+
+#include "Common/DynamicBuffer.h"
+
+#include "KeyDecompressor.h"
+
+namespace Hypertable {
+
+  /**
+   * Decompresses keys written by KeyCompressorDelta, rebuilding each one
+   * into its regular serialized form.
+   */
+  class KeyDecompressorDelta : public KeyDecompressor {
+  public:
+    KeyDecompressorDelta() { reset(); }
+    virtual void reset();
+    virtual const uint8_t *add(const uint8_t *ptr);
+    virtual bool less_than(SerializedKey serialized_key);
+    virtual void load(Key &key);
+  private:
+    SerializedKey m_serialized_key;
+    DynamicBuffer m_key;
+    DynamicBuffer m_row;
+    DynamicBuffer m_dictionary;
+    std::vector<std::pair<uint32_t, uint32_t> > m_qualifiers;
+    int64_t m_last_timestamp;
+    int64_t m_last_revision;
+  };
+  typedef intrusive_ptr<KeyDecompressorDelta> KeyDecompressorDeltaPtr;
+
+}
+
+#endif // HYPERTABLE_KEYDECOMPRESSORDELTA_H
@@ -35,6 +35,7 @@ namespace Hypertable {
       COMPACT_MERGING           = 0x0204,
       COMPACT_GC                = 0x0208,
       COMPACT_MOVE              = 0x0210,
+      COMPACT_EXPIRED           = 0x0220,
       MEMORY_PURGE              = 0x0400,
       MEMORY_PURGE_SHADOW_CACHE = 0x0401,
       MEMORY_PURGE_CELLSTORE    = 0x0402,
@@ -69,6 +70,10 @@ namespace Hypertable {
       return (flags & COMPACT_MOVE) == COMPACT_MOVE;
     }
 
+    inline bool expired_compaction(int flags) {
+      return (flags & COMPACT_EXPIRED) == COMPACT_EXPIRED;
+    }
+
     inline bool purge_shadow_cache(int flags) {
       return (flags & MEMORY_PURGE_SHADOW_CACHE) == MEMORY_PURGE_SHADOW_CACHE;
     }
@@ -84,6 +84,28 @@ namespace {
     }
   };
 
+  /**
+   * Estimates the benefit of a merging compaction per byte it rewrites.
+   * Merging a run of N CellStores saves N-1 CellStore reads for every scan
+   * of the range, so the saving is weighted by the range's scan count.
+   */
+  double merge_score(const AccessGroup::MaintenanceData *ag_data) {
+    const Range::MaintenanceData *range_data =
+      (const Range::MaintenanceData *)ag_data->user_data;
+    if (ag_data->merge_length < 2)
+      return 0.0;
+    double reads_saved = (double)(ag_data->merge_length - 1) *
+      (double)(range_data->load_factors.scans + 1);
+    return reads_saved / (double)(ag_data->merge_bytes + 1);
+  }
+
+  struct MergeScoreOrderingDescending {
+    bool operator()(const AccessGroup::MaintenanceData *x,
+		    const AccessGroup::MaintenanceData *y) const {
+      return merge_score(x) > merge_score(y);
+    }
+  };
+
 }
 
 
@@ -184,10 +206,18 @@ MaintenancePrioritizer::schedule_necessary_compactions(RangeDataVector &range_da
   CommitLog::CumulativeSizeMap cumulative_size_map;
   CommitLog::CumulativeSizeMap::iterator iter;
   AccessGroup::MaintenanceData *ag_data;
+  std::vector<AccessGroup::MaintenanceData *> merges;
   int64_t disk_total;
 
   log->load_cumulative_size_map(cumulative_size_map);
 
+  // The oldest cached revision of a USER range pins the fragments of all
+  // USER log streams
+  if (log == Global::user_log) {
+    for (size_t i=1; i<Global::user_logs.size(); i++)
+      Global::user_logs[i]->load_cumulative_size_map(cumulative_size_map);
+  }
+
   for (size_t i=0; i<range_data.size(); i++) {
 
     if (range_data[i].data->busy)
@@ -197,6 +227,14 @@ MaintenancePrioritizer::schedule_necessary_compactions(RangeDataVector &range_da
 
     for (ag_data = range_data[i].data->agdata; ag_data; ag_data = ag_data->next) {
 
+      // Drop fully expired CellStores, this costs no I/O
+      if (ag_data->expired_files) {
+        range_data[i].data->maintenance_flags |= MaintenanceFlag::COMPACT;
+        ag_data->maintenance_flags |= MaintenanceFlag::COMPACT_EXPIRED;
+        if (range_data[i].data->priority == 0)
+          range_data[i].data->priority = priority++;
+      }
+
       // Schedule compaction for AGs that need garbage collection
       if (ag_data->gc_needed) {
         range_data[i].data->maintenance_flags |= MaintenanceFlag::COMPACT;
@@ -268,18 +306,38 @@ MaintenancePrioritizer::schedule_necessary_compactions(RangeDataVector &range_da
             + (*iter).second.cumulative_size + " <= prune_threshold " + prune_threshold + "\n";
       }
 
-      // memory purge takes precedent over merging compactions
-      if (ag_data->needs_merging &&
-          (range_data[i].data->maintenance_flags & MaintenanceFlag::MEMORY_PURGE) == 0) {
-        if (range_data[i].data->priority == 0)
-          range_data[i].data->priority = priority++;
-        range_data[i].data->maintenance_flags |= MaintenanceFlag::COMPACT;
-        ag_data->maintenance_flags |= MaintenanceFlag::COMPACT_MERGING;
+      if (ag_data->needs_merging) {
+        ag_data->user_data = range_data[i].data;
+        merges.push_back(ag_data);
       }
 
     }
   }
 
+  /**
+   * Schedule merging compactions in order of decreasing benefit so that
+   * the ones admitted under the scheduler's I/O budget are the ones that
+   * save the most reads per byte rewritten.  Memory purge takes precedence
+   * over merging compactions.
+   */
+  {
+    struct MergeScoreOrderingDescending ordering;
+    sort(merges.begin(), merges.end(), ordering);
+  }
+
+  for (size_t i=0; i<merges.size(); i++) {
+    Range::MaintenanceData *rdata = (Range::MaintenanceData *)merges[i]->user_data;
+    if (rdata->maintenance_flags & MaintenanceFlag::MEMORY_PURGE)
+      continue;
+    if (rdata->priority == 0)
+      rdata->priority = priority++;
+    rdata->maintenance_flags |= MaintenanceFlag::COMPACT;
+    merges[i]->maintenance_flags |= MaintenanceFlag::COMPACT_MERGING;
+    trace_str += format("STAT %s merge_score %.3g merge_bytes %lld\n",
+                        merges[i]->ag->get_full_name(), merge_score(merges[i]),
+                        (Lld)merges[i]->merge_bytes);
+  }
+
   return memory_state.need_more();
 }
 
@@ -71,6 +71,15 @@ MaintenanceScheduler::MaintenanceScheduler(MaintenanceQueuePtr &queue, RSStatsPt
                                   std::numeric_limits<int32_t>::max());
   m_move_compactions_per_interval = get_i32("Hypertable.RangeServer.Maintenance.MoveCompactionsPerInterval");
 
+  // Bytes of merging compaction input that fit in the I/O budget for one
+  // maintenance interval
+  int32_t bandwidth = get_i32("Hypertable.RangeServer.Maintenance.Compaction.MaxBandwidth");
+  if (bandwidth > 0)
+    m_merge_bytes_per_interval = ((int64_t)bandwidth * Property::MiB *
+                                  (int64_t)m_maintenance_interval) / 1000;
+  else
+    m_merge_bytes_per_interval = std::numeric_limits<int64_t>::max();
+
   /** 
    * This code adds hashes for the four primary commit log
    * directories to the m_log_hashes set.  This set is passed
@@ -144,6 +153,14 @@ void MaintenanceScheduler::schedule() {
     trace_str += String("FileBlockCache-available_memory\t") + available_memory + "\n";
     trace_str += String("FileBlockCache-accesses\t") + accesses + "\n";
     trace_str += String("FileBlockCache-hits\t") + hits + "\n";
+    if (Global::ssd_block_cache) {
+      uint64_t capacity = 0, used = 0;
+      Global::ssd_block_cache->get_stats(&capacity, &used, &accesses, &hits);
+      trace_str += String("SsdBlockCache-capacity\t") + capacity + "\n";
+      trace_str += String("SsdBlockCache-used\t") + used + "\n";
+      trace_str += String("SsdBlockCache-accesses\t") + accesses + "\n";
+      trace_str += String("SsdBlockCache-hits\t") + hits + "\n";
+    }
   }
 
   boost::xtime now;
@@ -250,8 +267,8 @@ void MaintenanceScheduler::schedule() {
     if (Global::system_log)
       Global::system_log->purge(revision_system, log_dir_hashes, log_generation);
 
-    if (Global::user_log)
-      Global::user_log->purge(revision_user, log_dir_hashes, log_generation);
+    foreach_ht (CommitLog *log, Global::user_logs)
+      log->purge(revision_user, log_dir_hashes, log_generation);
   }
 
   {
@@ -317,6 +334,7 @@ void MaintenanceScheduler::schedule() {
     sort(range_data_prioritized.begin(), range_data_prioritized.end(), ordering);
 
     int32_t merges_created = 0;
+    int64_t merge_bytes = 0;
     int level = 0;
 
     for (size_t i=0; i<range_data_prioritized.size(); i++) {
@@ -342,11 +360,20 @@ void MaintenanceScheduler::schedule() {
                 MaintenanceFlag::gc_compaction(ag_data->maintenance_flags))
               task->add_subtask(ag_data->ag, ag_data->maintenance_flags);
             else if (MaintenanceFlag::merging_compaction(ag_data->maintenance_flags)) {
-              if (do_merges && merges_created < m_merges_per_interval) {
+              // The first merge is always admitted so a run larger than
+              // the budget still gets merged eventually
+              if (do_merges && merges_created < m_merges_per_interval &&
+                  (merges_created == 0 ||
+                   merge_bytes + ag_data->merge_bytes <= m_merge_bytes_per_interval)) {
                 task->add_subtask(ag_data->ag, ag_data->maintenance_flags);
+                merge_bytes += ag_data->merge_bytes;
                 merges_created++;
               }
+              else if (MaintenanceFlag::expired_compaction(ag_data->maintenance_flags))
+                task->add_subtask(ag_data->ag, MaintenanceFlag::COMPACT_EXPIRED);
             }
+            else if (MaintenanceFlag::expired_compaction(ag_data->maintenance_flags))
+              task->add_subtask(ag_data->ag, ag_data->maintenance_flags);
           }
         }
         Global::maintenance_queue->add(task);
@@ -82,6 +82,7 @@ namespace Hypertable {
     int32_t m_merging_delay;
     int32_t m_merges_per_interval;
     int32_t m_move_compactions_per_interval;
+    int64_t m_merge_bytes_per_interval;
     std::set<int64_t> m_log_hashes;
   };
 
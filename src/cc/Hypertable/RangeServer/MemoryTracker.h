@@ -26,13 +26,16 @@
 
 #include "FileBlockCache.h"
 #include "QueryCache.h"
+#include "RowCache.h"
 
 namespace Hypertable {
 
   class MemoryTracker {
   public:
-    MemoryTracker(FileBlockCache *block_cache, QueryCache *query_cache) 
-      : m_memory_used(0), m_block_cache(block_cache), m_query_cache(query_cache) { }
+    MemoryTracker(FileBlockCache *block_cache, QueryCache *query_cache,
+                  RowCache *row_cache = 0)
+      : m_memory_used(0), m_block_cache(block_cache), m_query_cache(query_cache),
+        m_row_cache(row_cache) { }
 
     void add(int64_t amount) {
       ScopedLock lock(m_mutex);
@@ -47,7 +50,8 @@ namespace Hypertable {
     int64_t balance() {
       ScopedLock lock(m_mutex);
       return m_memory_used + (m_block_cache ? m_block_cache->memory_used() : 0) +
-        (m_query_cache ? m_query_cache->memory_used() : 0);
+        (m_query_cache ? m_query_cache->memory_used() : 0) +
+        (m_row_cache ? m_row_cache->memory_used() : 0);
     }
 
   private:
@@ -55,6 +59,7 @@ namespace Hypertable {
     int64_t m_memory_used;
     FileBlockCache *m_block_cache;
     QueryCache *m_query_cache;
+    RowCache *m_row_cache;
   };
 
 }
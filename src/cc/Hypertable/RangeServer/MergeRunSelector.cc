@@ -0,0 +1,176 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <strings.h>
+
+#include "Hypertable/Lib/KeySpec.h"
+
+#include "Global.h"
+#include "MergeRunSelector.h"
+
+using namespace Hypertable;
+
+
+MergeRunSelector::MergeRunSelector()
+  : m_run_length_threshold(Global::merge_cellstore_run_length_threshold),
+    m_time_window(0) {
+}
+
+
+/**
+ * The tiered strategy lets a run of small CellStores grow to
+ * Hypertable.RangeServer.CellStore.Merge.RunLengthThreshold before merging
+ * it, trading read amplification for less rewriting.  The leveled
+ * strategy merges as soon as two adjacent CellStores fit in the target
+ * size.  The timewindow strategy applies the tiered rules to the
+ * CellStores of the current time window only and merges each closed window
+ * down to a single CellStore that is never rewritten again.  With a zero
+ * time window it behaves like the tiered strategy.
+ */
+void MergeRunSelector::set_strategy(const String &strategy) {
+  m_time_window = 0;
+  if (!strcasecmp(strategy.c_str(), "leveled"))
+    m_run_length_threshold = 1;
+  else {
+    m_run_length_threshold = Global::merge_cellstore_run_length_threshold;
+    if (!strcasecmp(strategy.c_str(), "timewindow"))
+      m_time_window = Global::merge_cellstore_time_window;
+  }
+}
+
+
+bool MergeRunSelector::find(const std::vector<StoreInfo> &stores,
+                            int64_t now, size_t *indexp, size_t *lenp) const {
+
+  if (stores.empty())
+    return false;
+
+  if (m_time_window > 0)
+    return find_time_window_run(stores, now, indexp, lenp);
+
+  return find_size_run(stores, 0, stores.size(), indexp, lenp);
+}
+
+
+/**
+ * Looks for a run of CellStores to merge among stores[begin, end)
+ */
+bool MergeRunSelector::find_size_run(const std::vector<StoreInfo> &stores,
+                                     size_t begin, size_t end,
+                                     size_t *indexp, size_t *lenp) const {
+  size_t index = begin;
+  size_t count = 0;
+  size_t i = begin;
+  int64_t running_total = 0;
+
+  do {
+    count++;
+    running_total += stores[i].disk_usage;
+
+    if (running_total >= Global::cellstore_target_size_max) {
+      if (count > (size_t)m_run_length_threshold) {
+        if (indexp)
+          *indexp = index;
+        if (lenp)
+           *lenp = count-1;
+        return true;
+      }
+      index = i+1;
+      count = 0;
+      running_total = 0;
+    }
+    else if (running_total >= Global::cellstore_target_size_min &&
+             count > 1) {
+      if (indexp)
+        *indexp = index;
+      if (lenp)
+        *lenp = count;
+      return true;
+    }
+    i++;
+  } while (i < end);
+
+  if (count > (size_t)m_run_length_threshold) {
+    if (indexp)
+      *indexp = index;
+    if (lenp)
+      *lenp = count;
+    return true;
+  }
+
+  return false;
+}
+
+
+/**
+ * Returns the time window of a CellStore, determined by its newest
+ * timestamp so that late arriving cells keep a store in the newer window.
+ * Stores without timestamps are treated as belonging to the current window.
+ */
+int64_t MergeRunSelector::store_window(const StoreInfo &store) const {
+  if (store.timestamp_min > store.timestamp_max)
+    return TIMESTAMP_MAX;
+  return store.timestamp_max / m_time_window;
+}
+
+
+/**
+ * Splits the stores into runs of adjacent CellStores that fall in the same
+ * time window.  Runs in the current window are merged by size like the
+ * tiered strategy; a run in a closed window is merged once into a single
+ * CellStore.  Closed windows holding expired CellStores are left alone
+ * since they will be dropped without a rewrite.
+ */
+bool MergeRunSelector::find_time_window_run(const std::vector<StoreInfo> &stores,
+                                            int64_t now, size_t *indexp,
+                                            size_t *lenp) const {
+  int64_t current_window = now / m_time_window;
+  size_t begin = 0, end;
+
+  while (begin < stores.size()) {
+    int64_t window = store_window(stores[begin]);
+    bool expired = stores[begin].expired;
+
+    for (end = begin+1; end < stores.size(); end++) {
+      if (store_window(stores[end]) != window)
+        break;
+      if (stores[end].expired)
+        expired = true;
+    }
+
+    if (window >= current_window) {
+      if (find_size_run(stores, begin, end, indexp, lenp))
+        return true;
+    }
+    else if (end - begin > 1 && !expired) {
+      if (indexp)
+        *indexp = begin;
+      if (lenp)
+        *lenp = end - begin;
+      return true;
+    }
+    begin = end;
+  }
+
+  return false;
+}
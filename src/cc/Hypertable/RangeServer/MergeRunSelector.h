@@ -0,0 +1,92 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_MERGERUNSELECTOR_H
+#define HYPERTABLE_MERGERUNSELECTOR_H
+
+#include <vector>
+
+#include "Common/String.h"
+
+namespace Hypertable {
+
+  /**
+   * Chooses the run of adjacent CellStores that a merging compaction
+   * rewrites, following the compaction strategy of the access group.
+   */
+  class MergeRunSelector {
+  public:
+
+    /** What the selector needs to know about a CellStore */
+    class StoreInfo {
+    public:
+      StoreInfo(int64_t disk_usage_, int64_t timestamp_min_,
+                int64_t timestamp_max_, bool expired_)
+        : disk_usage(disk_usage_), timestamp_min(timestamp_min_),
+          timestamp_max(timestamp_max_), expired(expired_) { }
+      int64_t disk_usage;
+      int64_t timestamp_min;
+      int64_t timestamp_max;
+      bool expired;
+    };
+
+    MergeRunSelector();
+
+    /** Sets the compaction strategy named in the schema.
+     *
+     * @param strategy "tiered", "leveled" or "timewindow"
+     */
+    void set_strategy(const String &strategy);
+
+    /** Returns the number of CellStores a run must exceed before it is
+     * merged regardless of size */
+    int32_t run_length_threshold() const { return m_run_length_threshold; }
+
+    /** Returns the length of a time window in nanoseconds, or 0 if
+     * CellStores are merged by size alone */
+    int64_t time_window() const { return m_time_window; }
+
+    /** Looks for a run of CellStores to merge.
+     *
+     * @param stores CellStores of the access group, oldest first
+     * @param now current time in nanoseconds since the epoch
+     * @param indexp set to the index of the first store of the run
+     * @param lenp set to the number of stores in the run
+     * @return true if a run was found
+     */
+    bool find(const std::vector<StoreInfo> &stores, int64_t now,
+              size_t *indexp=0, size_t *lenp=0) const;
+
+  private:
+    bool find_size_run(const std::vector<StoreInfo> &stores, size_t begin,
+                       size_t end, size_t *indexp, size_t *lenp) const;
+    bool find_time_window_run(const std::vector<StoreInfo> &stores,
+                              int64_t now, size_t *indexp,
+                              size_t *lenp) const;
+    int64_t store_window(const StoreInfo &store) const;
+
+    int32_t m_run_length_threshold;
+    int64_t m_time_window;
+  };
+
+}
+
+#endif // HYPERTABLE_MERGERUNSELECTOR_H
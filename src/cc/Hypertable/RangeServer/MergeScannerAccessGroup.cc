@@ -25,7 +25,9 @@
 #include "Hypertable/Lib/Key.h"
 #include "Hypertable/Lib/Schema.h"
 
+#include "Global.h"
 #include "MergeScannerAccessGroup.h"
+#include "ValueLog.h"
 
 using namespace Hypertable;
 
@@ -216,7 +218,8 @@ MergeScannerAccessGroup::do_initialize()
         }
       }
       // value match (exact match or prefix match)
-      if (cfi.has_column_predicate_filter()) {
+      // (counters are matched after aggregation, in do_forward)
+      if (cfi.has_column_predicate_filter() && !counter) {
         const uint8_t *dptr;
         if (!cfi.column_predicate_matches(sstate.value.str(),
                 sstate.value.decode_length(&dptr))) {
@@ -283,6 +286,15 @@ MergeScannerAccessGroup::do_initialize()
 
 void 
 MergeScannerAccessGroup::do_forward()
+{
+  // skip aggregated counters rejected by a column predicate
+  do {
+    forward_cell();
+  } while (m_no_forward && !counted_value_matches());
+}
+
+void 
+MergeScannerAccessGroup::forward_cell()
 {
   ScannerState sstate;
   Key key;
@@ -490,7 +502,7 @@ MergeScannerAccessGroup::do_forward()
             continue;
         }
         // value match (exact match or prefix match)
-        if (cfi.has_column_predicate_filter()) {
+        if (cfi.has_column_predicate_filter() && !counter) {
           const uint8_t *dptr;
           if (!cfi.column_predicate_matches(sstate.value.str(),
                  sstate.value.decode_length(&dptr)))
@@ -568,3 +580,30 @@ MergeScannerAccessGroup::do_forward()
   io_add_output_cell(cur_bytes);
 }
 
+
+/**
+ * Compaction scans leave value log references unresolved, so the value
+ * index entry is built from the value the reference points to.
+ */
+void MergeScannerAccessGroup::purge_from_index(const Key &key,
+                                               const ByteString &value) {
+  HT_ASSERT(key.flag == FLAG_INSERT);
+  CellFilterInfo &cfi =
+            m_scan_context_ptr->family_info[key.column_family_code];
+  if (!cfi.has_index && !cfi.has_qualifier_index)
+    return;
+
+  if (cfi.has_index && ValueLogReference::is_reference(value)) {
+    ByteString resolved;
+    try {
+      Global::value_log_reader->read(value, m_purge_value, resolved);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << "Unable to purge index entry: " << e << HT_END;
+      return;
+    }
+    m_index_updater->purge(key, resolved);
+  }
+  else
+    m_index_updater->purge(key, value);
+}
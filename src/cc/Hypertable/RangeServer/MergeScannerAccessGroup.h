@@ -90,6 +90,8 @@ namespace Hypertable {
     virtual void do_forward();
 
   private:
+    void forward_cell();
+
     inline bool matches_deleted_row(const Key& key) const {
       size_t len = key.len_row();
 
@@ -220,6 +222,16 @@ namespace Hypertable {
       m_skip_remaining_counter = false;
     }
 
+    inline bool counted_value_matches() {
+      CellFilterInfo &cfi =
+                m_scan_context->family_info[m_counted_key.column_family_code];
+      if (!cfi.has_column_predicate_filter())
+        return true;
+      // skip the length byte written by finish_count()
+      return cfi.column_predicate_matches((const char *)m_counted_value.base + 1,
+                                          8);
+    }
+
     inline void start_count(const Key &key, const ByteString &value) {
       SerializedKey serial;
     
@@ -235,13 +247,7 @@ namespace Hypertable {
       increment_count(key, value);
     }
 
-    inline void purge_from_index(const Key &key, const ByteString &value) {
-      HT_ASSERT(key.flag == FLAG_INSERT);
-      CellFilterInfo &cfi =
-                m_scan_context_ptr->family_info[key.column_family_code];
-      if (cfi.has_index || cfi.has_qualifier_index)
-        m_index_updater->purge(key, value);
-    }
+    void purge_from_index(const Key &key, const ByteString &value);
 
     // if this is true, return a delete even if it doesn't satisfy
     // the ScanSpec timestamp/version requirement
@@ -277,6 +283,7 @@ namespace Hypertable {
     DynamicBuffer m_deleted_cell_version;
     std::set<int64_t> m_deleted_cell_version_set;
     IndexUpdaterPtr m_index_updater;
+    DynamicBuffer m_purge_value;
 
     ScanContext*  m_scan_context;
 
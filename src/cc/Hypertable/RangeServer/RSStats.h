@@ -25,11 +25,14 @@
 #include <vector>
 #include <algorithm>
 
+#include "Common/LatencyRecorder.h"
 #include "Common/Logger.h"
 #include "Common/Mutex.h"
 #include "Common/ReferenceCount.h"
 #include "Common/Time.h"
 
+#include "Hypertable/Lib/StatsRangeServer.h"
+
 #include "Range.h"
 
 namespace Hypertable {
@@ -43,7 +46,8 @@ namespace Hypertable {
       STATS_COLLECTOR_MONITORING  = 1
     };
 
-    RSStats(const vector<int64_t> &compute_period_millis) {
+    RSStats(const vector<int64_t> &compute_period_millis)
+      : m_latency(StatsRangeServer::LATENCY_METRIC_MAX) {
       foreach_ht (int64_t compute_period, compute_period_millis) {
         m_stats_collectors.push_back(StatsCollector(compute_period));
       }
@@ -66,6 +70,24 @@ namespace Hypertable {
       }
     }
 
+    /** Records a request or pipeline stage latency.  Does not require
+     * the stats lock.
+     * @param metric one of StatsRangeServer::LatencyMetric
+     * @param usec latency in microseconds
+     */
+    void add_latency(int metric, int64_t usec) {
+      m_latency.record(metric, usec);
+    }
+
+    /** Returns the latency histograms accumulated since startup.  They are
+     * cumulative so that any number of callers can poll independently;
+     * callers wanting an interval subtract an earlier sample.
+     * @param histograms filled in with one histogram per LatencyMetric
+     */
+    void get_latency(std::vector<LatencyHistogram> &histograms) {
+      m_latency.aggregate(histograms);
+    }
+
     void recompute(int collector_id) {
       ScopedLock lock(m_mutex);
       m_stats_collectors[collector_id].recompute();
@@ -223,6 +245,7 @@ namespace Hypertable {
 
     Mutex m_mutex;
     vector<StatsCollector> m_stats_collectors;
+    LatencyRecorder m_latency;
   };
 
   typedef intrusive_ptr<RSStats> RSStatsPtr;
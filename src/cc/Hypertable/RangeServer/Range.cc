@@ -56,6 +56,11 @@ extern "C" {
 using namespace Hypertable;
 using namespace std;
 
+namespace {
+  /// Window (in seconds) over which the split load request rate is measured
+  const time_t SPLIT_LOAD_WINDOW = 60;
+}
+
 
 Range::Range(MasterClientPtr &master_client,
              const TableIdentifier *identifier, SchemaPtr &schema,
@@ -100,6 +105,10 @@ void Range::initialize() {
 
   memset(m_added_deletes, 0, 3*sizeof(int64_t));
 
+  m_load_window_start = 0;
+  m_load_window_requests = 0;
+  m_split_by_load = false;
+
   if (m_metalog_entity->table.is_metadata()) {
     if (m_metalog_entity->state.soft_limit == 0)
       m_metalog_entity->state.soft_limit = Global::range_metadata_split_size;
@@ -270,6 +279,13 @@ void Range::load_cell_stores(Metadata *metadata) {
 
       files += csvec[i] + ";\n";
 
+      // Value logs are tracked by the access group, not opened as CellStores
+      if (!strncmp(csvec[i].c_str() + csvec[i].rfind('/') + 1, "vlog", 4)) {
+        HT_INFOF("Loading value log %s", csvec[i].c_str());
+        ag->add_value_log(file_basename + csvec[i]);
+        continue;
+      }
+
       HT_INFOF("Loading CellStore %s", csvec[i].c_str());
 
       try {
@@ -290,8 +306,7 @@ void Range::load_cell_stores(Metadata *metadata) {
                   Error::get_text(e.code()));
       }
 
-      int64_t revision = boost::any_cast<int64_t>
-        (cellstore->get_trailer()->get("revision"));
+      int64_t revision = cellstore->get_revision();
       if (revision > m_latest_revision)
         m_latest_revision = revision;
 
@@ -462,6 +477,7 @@ Range::MaintenanceData *Range::get_maintenance_data(ByteArena &arena, time_t now
   AccessGroupVector  ag_vector(0);
   int64_t size=0;
   int64_t starting_maintenance_generation;
+  bool disk_usage_estimated = false;
 
   memset(mdata, 0, sizeof(MaintenanceData));
 
@@ -520,6 +536,8 @@ Range::MaintenanceData *Range::get_maintenance_data(ByteArena &arena, time_t now
     mdata->file_count += (*tailp)->file_count;
     mdata->key_bytes += (*tailp)->key_bytes;
     mdata->value_bytes += (*tailp)->value_bytes;
+    if ((*tailp)->disk_usage_estimated)
+      disk_usage_estimated = true;
   }
 
   if (mdata->disk_used)
@@ -530,10 +548,44 @@ Range::MaintenanceData *Range::get_maintenance_data(ByteArena &arena, time_t now
   if (tailp)
     (*tailp)->next = 0;
 
-  if (!m_unsplittable && size >= m_split_threshold)
+  // Don't split or throttle on an upper bound of the size; wait for the
+  // deferred block indexes to be loaded
+  if (!m_unsplittable && size >= m_split_threshold && !disk_usage_estimated)
     mdata->needs_split = true;
 
-  if (size > Global::range_maximum_size) {
+  /**
+   * Split hot ranges by load.  The request rate is measured over a window
+   * of SPLIT_LOAD_WINDOW seconds; if it exceeds the configured rate the
+   * range is split at its load median (see split_install_log) so that the
+   * halves can be balanced onto different servers.
+   */
+  if (Global::range_split_load_rate > 0 && !m_unsplittable &&
+      !mdata->is_metadata && !mdata->is_system) {
+    uint64_t requests = mdata->load_factors.scans + mdata->load_factors.updates;
+    if (m_load_window_start == 0 || now < m_load_window_start) {
+      m_load_window_start = now;
+      m_load_window_requests = requests;
+    }
+    else if (now - m_load_window_start >= SPLIT_LOAD_WINDOW) {
+      double rate = (double)(requests - m_load_window_requests) /
+        (double)(now - m_load_window_start);
+      bool split_by_load = rate >= (double)Global::range_split_load_rate &&
+        size >= Global::range_split_load_minimum_size;
+      if (split_by_load && !m_split_by_load)
+        HT_INFOF("Range %s request rate %.2f/s exceeds split load rate %d/s",
+                 m_name.c_str(), rate, (int)Global::range_split_load_rate);
+      {
+        ScopedLock lock(m_mutex);
+        m_split_by_load = split_by_load;
+      }
+      m_load_window_start = now;
+      m_load_window_requests = requests;
+    }
+    if (m_split_by_load && !disk_usage_estimated)
+      mdata->needs_split = true;
+  }
+
+  if (size > Global::range_maximum_size && !disk_usage_estimated) {
     ScopedLock lock(m_mutex);
     if (starting_maintenance_generation == m_maintenance_generation)
       m_capacity_exceeded_throttle = true;
@@ -551,6 +603,22 @@ Range::MaintenanceData *Range::get_maintenance_data(ByteArena &arena, time_t now
 }
 
 
+void Range::load_deferred_indexes() {
+  AccessGroupVector ag_vector(0);
+
+  {
+    ScopedLock lock(m_schema_mutex);
+    ag_vector = m_access_group_vector;
+  }
+
+  foreach_ht (AccessGroupPtr &ag, ag_vector) {
+    if (m_dropped)
+      break;
+    ag->load_deferred_indexes();
+  }
+}
+
+
 void Range::relinquish() {
   RangeMaintenanceGuard::Activator activator(m_maintenance_guard);
 
@@ -876,24 +944,50 @@ void Range::split_install_log() {
   /**
    * Split row determination Algorithm:
    *
-   * TBD
+   * If the range was flagged as hot, split at the load median, where load
+   * is approximated by CellStore block reads recorded in the block indexes
+   * plus the updates still held in the CellCaches.  Otherwise (or if no
+   * load data is available) split at the key count median.
    */
 
+  bool split_by_load;
+  {
+    ScopedLock lock(m_mutex);
+    split_by_load = m_split_by_load;
+    m_split_by_load = false;
+  }
+
   {
     StlArena arena(128000);
     SplitRowDataMapT split_row_data = 
       SplitRowDataMapT(LtCstr(), SplitRowDataAlloc(arena));
+    bool estimated = false;
+
+    if (split_by_load) {
+      foreach_ht (const AccessGroupPtr &ag, ag_vector)
+        ag->split_row_estimate_data_accessed(split_row_data);
+      foreach_ht (const AccessGroupPtr &ag, ag_vector)
+        ag->split_row_estimate_data_cached(split_row_data);
+      if (estimate_split_row(split_row_data, m_split_row)) {
+        HT_INFOF("Load split row estimate for %s is '%s'",
+                 m_name.c_str(), m_split_row.c_str());
+        estimated = true;
+      }
+      split_row_data.clear();
+    }
 
-    // Fetch CellStore block index split row data from
-    foreach_ht (const AccessGroupPtr &ag, ag_vector)
-      ag->split_row_estimate_data_stored(split_row_data);
+    if (!estimated) {
+      // Fetch CellStore block index split row data from
+      foreach_ht (const AccessGroupPtr &ag, ag_vector)
+        ag->split_row_estimate_data_stored(split_row_data);
 
-    // Fetch CellCache split row data from
-    foreach_ht (const AccessGroupPtr &ag, ag_vector)
-      ag->split_row_estimate_data_cached(split_row_data);
+      // Fetch CellCache split row data from
+      foreach_ht (const AccessGroupPtr &ag, ag_vector)
+        ag->split_row_estimate_data_cached(split_row_data);
+    }
 
     // Estimate split row from split row data
-    if (!estimate_split_row(split_row_data, m_split_row)) {
+    if (!estimated && !estimate_split_row(split_row_data, m_split_row)) {
       if (Global::row_size_unlimited) {
         m_unsplittable = true;
         HT_THROW(Error::CANCELLED, "");
@@ -1388,6 +1482,69 @@ void Range::compact(MaintenanceFlag::Map &subtask_map) {
 
 
 
+void Range::import_cell_stores(const String &ag_name,
+                               const std::vector<String> &files) {
+  RangeMaintenanceGuard::Activator activator(m_maintenance_guard);
+  AccessGroupPtr ag;
+  std::vector<CellStorePtr> imported;
+  // The cells take a revision from this server's clock, not the builder's
+  int64_t revision = get_ts64();
+
+  if (m_metalog_entity->state.state != RangeState::STEADY)
+    HT_THROWF(Error::RANGESERVER_RANGE_BUSY,
+              "Cannot import CellStores into %s in state %s", m_name.c_str(),
+              RangeState::get_text(m_metalog_entity->state.state).c_str());
+
+  {
+    ScopedLock lock(m_schema_mutex);
+    for (size_t i=0; i<m_access_group_vector.size(); i++) {
+      if (ag_name == m_access_group_vector[i]->get_name()) {
+        ag = m_access_group_vector[i];
+        break;
+      }
+    }
+  }
+
+  if (!ag)
+    HT_THROWF(Error::BAD_SCHEMA, "Access group '%s' not found in %s",
+              ag_name.c_str(), m_name.c_str());
+
+  // The files are moved into the range directory and opened before updates
+  // are blocked
+  ag->prepare_import(files, revision, imported);
+
+  try {
+    Barrier::ScopedActivator block_updates(m_update_barrier);
+
+    // Flush the cell cache so nothing older than the imported files is cached
+    {
+      ScopedLock lock(m_mutex);
+      ag->stage_compaction();
+    }
+    try {
+      ag->run_compaction(MaintenanceFlag::COMPACT_MINOR);
+    }
+    catch (Exception &e) {
+      ag->unstage_compaction();
+      throw;
+    }
+
+    revision = ag->install_import(imported);
+
+    ScopedLock lock(m_mutex);
+    if (revision > m_latest_revision)
+      m_latest_revision = revision;
+  }
+  catch (Exception &e) {
+    ag->discard_import(files, imported);
+    throw;
+  }
+
+  HT_INFOF("Imported %d CellStores into %s(%s)", (int)files.size(),
+           m_name.c_str(), ag_name.c_str());
+}
+
+
 void Range::purge_memory(MaintenanceFlag::Map &subtask_map) {
   RangeMaintenanceGuard::Activator activator(m_maintenance_guard);
   AccessGroupVector ag_vector(0);
@@ -170,8 +170,25 @@ namespace Hypertable {
 
     void compact(MaintenanceFlag::Map &subtask_map);
 
+    /** Attaches pre-built CellStore files to an access group of this range.
+     * The files are copied with a revision assigned by this server and are
+     * left in place for the caller to remove.  Updates are then blocked and
+     * the access group's cell cache is flushed before the copies are added
+     * so that revision ordering is preserved for commit log replay.
+     *
+     * @param ag_name access group name
+     * @param files DFS paths of the CellStore files to import
+     */
+    void import_cell_stores(const String &ag_name,
+                            const std::vector<String> &files);
+
     void purge_memory(MaintenanceFlag::Map &subtask_map);
 
+    /** Loads CellStore block indexes whose loading was deferred when the
+     * range was loaded during local recovery.
+     */
+    void load_deferred_indexes();
+
     void schedule_relinquish() { m_relinquish = true; }
     bool get_relinquish() const { return m_relinquish; }
 
@@ -388,6 +405,9 @@ namespace Hypertable {
     bool             m_relinquish;
     bool             m_removed_from_working_set;
     int64_t          m_maintenance_generation;
+    time_t           m_load_window_start;
+    uint64_t         m_load_window_requests;
+    bool             m_split_by_load;
     LoadMetricsRange m_load_metrics;
     int64_t          m_log_hash;
   };
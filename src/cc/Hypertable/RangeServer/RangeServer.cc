@@ -28,6 +28,7 @@
 #include <fstream>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 
 extern "C" {
 #include <fcntl.h>
@@ -47,11 +48,13 @@ extern "C" {
 #include "Common/FileUtils.h"
 #include "Common/HashMap.h"
 #include "Common/md5.h"
+#include "Common/Path.h"
 #include "Common/Random.h"
 #include "Common/StringExt.h"
 #include "Common/SystemInfo.h"
 #include "Common/ScopeGuard.h"
 
+#include "Hypertable/Lib/BlockCompressionHeader.h"
 #include "Hypertable/Lib/CommitLog.h"
 #include "Hypertable/Lib/Key.h"
 #include "Hypertable/Lib/MetaLogDefinition.h"
@@ -80,6 +83,7 @@ extern "C" {
 #include "RangeStatsGatherer.h"
 #include "ScanContext.h"
 #include "UpdateThread.h"
+#include "ValueLog.h"
 #include "ReplayBuffer.h"
 #include "MetaLogDefinitionRangeServer.h"
 
@@ -90,7 +94,8 @@ using namespace Hypertable::Property;
 
 RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
     ApplicationQueuePtr &app_queue, Hyperspace::SessionPtr &hyperspace)
-  : m_update_commit_queue_count(0), m_root_replay_finished(false),
+  : m_update_commit_queue_count(0), m_load_threads(1),
+    m_deferred_index_next(0), m_root_replay_finished(false),
     m_metadata_replay_finished(false), m_system_replay_finished(false),
     m_replay_finished(false), m_props(props), m_verbose(false),
     m_shutdown(false), m_comm(conn_mgr->get_comm()), m_conn_manager(conn_mgr),
@@ -111,6 +116,8 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   Global::row_size_unlimited = cfg.get_bool("Range.RowSize.Unlimited", false);
   Global::range_split_size = cfg.get_i64("Range.SplitSize");
   Global::range_maximum_size = cfg.get_i64("Range.MaximumSize");
+  Global::range_split_load_rate = cfg.get_i32("Range.SplitLoad.Rate");
+  Global::range_split_load_minimum_size = cfg.get_i64("Range.SplitLoad.MinimumSize");
   Global::range_metadata_split_size = cfg.get_i64("Range.MetadataSplitSize",
           Global::range_split_size);
   Global::access_group_garbage_compaction_threshold =
@@ -144,7 +151,25 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   boost::trim_if(Global::toplevel_dir, boost::is_any_of("/"));
   Global::toplevel_dir = String("/") + Global::toplevel_dir;
 
+  /**
+   * CellStore files can only be mapped if they are reachable through the
+   * local filesystem, i.e. the DFS broker is the local broker.  Each file is
+   * checked at open time and silently falls back to the broker otherwise.
+   */
+  if (cfg.get_bool("CellStore.Mmap") && props->has("DfsBroker.Local.Root")) {
+    Path root = props->get_str("DfsBroker.Local.Root");
+    if (!root.is_complete()) {
+      Path data_dir = props->get_str("Hypertable.DataDirectory");
+      root = data_dir / root;
+    }
+    Global::cellstore_mmap_root = root.string();
+    HT_INFOF("Memory-mapping uncompressed CellStores under %s",
+             Global::cellstore_mmap_root.c_str());
+  }
+
   Global::merge_cellstore_run_length_threshold = cfg.get_i32("CellStore.Merge.RunLengthThreshold");
+  Global::merge_cellstore_time_window =
+    (int64_t)cfg.get_i32("CellStore.Merge.TimeWindow") * 1000000000LL;
   Global::ignore_clock_skew_errors = cfg.get_bool("IgnoreClockSkewErrors");
 
   std::vector<int64_t> collector_periods(2);
@@ -227,6 +252,12 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
     Global::block_cache = new FileBlockCache(block_cache_min, block_cache_max,
 					     cfg.get_bool("BlockCache.Compressed"));
 
+  String ssd_cache_dir = cfg.get_str("BlockCache.Ssd.Directory");
+  int64_t ssd_cache_size = cfg.get_i64("BlockCache.Ssd.MaxSize");
+  if (!ssd_cache_dir.empty() && ssd_cache_size > 0)
+    Global::ssd_block_cache = new SsdBlockCache(ssd_cache_dir, ssd_cache_size,
+                                     cfg.get_i64("BlockCache.Ssd.WriteBuffer"));
+
   int64_t query_cache_memory = cfg.get_i64("QueryCache.MaxMemory");
   if (query_cache_memory > 0) {
     // reduce query cache if required
@@ -238,7 +269,31 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
     m_query_cache = new QueryCache(query_cache_memory);
   }
 
-  Global::memory_tracker = new MemoryTracker(Global::block_cache, m_query_cache);
+  int64_t row_cache_memory = cfg.get_i64("RowCache.MaxMemory");
+  if (row_cache_memory > 0) {
+    if ((double)row_cache_memory > (double)Global::memory_limit * 0.2) {
+      row_cache_memory = (int64_t)((double)Global::memory_limit * 0.2);
+      props->set("Hypertable.RangeServer.RowCache.MaxMemory", row_cache_memory);
+      HT_INFOF("Maximum size of row cache has been reduced to %.2fMB", (double)row_cache_memory / Property::MiB);
+    }
+    Global::row_cache = new RowCache(row_cache_memory);
+  }
+
+  if (cfg.get_bool("BlockChecksum.CRC32C")) {
+    BlockCompressionHeader::default_checksum_type =
+      BlockCompressionHeader::CRC32C;
+    HT_INFO("Checksumming new blocks with CRC32C");
+  }
+
+  int32_t compaction_bandwidth = cfg.get_i32("Maintenance.Compaction.MaxBandwidth");
+  if (compaction_bandwidth > 0) {
+    Global::compaction_throttle =
+      new CompactionThrottle((int64_t)compaction_bandwidth * Property::MiB);
+    HT_INFOF("Compaction I/O limited to %dMB/s", (int)compaction_bandwidth);
+  }
+
+  Global::memory_tracker = new MemoryTracker(Global::block_cache, m_query_cache,
+                                             Global::row_cache);
 
   Global::protocol = new Hypertable::RangeServerProtocol();
 
@@ -255,6 +310,9 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
 
   Global::dfs = dfsclient;
 
+  Global::value_log_reader = new ValueLogReader(Global::dfs.get(),
+      cfg.get_i32("ValueLog.MaxOpenFiles"));
+
   m_log_roll_limit = cfg.get_i64("CommitLog.RollLimit");
 
   m_dropped_table_id_cache = new TableIdCache(50);
@@ -334,8 +392,28 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   for (int i=0; i<3; i++)
     m_update_threads.push_back( new Thread(UpdateThread(this, i)) );
 
+  m_load_threads = cfg.get_i32("LoadThreads");
+  if (m_load_threads < 1)
+    m_load_threads = 1;
+
+  /**
+   * Defer CellStore block index loading during local recovery so that
+   * ranges come online as soon as their commit logs are replayed, then load
+   * the deferred indexes in the background
+   */
+  Global::defer_cellstore_index_load = cfg.get_bool("CellStore.LazyIndex");
+
   local_recover();
 
+  if (Global::defer_cellstore_index_load) {
+    Global::defer_cellstore_index_load = false;
+    m_live_map->get_range_data(m_deferred_index_ranges);
+    HT_INFOF("Loading deferred CellStore indexes for %d ranges with %d threads",
+             (int)m_deferred_index_ranges.size(), (int)m_load_threads);
+    for (int32_t i=0; i<m_load_threads; i++)
+      m_deferred_index_threads.push_back(new Thread(boost::bind(&RangeServer::load_deferred_indexes_worker, this)));
+  }
+
   Global::log_prune_threshold_min = cfg.get_i64("CommitLog.PruneThreshold.Min");
 
   uint32_t max_memory_percentage =
@@ -390,6 +468,8 @@ void RangeServer::shutdown() {
     m_update_response_queue_cond.notify_all();
     foreach_ht (Thread *thread, m_update_threads)
       thread->join();
+    foreach_ht (Thread *thread, m_deferred_index_threads)
+      thread->join();
 
     Global::range_locator = 0;
 
@@ -418,11 +498,11 @@ void RangeServer::shutdown() {
       Global::system_log = 0;
       */
     }
-    if (Global::user_log) {
-      Global::user_log->close();
+    m_user_log_streams = 0;
+    foreach_ht (CommitLog *log, Global::user_logs) {
+      log->close();
       /*
-      delete Global::user_log;
-      Global::user_log = 0;
+      delete log;
       */
     }
 
@@ -431,11 +511,31 @@ void RangeServer::shutdown() {
       Global::block_cache = 0;
     }
 
+    if (Global::ssd_block_cache) {
+      delete Global::ssd_block_cache;
+      Global::ssd_block_cache = 0;
+    }
+
     if (m_query_cache) {
        delete m_query_cache;
       m_query_cache = 0;
     }
 
+    if (Global::row_cache) {
+      delete Global::row_cache;
+      Global::row_cache = 0;
+    }
+
+    if (Global::compaction_throttle) {
+      delete Global::compaction_throttle;
+      Global::compaction_throttle = 0;
+    }
+
+    if (Global::value_log_reader) {
+      delete Global::value_log_reader;
+      Global::value_log_reader = 0;
+    }
+
     /*
     Global::maintenance_queue = 0;
     Global::metadata_table = 0;
@@ -589,6 +689,7 @@ void RangeServer::local_recover() {
   CommitLogReaderPtr user_log_reader;
   RangeDataVector range_data;
   std::vector<MetaLog::EntityPtr> entities, stripped_entities;
+  std::vector<MetaLog::EntityRange *> load_entities;
   MetaLog::EntityRange *range_entity;
   int priority = 0;
 
@@ -702,14 +803,15 @@ void RangeServer::local_recover() {
       // clear the replay map
       m_replay_map->clear();
 
+      load_entities.clear();
       foreach_ht(MetaLog::EntityPtr &entity, entities) {
         range_entity = dynamic_cast<MetaLog::EntityRange *>(entity.get());
         if (range_entity && range_entity->table.is_metadata() &&
             !(range_entity->spec.end_row &&
-              !strcmp(range_entity->spec.end_row, Key::END_ROOT_ROW))) {
-          replay_load_range(0, range_entity, false, &table_schemas);
-        }
+              !strcmp(range_entity->spec.end_row, Key::END_ROOT_ROW)))
+          load_entities.push_back(range_entity);
       }
+      replay_load_ranges(load_entities, &table_schemas);
 
       if (!m_replay_map->empty()) {
         metadata_log_reader =
@@ -764,11 +866,13 @@ void RangeServer::local_recover() {
       // clear the replay map
       m_replay_map->clear();
 
+      load_entities.clear();
       foreach_ht(MetaLog::EntityPtr &entity, entities) {
         range_entity = dynamic_cast<MetaLog::EntityRange *>(entity.get());
         if (range_entity && range_entity->table.is_system() && !range_entity->table.is_metadata())
-          replay_load_range(0, range_entity, false, &table_schemas);
+          load_entities.push_back(range_entity);
       }
+      replay_load_ranges(load_entities, &table_schemas);
 
       if (!m_replay_map->empty()) {
         system_log_reader =
@@ -820,11 +924,13 @@ void RangeServer::local_recover() {
       // clear the replay map
       m_replay_map->clear();
 
+      load_entities.clear();
       foreach_ht(MetaLog::EntityPtr &entity, entities) {
         range_entity = dynamic_cast<MetaLog::EntityRange *>(entity.get());
         if (range_entity && !range_entity->table.is_system())
-          replay_load_range(0, range_entity, false, &table_schemas);
+          load_entities.push_back(range_entity);
       }
+      replay_load_ranges(load_entities, &table_schemas);
 
       if (!m_replay_map->empty()) {
         user_log_reader = new CommitLogReader(Global::log_dfs,
@@ -856,8 +962,7 @@ void RangeServer::local_recover() {
         if (!m_replay_map->empty())
           m_live_map->merge(m_replay_map);
 
-        Global::user_log = new CommitLog(Global::log_dfs, Global::log_dir
-            + "/user", m_props, user_log_reader.get(), false);
+        create_user_logs(user_log_reader.get());
         m_replay_finished = true;
         m_replay_finished_cond.notify_all();
 
@@ -891,8 +996,7 @@ void RangeServer::local_recover() {
         Global::system_log = new CommitLog(Global::log_dfs, Global::log_dir
             + "/system", m_props, system_log_reader.get());
 
-      Global::user_log = new CommitLog(Global::log_dfs, Global::log_dir
-          + "/user", m_props, user_log_reader.get(), false);
+      create_user_logs(user_log_reader.get());
 
       Global::rsml_writer = new MetaLog::Writer(Global::log_dfs, rsml_definition,
                                                 Global::log_dir + "/" + rsml_definition->name(),
@@ -945,6 +1049,28 @@ void RangeServer::map_table_schemas(const String &parent,
   }
 }
 
+void RangeServer::create_user_logs(CommitLogReader *init_log) {
+  std::vector<CommitLog *> logs;
+  int32_t stream_count = m_props->get_i32(
+      "Hypertable.RangeServer.CommitLog.UserStreams");
+
+  if (stream_count < 1)
+    stream_count = 1;
+
+  // All streams share the user log directory so that log readers and
+  // server recovery see the fragments of every stream.  Existing fragments
+  // are adopted by the first stream.
+  for (int32_t i=0; i<stream_count; i++)
+    logs.push_back(new CommitLog(Global::log_dfs, Global::log_dir + "/user",
+                                 m_props, i == 0 ? init_log : 0, false,
+                                 i, stream_count));
+
+  m_user_log_streams = new CommitLogStreams(logs);
+  Global::user_logs = logs;
+  Global::user_log = logs[0];
+}
+
+
 void RangeServer::replay_log(CommitLogReaderPtr &log_reader) {
   BlockCompressionHeaderCommitLog header;
   uint8_t *base;
@@ -1291,6 +1417,7 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
   SchemaPtr schema;
   ScanContextPtr scan_ctx;
   bool decrement_needed=false;
+  HiResTime start_time;
 
   HT_DEBUG_OUT <<"Creating scanner:\n"<< *table << *range_spec
                << *scan_spec << HT_END;
@@ -1318,6 +1445,12 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
       HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC,
                "can only scan one cell interval");
 
+    if (scan_spec->aggregate < ScanSpec::AGGREGATE_NONE ||
+        scan_spec->aggregate > ScanSpec::AGGREGATE_MAX)
+      HT_THROWF(Error::RANGESERVER_BAD_SCAN_SPEC,
+                "unsupported aggregate function (%d)",
+                (int)scan_spec->aggregate);
+
     m_live_map->get(table, table_info);
 
     if (!table_info->get_range(range_spec, range))
@@ -1360,6 +1493,9 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
           HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
         range->decrement_scan_counter();
         decrement_needed = false;
+        HiResTime now;
+        m_server_stats->add_latency(StatsRangeServer::LATENCY_CREATE_SCANNER,
+                                    xtime_diff_micros(start_time, now));
         return;
       }
     }
@@ -1433,6 +1569,9 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
       }
     }
 
+    HiResTime now;
+    m_server_stats->add_latency(StatsRangeServer::LATENCY_CREATE_SCANNER,
+                                xtime_diff_micros(start_time, now));
   }
   catch (Hypertable::Exception &e) {
     int error;
@@ -1466,6 +1605,7 @@ RangeServer::fetch_scanblock(ResponseCallbackFetchScanblock *cb,
   TableInfoPtr table_info;
   TableIdentifierManaged scanner_table;
   SchemaPtr schema;
+  HiResTime start_time;
 
   HT_DEBUG_OUT <<"Scanner ID = " << scanner_id << HT_END;
 
@@ -1527,6 +1667,10 @@ RangeServer::fetch_scanblock(ResponseCallbackFetchScanblock *cb,
                 ext.size-4, (Lld)cells_returned);
     }
 
+    HiResTime now;
+    m_server_stats->add_latency(StatsRangeServer::LATENCY_FETCH_SCANBLOCK,
+                                xtime_diff_micros(start_time, now));
+
   }
   catch (Hypertable::Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -2089,8 +2233,8 @@ RangeServer::batch_update(std::vector<TableUpdate *> &updates, boost::xtime expi
   {
     ScopedLock lock(m_update_qualify_queue_mutex);
     HT_ASSERT(!updates.empty());
-    if (m_profile_query)
-      boost::xtime_get(&uc->start_time, TIME_UTC_);
+    boost::xtime_get(&uc->start_time, TIME_UTC_);
+    uc->received_time = uc->start_time;
     m_update_qualify_queue.push_back(uc);
     m_update_qualify_queue_cond.notify_all();
   }
@@ -2164,6 +2308,10 @@ void RangeServer::update_qualify_and_transform() {
 
       HT_DEBUG_OUT <<"Update: "<< table_update->id << HT_END;
 
+      // range, start_row and end_row carry the range found for the previous
+      // run of keys, which is reused while rows stay inside it
+      range = 0;
+
       try {
         if (!m_live_map->get(table_update->id.id, table_update->table_info)) {
           table_update->error = Error::TABLE_NOT_FOUND;
@@ -2241,8 +2389,15 @@ void RangeServer::update_qualify_and_transform() {
             continue;
           }
 
-          // Look for containing range, add to stop mods if not found
-          if (!table_update->table_info->find_containing_range(row, range,
+          // Look for containing range, add to stop mods if not found.
+          // Sorted batches mostly stay within the range of the previous run,
+          // so check that before searching the table's range set.
+          bool in_last_range = range && !range->get_relinquish() &&
+            strcmp(row, start_row.c_str()) > 0 &&
+            (end_row == "" || strcmp(row, end_row.c_str()) <= 0);
+
+          if (!in_last_range &&
+              !table_update->table_info->find_containing_range(row, range,
                                                         start_row, end_row)) {
             if (uc->send_back.error != Error::RANGESERVER_OUT_OF_RANGE
                 && uc->send_back.count > 0) {
@@ -2329,6 +2484,7 @@ void RangeServer::update_qualify_and_transform() {
             rulist->range->decrement_update_counter();
             table_update->range_map.erase(rulist->range.get());
             delete rulist;
+            range = 0;
             continue;
           }
 
@@ -2476,11 +2632,23 @@ void RangeServer::update_qualify_and_transform() {
               break;
             }
 
-            // Now copy the value (with sanity check)
+            // Now copy the value (with sanity check).  A client value with
+            // a padded length prefix would be taken for a value log
+            // reference, so it is re-encoded with the minimal prefix
             mod = key.ptr;
             key.next(); // skip value
             HT_ASSERT(key.ptr <= mod_end);
-            cur_bufp->add(mod, key.ptr-mod);
+            if (key.ptr - mod >= ValueLogReference::HEADER_LENGTH &&
+                ValueLogReference::is_reference(mod)) {
+              uint8_t prefix[5], *prefix_ptr = prefix;
+              const uint8_t *data;
+              size_t len = ByteString(mod).decode_length(&data);
+              Serialization::encode_vi32(&prefix_ptr, len);
+              cur_bufp->add(prefix, prefix_ptr - prefix);
+              cur_bufp->add(data, len);
+            }
+            else
+              cur_bufp->add(mod, key.ptr-mod);
             mod = key.ptr;
 
             table_update->total_added++;
@@ -2539,10 +2707,12 @@ void RangeServer::update_qualify_and_transform() {
     // Enqueue update
     {
       ScopedLock lock(m_update_commit_queue_mutex);
-      if (m_profile_query) {
+      {
         boost::xtime now;
         boost::xtime_get(&now, TIME_UTC_);
-        uc->qualify_time = xtime_diff_millis(uc->start_time, now);
+        int64_t usec = xtime_diff_micros(uc->start_time, now);
+        m_server_stats->add_latency(StatsRangeServer::LATENCY_UPDATE_QUALIFY, usec);
+        uc->qualify_time = usec / 1000;
         uc->start_time = now;
       }
       m_update_commit_queue.push_back(uc);
@@ -2559,7 +2729,7 @@ void RangeServer::update_commit() {
   uint64_t coalesce_amount = 0;
   int error = Error::OK;
   uint32_t committed_transfer_data;
-  bool user_log_needs_syncing;
+  std::vector<std::pair<TableUpdate *, CommitLogStreams::Write *> > user_writes;
 
   while (true) {
 
@@ -2576,7 +2746,7 @@ void RangeServer::update_commit() {
     }
 
     committed_transfer_data = 0;
-    user_log_needs_syncing = false;
+    user_writes.clear();
 
     /**
      * Commit ROOT mutations
@@ -2617,9 +2787,14 @@ void RangeServer::update_commit() {
 
         bool sync = false;
         if (table_update->id.is_user()) {
-          log = Global::user_log;
+          // USER updates are written below, in parallel across streams
+          size_t stream = m_user_log_streams->stream(table_update->id.id);
+          user_writes.push_back(std::make_pair(table_update,
+              m_user_log_streams->add_write(stream, &table_update->go_buf,
+                                            uc->last_revision)));
           if ((table_update->flags & RangeServerProtocol::UPDATE_FLAG_NO_LOG_SYNC) == 0)
-            user_log_needs_syncing = true;
+            m_user_log_streams->request_sync(stream);
+          continue;
         }
         else if (table_update->id.is_metadata()) {
           sync = true;
@@ -2642,12 +2817,28 @@ void RangeServer::update_commit() {
         }
       }
       else if (table_update->sync)
-        user_log_needs_syncing = true;
+        m_user_log_streams->request_sync(m_user_log_streams->stream(table_update->id.id));
 
     }
 
+    /**
+     * Commit USER mutations
+     */
+    if (!user_writes.empty()) {
+      m_user_log_streams->write();
+      for (size_t i=0; i<user_writes.size(); i++) {
+        TableUpdate *table_update = user_writes[i].first;
+        if ((error = user_writes[i].second->error) != Error::OK) {
+          table_update->error_msg = format("Problem writing %d bytes to USER commit log - %s",
+                                           (int)table_update->go_buf.fill(),
+                                           Error::get_text(error));
+          table_update->error = error;
+        }
+      }
+    }
+
     bool do_sync = false;
-    if (user_log_needs_syncing) {
+    if (m_user_log_streams->sync_requested()) {
       if (m_update_commit_queue_count > 0 && coalesce_amount < m_update_coalesce_limit) {
         coalesce_queue.push_back(uc);
         continue;
@@ -2657,17 +2848,15 @@ void RangeServer::update_commit() {
     else if (!coalesce_queue.empty())
       do_sync = true;
 
-    // Now sync the USER commit log if needed
+    // Now sync the USER commit log streams that need it.  This waits for
+    // the slowest of them; responses leave in revision order, so a slow
+    // stream also holds up the batches queued behind this one
     if (do_sync) {
-      size_t retry_count = 0;
       uc->total_syncs++;
-      while ((error = Global::user_log->sync()) != Error::OK) {
-        HT_ERRORF("Problem sync'ing user log fragment (%s) - %s",
-                  Global::user_log->get_current_fragment_file().c_str(),
-                  Error::get_text(error));
-        if (++retry_count == 6)
-          break;
-        poll(0, 0, 10000);
+      HiResTime sync_start;
+      if ((error = m_user_log_streams->sync()) == Error::OK) {
+        HiResTime now;
+        m_group_commit->record_sync(xtime_diff_micros(sync_start, now));
       }
     }
 
@@ -2677,10 +2866,12 @@ void RangeServer::update_commit() {
       coalesce_queue.push_back(uc);
       while (!coalesce_queue.empty()) {
         uc = coalesce_queue.front();
-        if (m_profile_query) {
+        {
           boost::xtime now;
           boost::xtime_get(&now, TIME_UTC_);
-          uc->commit_time = xtime_diff_millis(uc->start_time, now);
+          int64_t usec = xtime_diff_micros(uc->start_time, now);
+          m_server_stats->add_latency(StatsRangeServer::LATENCY_UPDATE_COMMIT, usec);
+          uc->commit_time = usec / 1000;
           uc->start_time = now;
         }
         coalesce_queue.pop_front();
@@ -2837,11 +3028,25 @@ void RangeServer::update_add_and_respond() {
       m_server_stats->add_update_data(uc->total_updates, uc->total_added, uc->total_bytes_added, uc->total_syncs);
     }
 
+    {
+      boost::xtime now;
+      boost::xtime_get(&now, TIME_UTC_);
+      int64_t usec = xtime_diff_micros(uc->start_time, now);
+      m_server_stats->add_latency(StatsRangeServer::LATENCY_UPDATE_ADD, usec);
+      uc->add_time = usec / 1000;
+      usec = xtime_diff_micros(uc->received_time, now);
+      foreach_ht (TableUpdate *table_update, uc->updates) {
+        foreach_ht (UpdateRequest *request, table_update->requests)
+          m_server_stats->add_latency(request->count == 0 ?
+                                      StatsRangeServer::LATENCY_COMMIT_LOG_SYNC :
+                                      StatsRangeServer::LATENCY_UPDATE, usec);
+      }
+    }
+
     if (m_profile_query) {
       ScopedLock lock(m_profile_mutex);
       boost::xtime now;
       boost::xtime_get(&now, TIME_UTC_);
-      uc->add_time = xtime_diff_millis(uc->start_time, now);
       m_profile_query_out << now.sec << "\tupdate\t" << uc->qualify_time << "\t" << uc->commit_time << "\t" << uc->add_time << "\n";
     }
 
@@ -2991,8 +3196,9 @@ void RangeServer::dump(ResponseCallback *cb, const char *outfile,
       if (Global::system_log)
         Global::system_log->get_stats("SYSTEM", str);
 
-      if (Global::user_log)
-        Global::user_log->get_stats("USER", str);
+      for (size_t i=0; i<Global::user_logs.size(); i++)
+        Global::user_logs[i]->get_stats(i == 0 ? String("USER") :
+                                        format("USER.%u", (unsigned)i), str);
     }
     out << str;
 
@@ -3068,6 +3274,7 @@ void RangeServer::get_statistics(ResponseCallbackGetStatistics *cb) {
   m_stats->cpu_user = m_stats->system.cpu_stat.user;
   m_stats->cpu_sys = m_stats->system.cpu_stat.sys;
   m_stats->live = m_replay_finished;
+  m_server_stats->get_latency(m_stats->latency);
 
   if (m_query_cache)
     m_query_cache->get_stats(&m_stats->query_cache_max_memory,
@@ -3549,6 +3756,48 @@ RangeServer::relinquish_range(ResponseCallback *cb,
   }
 }
 
+void
+RangeServer::import_cellstores(ResponseCallback *cb,
+        const TableIdentifier *table, const RangeSpec *range_spec,
+        const String &ag_name, const std::vector<String> &files) {
+  TableInfoPtr table_info;
+  RangePtr range;
+
+  HT_INFO_OUT << "import_cellstores ag=" << ag_name << " files="
+              << files.size() << "\n" << *table << *range_spec << HT_END;
+
+  if (!m_replay_finished) {
+    if (!wait_for_recovery_finish(cb->get_event()->expiration_time()))
+      return;
+  }
+
+  try {
+    if (table->is_system())
+      HT_THROWF(Error::NOT_ALLOWED, "Import into system table %s not allowed",
+                table->id);
+
+    if (!m_live_map->get(table->id, table_info)) {
+      cb->error(Error::TABLE_NOT_FOUND, table->id);
+      return;
+    }
+
+    if (!table_info->get_range(range_spec, range))
+      HT_THROW(Error::RANGESERVER_RANGE_NOT_FOUND,
+              format("%s[%s..%s]", table->id, range_spec->start_row,
+                  range_spec->end_row));
+
+    range->import_cell_stores(ag_name, files);
+
+    cb->response_ok();
+  }
+  catch (Hypertable::Exception &e) {
+    int error = 0;
+    HT_ERROR_OUT << e << HT_END;
+    if (cb && (error = cb->error(e.code(), e.what())) != Error::OK)
+      HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+  }
+}
+
 void RangeServer::replay_fragments(ResponseCallback *cb, int64_t op_id,
         const String &location, int plan_generation, 
         int type, const vector<uint32_t> &fragments,
@@ -4315,48 +4564,54 @@ RangeServer::replay_load_range(ResponseCallback *cb,
       << HT_END;
 
   try {
-    /** Get TableInfo from replay map, or copy it from live map, or create if
-     * doesn't exist **/
-    if (!m_replay_map->get(range_entity->table.id, table_info)) {
-      table_info = new TableInfo(m_master_client, &range_entity->table, schema);
-      register_table = true;
-    }
+    // Ranges may be replay loaded concurrently by replay_load_ranges().
+    // Serialize everything but the (expensive) Range construction.
+    {
+      ScopedLock lock(m_replay_load_mutex);
 
-    if (!m_live_map->get(range_entity->table.id, live_table_info))
-      live_table_info = table_info;
+      /** Get TableInfo from replay map, or copy it from live map, or create
+       * if doesn't exist **/
+      if (!m_replay_map->get(range_entity->table.id, table_info)) {
+        table_info = new TableInfo(m_master_client, &range_entity->table, schema);
+        register_table = true;
+      }
 
-    // Verify schema, this will create the Schema object and add it to
-    // table_info if it doesn't exist
-    verify_schema(table_info, range_entity->table.generation, table_schemas);
+      if (!m_live_map->get(range_entity->table.id, live_table_info))
+        live_table_info = table_info;
 
-    if (register_table)
-      m_replay_map->set(range_entity->table.id, table_info);
+      // Verify schema, this will create the Schema object and add it to
+      // table_info if it doesn't exist
+      verify_schema(table_info, range_entity->table.generation, table_schemas);
 
-    /**
-     * Make sure this range is not already loaded
-     */
-    if (table_info->get_range(&range_entity->spec, range) ||
-        live_table_info->get_range(&range_entity->spec, range))
-      HT_THROWF(Error::RANGESERVER_RANGE_ALREADY_LOADED, "%s[%s..%s]",
-                range_entity->table.id, range_entity->spec.start_row,
-                range_entity->spec.end_row);
+      if (register_table)
+        m_replay_map->set(range_entity->table.id, table_info);
 
-    /**
-     * Lazily create sys/METADATA table pointer
-     */
-    if (!Global::metadata_table) {
-      ScopedLock lock(Global::mutex);
-      uint32_t timeout_ms = m_props->get_i32("Hypertable.Request.Timeout");
-      if (!Global::range_locator)
-        Global::range_locator = new Hypertable::RangeLocator(m_props,
-                m_conn_manager, Global::hyperspace, timeout_ms);
-      ApplicationQueueInterfacePtr aq = m_app_queue;
-      Global::metadata_table = new Table(m_props, Global::range_locator,
-              m_conn_manager, Global::hyperspace, aq, m_namemap,
-                           TableIdentifier::METADATA_NAME, 0, timeout_ms);
-    }
+      /**
+       * Make sure this range is not already loaded
+       */
+      if (table_info->get_range(&range_entity->spec, range) ||
+          live_table_info->get_range(&range_entity->spec, range))
+        HT_THROWF(Error::RANGESERVER_RANGE_ALREADY_LOADED, "%s[%s..%s]",
+                  range_entity->table.id, range_entity->spec.start_row,
+                  range_entity->spec.end_row);
 
-    schema = table_info->get_schema();
+      /**
+       * Lazily create sys/METADATA table pointer
+       */
+      if (!Global::metadata_table) {
+        ScopedLock lock(Global::mutex);
+        uint32_t timeout_ms = m_props->get_i32("Hypertable.Request.Timeout");
+        if (!Global::range_locator)
+          Global::range_locator = new Hypertable::RangeLocator(m_props,
+                  m_conn_manager, Global::hyperspace, timeout_ms);
+        ApplicationQueueInterfacePtr aq = m_app_queue;
+        Global::metadata_table = new Table(m_props, Global::range_locator,
+                m_conn_manager, Global::hyperspace, aq, m_namemap,
+                             TableIdentifier::METADATA_NAME, 0, timeout_ms);
+      }
+
+      schema = table_info->get_schema();
+    }
 
     range = new Range(m_master_client, schema, range_entity,
             live_table_info.get());
@@ -4385,6 +4640,74 @@ RangeServer::replay_load_range(ResponseCallback *cb,
   }
 }
 
+/**
+ * Replay loads a set of ranges using up to m_load_threads threads.  Most of
+ * the time spent loading a range goes to opening its CellStores, which is
+ * dominated by DFS latency, so loading ranges in parallel shortens local
+ * recovery considerably.
+ */
+void
+RangeServer::replay_load_ranges(std::vector<MetaLog::EntityRange *> &ranges,
+                                const TableSchemaMap *table_schemas) {
+  size_t next = 0;
+  size_t thread_count = std::min((size_t)m_load_threads, ranges.size());
+
+  if (thread_count <= 1) {
+    foreach_ht (MetaLog::EntityRange *range_entity, ranges)
+      replay_load_range(0, range_entity, false, table_schemas);
+    return;
+  }
+
+  HiResTime start_time;
+  boost::thread_group threads;
+  for (size_t i=0; i<thread_count; i++)
+    threads.create_thread(boost::bind(&RangeServer::replay_load_range_worker,
+                                      this, &ranges, &next, table_schemas));
+  threads.join_all();
+
+  HiResTime now;
+  HT_INFOF("Replay loaded %d ranges with %d threads in %lld milliseconds",
+           (int)ranges.size(), (int)thread_count,
+           (Lld)xtime_diff_millis(start_time, now));
+}
+
+void
+RangeServer::replay_load_range_worker(std::vector<MetaLog::EntityRange *> *ranges,
+                                      size_t *nextp,
+                                      const TableSchemaMap *table_schemas) {
+  MetaLog::EntityRange *range_entity;
+
+  while (true) {
+    {
+      ScopedLock lock(m_replay_load_mutex);
+      if (*nextp >= ranges->size())
+        return;
+      range_entity = (*ranges)[(*nextp)++];
+    }
+    replay_load_range(0, range_entity, false, table_schemas);
+  }
+}
+
+void RangeServer::load_deferred_indexes_worker() {
+  RangePtr range;
+
+  while (!m_shutdown) {
+    {
+      ScopedLock lock(m_replay_load_mutex);
+      if (m_deferred_index_next >= m_deferred_index_ranges.size())
+        return;
+      range = m_deferred_index_ranges[m_deferred_index_next++].range;
+    }
+    try {
+      range->load_deferred_indexes();
+    }
+    catch (Exception &e) {
+      HT_WARN_OUT << "Problem loading deferred CellStore indexes for "
+                  << range->get_name() << " - " << e << HT_END;
+    }
+  }
+}
+
 void RangeServer::verify_schema(TableInfoPtr &table_info, uint32_t generation,
                                 const TableSchemaMap *table_schemas) {
   DynamicBuffer valbuf;
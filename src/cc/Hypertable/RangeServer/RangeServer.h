@@ -51,6 +51,7 @@
 #include "Hypertable/Lib/StatsRangeServer.h"
 #include "Hypertable/Lib/MetaLogEntityRange.h"
 
+#include "CommitLogStreams.h"
 #include "Global.h"
 #include "GroupCommitInterface.h"
 #include "GroupCommitTimerHandler.h"
@@ -125,6 +126,9 @@ namespace Hypertable {
 
     void relinquish_range(ResponseCallback *, const TableIdentifier *,
                           const RangeSpec *);
+    void import_cellstores(ResponseCallback *, const TableIdentifier *,
+                           const RangeSpec *, const String &ag_name,
+                           const std::vector<String> &files);
     void heapcheck(ResponseCallback *, const char *);
 
     void metadata_sync(ResponseCallback *, const char *, uint32_t flags, std::vector<const char *> columns);
@@ -210,9 +214,16 @@ namespace Hypertable {
     void get_table_schemas(TableSchemaMap &table_schemas);
     static void map_table_schemas(const String &parent, const std::vector<DirEntryAttr> &listing,
                                   TableSchemaMap &table_schemas);
+    void create_user_logs(CommitLogReader *init_log);
     void replay_log(CommitLogReaderPtr &log_reader);
     void replay_load_range(ResponseCallback *, MetaLog::EntityRange *,
                            bool write_rsml, const TableSchemaMap *table_schemas);
+    void replay_load_ranges(std::vector<MetaLog::EntityRange *> &ranges,
+                            const TableSchemaMap *table_schemas);
+    void replay_load_range_worker(std::vector<MetaLog::EntityRange *> *ranges,
+                                  size_t *nextp,
+                                  const TableSchemaMap *table_schemas);
+    void load_deferred_indexes_worker();
     void verify_schema(TableInfoPtr &, uint32_t generation, const TableSchemaMap *table_schemas=0);
     void transform_key(ByteString &bskey, DynamicBuffer *dest_bufp,
                        int64_t revision, int64_t *revisionp,
@@ -239,6 +250,7 @@ namespace Hypertable {
       uint32_t total_added;
       uint32_t total_syncs;
       uint64_t total_bytes_added;
+      boost::xtime received_time;
       boost::xtime start_time;
       uint32_t qualify_time;
       uint32_t commit_time;
@@ -257,6 +269,12 @@ namespace Hypertable {
     std::list<UpdateContext *> m_update_response_queue;
     std::vector<Thread *>      m_update_threads;
 
+    Mutex                      m_replay_load_mutex;
+    int32_t                    m_load_threads;
+    std::vector<Thread *>      m_deferred_index_threads;
+    RangeDataVector            m_deferred_index_ranges;
+    size_t                     m_deferred_index_next;
+
     Mutex                  m_mutex;
     Mutex                  m_drop_table_mutex;
     boost::condition       m_root_replay_finished_cond;
@@ -279,6 +297,7 @@ namespace Hypertable {
     Mutex                  m_failover_mutex;
 
     CommitLogPtr           m_replay_log;
+    CommitLogStreamsPtr    m_user_log_streams;
     ConnectionManagerPtr   m_conn_manager;
     ApplicationQueuePtr    m_app_queue;
     uint64_t               m_existence_file_handle;
@@ -26,6 +26,7 @@
 #include "AsyncComm/ResponseCallback.h"
 #include "Common/Serialization.h"
 
+#include "Hypertable/Lib/PayloadCompression.h"
 #include "Hypertable/Lib/Types.h"
 
 #include "RangeServer.h"
@@ -39,11 +40,15 @@ using namespace Hypertable;
 void RequestHandlerUpdate::run() {
   ResponseCallbackUpdate cb(m_comm, m_event);
   TableIdentifier table;
-  const uint8_t *decode_ptr = m_event->payload;
-  size_t decode_remain = m_event->payload_len;
+  const uint8_t *decode_ptr;
+  size_t decode_remain;
   StaticBuffer mods;
 
   try {
+    PayloadCompression::inflate(m_event);
+    decode_ptr = m_event->payload;
+    decode_remain = m_event->payload_len;
+
     table.decode(&decode_ptr, &decode_remain);
     uint32_t count = Serialization::decode_i32(&decode_ptr, &decode_remain);
     uint32_t flags = Serialization::decode_i32(&decode_ptr, &decode_remain);
@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include "Hypertable/Lib/PayloadCompression.h"
+
 #include "ResponseCallbackCreateScanner.h"
 
 using namespace Hypertable;
@@ -37,6 +39,8 @@ ResponseCallbackCreateScanner::response(short moreflag, int32_t id,
   cbp->append_i32(skipped_rows);    // for OFFSET
   cbp->append_i32(skipped_cells);   // for CELL_OFFSET
 
+  if (m_event->header.flags & CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED)
+    PayloadCompression::compress(cbp, 4);
   return m_comm->send_response(m_event->addr, cbp);
 }
 
@@ -55,6 +59,8 @@ ResponseCallbackCreateScanner::response(short moreflag, int32_t id,
   cbp->append_i32(skipped_rows);    // for OFFSET
   cbp->append_i32(skipped_cells);   // for CELL_OFFSET
 
+  if (m_event->header.flags & CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED)
+    PayloadCompression::compress(cbp, 4);
   return m_comm->send_response(m_event->addr, cbp);
 }
 
@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include "Hypertable/Lib/PayloadCompression.h"
+
 #include "ResponseCallbackFetchScanblock.h"
 
 using namespace Hypertable;
@@ -35,6 +37,8 @@ ResponseCallbackFetchScanblock::response(short moreflag, int32_t id,
   cbp->append_i32(id);              // scanner ID
   cbp->append_i32(0);               // skipped_rows
   cbp->append_i32(0);               // skipped_cells
+  if (m_event->header.flags & CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED)
+    PayloadCompression::compress(cbp, 4);
   return m_comm->send_response(m_event->addr, cbp);
 }
 
@@ -27,7 +27,17 @@ using namespace Hypertable;
 int ResponseCallbackUpdate::response(StaticBuffer &ext) {
   CommHeader header;
   header.initialize_from_request_header(m_event->header);
+  header.flags |= CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED;
   CommBufPtr cbp(new CommBuf( header, 4, ext));
   cbp->append_i32(Error::OK);
   return m_comm->send_response(m_event->addr, cbp);
 }
+
+int ResponseCallbackUpdate::response_ok() {
+  CommHeader header;
+  header.initialize_from_request_header(m_event->header);
+  header.flags |= CommHeader::FLAGS_BIT_ACCEPT_COMPRESSED;
+  CommBufPtr cbp(new CommBuf(header, 4));
+  cbp->append_i32(Error::OK);
+  return m_comm->send_response(m_event->addr, cbp);
+}
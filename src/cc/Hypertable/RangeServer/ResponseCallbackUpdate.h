@@ -35,7 +35,11 @@ namespace Hypertable {
       : ResponseCallback(comm, event_ptr) { }
 
     int response(StaticBuffer &ext);
-    using ResponseCallback::response_ok;
+
+    /** Sends an OK response that advertises support for compressed update
+     * payloads (see PayloadCompression).
+     */
+    virtual int response_ok();
   };
 
 }
@@ -0,0 +1,106 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+
+#include "RowCache.h"
+
+using namespace Hypertable;
+using std::pair;
+
+#define OVERHEAD 64
+
+CellCachePtr RowCache::lookup(const String &access_group, const char *row,
+                              int64_t generation) {
+  ScopedLock lock(m_mutex);
+  HashIndex &hash_index = m_cache.get<1>();
+  HashIndex::iterator iter;
+
+  if (m_total_lookup_count > 0 && (m_total_lookup_count % 1000) == 0) {
+    HT_INFOF("RowCache hit rate over last 1000 lookups, cumulative = %f, %f",
+             ((double)m_recent_hit_count / (double)1000)*100.0,
+             ((double)m_total_hit_count / (double)m_total_lookup_count)*100.0);
+    m_recent_hit_count = 0;
+  }
+
+  m_total_lookup_count++;
+
+  if ((iter = hash_index.find(make_key(access_group, row))) == hash_index.end())
+    return 0;
+
+  if (iter->generation != generation) {
+    m_avail_memory += iter->length;
+    hash_index.erase(iter);
+    return 0;
+  }
+
+  // move to the most recently used end
+  m_cache.relocate(m_cache.end(), m_cache.project<0>(iter));
+
+  m_total_hit_count++;
+  m_recent_hit_count++;
+  return iter->cells;
+}
+
+bool RowCache::insert(const String &access_group, const char *row,
+                      int64_t generation, CellCachePtr &cells) {
+  ScopedLock lock(m_mutex);
+  HashIndex &hash_index = m_cache.get<1>();
+  HashIndex::iterator lookup_iter;
+  String key = make_key(access_group, row);
+  uint64_t length = cells->memory_allocated() + key.length() + OVERHEAD;
+
+  if (length > m_max_memory)
+    return false;
+
+  if ((lookup_iter = hash_index.find(key)) != hash_index.end()) {
+    m_avail_memory += lookup_iter->length;
+    hash_index.erase(lookup_iter);
+  }
+
+  // make room
+  Cache::iterator iter = m_cache.begin();
+  while (m_avail_memory < length && iter != m_cache.end()) {
+    m_avail_memory += iter->length;
+    iter = m_cache.erase(iter);
+  }
+
+  if (m_avail_memory < length)
+    return false;
+
+  pair<Sequence::iterator, bool> insert_result =
+    m_cache.push_back(RowCacheEntry(key, generation, cells, length));
+  HT_ASSERT(insert_result.second);
+
+  m_avail_memory -= length;
+
+  return true;
+}
+
+void RowCache::get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
+                         uint64_t *total_lookupsp, uint64_t *total_hitsp) {
+  ScopedLock lock(m_mutex);
+  *total_lookupsp = m_total_lookup_count;
+  *total_hitsp = m_total_hit_count;
+  *max_memoryp = m_max_memory;
+  *available_memoryp = m_avail_memory;
+}
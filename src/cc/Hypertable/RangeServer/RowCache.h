@@ -0,0 +1,135 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_ROWCACHE_H
+#define HYPERTABLE_ROWCACHE_H
+
+#include <boost/functional/hash.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include "Common/Mutex.h"
+#include "Common/String.h"
+
+#include "CellCache.h"
+
+namespace Hypertable {
+  using namespace boost::multi_index;
+
+  /**
+   * LRU cache of the CellStore contents of recently read rows, one entry
+   * per access group and row.  Entries hold the raw cells (all versions
+   * and delete records) so that single-row scans with any column
+   * selection can be served by a CellCacheScanner in place of the
+   * CellStore scanners.  The CellCache of the access group is always
+   * scanned live, so updates never make an entry stale; an entry only
+   * becomes stale when the set of CellStores in its access group changes,
+   * which is detected with the generation number the access group takes
+   * from new_generation() whenever that happens.
+   */
+  class RowCache {
+
+  public:
+    RowCache(uint64_t max_memory)
+      : m_max_memory(max_memory), m_avail_memory(max_memory),
+        m_generation(0), m_total_lookup_count(0), m_total_hit_count(0),
+        m_recent_hit_count(0) { }
+
+    /** Returns the cells cached for a row, or 0 if there are none for
+     * the given generation of the access group.
+     *
+     * @param access_group table and access group name
+     * @param row row key
+     * @param generation current generation of the access group
+     * @return cached cells or 0
+     */
+    CellCachePtr lookup(const String &access_group, const char *row,
+                        int64_t generation);
+
+    /** Caches the cells of a row, evicting least recently used rows to
+     * make room.
+     *
+     * @return <i>true</i> if the row was cached
+     */
+    bool insert(const String &access_group, const char *row,
+                int64_t generation, CellCachePtr &cells);
+
+    /** Returns a generation number not handed out before. */
+    int64_t new_generation() {
+      ScopedLock lock(m_mutex);
+      return ++m_generation;
+    }
+
+    uint64_t memory_used() {
+      ScopedLock lock(m_mutex);
+      return m_max_memory - m_avail_memory;
+    }
+
+    void get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
+                   uint64_t *total_lookupsp, uint64_t *total_hitsp);
+
+  private:
+
+    class RowCacheEntry {
+    public:
+      RowCacheEntry(const String &k, int64_t gen, CellCachePtr &c,
+                    uint64_t len)
+        : key(k), generation(gen), cells(c), length(len) { }
+      String key;
+      int64_t generation;
+      CellCachePtr cells;
+      uint64_t length;
+    };
+
+    typedef boost::multi_index_container<
+      RowCacheEntry,
+      indexed_by<
+        sequenced<>,
+        hashed_unique<member<RowCacheEntry, String, &RowCacheEntry::key>,
+                      boost::hash<String> >
+      >
+    > Cache;
+
+    typedef Cache::nth_index<0>::type Sequence;
+    typedef Cache::nth_index<1>::type HashIndex;
+
+    static String make_key(const String &access_group, const char *row) {
+      String key(access_group);
+      key.append(1, '\0');
+      key.append(row);
+      return key;
+    }
+
+    Mutex     m_mutex;
+    Cache     m_cache;
+    uint64_t  m_max_memory;
+    uint64_t  m_avail_memory;
+    int64_t   m_generation;
+    uint64_t  m_total_lookup_count;
+    uint64_t  m_total_hit_count;
+    uint32_t  m_recent_hit_count;
+  };
+
+}
+
+#endif // HYPERTABLE_ROWCACHE_H
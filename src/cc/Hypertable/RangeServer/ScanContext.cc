@@ -35,6 +35,35 @@ using namespace std;
 using namespace Hypertable;
 
 
+bool CellFilterInfo::parse_integer(const char *value, uint32_t value_len,
+                                   int64_t *result) {
+  const char *ptr = value;
+  const char *end = value + value_len;
+  bool negative = false;
+  uint64_t limit, n = 0;
+
+  if (value == 0 || value_len == 0)
+    return false;
+
+  if (*ptr == '-' || *ptr == '+') {
+    negative = (*ptr == '-');
+    if (++ptr == end)
+      return false;
+  }
+  limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+
+  for (; ptr < end; ++ptr) {
+    if (*ptr < '0' || *ptr > '9')
+      return false;
+    uint64_t digit = *ptr - '0';
+    if (n > (limit - digit) / 10)
+      return false;
+    n = n*10 + digit;
+  }
+  *result = negative ? (int64_t)(0 - n) : (int64_t)n;
+  return true;
+}
+
 const uint8_t* CellFilterInfo::memfind(
   const uint8_t* block,        // Block containing data
   size_t         block_size,   // Size of block in bytes
@@ -109,6 +138,8 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
 
   revision = (rev == TIMESTAMP_NULL) ? TIMESTAMP_MAX : rev;
 
+  resolve_value_refs = true;
+
   // set time interval
   if (ss) {
     time_interval.first = ss->time_interval.first;
@@ -438,8 +469,9 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
           HT_THROW(Error::RANGESERVER_SCHEMA_INVALID_CFID,
                    format("Bad id for column family '%s'", cf->name.c_str()).c_str() );
         }
-        if (cf->counter) {
-          HT_THROW(Error::BAD_SCAN_SPEC, "Counters are not supported for column predicates" );
+        if (cf->counter && !cp.is_comparison()) {
+          HT_THROW(Error::BAD_SCAN_SPEC, "Only comparison predicates are "
+                   "supported for counter columns" );
         }
         family_info[cf->id].add_column_predicate(cp);
       }
@@ -31,6 +31,7 @@
 #include "Common/ByteString.h"
 #include "Common/Error.h"
 #include "Common/ReferenceCount.h"
+#include "Common/Serialization.h"
 #include "Common/StringExt.h"
 
 #include "Hypertable/Lib/Key.h"
@@ -63,6 +64,7 @@ namespace Hypertable {
       }
       prefix_qualifiers = other.prefix_qualifiers;
       column_predicates = other.column_predicates;
+      integer_bounds = other.integer_bounds;
       search_buf_column_predicates = other.search_buf_column_predicates;
       filter_by_exact_qualifier = other.filter_by_exact_qualifier;
       filter_by_prefix_qualifier = other.filter_by_prefix_qualifier;
@@ -140,47 +142,54 @@ namespace Hypertable {
     }
     bool has_qualifier_regexp_filter() const { return filter_by_regexp_qualifier;}
 
+    // Comparison predicates must all hold, so that "v >= 10 AND v <= 20"
+    // selects a range; the other predicates are alternatives of which at
+    // least one has to match
     bool column_predicate_matches(const char* value, uint32_t value_len) {
       int ncp = 0;
+      bool have_alternatives = false;
+      bool alternative_matched = false;
       foreach_ht (const ColumnPredicate& cp, column_predicates) {
-        if (cp.value && value) {
-          switch (cp.operation) {
-            case ColumnPredicate::EXACT_MATCH:
-              if (cp.value_len == value_len &&
-                    memcmp(cp.value, value, cp.value_len) == 0)
-                return true;
-              break;
-            case ColumnPredicate::PREFIX_MATCH:
-              if (cp.value_len <= value_len &&
-                      memcmp(cp.value, value, cp.value_len) == 0)
-                return true;
-              break;
-            case Hypertable::ColumnPredicate::CONTAINS:
-              if (cp.value_len <= value_len) {
-                while (search_buf_column_predicates.size() < column_predicates.size()) {
-                  search_buf_column_predicates.push_back(search_buf_t());
-                }
-                search_buf_t& buf = search_buf_column_predicates[ncp];
-                if (memfind((const uint8_t*)value, value_len, (const uint8_t*)cp.value,
-                      cp.value_len, buf.shift, &buf.repeat) != 0)
-                  return true;
-              }
-              break;
-            default:
-              break;
-          }
+        if (cp.is_comparison()) {
+          if (!value || !comparison_matches(ncp, cp, value, value_len))
+            return false;
+        }
+        else {
+          have_alternatives = true;
+          if (!alternative_matched &&
+              alternative_matches(ncp, cp, value, value_len))
+            alternative_matched = true;
         }
-        else if (!cp.value && !value)
-          return true;
         ++ncp;
       }
-      return false;
+      return !have_alternatives || alternative_matched;
     }
 
     void add_column_predicate( const ColumnPredicate& cp ) {
+      pair<int64_t, int64_t> bounds(0, 0);
+      if (cp.is_comparison()) {
+        bool between =
+          (cp.operation & ColumnPredicate::OPERATION_MASK) == ColumnPredicate::BETWEEN;
+        if (!cp.value || (between && !cp.end_value))
+          HT_THROW(Error::BAD_SCAN_SPEC, (String)"Missing bound in comparison "
+                   "predicate on column " + cp.column_family);
+        if (counter || (cp.operation & ColumnPredicate::INTEGER_COMPARISON)) {
+          if (!parse_integer(cp.value, cp.value_len, &bounds.first) ||
+              (between && !parse_integer(cp.end_value, cp.end_value_len,
+                                         &bounds.second)))
+            HT_THROW(Error::BAD_SCAN_SPEC, (String)"Bad integer bound in "
+                     "comparison predicate on column " + cp.column_family);
+        }
+      }
       column_predicates.push_back( cp );
+      integer_bounds.push_back( bounds );
     }
 
+    // Parses an optionally signed decimal integer spanning the whole value;
+    // returns false if the value is not an integer or overflows 64 bits
+    static bool parse_integer(const char *value, uint32_t value_len,
+                              int64_t *result);
+
     bool has_column_predicate_filter( ) const {
       return !column_predicates.empty();
     }
@@ -201,6 +210,9 @@ namespace Hypertable {
     CstrSet exact_qualifiers_set;
     StringSet prefix_qualifiers;
     std::vector<ColumnPredicate> column_predicates;
+    // Parsed bounds of integer comparison predicates, parallel to
+    // column_predicates
+    std::vector<std::pair<int64_t, int64_t> > integer_bounds;
     struct search_buf_t {
       size_t shift[256];
       bool repeat;
@@ -211,6 +223,86 @@ namespace Hypertable {
     bool filter_by_regexp_qualifier;
     bool filter_by_prefix_qualifier;
 
+    bool alternative_matches(size_t ncp, const ColumnPredicate &cp,
+                             const char *value, uint32_t value_len) {
+      if (cp.value && value) {
+        switch (cp.operation) {
+          case ColumnPredicate::EXACT_MATCH:
+            return cp.value_len == value_len &&
+              memcmp(cp.value, value, cp.value_len) == 0;
+          case ColumnPredicate::PREFIX_MATCH:
+            return cp.value_len <= value_len &&
+              memcmp(cp.value, value, cp.value_len) == 0;
+          case Hypertable::ColumnPredicate::CONTAINS:
+            if (cp.value_len <= value_len) {
+              while (search_buf_column_predicates.size() < column_predicates.size()) {
+                search_buf_column_predicates.push_back(search_buf_t());
+              }
+              search_buf_t& buf = search_buf_column_predicates[ncp];
+              return memfind((const uint8_t*)value, value_len, (const uint8_t*)cp.value,
+                             cp.value_len, buf.shift, &buf.repeat) != 0;
+            }
+            return false;
+          default:
+            return false;
+        }
+      }
+      return !cp.value && !value;
+    }
+
+    bool comparison_matches(size_t ncp, const ColumnPredicate &cp,
+                            const char *value, uint32_t value_len) {
+      uint32_t op = cp.operation & ColumnPredicate::OPERATION_MASK;
+      int cmp_lo, cmp_hi = 0;
+
+      if (counter || (cp.operation & ColumnPredicate::INTEGER_COMPARISON)) {
+        int64_t v;
+        if (counter) {
+          // aggregated counter values are encoded 64 bit ints
+          if (value_len < 8)
+            return false;
+          const uint8_t *ptr = (const uint8_t *)value;
+          size_t remain = 8;
+          v = Serialization::decode_i64(&ptr, &remain);
+        }
+        else if (!parse_integer(value, value_len, &v))
+          return false;
+        const pair<int64_t, int64_t> &bounds = integer_bounds[ncp];
+        cmp_lo = (v < bounds.first) ? -1 : ((v > bounds.first) ? 1 : 0);
+        cmp_hi = (v < bounds.second) ? -1 : ((v > bounds.second) ? 1 : 0);
+      }
+      else {
+        cmp_lo = compare_values(value, value_len, cp.value, cp.value_len);
+        if (op == ColumnPredicate::BETWEEN)
+          cmp_hi = compare_values(value, value_len, cp.end_value,
+                                  cp.end_value_len);
+      }
+
+      switch (op) {
+        case ColumnPredicate::LESS_THAN:
+          return cmp_lo < 0;
+        case ColumnPredicate::LESS_OR_EQUAL:
+          return cmp_lo <= 0;
+        case ColumnPredicate::GREATER_THAN:
+          return cmp_lo > 0;
+        case ColumnPredicate::GREATER_OR_EQUAL:
+          return cmp_lo >= 0;
+        case ColumnPredicate::BETWEEN:
+          return cmp_lo >= 0 && cmp_hi <= 0;
+        default:
+          break;
+      }
+      return false;
+    }
+
+    static int compare_values(const char *a, uint32_t a_len,
+                              const char *b, uint32_t b_len) {
+      int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+      if (cmp == 0)
+        return (a_len < b_len) ? -1 : ((a_len > b_len) ? 1 : 0);
+      return cmp;
+    }
+
     // Searches for a pattern in a block of memory using the Boyer- Moore-Horspool-Sunday algorithm
     static const uint8_t* memfind(
       const uint8_t* block,        // Block containing data
@@ -249,6 +341,9 @@ namespace Hypertable {
     RE2 *value_regexp;
     typedef std::set<const char *, LtCstr, CstrAlloc> CstrRowSet;
     CstrRowSet rowset;
+    /** If false, CellStore scanners return value log references as is
+     * instead of reading the values they point to */
+    bool resolve_value_refs;
 
     /**
      * Constructor.
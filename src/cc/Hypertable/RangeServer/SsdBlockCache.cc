@@ -0,0 +1,216 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+
+extern "C" {
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+}
+
+#include "SsdBlockCache.h"
+
+using namespace Hypertable;
+
+SsdBlockCache::SsdBlockCache(const String &directory, int64_t capacity,
+                             int64_t write_buffer)
+  : m_fd(-1), m_capacity(capacity), m_write_buffer(write_buffer),
+    m_pending_bytes(0), m_head(0), m_used(0), m_accesses(0), m_hits(0),
+    m_shutdown(false), m_writer(0) {
+
+  if (!FileUtils::exists(directory) && !FileUtils::mkdirs(directory))
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to create block cache directory "
+              "'%s'", directory.c_str());
+
+  m_filename = format("%s/blockcache.%d", directory.c_str(), (int)getpid());
+
+  if ((m_fd = ::open(m_filename.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644)) < 0)
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to open block cache file '%s' "
+              "- %s", m_filename.c_str(), strerror(errno));
+
+  // Nothing in the file is meaningful after a restart
+  FileUtils::unlink(m_filename);
+
+  m_writer = new Thread(Writer(this));
+
+  HT_INFOF("SSD block cache %s, capacity=%lld", m_filename.c_str(),
+           (Lld)m_capacity);
+}
+
+
+SsdBlockCache::~SsdBlockCache() {
+  {
+    ScopedLock lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+  }
+  m_writer->join();
+  delete m_writer;
+  foreach_ht (PendingMap::value_type &v, m_pending)
+    delete [] v.second.block;
+  ::close(m_fd);
+}
+
+
+/**
+ * The file region is read without holding the lock.  The writer removes a
+ * block from the index before overwriting its region, so if the block is
+ * still in the index after the read, the data read was not overwritten.
+ */
+bool SsdBlockCache::read(int file_id, uint64_t file_offset, uint8_t *buf,
+                         uint32_t length) {
+  Key key(file_id, file_offset);
+  Location location;
+
+  {
+    ScopedLock lock(m_mutex);
+    m_accesses++;
+
+    PendingMap::iterator pending_iter = m_pending.find(key);
+    if (pending_iter != m_pending.end()) {
+      if (pending_iter->second.length != length)
+        return false;
+      memcpy(buf, pending_iter->second.block, length);
+      m_hits++;
+      return true;
+    }
+
+    LocationMap::iterator iter = m_locations.find(key);
+    if (iter == m_locations.end() || iter->second.length != length)
+      return false;
+    location = iter->second;
+  }
+
+  ssize_t nread = FileUtils::pread(m_fd, buf, length, location.offset);
+  if (nread != (ssize_t)length) {
+    HT_WARNF("Short read from block cache file %s (offset=%llu, length=%u)",
+             m_filename.c_str(), (Llu)location.offset, (unsigned)length);
+    return false;
+  }
+
+  ScopedLock lock(m_mutex);
+  LocationMap::iterator iter = m_locations.find(key);
+  if (iter == m_locations.end() || iter->second.offset != location.offset)
+    return false;
+  m_hits++;
+  return true;
+}
+
+
+void SsdBlockCache::insert(int file_id, uint64_t file_offset,
+                           const uint8_t *block, uint32_t length) {
+  Key key(file_id, file_offset);
+
+  if ((int64_t)length > m_capacity)
+    return;
+
+  ScopedLock lock(m_mutex);
+
+  if (m_shutdown || m_pending_bytes + length > m_write_buffer ||
+      m_pending.count(key) || m_locations.count(key))
+    return;
+
+  PendingBlock pending;
+  pending.key = key;
+  pending.block = new uint8_t [length];
+  pending.length = length;
+  memcpy(pending.block, block, length);
+
+  m_pending[key] = pending;
+  m_write_queue.push_back(key);
+  m_pending_bytes += length;
+  m_cond.notify_one();
+}
+
+
+void SsdBlockCache::write_loop() {
+  PendingBlock pending;
+  uint64_t offset;
+
+  while (true) {
+
+    {
+      ScopedLock lock(m_mutex);
+
+      while (m_write_queue.empty() && !m_shutdown)
+        m_cond.wait(lock);
+
+      if (m_shutdown)
+        return;
+
+      pending = m_pending[m_write_queue.front()];
+      m_write_queue.pop_front();
+
+      // Wrap to the start of the file and evict whatever the block will
+      // overwrite
+      if (m_head + pending.length > (uint64_t)m_capacity)
+        m_head = 0;
+      offset = m_head;
+      m_head += pending.length;
+
+      OffsetMap::iterator iter = m_offsets.lower_bound(offset);
+      while (iter != m_offsets.end() && iter->first < m_head) {
+        LocationMap::iterator loc_iter = m_locations.find(iter->second);
+        m_used -= loc_iter->second.length;
+        m_locations.erase(loc_iter);
+        m_offsets.erase(iter++);
+      }
+    }
+
+    bool written = FileUtils::pwrite(m_fd, pending.block, pending.length,
+                                     offset) == (ssize_t)pending.length;
+    if (!written)
+      HT_WARNF("Problem writing %u bytes to block cache file %s at offset "
+               "%llu", (unsigned)pending.length, m_filename.c_str(),
+               (Llu)offset);
+
+    {
+      ScopedLock lock(m_mutex);
+      if (written) {
+        Location location;
+        location.offset = offset;
+        location.length = pending.length;
+        m_locations[pending.key] = location;
+        m_offsets[offset] = pending.key;
+        m_used += pending.length;
+      }
+      m_pending.erase(pending.key);
+      m_pending_bytes -= pending.length;
+    }
+
+    delete [] pending.block;
+  }
+}
+
+
+void SsdBlockCache::get_stats(uint64_t *capacityp, uint64_t *usedp,
+                              uint64_t *accessesp, uint64_t *hitsp) {
+  ScopedLock lock(m_mutex);
+  *capacityp = m_capacity;
+  *usedp = m_used;
+  *accessesp = m_accesses;
+  *hitsp = m_hits;
+}
@@ -0,0 +1,145 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_SSDBLOCKCACHE_H
+#define HYPERTABLE_SSDBLOCKCACHE_H
+
+#include <deque>
+#include <map>
+
+#include <boost/thread/condition.hpp>
+
+#include "Common/HashMap.h"
+#include "Common/Mutex.h"
+#include "Common/String.h"
+#include "Common/Thread.h"
+
+namespace Hypertable {
+
+  /**
+   * Second cache tier for compressed CellStore blocks, kept in a file on a
+   * local disk (typically SSD).  Blocks are written to the file as a
+   * circular log and evicted oldest first when the log wraps over them.
+   * The index of cached blocks lives in memory and the file is unlinked as
+   * soon as it is opened, so the cache does not survive a restart.
+   *
+   * Inserts are copied into a bounded write buffer and written by a
+   * background thread, so the scan path never waits on the local disk for
+   * a write.  Blocks still in the write buffer are served from memory.
+   */
+  class SsdBlockCache {
+  public:
+    /**
+     * @param directory directory in which to create the cache file
+     * @param capacity maximum size of the cache file
+     * @param write_buffer maximum number of bytes waiting to be written
+     */
+    SsdBlockCache(const String &directory, int64_t capacity,
+                  int64_t write_buffer);
+    ~SsdBlockCache();
+
+    /** Reads a cached block.
+     * @param file_id CellStore file id (see FileBlockCache::get_next_file_id)
+     * @param file_offset offset of the block within the CellStore
+     * @param buf buffer to receive the block
+     * @param length expected length of the block
+     * @return true if the block was found and read into buf
+     */
+    bool read(int file_id, uint64_t file_offset, uint8_t *buf, uint32_t length);
+
+    /** Queues a copy of a block to be written to the cache.  The block is
+     * dropped if it is already cached or the write buffer is full.
+     */
+    void insert(int file_id, uint64_t file_offset, const uint8_t *block,
+                uint32_t length);
+
+    void get_stats(uint64_t *capacityp, uint64_t *usedp,
+                   uint64_t *accessesp, uint64_t *hitsp);
+
+  private:
+
+    class Writer {
+    public:
+      Writer(SsdBlockCache *cache) : m_cache(cache) { }
+      void operator()() { m_cache->write_loop(); }
+    private:
+      SsdBlockCache *m_cache;
+    };
+
+    void write_loop();
+
+    /** Identifies a block by CellStore file id and full 64-bit offset, so
+     * blocks beyond 4GB in a file never share a key.
+     */
+    struct Key {
+      Key() : file_id(-1), file_offset(0) { }
+      Key(int id, uint64_t offset) : file_id(id), file_offset(offset) { }
+      bool operator==(const Key &other) const {
+        return file_id == other.file_id && file_offset == other.file_offset;
+      }
+      int      file_id;
+      uint64_t file_offset;
+    };
+
+    struct KeyHash {
+      size_t operator()(const Key &k) const {
+        uint64_t h = k.file_offset ^ ((uint64_t)(uint32_t)k.file_id << 32);
+        return (size_t)(h ^ (h >> 32));
+      }
+    };
+
+    struct Location {
+      uint64_t offset;
+      uint32_t length;
+    };
+
+    struct PendingBlock {
+      Key      key;
+      uint8_t *block;
+      uint32_t length;
+    };
+
+    typedef hash_map<Key, Location, KeyHash> LocationMap;
+    typedef std::map<uint64_t, Key> OffsetMap;
+    typedef hash_map<Key, PendingBlock, KeyHash> PendingMap;
+
+    Mutex             m_mutex;
+    boost::condition  m_cond;
+    int               m_fd;
+    String            m_filename;
+    int64_t           m_capacity;
+    int64_t           m_write_buffer;
+    int64_t           m_pending_bytes;
+    uint64_t          m_head;
+    uint64_t          m_used;
+    uint64_t          m_accesses;
+    uint64_t          m_hits;
+    LocationMap       m_locations;
+    OffsetMap         m_offsets;
+    PendingMap        m_pending;
+    std::deque<Key>   m_write_queue;
+    bool              m_shutdown;
+    Thread           *m_writer;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_SSDBLOCKCACHE_H
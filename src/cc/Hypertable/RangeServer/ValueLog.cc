@@ -0,0 +1,317 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Checksum.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/Serialization.h"
+#include "Common/StaticBuffer.h"
+
+#include "Global.h"
+#include "ValueLog.h"
+
+using namespace Hypertable;
+
+namespace {
+  const size_t FLUSH_SIZE = 1048576;
+}
+
+void
+ValueLogReference::encode(DynamicBuffer &buf, const String &fname,
+                          uint64_t offset, uint32_t length,
+                          uint32_t checksum) {
+  size_t payload_len = Serialization::encoded_length_vi64(offset) +
+    Serialization::encoded_length_vi32(length) + 4 +
+    Serialization::encoded_length_vstr(fname);
+
+  buf.clear();
+  buf.ensure(HEADER_LENGTH + payload_len);
+
+  // Padded length prefix, see class description
+  for (int i=0; i<4; i++)
+    *buf.ptr++ = (uint8_t)(((payload_len >> (7*i)) & 0x7f) | 0x80);
+  *buf.ptr++ = 0;
+
+  Serialization::encode_vi64(&buf.ptr, offset);
+  Serialization::encode_vi32(&buf.ptr, length);
+  Serialization::encode_i32(&buf.ptr, checksum);
+  Serialization::encode_vstr(&buf.ptr, fname);
+}
+
+void ValueLogReference::decode(const ByteString &value) {
+  const uint8_t *ptr;
+  size_t remaining = value.decode_length(&ptr);
+
+  if (ptr - value.ptr != HEADER_LENGTH)
+    HT_THROW(Error::RANGESERVER_CORRUPT_CELLSTORE,
+             "Bad value log reference header");
+
+  offset = Serialization::decode_vi64(&ptr, &remaining);
+  length = Serialization::decode_vi32(&ptr, &remaining);
+  checksum = Serialization::decode_i32(&ptr, &remaining);
+  fname = Serialization::decode_vstr(&ptr, &remaining, &fname_len);
+
+  if (!valid_name(fname, fname_len))
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Bad value log name "
+              "'%s' in reference", String(fname, fname_len).c_str());
+}
+
+/**
+ * Names are written by ValueLogWriter relative to the tables directory and
+ * always end in a file named vlog<n>.  Anything else, in particular an
+ * absolute name or one with a ".." component, cannot have come from a
+ * compaction.
+ */
+bool ValueLogReference::valid_name(const char *name, size_t len) {
+  if (len == 0 || name[0] == '/' || memchr(name, 0, len))
+    return false;
+  const char *end = name + len;
+  const char *base = name;
+  for (const char *ptr = name; ptr <= end; ptr++) {
+    if (ptr == end || *ptr == '/') {
+      if (ptr == base || (ptr - base == 2 && !strncmp(base, "..", 2)) ||
+          (ptr - base == 1 && *base == '.'))
+        return false;
+      if (ptr == end)
+        break;
+      base = ptr + 1;
+    }
+  }
+  return end - base > 4 && !strncmp(base, "vlog", 4);
+}
+
+
+ValueLogWriter::ValueLogWriter(Filesystem *filesys, const String &fname,
+                               int32_t replication)
+  : m_filesys(filesys), m_filename(fname), m_replication(replication),
+    m_fd(-1), m_offset(0) {
+  String prefix = Global::toplevel_dir + "/tables/";
+  HT_ASSERT(!strncmp(fname.c_str(), prefix.c_str(), prefix.length()));
+  m_relative_name = fname.substr(prefix.length());
+}
+
+ValueLogWriter::~ValueLogWriter() {
+  if (m_fd != -1) {
+    try {
+      m_filesys->close(m_fd);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << "Problem closing value log " << m_filename << " - "
+                   << e << HT_END;
+    }
+  }
+}
+
+ByteString ValueLogWriter::add(const ByteString value) {
+  const uint8_t *data;
+  uint32_t len = value.decode_length(&data);
+
+  if (m_fd == -1)
+    m_fd = m_filesys->create(m_filename, Filesystem::OPEN_FLAG_OVERWRITE,
+                             -1, m_replication, -1);
+
+  ValueLogReference::encode(m_ref_buf, m_relative_name, m_offset, len,
+                            crc32c(data, len));
+
+  m_buf.add(data, len);
+  m_offset += len;
+
+  if (m_buf.fill() >= FLUSH_SIZE)
+    flush(0);
+
+  return ByteString(m_ref_buf.base);
+}
+
+void ValueLogWriter::close() {
+  if (m_fd == -1)
+    return;
+  flush(Filesystem::O_FLUSH);
+  m_filesys->close(m_fd);
+  m_fd = -1;
+}
+
+void ValueLogWriter::flush(uint32_t flags) {
+  if (m_buf.fill() == 0)
+    return;
+  StaticBuffer send_buf(m_buf);
+  m_filesys->append(m_fd, send_buf, flags);
+}
+
+
+ValueLogReader::ValueLogReader(Filesystem *filesys, size_t max_open_files)
+  : m_filesys(filesys), m_max_open_files(max_open_files) {
+}
+
+ValueLogReader::~ValueLogReader() {
+  foreach_ht(OpenFileMap::value_type &v, m_files) {
+    try {
+      m_filesys->close(v.second.fd);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << "Problem closing value log " << v.first << " - "
+                   << e << HT_END;
+    }
+  }
+}
+
+void ValueLogReader::read(const ByteString reference, DynamicBuffer &dst,
+                          ByteString &value) {
+  ValueLogReference ref;
+  ref.decode(reference);
+  String fname(ref.fname, ref.fname_len);
+
+  dst.clear();
+  dst.ensure(Serialization::encoded_length_vi32(ref.length) + ref.length);
+  Serialization::encode_vi32(&dst.ptr, ref.length);
+
+  int fd = acquire(fname);
+  size_t nread;
+  try {
+    nread = m_filesys->pread(fd, dst.ptr, ref.length, ref.offset);
+  }
+  catch (Exception &e) {
+    release(fname);
+    HT_THROW2F(e.code(), e, "Problem reading value log %s", fname.c_str());
+  }
+  release(fname);
+
+  if (nread != ref.length)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Short read of value log "
+              "%s at offset %llu (%u of %u bytes)", fname.c_str(),
+              (Llu)ref.offset, (unsigned)nread, (unsigned)ref.length);
+
+  if (crc32c(dst.ptr, ref.length) != ref.checksum)
+    HT_THROWF(Error::CHECKSUM_MISMATCH, "Value log %s offset %llu",
+              fname.c_str(), (Llu)ref.offset);
+
+  dst.ptr += ref.length;
+  value.ptr = dst.base;
+}
+
+int ValueLogReader::acquire(const String &fname) {
+  ScopedLock lock(m_mutex);
+  OpenFileMap::iterator iter = m_files.find(fname);
+  if (iter == m_files.end()) {
+    OpenFile of;
+    of.fd = m_filesys->open(Global::toplevel_dir + "/tables/" + fname, 0);
+    iter = m_files.insert(OpenFileMap::value_type(fname, of)).first;
+  }
+  iter->second.refs++;
+  return iter->second.fd;
+}
+
+/**
+ * Once more than the maximum number of files are open, files without
+ * readers are closed.
+ */
+void ValueLogReader::release(const String &fname) {
+  ScopedLock lock(m_mutex);
+  OpenFileMap::iterator iter = m_files.find(fname);
+  HT_ASSERT(iter != m_files.end() && iter->second.refs > 0);
+  iter->second.refs--;
+
+  if (m_files.size() <= m_max_open_files)
+    return;
+
+  for (iter = m_files.begin(); iter != m_files.end(); ) {
+    if (iter->second.refs == 0) {
+      try {
+        m_filesys->close(iter->second.fd);
+      }
+      catch (Exception &e) {
+        HT_ERROR_OUT << "Problem closing value log " << iter->first << " - "
+                     << e << HT_END;
+      }
+      m_files.erase(iter++);
+    }
+    else
+      ++iter;
+  }
+}
+
+
+void ValueLogCompactor::process(const Key &key, bool counter,
+                                ByteString &value) {
+  if (ValueLogReference::is_reference(value)) {
+    m_ref.decode(value);
+    String fname = Global::toplevel_dir + "/tables/" +
+      String(m_ref.fname, m_ref.fname_len);
+    if (m_rewrite.count(fname) == 0) {
+      m_live_bytes[fname] += m_ref.length;
+      return;
+    }
+    m_reader->read(value, m_buf, value);
+  }
+  if (m_writer && key.flag == FLAG_INSERT && !counter) {
+    const uint8_t *data;
+    if (value.decode_length(&data) >= m_threshold)
+      value = m_writer->add(value);
+  }
+}
+
+
+void ValueLogSet::load(const String &fname, uint64_t size) {
+  m_logs[fname] = Info(size, false);
+}
+
+void ValueLogSet::add(const String &fname, uint64_t size) {
+  m_logs[fname] = Info(size, true);
+}
+
+void ValueLogSet::get_rewrite_candidates(std::set<String> &logs) const {
+  foreach_ht (const InfoMap::value_type &v, m_logs) {
+    if (v.second.measured && v.second.live_bytes < v.second.size / 2)
+      logs.insert(v.first);
+  }
+}
+
+void ValueLogSet::set_live_bytes(const std::map<String, uint64_t> &live,
+                                 std::vector<String> &removed) {
+  std::map<String, uint64_t>::const_iterator live_iter;
+  for (InfoMap::iterator iter = m_logs.begin(); iter != m_logs.end(); ) {
+    if ((live_iter = live.find(iter->first)) == live.end()) {
+      removed.push_back(iter->first);
+      m_logs.erase(iter++);
+    }
+    else {
+      iter->second.live_bytes = live_iter->second;
+      iter->second.measured = true;
+      ++iter;
+    }
+  }
+}
+
+uint64_t ValueLogSet::disk_usage(double share) const {
+  uint64_t usage = 0;
+  foreach_ht (const InfoMap::value_type &v, m_logs) {
+    if (v.second.measured)
+      usage += v.second.live_bytes;
+    else
+      usage += (uint64_t)((double)v.second.size * share);
+  }
+  return usage;
+}
+
+void ValueLogSet::get_files(std::vector<String> &files) const {
+  foreach_ht (const InfoMap::value_type &v, m_logs)
+    files.push_back(v.first);
+}
@@ -0,0 +1,285 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_VALUELOG_H
+#define HYPERTABLE_VALUELOG_H
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Filesystem.h"
+#include "Common/HashMap.h"
+#include "Common/Mutex.h"
+#include "Common/ReferenceCount.h"
+#include "Common/String.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Hypertable {
+
+  /**
+   * Reference to a value that has been moved out of a CellStore and into
+   * a value log file.  A reference is stored in place of the value as a
+   * ByteString whose vint length prefix is padded to five bytes.  Normal
+   * values always use the minimal length encoding and no value is large
+   * enough to need five bytes, so the padding identifies references
+   * without any change to the key or CellStore format.  The reference
+   * payload holds the file offset, length and crc32c of the value and the
+   * name of the value log relative to the toplevel tables directory.
+   */
+  class ValueLogReference {
+  public:
+    enum { HEADER_LENGTH = 5 };
+
+    static bool is_reference(const uint8_t *ptr) {
+      return ptr && (ptr[0] & 0x80) && (ptr[1] & 0x80) && (ptr[2] & 0x80) &&
+        (ptr[3] & 0x80) && ptr[4] == 0;
+    }
+
+    static bool is_reference(const ByteString &value) {
+      return is_reference(value.ptr);
+    }
+
+    /** Encodes a reference into <code>buf</code>, replacing its contents
+     *
+     * @param buf destination buffer
+     * @param fname value log name relative to the tables directory
+     * @param offset offset of the value within the value log
+     * @param length length of the value
+     * @param checksum crc32c of the value
+     */
+    static void encode(DynamicBuffer &buf, const String &fname,
+                       uint64_t offset, uint32_t length, uint32_t checksum);
+
+    /** Decodes the reference stored in <code>value</code>.  The file name
+     * points into the value.  Throws RANGESERVER_CORRUPT_CELLSTORE if the
+     * reference is malformed or names something other than a value log.
+     */
+    void decode(const ByteString &value);
+
+    /** Returns true if <code>name</code> is a well-formed value log name
+     * relative to the tables directory.
+     */
+    static bool valid_name(const char *name, size_t len);
+
+    const char *fname;
+    uint32_t fname_len;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t checksum;
+  };
+
+  /**
+   * Writes the large values of one compaction to an append-only value log
+   * file.  The file is created on the first add() and must be closed before
+   * a CellStore holding references into it is installed.
+   */
+  class ValueLogWriter : public ReferenceCount {
+  public:
+    ValueLogWriter(Filesystem *filesys, const String &fname,
+                   int32_t replication=-1);
+    virtual ~ValueLogWriter();
+
+    /** Appends a value to the log.
+     *
+     * @param value value to append
+     * @return reference to the value, valid until the next call
+     */
+    ByteString add(const ByteString value);
+
+    /** Flushes outstanding data and closes the file */
+    void close();
+
+    /** Returns the absolute name of the value log */
+    const String &get_filename() const { return m_filename; }
+
+    /** Returns true if any values have been written */
+    bool empty() const { return m_offset == 0; }
+
+    /** Returns the number of bytes written */
+    uint64_t size() const { return m_offset; }
+
+  private:
+    void flush(uint32_t flags);
+
+    Filesystem   *m_filesys;
+    String        m_filename;
+    String        m_relative_name;
+    int32_t       m_replication;
+    int           m_fd;
+    uint64_t      m_offset;
+    DynamicBuffer m_buf;
+    DynamicBuffer m_ref_buf;
+  };
+  typedef intrusive_ptr<ValueLogWriter> ValueLogWriterPtr;
+
+  /**
+   * Resolves value log references at scan time.  File descriptors are
+   * cached and shared by all scanners of the RangeServer.
+   */
+  class ValueLogReader {
+  public:
+    ValueLogReader(Filesystem *filesys, size_t max_open_files);
+    ~ValueLogReader();
+
+    /** Reads the value a reference points to.
+     *
+     * @param reference value log reference
+     * @param dst buffer to hold the value
+     * @param value set to the value, encoded as a ByteString in dst
+     */
+    void read(const ByteString reference, DynamicBuffer &dst,
+              ByteString &value);
+
+  private:
+    struct OpenFile {
+      OpenFile() : fd(-1), refs(0) { }
+      int fd;
+      uint32_t refs;
+    };
+    typedef hash_map<String, OpenFile> OpenFileMap;
+
+    int acquire(const String &fname);
+    void release(const String &fname);
+
+    Mutex        m_mutex;
+    Filesystem  *m_filesys;
+    size_t       m_max_open_files;
+    OpenFileMap  m_files;
+  };
+
+  /**
+   * Value log handling for the cells of one compaction.  Large inserted
+   * values are moved to the new value log, references into logs being
+   * rewritten are resolved so their values get copied, and the bytes still
+   * referenced in every other log are tallied.
+   */
+  class ValueLogCompactor {
+  public:
+    /**
+     * @param reader reader used to resolve references into rewritten logs
+     * @param writer value log of the compaction, or 0 if values stay inline
+     * @param threshold minimum length of a value moved to the value log
+     * @param rewrite absolute names of the logs to rewrite
+     */
+    ValueLogCompactor(ValueLogReader *reader, ValueLogWriter *writer,
+                      uint32_t threshold, const std::set<String> &rewrite)
+      : m_reader(reader), m_writer(writer), m_threshold(threshold),
+        m_rewrite(rewrite) { }
+
+    /** Replaces <code>value</code> with what the new CellStore should hold
+     * for the cell.  The result is valid until the next call.
+     *
+     * @param key key of the cell
+     * @param counter true if the cell belongs to a counter column
+     * @param value value of the cell
+     */
+    void process(const Key &key, bool counter, ByteString &value);
+
+    /** Returns the bytes referenced per absolute log name */
+    const std::map<String, uint64_t> &live_bytes() const {
+      return m_live_bytes;
+    }
+
+  private:
+    ValueLogReader   *m_reader;
+    ValueLogWriter   *m_writer;
+    uint32_t          m_threshold;
+    std::set<String>  m_rewrite;
+    std::map<String, uint64_t> m_live_bytes;
+    ValueLogReference m_ref;
+    DynamicBuffer     m_buf;
+  };
+
+  /**
+   * The value logs of an access group and how much of each is still
+   * referenced by the range.  Logs loaded from METADATA may be shared with
+   * the other half of a split, so until the next full compaction measures
+   * the references, a loaded log is charged to the range in proportion to
+   * the range's share of its CellStore files.  Logs written by compactions
+   * of this range are entirely live.
+   */
+  class ValueLogSet {
+  public:
+    /** Adds a value log listed in the METADATA Files column.
+     *
+     * @param fname absolute name of the value log
+     * @param size file size
+     */
+    void load(const String &fname, uint64_t size);
+
+    /** Adds a value log written by a compaction of this range.
+     *
+     * @param fname absolute name of the value log
+     * @param size file size
+     */
+    void add(const String &fname, uint64_t size);
+
+    /** Returns the logs that were more than half garbage at the previous
+     * full compaction.  Their live values are copied by the next one so the
+     * logs can be dropped.
+     *
+     * @param logs set to receive the absolute log names
+     */
+    void get_rewrite_candidates(std::set<String> &logs) const;
+
+    /** Records the references seen by a compaction of all CellStores.
+     * Logs without any reference are removed.
+     *
+     * @param live bytes referenced per absolute log name
+     * @param removed vector to which the names of removed logs are appended
+     */
+    void set_live_bytes(const std::map<String, uint64_t> &live,
+                        std::vector<String> &removed);
+
+    /** Returns the bytes charged to the range.
+     *
+     * @param share fraction of its CellStore files that the range covers,
+     *        applied to logs whose live bytes have not been measured
+     */
+    uint64_t disk_usage(double share) const;
+
+    /** Appends the absolute names of all logs to <code>files</code> */
+    void get_files(std::vector<String> &files) const;
+
+    bool empty() const { return m_logs.empty(); }
+
+  private:
+    struct Info {
+      Info(uint64_t sz=0, bool m=true)
+        : size(sz), live_bytes(sz), measured(m) { }
+      uint64_t size;
+      // Referenced bytes as of the last compaction of all cell stores
+      uint64_t live_bytes;
+      // False until a compaction of all cell stores has counted references
+      bool measured;
+    };
+    typedef std::map<String, Info> InfoMap;
+
+    InfoMap m_logs;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_VALUELOG_H
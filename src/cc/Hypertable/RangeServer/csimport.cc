@@ -0,0 +1,366 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <boost/algorithm/string.hpp>
+
+#include "AsyncComm/Comm.h"
+#include "AsyncComm/ConnectionManager.h"
+
+#include "Common/Init.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+#include "Common/System.h"
+#include "Common/Time.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/Client.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/LoadDataSource.h"
+#include "Hypertable/Lib/LoadDataSourceFactory.h"
+#include "Hypertable/Lib/RangeServerClient.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "Config.h"
+#include "CellStoreV6.h"
+#include "Global.h"
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  struct AppPolicy : Config::Policy {
+    static void init_options() {
+      cmdline_desc("Usage: %s [options] <table> <input-file>\n\n"
+        "Builds CellStores directly from the row-sorted TSV file <input-file>,\n"
+        "splitting them at the range boundaries of <table>, and attaches\n"
+        "them to the live ranges.  Cells bypass the commit log and the cell\n"
+        "cache.  Rows in the input must be in ascending order; cells within\n"
+        "a row may appear in any order.\n\nOptions").add_options()
+        ("namespace", str()->default_value("/"),
+         "Namespace in which <table> resides")
+        ("staging-dir", str(),
+         "DFS directory in which CellStores are built (default is "
+         "<toplevel>/tmp/csimport/<table-id>/<pid>)")
+        ("max-entries", i64()->default_value(1000000),
+         "Expected number of cells per range, used to size bloom filters")
+        ("dry-run", "Build the CellStores but do not import them")
+        ("verbose,v", "Show per-range progress")
+        ;
+      cmdline_hidden_desc().add_options()
+        ("table", str(), "")
+        ("input-file", str(), "");
+      cmdline_positional_desc().add("table", 1).add("input-file", 1);
+    }
+    static void init() {
+      if (!has("table") || !has("input-file")) {
+        HT_ERROR_OUT << "table and input-file required" << HT_END;
+        cout << cmdline_desc() << endl;
+        exit(1);
+      }
+    }
+  };
+
+  typedef Meta::list<AppPolicy, DfsClientPolicy, DefaultCommPolicy> Policies;
+
+  typedef std::map<String, CellStorePtr> CellStoreMapT;
+
+  /** A cell of the row being buffered; offset locates its serialized
+   * key (followed by the value) in the row buffer.
+   */
+  struct RowCell {
+    RowCell(size_t o, const String *a) : offset(o), ag(a) { }
+    size_t offset;
+    const String *ag;
+  };
+
+  /** Orders buffered cells by serialized key. */
+  struct RowCellLt {
+    RowCellLt(DynamicBuffer &buf) : base(buf.base) { }
+    bool operator()(const RowCell &c1, const RowCell &c2) const {
+      return SerializedKey(base + c1.offset) < SerializedKey(base + c2.offset);
+    }
+    const uint8_t *base;
+  };
+
+  /**
+   * Writes one CellStore per access group for the range currently being
+   * filled, and hands them to the owning RangeServer once the input moves
+   * past the range's end row.
+   */
+  class RangeWriter {
+  public:
+    RangeWriter(SchemaPtr &schema, TableIdentifier *table_id,
+                const String &staging_dir, int64_t max_entries)
+      : m_schema(schema), m_table_id(table_id), m_staging_dir(staging_dir),
+        m_max_entries(max_entries), m_split(0), m_ordinal(0),
+        m_rsclient(0), m_total_cells(0), m_total_files(0) { }
+
+    void start(const TableSplit *split) {
+      HT_ASSERT(m_stores.empty());
+      m_split = split;
+      m_ordinal++;
+    }
+
+    void add(const String &ag_name, const Key &key, const ByteString value) {
+      CellStoreMapT::iterator iter = m_stores.find(ag_name);
+      if (iter == m_stores.end()) {
+        Schema::AccessGroup *ag = m_schema->get_access_group(ag_name);
+        PropertiesPtr props = new Properties();
+        props->set("compressor", ag->compressor.size() ?
+                   ag->compressor : m_schema->get_compressor());
+        props->set("blocksize", ag->blocksize);
+        if (ag->replication != -1)
+          props->set("replication", (int32_t)ag->replication);
+        if (ag->bloom_filter.size())
+          Schema::parse_bloom_filter(ag->bloom_filter, props);
+        else
+          Schema::parse_bloom_filter(Config::get_str("Hypertable.RangeServer"
+              ".CellStore.DefaultBloomFilter"), props);
+        String fname = format("%s/r%u-%s", m_staging_dir.c_str(),
+                              (unsigned)m_ordinal, ag_name.c_str());
+        CellStorePtr cs = new CellStoreV6(Global::dfs.get(), m_schema.get());
+        cs->create(fname.c_str(), m_max_entries, props, m_table_id);
+        iter = m_stores.insert(CellStoreMapT::value_type(ag_name, cs)).first;
+      }
+      iter->second->add(key, value);
+      m_total_cells++;
+    }
+
+    void finish(bool dry_run, bool verbose) {
+      if (m_stores.empty())
+        return;
+
+      RangeSpec range(m_split->start_row, m_split->end_row);
+      CommAddress addr;
+      addr.set_proxy(m_split->location);
+
+      foreach_ht (CellStoreMapT::value_type &v, m_stores) {
+        v.second->finalize(m_table_id);
+        std::vector<String> files(1, v.second->get_filename());
+        m_total_files++;
+        if (verbose)
+          cout << "Built " << files[0] << " (" << v.second->get_total_entries()
+               << " cells) for " << m_table_id->id << "[" << range.start_row
+               << ".." << range.end_row << "]" << endl;
+        if (!dry_run) {
+          // The server moves the staged file into the range directory; on
+          // failure it is moved back and left in the staging directory
+          m_rsclient->import_cellstores(addr, *m_table_id, range, v.first,
+                                        files);
+        }
+      }
+      m_stores.clear();
+    }
+
+    void set_client(RangeServerClient *rsclient) { m_rsclient = rsclient; }
+
+    int64_t total_cells() const { return m_total_cells; }
+    int64_t total_files() const { return m_total_files; }
+
+  private:
+    SchemaPtr m_schema;
+    TableIdentifier *m_table_id;
+    String m_staging_dir;
+    int64_t m_max_entries;
+    const TableSplit *m_split;
+    uint32_t m_ordinal;
+    CellStoreMapT m_stores;
+    RangeServerClient *m_rsclient;
+    int64_t m_total_cells;
+    int64_t m_total_files;
+  };
+
+} // local namespace
+
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    int timeout = get_i32("timeout");
+    String ns_name = get_str("namespace");
+    String table_name = get_str("table");
+    String input_file = get_str("input-file");
+    bool dry_run = has("dry-run");
+    bool verbose = has("verbose");
+
+    ConnectionManagerPtr conn_mgr = new ConnectionManager();
+    DfsBroker::ClientPtr dfs = new DfsBroker::Client(conn_mgr, properties);
+
+    if (!dfs->wait_for_connection(timeout)) {
+      cerr << "error: timed out waiting for DFS broker" << endl;
+      exit(1);
+    }
+
+    Global::dfs = dfs;
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    Global::toplevel_dir = properties->get_str("Hypertable.Directory");
+    boost::trim_if(Global::toplevel_dir, boost::is_any_of("/"));
+    Global::toplevel_dir = String("/") + Global::toplevel_dir;
+
+    ClientPtr client = new Hypertable::Client(System::install_dir);
+    NamespacePtr ns = client->open_namespace(ns_name);
+    TablePtr table = ns->open_table(table_name);
+    SchemaPtr schema = table->schema();
+
+    if (table->has_index_table() || table->has_qualifier_index_table())
+      HT_THROWF(Error::NOT_ALLOWED, "Table '%s' has secondary indices, "
+                "use LOAD DATA INFILE instead", table_name.c_str());
+
+    TableIdentifierManaged table_id;
+    {
+      TableIdentifier tid;
+      table->get_identifier(&tid);
+      table_id = tid;
+    }
+
+    TableSplitsContainer splits;
+    ns->get_table_splits(table_name, splits);
+    if (splits.empty())
+      HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND, "No ranges found for "
+                "table '%s'", table_name.c_str());
+
+    String staging_dir;
+    if (has("staging-dir"))
+      staging_dir = get_str("staging-dir");
+    else
+      staging_dir = format("%s/tmp/csimport/%s/%d",
+                           Global::toplevel_dir.c_str(), table_id.id,
+                           (int)getpid());
+    dfs->mkdirs(staging_dir);
+
+    // Cells with no timestamp take the time the load started.  They all
+    // share one revision, which the RangeServers override with their own
+    // at scan time
+    int64_t revision = get_ts64();
+
+    RangeServerClient rsclient(Comm::instance());
+    RangeWriter writer(schema, &table_id, staging_dir,
+                       get_i64("max-entries"));
+    writer.set_client(&rsclient);
+
+    DfsBroker::ClientPtr lds_dfs = dfs;
+    std::vector<String> key_columns;
+    LoadDataSourcePtr lds = LoadDataSourceFactory::create(lds_dfs,
+        input_file, LOCAL_FILE, "", LOCAL_FILE, key_columns, "");
+
+    KeySpec key_spec;
+    uint8_t *value;
+    uint32_t value_len;
+    uint32_t consumed;
+    bool is_delete;
+    String last_row;
+    size_t split_idx = 0;
+    DynamicBuffer row_buf;
+    std::vector<RowCell> row_cells;
+    bool more = true;
+
+    writer.start(&splits[0]);
+
+    while (more) {
+      more = lds->next(&key_spec, &value, &value_len, &is_delete, &consumed);
+
+      // Flush the buffered row once a new row begins (or input ends)
+      if (!row_cells.empty() &&
+          (!more || strcmp((const char *)key_spec.row, last_row.c_str()))) {
+        std::sort(row_cells.begin(), row_cells.end(), RowCellLt(row_buf));
+        Key key;
+        ByteString bs;
+        foreach_ht (RowCell &cell, row_cells) {
+          key.load(SerializedKey(row_buf.base + cell.offset));
+          bs.ptr = row_buf.base + cell.offset + key.length;
+          writer.add(*cell.ag, key, bs);
+        }
+        row_buf.clear();
+        row_cells.clear();
+      }
+
+      if (!more)
+        break;
+
+      if (key_spec.row_len == 0)
+        continue;
+
+      const char *row = (const char *)key_spec.row;
+
+      if (!last_row.empty() && strcmp(row, last_row.c_str()) < 0)
+        HT_THROWF(Error::BAD_KEY, "Input not sorted at line %lld: '%s' < '%s'",
+                  (Lld)lds->get_current_lineno(), row, last_row.c_str());
+
+      if (last_row.empty() || strcmp(row, last_row.c_str())) {
+        // Advance to the range containing this row
+        while (strcmp(row, splits[split_idx].end_row) > 0) {
+          writer.finish(dry_run, verbose);
+          HT_ASSERT(split_idx + 1 < splits.size());
+          writer.start(&splits[++split_idx]);
+        }
+        last_row = row;
+      }
+
+      Schema::ColumnFamily *cf = 0;
+      if (key_spec.column_family &&
+          (cf = schema->get_column_family(key_spec.column_family)) == 0)
+        HT_THROWF(Error::BAD_KEY, "Unknown column family '%s' at line %lld",
+                  key_spec.column_family, (Lld)lds->get_current_lineno());
+      if (cf == 0)
+        HT_THROWF(Error::NOT_ALLOWED, "Row deletes not supported by import "
+                  "(line %lld)", (Lld)lds->get_current_lineno());
+
+      uint8_t flag = is_delete ? key_spec.flag : FLAG_INSERT;
+      int64_t timestamp = key_spec.timestamp == AUTO_ASSIGN ?
+        revision : key_spec.timestamp;
+
+      row_cells.push_back(RowCell(row_buf.fill(), &cf->ag));
+      create_key_and_append(row_buf, flag, row, (uint8_t)cf->id,
+                            key_spec.column_qualifier ?
+                            key_spec.column_qualifier : "",
+                            timestamp, revision);
+      append_as_byte_string(row_buf, value, value_len);
+    }
+
+    writer.finish(dry_run, verbose);
+
+    cout << "Imported " << writer.total_cells() << " cells in "
+         << writer.total_files() << " CellStores"
+         << (dry_run ? String(" (dry run, left in ") + staging_dir + ")" : "")
+         << endl;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    _exit(1);
+  }
+  _exit(0);
+}
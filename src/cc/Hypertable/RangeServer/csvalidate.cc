@@ -53,6 +53,8 @@
 #include "CellStoreFactory.h"
 #include "CellStoreTrailerV6.h"
 #include "Global.h"
+#include "KeyCompressor.h"
+#include "KeyDecompressorDelta.h"
 #include "KeyDecompressorPrefix.h"
 
 using namespace Hypertable;
@@ -152,7 +154,11 @@ namespace {
 
     uint16_t compression_type = boost::any_cast<uint16_t>(state.trailer->get("compression_type"));
     state.compressor = CompressorFactory::create_block_codec((BlockCompressionCodec::Type)compression_type);
-    state.key_decompressor = new KeyDecompressorPrefix();
+    uint16_t key_compression_scheme = boost::any_cast<uint16_t>(state.trailer->get("key_compression_scheme"));
+    if (key_compression_scheme == KeyCompressionType::DELTA)
+      state.key_decompressor = new KeyDecompressorDelta();
+    else
+      state.key_decompressor = new KeyDecompressorPrefix();
   }
   
 
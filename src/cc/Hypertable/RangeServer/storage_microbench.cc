@@ -0,0 +1,586 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <boost/algorithm/string.hpp>
+
+#include "AsyncComm/ConnectionManager.h"
+
+#include "Common/BloomFilterWithChecksum.h"
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/FileUtils.h"
+#include "Common/Init.h"
+#include "Common/Stopwatch.h"
+#include "Common/String.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/DataGenerator.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "Config.h"
+#include "CellCache.h"
+#include "CellStoreFactory.h"
+#include "CellStoreV6.h"
+#include "Global.h"
+#include "KeyCompressorDelta.h"
+#include "KeyCompressorPrefix.h"
+#include "KeyDecompressorDelta.h"
+#include "KeyDecompressorPrefix.h"
+#include "MergeScannerAccessGroup.h"
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+/*
+ * Every operator new in the process bumps these counters, so the numbers
+ * reported for a component are the heap allocations made while it ran.
+ * CellCache arena pages come from malloc and are reported separately.
+ */
+namespace {
+  uint64_t g_alloc_count = 0;
+  uint64_t g_alloc_bytes = 0;
+}
+
+void *operator new(size_t sz) throw (std::bad_alloc) {
+  __sync_fetch_and_add(&g_alloc_count, 1);
+  __sync_fetch_and_add(&g_alloc_bytes, sz);
+  void *ptr = malloc(sz ? sz : 1);
+  if (ptr == 0)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t sz) throw (std::bad_alloc) {
+  return operator new(sz);
+}
+
+void operator delete(void *ptr) throw () {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) throw () {
+  free(ptr);
+}
+
+namespace {
+
+  const char *usage =
+    "Usage: storage_microbench [options]\n\n"
+    "Drives the RangeServer storage classes directly with synthetic cells\n"
+    "produced by the DataGenerator and reports ops/s, bytes/s and heap\n"
+    "allocations for each component.  Components are:\n\n"
+    "  cellcache  CellCache insert (arrival order) and full scan\n"
+    "  cellstore  CellStoreV6 write and full scan, once per codec; needs a\n"
+    "             running DFS broker\n"
+    "  merge      MergeScannerAccessGroup over --merge-inputs CellCaches\n"
+    "  bloom      Bloom filter inserts and probes of present and absent rows\n"
+    "  keycomp    Prefix and delta key compression and decompression\n\n"
+    "Without --spec-file, cells have random 20-digit row keys, one 'Field'\n"
+    "column with an 8 byte qualifier and --value-size byte values.\n\n"
+    "Options";
+
+  struct AppPolicy : Config::Policy {
+    static void init_options() {
+      cmdline_desc(usage).add_options()
+        ("cells", i64()->default_value(100000),
+         "Number of cells to generate")
+        ("value-size", i32()->default_value(64),
+         "Value size of the built-in data specification")
+        ("spec-file", str(),
+         "File containing the DataGenerator specification")
+        ("components", str()->default_value("cellcache,cellstore,merge,"
+         "bloom,keycomp"), "Comma separated list of components to run")
+        ("codecs", str()->default_value("none,zlib,lzo,quicklz,bmz,snappy"),
+         "Comma separated list of CellStore block compression codecs")
+        ("merge-inputs", i32()->default_value(4),
+         "Number of CellCaches merged by the merge component")
+        ("bloom-false-positive-prob", f64()->default_value(0.01),
+         "Target false positive probability of the bloom filter")
+        ("dfs-dir", str()->default_value("/storage_microbench"),
+         "DFS directory in which CellStores are written")
+        ;
+    }
+  };
+
+  typedef Meta::list<AppPolicy, DataGeneratorPolicy, DfsClientPolicy,
+                     DefaultCommPolicy> Policies;
+
+  /** Serialized cells produced by the DataGenerator.  Each entry of
+   * #offsets locates a serialized key followed by its value; #sorted holds
+   * the same offsets in key order.
+   */
+  struct CellSet {
+    DynamicBuffer buf;
+    vector<size_t> offsets;
+    vector<size_t> sorted;
+    map<String, int> families;
+    SchemaPtr schema;
+    uint64_t key_bytes;
+    uint64_t value_bytes;
+  };
+
+  /** Orders serialized cell offsets by key. */
+  struct CellOffsetLt {
+    CellOffsetLt(DynamicBuffer &buf) : base(buf.base) { }
+    bool operator()(size_t o1, size_t o2) const {
+      return SerializedKey(base + o1) < SerializedKey(base + o2);
+    }
+    const uint8_t *base;
+  };
+
+  inline void load_cell(const CellSet &cells, size_t offset, Key &key,
+                        ByteString &value) {
+    key.load(SerializedKey(cells.buf.base + offset));
+    value.ptr = key.serial.ptr + key.length;
+  }
+
+  struct Result {
+    Result(const String &n) : name(n), ops(0), bytes(0), seconds(0.0),
+                              allocs(0), alloc_bytes(0) { }
+    String name;
+    uint64_t ops;
+    uint64_t bytes;
+    double seconds;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    String notes;
+  };
+
+  /** Times a component and snapshots the allocation counters around it. */
+  class Measurement {
+  public:
+    Measurement(Result &result) : m_result(result),
+        m_allocs(g_alloc_count), m_alloc_bytes(g_alloc_bytes) { }
+
+    ~Measurement() {
+      m_stopwatch.stop();
+      m_result.seconds = m_stopwatch.elapsed();
+      m_result.allocs = g_alloc_count - m_allocs;
+      m_result.alloc_bytes = g_alloc_bytes - m_alloc_bytes;
+    }
+
+  private:
+    Result &m_result;
+    uint64_t m_allocs;
+    uint64_t m_alloc_bytes;
+    Stopwatch m_stopwatch;
+  };
+
+  void load_generator_props(PropertiesPtr &props) {
+    if (has("spec-file")) {
+      String spec_file = get_str("spec-file");
+      if (!FileUtils::exists(spec_file))
+        HT_THROW(Error::FILE_NOT_FOUND, spec_file);
+      props->load(spec_file, cmdline_hidden_desc(), true);
+      return;
+    }
+    props->set("rowkey.component.0.type", String("integer"));
+    props->set("rowkey.component.0.format", String("%020lld"));
+    props->set("rowkey.component.0.order", String("random"));
+    props->set("Field.qualifier.type", String("string"));
+    props->set("Field.qualifier.size", String("8"));
+    props->set("Field.qualifier.charset", String("abcdefghijklmnopqrstuvwxyz"));
+    props->set("Field.value.size", format("%d", get_i32("value-size")));
+  }
+
+  void generate_cells(CellSet &cells, int64_t count) {
+    PropertiesPtr props = new Properties();
+    load_generator_props(props);
+
+    DataGenerator dg(props);
+    int64_t revision = 0;
+    cells.key_bytes = cells.value_bytes = 0;
+    cells.offsets.reserve(count);
+
+    for (DataGenerator::iterator iter = dg.begin();
+         iter != dg.end() && revision < count; ++iter) {
+      Cell &cell = *iter;
+      map<String, int>::iterator fiter = cells.families.find(cell.column_family);
+      if (fiter == cells.families.end()) {
+        int id = cells.families.size() + 1;
+        if (id > 255)
+          HT_THROW(Error::TOO_MANY_COLUMNS, "More than 255 column families");
+        fiter = cells.families.insert(make_pair(String(cell.column_family),
+                                                id)).first;
+      }
+      revision++;
+      size_t offset = cells.buf.fill();
+      cells.offsets.push_back(offset);
+      create_key_and_append(cells.buf, FLAG_INSERT, cell.row_key,
+                            (uint8_t)fiter->second, cell.column_qualifier,
+                            revision, revision);
+      cells.key_bytes += cells.buf.fill() - offset;
+      append_as_byte_string(cells.buf, cell.value, cell.value_len);
+      cells.value_bytes += cells.buf.fill() - offset;
+    }
+    cells.value_bytes -= cells.key_bytes;
+
+    cells.sorted = cells.offsets;
+    sort(cells.sorted.begin(), cells.sorted.end(), CellOffsetLt(cells.buf));
+
+    String schema_str = "<Schema>\n  <AccessGroup name=\"default\">\n";
+    for (map<String, int>::iterator iter = cells.families.begin();
+         iter != cells.families.end(); ++iter)
+      schema_str += format("    <ColumnFamily id=\"%d\">\n      <Name>%s"
+                           "</Name>\n    </ColumnFamily>\n", iter->second,
+                           iter->first.c_str());
+    schema_str += "  </AccessGroup>\n</Schema>";
+
+    cells.schema = Schema::new_instance(schema_str, schema_str.length());
+    if (!cells.schema->is_valid())
+      HT_THROWF(Error::SCHEMA_PARSE_ERROR, "%s",
+                cells.schema->get_error_string());
+  }
+
+  void scan_all(CellListScanner *scanner, Result &result) {
+    Key key;
+    ByteString value;
+    while (scanner->get(key, value)) {
+      result.ops++;
+      result.bytes += key.length + value.length();
+      scanner->forward();
+    }
+  }
+
+  void fill_cell_cache(CellSet &cells, CellCache *cache,
+                       const vector<size_t> &offsets, size_t begin=0,
+                       size_t stride=1) {
+    Key key;
+    ByteString value;
+    cache->lock();
+    for (size_t i=begin; i<offsets.size(); i+=stride) {
+      load_cell(cells, offsets[i], key, value);
+      cache->add(key, value);
+    }
+    cache->unlock();
+  }
+
+  void run_cell_cache(CellSet &cells, vector<Result> &results) {
+    CellCachePtr cache = new CellCache();
+    Result add("cellcache.add");
+    {
+      Measurement m(add);
+      fill_cell_cache(cells, cache.get(), cells.offsets);
+    }
+    add.ops = cells.offsets.size();
+    add.bytes = cells.key_bytes + cells.value_bytes;
+    add.notes = format("arena=%llu bytes",
+                       (Llu)cache->memory_allocated());
+    results.push_back(add);
+
+    Result scan("cellcache.scan");
+    {
+      ScanContextPtr scan_ctx = new ScanContext(cells.schema);
+      Measurement m(scan);
+      CellListScannerPtr scanner = cache->create_scanner(scan_ctx);
+      scan_all(scanner.get(), scan);
+    }
+    results.push_back(scan);
+  }
+
+  void run_cell_store(CellSet &cells, const String &codec,
+                      vector<Result> &results) {
+    TableIdentifier table_id("1");
+    String fname = format("%s/cs-%s-%d", get_str("dfs-dir").c_str(),
+                          codec.c_str(), (int)getpid());
+    PropertiesPtr props = new Properties();
+    props->set("compressor", codec);
+    Schema::parse_bloom_filter(get_str("Hypertable.RangeServer.CellStore"
+                                       ".DefaultBloomFilter"), props);
+
+    Result write("cellstore.write." + codec);
+    {
+      Key key;
+      ByteString value;
+      Measurement m(write);
+      CellStorePtr cs = new CellStoreV6(Global::dfs.get(), cells.schema.get());
+      cs->create(fname.c_str(), cells.sorted.size(), props, &table_id);
+      for (size_t i=0; i<cells.sorted.size(); i++) {
+        load_cell(cells, cells.sorted[i], key, value);
+        cs->add(key, value);
+      }
+      cs->finalize(&table_id);
+    }
+    int64_t file_length = Global::dfs->length(fname);
+    write.ops = cells.sorted.size();
+    write.bytes = cells.key_bytes + cells.value_bytes;
+    write.notes = format("file=%lld bytes ratio=%.3f", (Lld)file_length,
+                         (double)file_length / (double)write.bytes);
+    results.push_back(write);
+
+    Result read("cellstore.scan." + codec);
+    {
+      CellStorePtr cs = CellStoreFactory::open(fname, 0, 0);
+      ScanContextPtr scan_ctx = new ScanContext(cells.schema);
+      Measurement m(read);
+      CellListScannerPtr scanner = cs->create_scanner(scan_ctx);
+      scan_all(scanner.get(), read);
+    }
+    read.notes = "block cache disabled";
+    results.push_back(read);
+
+    Global::dfs->remove(fname);
+  }
+
+  void run_merge(CellSet &cells, vector<Result> &results) {
+    int32_t inputs = get_i32("merge-inputs");
+    if (inputs < 1)
+      HT_THROW(Error::CONFIG_BAD_VALUE, "merge-inputs must be positive");
+
+    // Deal sorted cells round-robin so every input overlaps every other one
+    vector<CellCachePtr> caches;
+    for (int32_t i=0; i<inputs; i++) {
+      caches.push_back(new CellCache());
+      fill_cell_cache(cells, caches.back().get(), cells.sorted, i, inputs);
+    }
+
+    String table_name = "storage_microbench";
+    Result merge(format("merge.%d-way", (int)inputs));
+    {
+      ScanContextPtr scan_ctx = new ScanContext(cells.schema);
+      Measurement m(merge);
+      MergeScannerAccessGroup mscanner(table_name, scan_ctx);
+      for (size_t i=0; i<caches.size(); i++)
+        mscanner.add_scanner(caches[i]->create_scanner(scan_ctx));
+      scan_all(&mscanner, merge);
+    }
+    results.push_back(merge);
+  }
+
+  void run_bloom(CellSet &cells, vector<Result> &results) {
+    vector<String> rows, absent;
+    Key key;
+    ByteString value;
+    uint64_t row_bytes = 0;
+
+    rows.reserve(cells.offsets.size());
+    for (size_t i=0; i<cells.offsets.size(); i++) {
+      load_cell(cells, cells.offsets[i], key, value);
+      rows.push_back(key.row);
+      row_bytes += rows.back().length();
+    }
+    // Row keys of the built-in spec are digits only, so these never match
+    absent.reserve(rows.size());
+    for (size_t i=0; i<rows.size(); i++)
+      absent.push_back(rows[i] + "~absent");
+
+    BloomFilterWithChecksum bloom(rows.size(),
+                                  (float)get_f64("bloom-false-positive-prob"));
+
+    Result insert("bloom.insert");
+    {
+      Measurement m(insert);
+      for (size_t i=0; i<rows.size(); i++)
+        bloom.insert(rows[i]);
+    }
+    insert.ops = rows.size();
+    insert.bytes = row_bytes;
+    insert.notes = format("filter=%llu bytes hashes=%llu",
+                          (Llu)bloom.total_size(), (Llu)bloom.get_num_hashes());
+    results.push_back(insert);
+
+    Result hit("bloom.probe.present");
+    size_t misses = 0;
+    {
+      Measurement m(hit);
+      for (size_t i=0; i<rows.size(); i++)
+        if (!bloom.may_contain(rows[i]))
+          misses++;
+    }
+    HT_ASSERT(misses == 0);
+    hit.ops = rows.size();
+    hit.bytes = row_bytes;
+    results.push_back(hit);
+
+    Result miss("bloom.probe.absent");
+    size_t false_positives = 0;
+    {
+      Measurement m(miss);
+      for (size_t i=0; i<absent.size(); i++)
+        if (bloom.may_contain(absent[i]))
+          false_positives++;
+    }
+    miss.ops = absent.size();
+    miss.bytes = row_bytes + 7 * absent.size();
+    miss.notes = format("false-positive-rate=%.4f",
+                        (double)false_positives / (double)absent.size());
+    results.push_back(miss);
+  }
+
+  void run_key_compression(CellSet &cells, const String &scheme,
+                           KeyCompressor *compressor,
+                           KeyDecompressor *decompressor,
+                           vector<Result> &results) {
+    size_t block_size = get_i32("Hypertable.RangeServer.CellStore"
+                                ".DefaultBlockSize");
+    DynamicBuffer output(cells.key_bytes);
+    vector<size_t> block_starts;
+    Key key;
+    ByteString value;
+
+    // Reset at the same points a CellStore would start a new block
+    Result compress("keycomp.compress." + scheme);
+    {
+      Measurement m(compress);
+      size_t block_fill = block_size;
+      for (size_t i=0; i<cells.sorted.size(); i++) {
+        load_cell(cells, cells.sorted[i], key, value);
+        if (block_fill >= block_size) {
+          compressor->reset();
+          block_starts.push_back(i);
+          block_fill = 0;
+        }
+        compressor->add(key);
+        output.ensure(compressor->length());
+        compressor->write(output.ptr);
+        output.ptr += compressor->length();
+        block_fill += compressor->length() + value.length();
+      }
+    }
+    compress.ops = cells.sorted.size();
+    compress.bytes = cells.key_bytes;
+    compress.notes = format("ratio=%.3f",
+                            (double)output.fill() / (double)cells.key_bytes);
+    results.push_back(compress);
+
+    Result decompress("keycomp.decompress." + scheme);
+    {
+      Measurement m(decompress);
+      const uint8_t *ptr = output.base;
+      size_t next_block = 0;
+      for (size_t i=0; i<cells.sorted.size(); i++) {
+        if (next_block < block_starts.size() && block_starts[next_block] == i) {
+          decompressor->reset();
+          next_block++;
+        }
+        ptr = decompressor->add(ptr);
+        decompressor->load(key);
+      }
+      HT_ASSERT(ptr == output.ptr);
+    }
+    decompress.ops = cells.sorted.size();
+    decompress.bytes = cells.key_bytes;
+    results.push_back(decompress);
+  }
+
+  void display_results(vector<Result> &results) {
+    printf("%-28s %10s %12s %10s %12s %10s  %s\n", "component", "ops",
+           "ops/s", "MB/s", "allocs", "allocs/op", "notes");
+    for (size_t i=0; i<results.size(); i++) {
+      Result &r = results[i];
+      double seconds = r.seconds > 0.0 ? r.seconds : 1e-9;
+      printf("%-28s %10llu %12.0f %10.2f %12llu %10.3f  %s\n",
+             r.name.c_str(), (Llu)r.ops, (double)r.ops / seconds,
+             ((double)r.bytes / seconds) / (1024.0 * 1024.0), (Llu)r.allocs,
+             r.ops ? (double)r.allocs / (double)r.ops : 0.0,
+             r.notes.c_str());
+    }
+    fflush(stdout);
+  }
+
+} // local namespace
+
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    vector<String> components, codecs;
+    String str = get_str("components");
+    boost::split(components, str, boost::is_any_of(","));
+    str = get_str("codecs");
+    boost::split(codecs, str, boost::is_any_of(","));
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+    Global::cell_cache_scanner_cache_size =
+      get_i32("Hypertable.RangeServer.AccessGroup.CellCache.ScannerCacheSize");
+
+    CellSet cells;
+    generate_cells(cells, get_i64("cells"));
+    cout << "Generated " << cells.offsets.size() << " cells, "
+         << cells.key_bytes << " key bytes, " << cells.value_bytes
+         << " value bytes" << endl;
+
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::ClientPtr dfs;
+    vector<Result> results;
+
+    foreach_ht (const String &component, components) {
+      if (component == "cellcache")
+        run_cell_cache(cells, results);
+      else if (component == "cellstore") {
+        if (!dfs) {
+          conn_mgr = new ConnectionManager();
+          dfs = new DfsBroker::Client(conn_mgr, properties);
+          if (!dfs->wait_for_connection(get_i32("timeout"))) {
+            cerr << "error: timed out waiting for DFS broker" << endl;
+            exit(1);
+          }
+          Global::dfs = dfs;
+          dfs->mkdirs(get_str("dfs-dir"));
+        }
+        foreach_ht (const String &codec, codecs)
+          run_cell_store(cells, codec, results);
+      }
+      else if (component == "merge")
+        run_merge(cells, results);
+      else if (component == "bloom")
+        run_bloom(cells, results);
+      else if (component == "keycomp") {
+        KeyCompressorPrefix prefix;
+        KeyDecompressorPrefix prefix_decompressor;
+        run_key_compression(cells, "prefix", &prefix, &prefix_decompressor,
+                            results);
+        KeyCompressorDelta delta;
+        KeyDecompressorDelta delta_decompressor;
+        run_key_compression(cells, "delta", &delta, &delta_decompressor,
+                            results);
+      }
+      else
+        HT_THROWF(Error::CONFIG_BAD_VALUE, "Unknown component '%s'",
+                  component.c_str());
+    }
+
+    display_results(results);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    _exit(1);
+  }
+  _exit(0); // don't bother with static objects
+}
@@ -0,0 +1,341 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/Serialization.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "../CellCache.h"
+#include "../Global.h"
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "    <ColumnFamily id=\"2\">\n"
+  "      <Name>count</Name>\n"
+  "      <Counter>true</Counter>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const char *LONG_ROW_FORMAT = "com.example.www/users/%04d";
+
+  // Gives the test access to the cell map
+  class TestCellCache : public CellCache {
+  public:
+    const CellMap &cell_map() { return m_cell_map; }
+  };
+  typedef intrusive_ptr<TestCellCache> TestCellCachePtr;
+
+  struct TestCell {
+    String key;
+    String value;
+  };
+
+  bool operator<(const TestCell &c1, const TestCell &c2) {
+    return SerializedKey((const uint8_t *)c1.key.data()) <
+      SerializedKey((const uint8_t *)c2.key.data());
+  }
+
+  TestCell make_cell(uint8_t flag, const char *row, uint8_t family,
+                 const char *qualifier, int64_t ts, const String &value) {
+    DynamicBuffer buf;
+    TestCell cell;
+    create_key_and_append(buf, flag, row, family, qualifier, ts, ts);
+    cell.key = String((const char *)buf.base, buf.fill());
+    buf.clear();
+    append_as_byte_string(buf, value.data(), value.length());
+    cell.value = String((const char *)buf.base, buf.fill());
+    return cell;
+  }
+
+  TestCell make_counter(const char *row, const char *qualifier, int64_t ts,
+                    int64_t count) {
+    uint8_t buf[9];
+    uint8_t *ptr = buf;
+    TestCell cell = make_cell(FLAG_INSERT, row, 2, qualifier, ts, "");
+    *ptr++ = 8;
+    Serialization::encode_i64(&ptr, (uint64_t)count);
+    cell.value = String((const char *)buf, 9);
+    return cell;
+  }
+
+  int64_t decode_counter(ByteString value) {
+    const uint8_t *ptr;
+    HT_ASSERT(value.decode_length(&ptr) == 8);
+    size_t remaining = 8;
+    return (int64_t)Serialization::decode_i64(&ptr, &remaining);
+  }
+
+  void add(CellCache *cache, const TestCell &cell, bool counter=false) {
+    Key key;
+    key.load(SerializedKey((const uint8_t *)cell.key.data()));
+    cache->lock();
+    if (counter)
+      cache->add_counter(key, ByteString((const uint8_t *)cell.value.data()));
+    else
+      cache->add(key, ByteString((const uint8_t *)cell.value.data()));
+    cache->unlock();
+  }
+
+  // Every cell of the long rows, ten per row, in random order
+  void make_long_row_cells(vector<TestCell> &cells) {
+    char row[64], qualifier[8];
+    for (int i=0; i<20; i++) {
+      sprintf(row, LONG_ROW_FORMAT, i);
+      for (int j=0; j<10; j++) {
+        sprintf(qualifier, "q%d", j);
+        cells.push_back(make_cell(FLAG_INSERT, row, 1, qualifier, 1000 + j,
+                                  format("value-%d-%d", i, j)));
+      }
+    }
+    random_shuffle(cells.begin(), cells.end());
+  }
+
+  // Counts records stored as plain SerializedKeys and checks that
+  // records referencing their row are shorter
+  size_t count_plain(TestCellCachePtr &cache, int64_t *savedp) {
+    Key key;
+    ByteArena arena;
+    size_t plain = 0;
+    *savedp = 0;
+    const CellCache::CellMap &cell_map = cache->cell_map();
+    for (CellCache::CellMap::const_iterator iter = cell_map.begin();
+         iter != cell_map.end(); ++iter) {
+      key.load(iter->first.serialized(arena));
+      if (iter->first.shared_row())
+        HT_ASSERT(iter->second < key.length);
+      else {
+        HT_ASSERT(iter->second == key.length);
+        plain++;
+      }
+      *savedp += key.length - iter->second;
+    }
+    return plain;
+  }
+
+  /**
+   * Single cell rows and rows no longer than a pointer are kept as plain
+   * SerializedKeys, so they take no more memory than before rows were
+   * shared.  Only the first cell of a long row stores the row.
+   */
+  void test_layout() {
+    char row[64];
+    int64_t saved;
+
+    TestCellCachePtr narrow = new TestCellCache();
+    for (int i=0; i<200; i++) {
+      sprintf(row, "n%04d", (i * 37) % 200);
+      add(narrow.get(), make_cell(FLAG_INSERT, row, 1, "q", 1, "v"));
+    }
+    HT_ASSERT(narrow->size() == 200);
+    HT_ASSERT(count_plain(narrow, &saved) == 200);
+    HT_ASSERT(saved == 0);
+
+    TestCellCachePtr short_rows = new TestCellCache();
+    for (int i=0; i<50; i++) {
+      sprintf(row, "s%02d", i);
+      for (int j=0; j<10; j++)
+        add(short_rows.get(), make_cell(FLAG_INSERT, row, 1,
+                                        format("q%d", j).c_str(), 1, "v"));
+    }
+    HT_ASSERT(short_rows->size() == 500);
+    HT_ASSERT(count_plain(short_rows, &saved) == 500);
+    HT_ASSERT(saved == 0);
+
+    vector<TestCell> cells;
+    make_long_row_cells(cells);
+    TestCellCachePtr long_rows = new TestCellCache();
+    for (size_t i=0; i<cells.size(); i++)
+      add(long_rows.get(), cells[i]);
+    HT_ASSERT(long_rows->size() == 200);
+    HT_ASSERT(count_plain(long_rows, &saved) == 20);
+    HT_ASSERT(saved > 0);
+    cout << "Long rows: " << saved << " key bytes saved over "
+         << long_rows->size() << " cells" << endl;
+  }
+
+  void scan(CellCachePtr cache, SchemaPtr &schema, const ScanSpec *spec,
+            vector<TestCell> &result) {
+    RangeSpec range;
+    ScanContextPtr scan_ctx;
+    CellListScannerPtr scanner;
+    Key key;
+    ByteString value;
+
+    range.start_row = "";
+    range.end_row = Key::END_ROW_MARKER;
+    scan_ctx = new ScanContext(TIMESTAMP_MAX, spec, &range, schema);
+    scanner = cache->create_scanner(scan_ctx);
+    result.clear();
+    while (scanner->get(key, value)) {
+      TestCell cell;
+      cell.key = String((const char *)key.serial.ptr, key.length);
+      cell.value = String((const char *)value.ptr, value.length());
+      result.push_back(cell);
+      scanner->forward();
+    }
+  }
+
+  /**
+   * Keys come back from the scanner in SerializedKey order, rebuilt from
+   * the records that reference their row.
+   */
+  void test_scan(SchemaPtr &schema) {
+    vector<TestCell> cells, expected, result;
+    TestCellCachePtr cache = new TestCellCache();
+    char row[64];
+
+    make_long_row_cells(cells);
+    expected = cells;
+
+    // Deletes in the row that the cell interval scan starts in
+    sprintf(row, LONG_ROW_FORMAT, 7);
+    cells.push_back(make_cell(FLAG_DELETE_ROW, row, 0, "", 900, ""));
+    cells.push_back(make_cell(FLAG_DELETE_COLUMN_FAMILY, row, 1, "", 901, ""));
+    expected.push_back(cells[cells.size()-2]);
+    expected.push_back(cells.back());
+    random_shuffle(cells.begin(), cells.end());
+
+    for (size_t i=0; i<cells.size(); i++)
+      add(cache.get(), cells[i]);
+
+    // A second add of the same key replaces the value
+    TestCell replacement = expected[17];
+    replacement.value = make_cell(FLAG_INSERT, "", 1, "", 1, "replaced").value;
+    add(cache.get(), replacement);
+    expected[17] = replacement;
+
+    HT_ASSERT(cache->size() == expected.size());
+
+    sort(expected.begin(), expected.end());
+    ScanSpecBuilder ssbuilder;
+    scan(cache.get(), schema, &ssbuilder.get(), result);
+    HT_ASSERT(result.size() == expected.size());
+    for (size_t i=0; i<result.size(); i++) {
+      HT_ASSERT(result[i].key == expected[i].key);
+      HT_ASSERT(result[i].value == expected[i].value);
+    }
+
+    // A cell interval starting mid-row also returns the row's deletes
+    ssbuilder.clear();
+    ssbuilder.add_cell_interval(row, "tag:q3", true, row, "tag:q7", true);
+    scan(cache.get(), schema, &ssbuilder.get(), result);
+    HT_ASSERT(result.size() == 7);
+    Key key;
+    key.load(SerializedKey((const uint8_t *)result[0].key.data()));
+    HT_ASSERT(key.flag == FLAG_DELETE_ROW && !strcmp(key.row, row));
+    key.load(SerializedKey((const uint8_t *)result[1].key.data()));
+    HT_ASSERT(key.flag == FLAG_DELETE_COLUMN_FAMILY && !strcmp(key.row, row));
+    for (size_t i=2; i<result.size(); i++) {
+      key.load(SerializedKey((const uint8_t *)result[i].key.data()));
+      HT_ASSERT(!strcmp(key.row, row));
+      HT_ASSERT(key.column_family_code == 1);
+      HT_ASSERT(key.column_qualifier[1] - '0' == (int)i + 1);
+    }
+  }
+
+  /**
+   * Counter increments fold into the cell already in the cache, which
+   * takes the timestamp and revision of the latest increment.  Both
+   * record layouts are covered.
+   */
+  void test_counters(SchemaPtr &schema) {
+    vector<TestCell> cells, result;
+    TestCellCachePtr cache = new TestCellCache();
+    char row[64];
+    Key key;
+
+    sprintf(row, LONG_ROW_FORMAT, 1);
+    add(cache.get(), make_cell(FLAG_INSERT, row, 1, "q", 1, "v"));
+    for (int i=1; i<=3; i++) {
+      add(cache.get(), make_counter(row, "c", 100 + i, i), true);
+      add(cache.get(), make_counter("c1", "c", 200 + i, 10 * i), true);
+    }
+    HT_ASSERT(cache->size() == 3);
+
+    ScanSpecBuilder ssbuilder;
+    ssbuilder.add_column("count");
+    scan(cache.get(), schema, &ssbuilder.get(), result);
+    HT_ASSERT(result.size() == 2);
+
+    key.load(SerializedKey((const uint8_t *)result[0].key.data()));
+    HT_ASSERT(!strcmp(key.row, "c1"));
+    HT_ASSERT(key.timestamp == 203 && key.revision == 203);
+    HT_ASSERT(decode_counter((const uint8_t *)result[0].value.data()) == 60);
+
+    key.load(SerializedKey((const uint8_t *)result[1].key.data()));
+    HT_ASSERT(!strcmp(key.row, row));
+    HT_ASSERT(key.timestamp == 103 && key.revision == 103);
+    HT_ASSERT(decode_counter((const uint8_t *)result[1].value.data()) == 6);
+
+    // A reset is added as a new cell rather than summed
+    TestCell reset = make_counter(row, "c", 104, 0);
+    reset.value[0] = 9;
+    reset.value.append("=");
+    add(cache.get(), reset, true);
+    HT_ASSERT(cache->size() == 4);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  init_with_policy<DefaultPolicy>(argc, argv);
+
+  Global::memory_tracker = new MemoryTracker(0, 0);
+  // Small batches so that scans refill the entry cache within a row
+  Global::cell_cache_scanner_cache_size = 7;
+
+  srand(1);
+
+  SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+  if (!schema->is_valid()) {
+    HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+    exit(1);
+  }
+
+  test_layout();
+  test_scan(schema);
+  test_counters(schema);
+
+  return 0;
+}
@@ -0,0 +1,166 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/PageArenaAllocator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "../CellStoreBlockIndexArray.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  typedef CellStoreBlockIndexArray<uint32_t> BlockIndexT;
+
+  const int NUM_BLOCKS = 100;
+  const int HOT_BLOCK = 80;
+
+  // Builds an index with one entry per block, the entry for block i
+  // holding the last key of that block, row<i>
+  void load_index(BlockIndexT &index) {
+    DynamicBuffer fixed(0);
+    DynamicBuffer variable(0);
+    char row[32];
+
+    for (int i=0; i<NUM_BLOCKS; i++) {
+      uint32_t offset = i * 65536;
+      sprintf(row, "row%04d", i);
+      create_key_and_append(variable, FLAG_INSERT, row, 1, "", i + 1, i + 1);
+      fixed.add(&offset, sizeof(offset));
+    }
+    index.load(fixed, variable, NUM_BLOCKS * 65536);
+  }
+
+  // Reads the block holding <code>row</code> the way a scanner does
+  void read_block(BlockIndexT &index, const char *row) {
+    DynamicBuffer buf(0);
+    create_key_and_append(buf, FLAG_INSERT, row, 1, "", TIMESTAMP_MAX,
+                          TIMESTAMP_MAX);
+    BlockIndexT::iterator iter = index.lower_bound(SerializedKey(buf.base));
+    HT_ASSERT(iter != index.end());
+    index.record_access(iter);
+  }
+
+  // Same median rule as Range::estimate_split_row()
+  String median_row(CellList::SplitRowDataMapT &split_row_data) {
+    int64_t target = 0;
+    for (CellList::SplitRowDataMapT::iterator iter = split_row_data.begin();
+         iter != split_row_data.end(); ++iter)
+      target += iter->second;
+    target /= 2;
+
+    int64_t cumulative = 0;
+    for (CellList::SplitRowDataMapT::iterator iter = split_row_data.begin();
+         iter != split_row_data.end(); ++iter) {
+      if (cumulative + iter->second >= target) {
+        if (cumulative > 0)
+          --iter;
+        return iter->first;
+      }
+      cumulative += iter->second;
+    }
+    return "";
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  BlockIndexT index;
+  char row[32];
+
+  load_index(index);
+
+  // No reads yet, so there is no load data to split on
+  {
+    StlArena arena(8192);
+    CellList::SplitRowDataMapT split_row_data =
+      CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+    index.row_access_estimate(split_row_data);
+    HT_ASSERT(split_row_data.empty());
+  }
+
+  // One full scan, then repeated reads of the top fifth of the key space
+  for (int i=0; i<NUM_BLOCKS; i++) {
+    sprintf(row, "row%04d", i);
+    read_block(index, row);
+  }
+  for (int n=0; n<10; n++) {
+    for (int i=HOT_BLOCK; i<NUM_BLOCKS; i++) {
+      sprintf(row, "row%04d", i);
+      read_block(index, row);
+    }
+  }
+
+  {
+    StlArena arena(8192);
+    CellList::SplitRowDataMapT split_row_data =
+      CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+    int64_t total = 0;
+
+    index.row_access_estimate(split_row_data);
+    HT_ASSERT(split_row_data.size() == (size_t)NUM_BLOCKS);
+    for (CellList::SplitRowDataMapT::iterator iter = split_row_data.begin();
+         iter != split_row_data.end(); ++iter) {
+      int i = atoi(iter->first + 3);
+      HT_ASSERT(iter->second == (i < HOT_BLOCK ? 1 : 11));
+      total += iter->second;
+    }
+    HT_ASSERT(total == NUM_BLOCKS + 10 * (NUM_BLOCKS - HOT_BLOCK));
+
+    // The load median lands inside the hot blocks, well past the key median
+    String split_row = median_row(split_row_data);
+    cout << "Load median " << split_row << endl;
+    HT_ASSERT(split_row.compare("row0080") > 0);
+    HT_ASSERT(split_row.compare("row0090") < 0);
+
+    // A second store with the same index rows adds to the same entries
+    BlockIndexT index2;
+    load_index(index2);
+    sprintf(row, "row%04d", 0);
+    read_block(index2, row);
+    index2.row_access_estimate(split_row_data);
+    HT_ASSERT(split_row_data.size() == (size_t)NUM_BLOCKS);
+    HT_ASSERT(split_row_data["row0000"] == 2);
+  }
+
+  // Reloading the index discards the counts
+  index.clear();
+  load_index(index);
+  {
+    StlArena arena(8192);
+    CellList::SplitRowDataMapT split_row_data =
+      CellList::SplitRowDataMapT(LtCstr(), CellList::SplitRowDataAlloc(arena));
+    index.row_access_estimate(split_row_data);
+    HT_ASSERT(split_row_data.empty());
+  }
+
+  return 0;
+}
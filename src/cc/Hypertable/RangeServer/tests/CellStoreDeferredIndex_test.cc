@@ -0,0 +1,217 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/InetAddr.h"
+#include "Common/Serialization.h"
+#include "Common/System.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "AsyncComm/ConnectionManager.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "../CellStoreFactory.h"
+#include "../CellStoreV6.h"
+#include "../Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const int NUM_ROWS = 20000;
+
+  CellStorePtr open_store(const String &fname, const char *start_row,
+                          const char *end_row, bool deferred) {
+    Global::defer_cellstore_index_load = deferred;
+    CellStorePtr cs = CellStoreFactory::open(fname, start_row, end_row);
+    Global::defer_cellstore_index_load = false;
+    return cs;
+  }
+
+  size_t count_cells(CellStorePtr &cs, SchemaPtr &schema) {
+    ScanContextPtr scan_ctx = new ScanContext(schema);
+    CellListScannerPtr scanner = cs->create_scanner(scan_ctx);
+    Key key;
+    ByteString value;
+    size_t count = 0;
+    while (scanner->get(key, value)) {
+      count++;
+      scanner->forward();
+    }
+    return count;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    struct sockaddr_in addr;
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::ClientPtr client;
+    TableIdentifier table_id("0");
+
+    Config::init(argc, argv);
+    System::initialize(System::locate_install_dir(argv[0]));
+    ReactorFactory::initialize(2);
+
+    uint16_t port = Config::properties->get_i16("DfsBroker.Port");
+    InetAddr::initialize(&addr, "localhost", port);
+
+    conn_mgr = new ConnectionManager();
+    Global::dfs = new DfsBroker::Client(conn_mgr, addr, 15000);
+
+    // force broker client to be destroyed before connection manager
+    client = (DfsBroker::Client *)Global::dfs.get();
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    String testdir = "/CellStoreDeferredIndex_test";
+    if (client->exists(testdir))
+      client->rmdir(testdir);
+    client->mkdirs(testdir);
+
+    SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+    if (!schema->is_valid()) {
+      HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+      exit(1);
+    }
+
+    String csname = testdir + "/cs0";
+    {
+      PropertiesPtr cs_props = new Properties();
+      CellStorePtr cs = new CellStoreV6(Global::dfs.get(), schema.get());
+      DynamicBuffer dbuf;
+      uint8_t valuebuf[16];
+      uint8_t *uptr = valuebuf;
+      Key key;
+      char row[32];
+
+      Serialization::encode_vi32(&uptr, 5);
+      memcpy(uptr, "value", 5);
+
+      cs_props->set("blocksize", (uint32_t)4096);
+      cs->create(csname.c_str(), NUM_ROWS, cs_props, &table_id);
+      for (int i=0; i<NUM_ROWS; i++) {
+        sprintf(row, "row%06d", i);
+        dbuf.clear();
+        create_key_and_append(dbuf, FLAG_INSERT, row, 1, "q", i + 1, i + 1);
+        key.load(SerializedKey(dbuf.base));
+        cs->add(key, ByteString(valuebuf));
+      }
+      cs->finalize(&table_id);
+    }
+    int64_t file_length = client->length(csname);
+
+    // Reference: a quarter of the file, index loaded at open
+    const char *start_row = "row004999";
+    const char *end_row = "row009999";
+    CellStorePtr loaded = open_store(csname, start_row, end_row, false);
+    HT_ASSERT(!loaded->index_deferred());
+    HT_ASSERT(!loaded->disk_usage_estimated());
+    HT_ASSERT(loaded->block_index_memory_used() > 0);
+    HT_ASSERT(loaded->disk_usage() < (uint64_t)file_length);
+
+    // Deferred: the whole file is charged until the index is installed
+    CellStorePtr cs = open_store(csname, start_row, end_row, true);
+    HT_ASSERT(cs->index_deferred());
+    HT_ASSERT(cs->disk_usage_estimated());
+    HT_ASSERT(cs->block_index_memory_used() == 0);
+    HT_ASSERT(cs->disk_usage() == (uint64_t)file_length);
+    {
+      DynamicBuffer fixed, variable;
+      cs->read_deferred_index(fixed, variable);
+      // reading leaves the store untouched
+      HT_ASSERT(cs->index_deferred());
+      HT_ASSERT(cs->block_index_memory_used() == 0);
+      cs->install_deferred_index(fixed, variable);
+    }
+    HT_ASSERT(!cs->index_deferred());
+    HT_ASSERT(!cs->disk_usage_estimated());
+    HT_ASSERT(cs->disk_usage() == loaded->disk_usage());
+    HT_ASSERT(cs->block_count() == loaded->block_count());
+    HT_ASSERT(count_cells(cs, schema) == 5000);
+
+    // An index loaded on demand by a scan while the deferred one was being
+    // read wins; the buffers read meanwhile are dropped
+    cs = open_store(csname, start_row, end_row, true);
+    {
+      DynamicBuffer fixed, variable;
+      cs->read_deferred_index(fixed, variable);
+      HT_ASSERT(count_cells(cs, schema) == 5000);
+      HT_ASSERT(!cs->index_deferred());
+      int64_t index_memory = cs->block_index_memory_used();
+      HT_ASSERT(index_memory > 0);
+      cs->install_deferred_index(fixed, variable);
+      HT_ASSERT(cs->block_index_memory_used() == index_memory);
+      HT_ASSERT(fixed.base == 0 && variable.base == 0);
+    }
+    HT_ASSERT(cs->disk_usage() == loaded->disk_usage());
+
+    // A store covering the whole file has an exact disk usage without its
+    // index, but the index is still deferred and loaded in the background
+    cs = open_store(csname, "", Key::END_ROW_MARKER, true);
+    HT_ASSERT(cs->index_deferred());
+    HT_ASSERT(!cs->disk_usage_estimated());
+    HT_ASSERT(cs->block_index_memory_used() == 0);
+    {
+      DynamicBuffer fixed, variable;
+      cs->read_deferred_index(fixed, variable);
+      cs->install_deferred_index(fixed, variable);
+    }
+    HT_ASSERT(!cs->index_deferred());
+    HT_ASSERT(cs->block_index_memory_used() > 0);
+    HT_ASSERT(count_cells(cs, schema) == NUM_ROWS);
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
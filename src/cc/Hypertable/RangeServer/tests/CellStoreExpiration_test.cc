@@ -0,0 +1,138 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "Hypertable/Lib/Schema.h"
+
+#include "../CellStoreExpiration.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const int64_t DAY = 86400LL * 1000000000LL;
+
+  // "short" expires after one day, "long" after thirty
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily>\n"
+  "      <Name>short</Name>\n"
+  "      <ttl>86400</ttl>\n"
+  "    </ColumnFamily>\n"
+  "    <ColumnFamily>\n"
+  "      <Name>long</Name>\n"
+  "      <ttl>2592000</ttl>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  // "long" altered to sixty days
+  const char *schema2_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily>\n"
+  "      <Name>short</Name>\n"
+  "      <ttl>86400</ttl>\n"
+  "    </ColumnFamily>\n"
+  "    <ColumnFamily>\n"
+  "      <Name>long</Name>\n"
+  "      <ttl>5184000</ttl>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const char *schema3_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily>\n"
+  "      <Name>short</Name>\n"
+  "      <ttl>86400</ttl>\n"
+  "    </ColumnFamily>\n"
+  "    <ColumnFamily>\n"
+  "      <Name>forever</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  Schema::AccessGroup *load_access_group(const char *str, SchemaPtr &schema) {
+    schema = Schema::new_instance(str, strlen(str));
+    if (!schema->is_valid()) {
+      HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+      exit(1);
+    }
+    return schema->get_access_group("default");
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  CellStoreExpiration expiration;
+  SchemaPtr schema;
+  int64_t now = 1350000000LL * 1000000000LL;
+
+  expiration.set_schema(load_access_group(schema_str, schema));
+  HT_ASSERT(expiration.ttl() == 30 * DAY);
+
+  /*
+   * A "long" cell written ten days ago sits in an older store and a
+   * tombstone deleting it, written two days ago, in a newer one.  The
+   * tombstone has no TTL, so its store's expiration time has passed and
+   * its newest cell is older than the shortest TTL.  Dropping it would
+   * resurrect the cell, so it must not count as expired.
+   */
+  int64_t cell_ts = now - 10 * DAY;
+  int64_t tombstone_ts = now - 2 * DAY;
+  HT_ASSERT(!expiration.expired(cell_ts + 30 * DAY, cell_ts, cell_ts, now));
+  HT_ASSERT(!expiration.expired(tombstone_ts, tombstone_ts, tombstone_ts,
+                                now));
+
+  // Once older than the longest TTL, the tombstone and every cell it can
+  // shadow have expired
+  tombstone_ts = now - 31 * DAY;
+  cell_ts = tombstone_ts - DAY;
+  HT_ASSERT(expiration.expired(tombstone_ts, tombstone_ts, tombstone_ts, now));
+  HT_ASSERT(expiration.expired(cell_ts + 30 * DAY, cell_ts, cell_ts, now));
+
+  // Raising a TTL keeps stores whose trailer was computed with the old one
+  expiration.set_schema(load_access_group(schema2_str, schema));
+  HT_ASSERT(expiration.ttl() == 60 * DAY);
+  cell_ts = now - 40 * DAY;
+  HT_ASSERT(!expiration.expired(cell_ts + 30 * DAY, cell_ts, cell_ts, now));
+
+  // Stores without cells or with an unknown expiration time are kept
+  HT_ASSERT(!expiration.expired(TIMESTAMP_NULL, cell_ts, cell_ts, now));
+  HT_ASSERT(!expiration.expired(cell_ts, TIMESTAMP_MAX, TIMESTAMP_MIN, now));
+
+  // A column family without a TTL makes the access group ineligible
+  expiration.set_schema(load_access_group(schema3_str, schema));
+  HT_ASSERT(expiration.ttl() == 0);
+  cell_ts = now - 1000 * DAY;
+  HT_ASSERT(!expiration.expired(cell_ts, cell_ts, cell_ts, now));
+
+  return 0;
+}
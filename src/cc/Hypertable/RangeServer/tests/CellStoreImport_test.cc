@@ -0,0 +1,212 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/InetAddr.h"
+#include "Common/Serialization.h"
+#include "Common/System.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "AsyncComm/ConnectionManager.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "../CellStoreFactory.h"
+#include "../CellStoreV6.h"
+#include "../Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const int NUM_ROWS = 2000;
+
+  // Scans the store and checks that every cell carries revision
+  // <code>revision</code>, keeps its timestamp and comes back in order
+  size_t check_scan(CellStorePtr &cs, SchemaPtr &schema, const char *row,
+                    int64_t revision) {
+    RangeSpec range;
+    ScanSpecBuilder ssbuilder;
+    ScanContextPtr scan_ctx;
+    CellListScannerPtr scanner;
+    Key key;
+    ByteString value;
+    String last_row;
+    size_t count = 0;
+
+    range.start_row = "";
+    range.end_row = Key::END_ROW_MARKER;
+    if (row)
+      ssbuilder.add_cell(row, "tag:q");
+    scan_ctx = new ScanContext(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+    scanner = cs->create_scanner(scan_ctx);
+    while (scanner->get(key, value)) {
+      if (key.revision != revision) {
+        cout << "Error: " << key.row << " has revision " << key.revision
+             << ", expected " << revision << endl;
+        exit(1);
+      }
+      if (key.timestamp != atoi(&key.row[3]) + 1) {
+        cout << "Error: " << key.row << " has timestamp " << key.timestamp
+             << endl;
+        exit(1);
+      }
+      if (last_row.compare(key.row) >= 0) {
+        cout << "Error: " << key.row << " returned after " << last_row
+             << endl;
+        exit(1);
+      }
+      last_row = key.row;
+      count++;
+      scanner->forward();
+    }
+    return count;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  // The revision is only taken from names of the form cs<id>.r<revision>
+  HT_ASSERT(CellStore::imported_name("/t/cs12", 1234) == "/t/cs12.r1234");
+  HT_ASSERT(CellStore::imported_revision("/t/cs12.r1234") == 1234);
+  HT_ASSERT(CellStore::imported_revision("cs12.r1234") == 1234);
+  HT_ASSERT(CellStore::imported_revision("/t/cs3") == 0);
+  HT_ASSERT(CellStore::imported_revision("/t.r5/cs3") == 0);
+  HT_ASSERT(CellStore::imported_revision("/t/vlog3.r5") == 0);
+
+  try {
+    struct sockaddr_in addr;
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::ClientPtr client;
+    TableIdentifier table_id("0");
+    const int64_t builder_revision = 1000;
+    const int64_t import_revision = 5000;
+
+    Config::init(argc, argv);
+    System::initialize(System::locate_install_dir(argv[0]));
+    ReactorFactory::initialize(2);
+
+    uint16_t port = Config::properties->get_i16("DfsBroker.Port");
+    InetAddr::initialize(&addr, "localhost", port);
+
+    conn_mgr = new ConnectionManager();
+    Global::dfs = new DfsBroker::Client(conn_mgr, addr, 15000);
+
+    // force broker client to be destroyed before connection manager
+    client = (DfsBroker::Client *)Global::dfs.get();
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    String testdir = "/CellStoreImport_test";
+    if (client->exists(testdir))
+      client->rmdir(testdir);
+    client->mkdirs(testdir);
+
+    SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+    if (!schema->is_valid()) {
+      HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+      exit(1);
+    }
+
+    // Build a store the way csimport does, every cell at one revision
+    String csname = testdir + "/cs0";
+    {
+      PropertiesPtr cs_props = new Properties();
+      CellStorePtr cs = new CellStoreV6(Global::dfs.get(), schema.get());
+      DynamicBuffer dbuf;
+      uint8_t valuebuf[16];
+      uint8_t *uptr = valuebuf;
+      Key key;
+      char row[32];
+
+      Serialization::encode_vi32(&uptr, 5);
+      memcpy(uptr, "value", 5);
+
+      cs->create(csname.c_str(), NUM_ROWS, cs_props, &table_id);
+      for (int i=0; i<NUM_ROWS; i++) {
+        sprintf(row, "row%06d", i);
+        dbuf.clear();
+        create_key_and_append(dbuf, FLAG_INSERT, row, 1, "q", i + 1,
+                              builder_revision);
+        key.load(SerializedKey(dbuf.base));
+        cs->add(key, ByteString(valuebuf));
+      }
+      cs->finalize(&table_id);
+    }
+
+    CellStorePtr cs = CellStoreFactory::open(csname, "",
+                                             Key::END_ROW_MARKER);
+    HT_ASSERT(cs->get_revision_override() == 0);
+    HT_ASSERT(cs->get_revision() == builder_revision);
+    HT_ASSERT(check_scan(cs, schema, 0, builder_revision) == NUM_ROWS);
+
+    // Installing the store under an imported name replaces the revision of
+    // every cell without rewriting the file
+    String imported = CellStore::imported_name(testdir + "/cs1",
+                                               import_revision);
+    client->rename(csname, imported);
+    cs = CellStoreFactory::open(imported, "", Key::END_ROW_MARKER);
+    HT_ASSERT(cs->get_revision_override() == import_revision);
+    HT_ASSERT(cs->get_revision() == import_revision);
+    HT_ASSERT(check_scan(cs, schema, 0, import_revision) == NUM_ROWS);
+
+    // Point lookups still find their block
+    HT_ASSERT(check_scan(cs, schema, "row000000", import_revision) == 1);
+    HT_ASSERT(check_scan(cs, schema, "row001234", import_revision) == 1);
+    HT_ASSERT(check_scan(cs, schema, "row001999", import_revision) == 1);
+    HT_ASSERT(check_scan(cs, schema, "row002000", import_revision) == 0);
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,228 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/InetAddr.h"
+#include "Common/Path.h"
+#include "Common/Serialization.h"
+#include "Common/System.h"
+
+#include <cstdlib>
+#include <iostream>
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include "AsyncComm/ConnectionManager.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "../CellStoreFactory.h"
+#include "../CellStoreV6.h"
+#include "../Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const int NUM_ROWS = 5000;
+
+  // Scans the store, or the single row <code>row</code>, and checks that
+  // cells come back in order with their values
+  size_t check_scan(CellStorePtr &cs, SchemaPtr &schema, const char *row) {
+    RangeSpec range;
+    ScanSpecBuilder ssbuilder;
+    ScanContextPtr scan_ctx;
+    CellListScannerPtr scanner;
+    Key key;
+    ByteString value;
+    String last_row;
+    size_t count = 0;
+    char expected[32];
+
+    range.start_row = "";
+    range.end_row = Key::END_ROW_MARKER;
+    if (row)
+      ssbuilder.add_cell(row, "tag:q");
+    scan_ctx = new ScanContext(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+    scanner = cs->create_scanner(scan_ctx);
+    while (scanner->get(key, value)) {
+      if (last_row.compare(key.row) >= 0) {
+        cout << "Error: " << key.row << " returned after " << last_row
+             << endl;
+        exit(1);
+      }
+      sprintf(expected, "value%s", &key.row[3]);
+      if (value.length() != strlen(expected) ||
+          memcmp(value.str(), expected, value.length())) {
+        cout << "Error: bad value for " << key.row << endl;
+        exit(1);
+      }
+      last_row = key.row;
+      count++;
+      scanner->forward();
+    }
+    return count;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  try {
+    struct sockaddr_in addr;
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::ClientPtr client;
+    TableIdentifier table_id("0");
+
+    Config::init(argc, argv);
+    System::initialize(System::locate_install_dir(argv[0]));
+    ReactorFactory::initialize(2);
+
+    uint16_t port = Config::properties->get_i16("DfsBroker.Port");
+    InetAddr::initialize(&addr, "localhost", port);
+
+    conn_mgr = new ConnectionManager();
+    Global::dfs = new DfsBroker::Client(conn_mgr, addr, 15000);
+
+    // force broker client to be destroyed before connection manager
+    client = (DfsBroker::Client *)Global::dfs.get();
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    // Same root as the RangeServer computes for CellStore.Mmap
+    HT_ASSERT(Config::properties->has("DfsBroker.Local.Root"));
+    Path root = Config::properties->get_str("DfsBroker.Local.Root");
+    if (!root.is_complete()) {
+      Path data_dir = Config::properties->get_str("Hypertable.DataDirectory");
+      root = data_dir / root;
+    }
+    String mmap_root = root.string();
+
+    String testdir = "/CellStoreMmap_test";
+    if (client->exists(testdir))
+      client->rmdir(testdir);
+    client->mkdirs(testdir);
+
+    SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+    if (!schema->is_valid()) {
+      HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+      exit(1);
+    }
+
+    // Small uncompressed blocks, so the store spans many mapped blocks
+    String csname = testdir + "/cs0";
+    {
+      PropertiesPtr cs_props = new Properties();
+      CellStorePtr cs = new CellStoreV6(Global::dfs.get(), schema.get());
+      DynamicBuffer dbuf(256);  // big enough that key stays put
+      Key key;
+      char row[32], value[32];
+
+      cs_props->set("compressor", String("none"));
+      cs_props->set("blocksize", uint32_t(1024));
+      cs->create(csname.c_str(), NUM_ROWS, cs_props, &table_id);
+      for (int i=0; i<NUM_ROWS; i++) {
+        sprintf(row, "row%06d", i);
+        sprintf(value, "value%06d", i);
+        dbuf.clear();
+        create_key_and_append(dbuf, FLAG_INSERT, row, 1, "q", i + 1, i + 1);
+        key.load(SerializedKey(dbuf.base));
+        dbuf.set_mark();
+        append_as_byte_string(dbuf, value, strlen(value));
+        cs->add(key, ByteString(dbuf.mark));
+      }
+      cs->finalize(&table_id);
+    }
+
+    // Without a mapping root the store is read through the broker
+    CellStorePtr cs = CellStoreFactory::open(csname, "", Key::END_ROW_MARKER);
+    HT_ASSERT(cs->mapped_data() == 0);
+    HT_ASSERT(check_scan(cs, schema, 0) == NUM_ROWS);
+
+    // Mapped scans return the same cells, including on a second pass over
+    // blocks that have already been verified
+    Global::cellstore_mmap_root = mmap_root;
+    cs = CellStoreFactory::open(csname, "", Key::END_ROW_MARKER);
+    HT_ASSERT(cs->mapped_data() != 0);
+    HT_ASSERT(check_scan(cs, schema, 0) == NUM_ROWS);
+    HT_ASSERT(check_scan(cs, schema, 0) == NUM_ROWS);
+    HT_ASSERT(check_scan(cs, schema, "row000000") == 1);
+    HT_ASSERT(check_scan(cs, schema, "row002345") == 1);
+    HT_ASSERT(check_scan(cs, schema, "row004999") == 1);
+    HT_ASSERT(check_scan(cs, schema, "row005000") == 0);
+    cs = 0;
+
+    // A corrupted byte in the first data block is caught by the checksum
+    String path = mmap_root + csname;
+    int fd = ::open(path.c_str(), O_WRONLY);
+    HT_ASSERT(fd >= 0);
+    uint8_t garbage = 0xff;
+    HT_ASSERT(pwrite(fd, &garbage, 1, 512) == 1);
+    ::close(fd);
+
+    cs = CellStoreFactory::open(csname, "", Key::END_ROW_MARKER);
+    HT_ASSERT(cs->mapped_data() != 0);
+    try {
+      check_scan(cs, schema, "row000000");
+      HT_ERROR("Corrupted mapped block was not detected");
+      return 1;
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH);
+    }
+    cs = 0;
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
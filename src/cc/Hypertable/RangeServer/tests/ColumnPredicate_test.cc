@@ -0,0 +1,217 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Common/Init.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Serialization.h"
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/RangeState.h"
+#include "Hypertable/Lib/ScanSpec.h"
+#include "Hypertable/Lib/Schema.h"
+
+#include "../CellCache.h"
+#include "../Global.h"
+#include "../MergeScannerAccessGroup.h"
+#include "../ScanContext.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>hits</Name>\n"
+  "      <Counter>true</Counter>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  void check_parse(const char *str, bool valid, int64_t expected=0) {
+    int64_t value = 0;
+    if (CellFilterInfo::parse_integer(str, strlen(str), &value) != valid ||
+        (valid && value != expected)) {
+      cout << "Error: parse_integer(\"" << str << "\") failed" << endl;
+      exit(1);
+    }
+  }
+
+  bool matches(CellFilterInfo &cfi, const char *value) {
+    return cfi.column_predicate_matches(value, strlen(value));
+  }
+
+  void add_counter(CellCache *cache, const char *row, int64_t timestamp,
+                   int64_t increment) {
+    DynamicBuffer key_buf, value_buf;
+    Key key;
+    create_key_and_append(key_buf, FLAG_INSERT, row, 1, "", timestamp,
+                          timestamp);
+    key.load(SerializedKey(key_buf.base));
+    uint8_t *ptr;
+    value_buf.reserve(9);
+    ptr = value_buf.base;
+    *ptr++ = 8;
+    Serialization::encode_i64(&ptr, increment);
+    cache->add(key, ByteString(value_buf.base));
+  }
+
+}
+
+int main(int argc, char **argv) {
+  Config::init(argc, argv);
+
+  // Integers span the whole value and fit in 64 bits
+  check_parse("0", true, 0);
+  check_parse("-0", true, 0);
+  check_parse("+17", true, 17);
+  check_parse("-42", true, -42);
+  check_parse("9223372036854775807", true, INT64_MAX);
+  check_parse("-9223372036854775808", true, INT64_MIN);
+  check_parse("9223372036854775808", false);
+  check_parse("-9223372036854775809", false);
+  check_parse("99999999999999999999", false);
+  check_parse("", false);
+  check_parse("-", false);
+  check_parse("+", false);
+  check_parse(" 12", false);
+  check_parse("12 ", false);
+  check_parse("1.5", false);
+  check_parse("0x10", false);
+
+  // Values compare as bytes unless integer comparison is requested
+  {
+    CellFilterInfo lexical, integer;
+    lexical.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::GREATER_THAN, "9"));
+    integer.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::GREATER_THAN|ColumnPredicate::INTEGER_COMPARISON,
+        "9"));
+    HT_ASSERT(!matches(lexical, "10"));
+    HT_ASSERT(matches(integer, "10"));
+    HT_ASSERT(matches(lexical, "90"));
+    HT_ASSERT(matches(integer, "90"));
+    HT_ASSERT(matches(lexical, "a"));
+    HT_ASSERT(!matches(integer, "a"));
+    HT_ASSERT(!matches(lexical, "8"));
+    HT_ASSERT(!matches(integer, "-10"));
+  }
+
+  // Comparisons on a family must all hold
+  {
+    CellFilterInfo cfi;
+    uint32_t op = ColumnPredicate::INTEGER_COMPARISON;
+    cfi.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::GREATER_OR_EQUAL|op, "10"));
+    cfi.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::LESS_OR_EQUAL|op, "20"));
+    HT_ASSERT(!matches(cfi, "5"));
+    HT_ASSERT(matches(cfi, "10"));
+    HT_ASSERT(matches(cfi, "15"));
+    HT_ASSERT(matches(cfi, "20"));
+    HT_ASSERT(!matches(cfi, "25"));
+
+    // ... while exact matches remain alternatives
+    cfi.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::EXACT_MATCH, "12"));
+    cfi.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::EXACT_MATCH, "25"));
+    HT_ASSERT(matches(cfi, "12"));
+    HT_ASSERT(!matches(cfi, "15"));
+    HT_ASSERT(!matches(cfi, "25"));
+  }
+
+  // BETWEEN bounds are inclusive
+  {
+    CellFilterInfo lexical, integer;
+    lexical.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::BETWEEN, "b", "d"));
+    integer.add_column_predicate(ColumnPredicate("v",
+        ColumnPredicate::BETWEEN|ColumnPredicate::INTEGER_COMPARISON,
+        "-5", "5"));
+    HT_ASSERT(matches(lexical, "b"));
+    HT_ASSERT(matches(lexical, "cat"));
+    HT_ASSERT(matches(lexical, "d"));
+    HT_ASSERT(!matches(lexical, "dog"));
+    HT_ASSERT(matches(integer, "-5"));
+    HT_ASSERT(matches(integer, "5"));
+    HT_ASSERT(!matches(integer, "6"));
+  }
+
+  // Aggregated counters are filtered after the increments are summed
+  {
+    SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+    if (!schema->is_valid()) {
+      cout << "Error: " << schema->get_error_string() << endl;
+      exit(1);
+    }
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    CellCachePtr cache = new CellCache();
+    cache->lock();
+    add_counter(cache.get(), "a", 2, 1);    // 1
+    add_counter(cache.get(), "b", 2, 2);    // 5
+    add_counter(cache.get(), "b", 1, 3);
+    add_counter(cache.get(), "c", 3, 4);    // 12
+    add_counter(cache.get(), "c", 2, 4);
+    add_counter(cache.get(), "c", 1, 4);
+    add_counter(cache.get(), "d", 2, 10);   // 9
+    add_counter(cache.get(), "d", 1, -1);
+    add_counter(cache.get(), "e", 1, 7);    // 7
+    cache->unlock();
+
+    RangeSpec range;
+    range.start_row = "";
+    range.end_row = Key::END_ROW_MARKER;
+    ScanSpecBuilder ssb;
+    ssb.add_column_predicate(ColumnPredicate("hits",
+        ColumnPredicate::BETWEEN, "5", "9"));
+    ScanContextPtr scan_ctx = new ScanContext(TIMESTAMP_MAX, &ssb.get(),
+                                              &range, schema);
+
+    String table_name = "ColumnPredicate_test";
+    MergeScannerAccessGroup mscanner(table_name, scan_ctx);
+    mscanner.add_scanner(cache->create_scanner(scan_ctx));
+
+    Key key;
+    ByteString value;
+    String rows;
+    while (mscanner.get(key, value)) {
+      rows += key.row;
+      mscanner.forward();
+    }
+    if (rows != "bde") {
+      cout << "Error: counter rows \"" << rows << "\" expected \"bde\""
+           << endl;
+      exit(1);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/System.h"
+#include "Common/Time.h"
+
+#include "Hypertable/RangeServer/CompactionThrottle.h"
+
+using namespace Hypertable;
+using namespace std;
+
+#define RATE (1024 * 1024)
+#define CHUNK (64 * 1024)
+
+int main(int argc, char **argv) {
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  // A disabled throttle never waits
+  {
+    CompactionThrottle throttle(0);
+    for (int i=0; i<100; i++)
+      throttle.consume(RATE);
+    HT_ASSERT(throttle.wait_millis() == 0);
+  }
+
+  // The first second's worth is a burst, the rest is paced.  The clock is
+  // supplied by the test so the result does not depend on scheduling.
+  {
+    CompactionThrottle throttle(RATE);
+    HiResTime now;
+    HT_ASSERT(throttle.reserve(RATE, now) == 0);
+    HT_ASSERT(throttle.reserve(CHUNK, now) == (CHUNK * 1000) / RATE);
+    HT_ASSERT(throttle.reserve(2 * RATE - CHUNK, now) == 2000);
+
+    // Waiting out the debt brings the bucket back to empty
+    now += 2000;
+    HT_ASSERT(throttle.reserve(0, now) == 0);
+    HT_ASSERT(throttle.reserve(RATE / 2, now) == 500);
+
+    // A long idle period refills no more than one second's worth
+    now += 10000;
+    HT_ASSERT(throttle.reserve(RATE, now) == 0);
+    HT_ASSERT(throttle.reserve(CHUNK, now) == (CHUNK * 1000) / RATE);
+    HT_ASSERT(throttle.wait_millis() ==
+              2000 + 500 + 2 * ((CHUNK * 1000) / RATE));
+  }
+
+  // Consuming faster than the rate makes callers wait
+  {
+    CompactionThrottle throttle(RATE);
+    for (int64_t consumed = 0; consumed < RATE + 4 * CHUNK; consumed += CHUNK)
+      throttle.consume(CHUNK);
+    HT_ASSERT(throttle.wait_millis() > 0);
+  }
+
+  return 0;
+}
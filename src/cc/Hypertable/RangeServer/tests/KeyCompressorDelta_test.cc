@@ -0,0 +1,147 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Common/DynamicBuffer.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include "Hypertable/RangeServer/KeyCompressorDelta.h"
+#include "Hypertable/RangeServer/KeyCompressorPrefix.h"
+#include "Hypertable/RangeServer/KeyDecompressorDelta.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /** Builds serialized keys resembling a narrow time-series table, plus
+   * keys exercising every timestamp and revision encoding
+   */
+  void make_keys(DynamicBuffer &buf, vector<size_t> &offsets) {
+    char row[32], qualifier[16];
+    int64_t timestamp = 1350000000000000000LL;
+
+    for (int r=0; r<200; r++) {
+      sprintf(row, "host%03d.metrics.%d", r/10, r);
+      for (int q=0; q<8; q++) {
+        if (q == 0)
+          qualifier[0] = 0;
+        else
+          sprintf(qualifier, "cpu%d", q);
+        timestamp += 1000 + (rand() % 1000);
+        offsets.push_back(buf.fill());
+        switch (r % 4) {
+        case 0:
+          create_key_and_append(buf, FLAG_INSERT, row, 1, qualifier,
+                                timestamp, timestamp + 7);
+          break;
+        case 1:
+          create_key_and_append(buf, FLAG_INSERT, row, 2, qualifier,
+                                timestamp, timestamp);
+          break;
+        case 2:
+          create_key_and_append(buf, FLAG_INSERT, row, 3, qualifier,
+                                TIMESTAMP_NULL, timestamp - 5);
+          break;
+        default:
+          create_key_and_append(buf, FLAG_DELETE_CELL, row, 1, qualifier,
+                                timestamp - (rand() % 100000), timestamp);
+          break;
+        }
+      }
+    }
+  }
+
+  size_t compress(KeyCompressor *compressor, DynamicBuffer &keys,
+                  vector<size_t> &offsets, DynamicBuffer &output,
+                  size_t block_keys) {
+    Key key;
+    output.clear();
+    for (size_t i=0; i<offsets.size(); i++) {
+      if (i % block_keys == 0)
+        compressor->reset();
+      key.load(SerializedKey(keys.base + offsets[i]));
+      compressor->add(key);
+      output.ensure(compressor->length());
+      compressor->write(output.ptr);
+      output.ptr += compressor->length();
+    }
+    return output.fill();
+  }
+
+}
+
+int main(int argc, char **argv) {
+  DynamicBuffer keys;
+  DynamicBuffer output;
+  vector<size_t> offsets;
+  const size_t block_keys = 97;
+
+  srand(1);
+  make_keys(keys, offsets);
+
+  KeyCompressorPtr delta = new KeyCompressorDelta();
+  size_t delta_size = compress(delta.get(), keys, offsets, output, block_keys);
+
+  // Every key decompresses to exactly its original serialized form
+  KeyDecompressorDelta decompressor;
+  const uint8_t *ptr = output.base;
+  Key key, expected;
+  for (size_t i=0; i<offsets.size(); i++) {
+    if (i % block_keys == 0)
+      decompressor.reset();
+    ptr = decompressor.add(ptr);
+    decompressor.load(key);
+    expected.load(SerializedKey(keys.base + offsets[i]));
+    if (key.length != expected.length ||
+        memcmp(key.serial.ptr, expected.serial.ptr, key.length)) {
+      cout << "Error: key " << i << " mismatch, got " << key
+           << " expected " << expected << endl;
+      exit(1);
+    }
+    HT_ASSERT(!decompressor.less_than(expected.serial));
+  }
+  HT_ASSERT(ptr == output.ptr);
+
+  // The last key of a block is available uncompressed for the block index
+  DynamicBuffer last(delta->length_uncompressed());
+  delta->write_uncompressed(last.base);
+  HT_ASSERT(!memcmp(last.base, keys.base + offsets.back(),
+                    delta->length_uncompressed()));
+
+  KeyCompressorPtr prefix = new KeyCompressorPrefix();
+  DynamicBuffer prefix_output;
+  size_t prefix_size = compress(prefix.get(), keys, offsets, prefix_output,
+                                block_keys);
+  if (delta_size >= prefix_size) {
+    cout << "Error: delta encoding (" << delta_size << " bytes) is not "
+         << "smaller than prefix encoding (" << prefix_size << " bytes)"
+         << endl;
+    exit(1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <vector>
+
+#include "../Global.h"
+#include "../MergeRunSelector.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  typedef vector<MergeRunSelector::StoreInfo> StoreVector;
+
+  const int64_t WINDOW = 1000;
+  const int64_t NOW = 10500;
+
+  void add_store(StoreVector &stores, int64_t disk_usage,
+                 int64_t timestamp_min=0, int64_t timestamp_max=0,
+                 bool expired=false) {
+    stores.push_back(MergeRunSelector::StoreInfo(disk_usage, timestamp_min,
+                                                 timestamp_max, expired));
+  }
+
+  void add_sizes(StoreVector &stores, const int64_t *sizes, size_t count) {
+    for (size_t i=0; i<count; i++)
+      add_store(stores, sizes[i]);
+  }
+
+  bool run_is(MergeRunSelector &selector, StoreVector &stores,
+              size_t index, size_t len) {
+    size_t found_index, found_len;
+    if (!selector.find(stores, NOW, &found_index, &found_len))
+      return false;
+    return found_index == index && found_len == len;
+  }
+
+  void test_size_strategies() {
+    MergeRunSelector selector;
+    StoreVector stores;
+
+    selector.set_strategy("tiered");
+    HT_ASSERT(selector.run_length_threshold() == 3);
+    HT_ASSERT(selector.time_window() == 0);
+    HT_ASSERT(!selector.find(stores, NOW));
+
+    // Full size stores are never merged with their neighbours
+    int64_t full[] = { 200, 200, 5 };
+    add_sizes(stores, full, 3);
+    HT_ASSERT(!selector.find(stores, NOW));
+
+    // Small stores merge once they reach the minimum target size ...
+    int64_t fits[] = { 200, 6, 6 };
+    stores.clear();
+    add_sizes(stores, fits, 3);
+    HT_ASSERT(run_is(selector, stores, 1, 2));
+
+    // ... or once the run is longer than the run length threshold
+    int64_t short_run[] = { 200, 2, 2, 2 };
+    stores.clear();
+    add_sizes(stores, short_run, 4);
+    HT_ASSERT(!selector.find(stores, NOW));
+    add_store(stores, 2);
+    HT_ASSERT(run_is(selector, stores, 1, 4));
+
+    // A run that would exceed the maximum target size starts over
+    int64_t overflow[] = { 60, 60, 5 };
+    stores.clear();
+    add_sizes(stores, overflow, 3);
+    HT_ASSERT(!selector.find(stores, NOW));
+
+    // Leveled merges any two adjacent small stores
+    stores.clear();
+    add_sizes(stores, short_run, 3);
+    HT_ASSERT(!selector.find(stores, NOW));
+    selector.set_strategy("leveled");
+    HT_ASSERT(selector.run_length_threshold() == 1);
+    HT_ASSERT(run_is(selector, stores, 1, 2));
+  }
+
+  void test_time_window_strategy() {
+    MergeRunSelector selector;
+    StoreVector stores;
+
+    selector.set_strategy("TimeWindow");
+    HT_ASSERT(selector.run_length_threshold() == 3);
+    HT_ASSERT(selector.time_window() == WINDOW);
+
+    // A closed window is merged into one store whatever its size
+    add_store(stores, 200, 7000, 7999);
+    add_store(stores, 200, 7100, 7900);
+    add_store(stores, 2, 10100, 10200);
+    HT_ASSERT(run_is(selector, stores, 0, 2));
+
+    // Closed windows holding an expired store, and closed windows that
+    // are already a single store, are skipped.  The current window is
+    // merged by size.
+    stores.clear();
+    add_store(stores, 2, 7000, 7999, true);
+    add_store(stores, 2, 7100, 7900);
+    add_store(stores, 2, 8000, 8500);
+    for (int i=0; i<3; i++)
+      add_store(stores, 2, 10100 + i, 10200 + i);
+    HT_ASSERT(!selector.find(stores, NOW));
+    add_store(stores, 2, 10300, 10400);
+    HT_ASSERT(run_is(selector, stores, 3, 4));
+
+    // A store is placed by its newest cell, so late arrivals keep it in
+    // the current window
+    stores.clear();
+    add_store(stores, 2, 7500, 7600);
+    add_store(stores, 2, 7500, 10100);
+    for (int i=0; i<2; i++)
+      add_store(stores, 2, 10100, 10200);
+    HT_ASSERT(!selector.find(stores, NOW));
+    add_store(stores, 2, 10100, 10200);
+    HT_ASSERT(run_is(selector, stores, 1, 4));
+
+    // Stores without timestamps are never treated as a closed window
+    stores.clear();
+    for (int i=0; i<3; i++)
+      add_store(stores, 2, 1, 0);
+    HT_ASSERT(!selector.find(stores, NOW));
+    add_store(stores, 2, 1, 0);
+    HT_ASSERT(run_is(selector, stores, 0, 4));
+  }
+
+  // With Hypertable.RangeServer.CellStore.Merge.TimeWindow set to 0 the
+  // timewindow strategy falls back to the tiered rules
+  void test_zero_time_window() {
+    MergeRunSelector selector;
+    StoreVector stores;
+
+    Global::merge_cellstore_time_window = 0;
+    selector.set_strategy("timewindow");
+    HT_ASSERT(selector.time_window() == 0);
+    HT_ASSERT(selector.run_length_threshold() == 3);
+
+    add_store(stores, 200, 7000, 7999);
+    add_store(stores, 200, 7100, 7900);
+    HT_ASSERT(!selector.find(stores, NOW));
+    for (int i=0; i<4; i++)
+      add_store(stores, 2, 10100, 10200);
+    HT_ASSERT(run_is(selector, stores, 2, 4));
+    Global::merge_cellstore_time_window = WINDOW;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  Global::cellstore_target_size_min = 10;
+  Global::cellstore_target_size_max = 100;
+  Global::merge_cellstore_run_length_threshold = 3;
+  Global::merge_cellstore_time_window = WINDOW;
+
+  test_size_strategies();
+  test_time_window_strategy();
+  test_zero_time_window();
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+
+#include "Common/Config.h"
+#include "Common/Init.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/System.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include "Hypertable/RangeServer/Global.h"
+#include "Hypertable/RangeServer/RowCache.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  CellCachePtr make_row(const char *row, size_t cells) {
+    CellCachePtr cache = new CellCache(false);
+    DynamicBuffer buf;
+    Key key;
+    ByteString value;
+    char qualifier[16];
+
+    cache->arena().set_page_size(4096);
+    cache->lock();
+    for (size_t i=0; i<cells; i++) {
+      buf.clear();
+      sprintf(qualifier, "q%d", (int)i);
+      create_key_and_append(buf, FLAG_INSERT, row, 1, qualifier, i+1, i+1);
+      append_as_byte_string(buf, "value", 5);
+      key.load(SerializedKey(buf.base));
+      value.ptr = buf.base + key.length;
+      cache->add(key, value);
+    }
+    cache->unlock();
+    return cache;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  Config::init(argc, argv);
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  RowCache cache(64 * 1024);
+  Global::memory_tracker = new MemoryTracker(0, 0, &cache);
+  String ag("1(default)");
+  int64_t generation = cache.new_generation();
+
+  if (cache.lookup(ag, "aa", generation)) {
+    cout << "Error: row should not exist in cache." << endl;
+    exit(1);
+  }
+
+  CellCachePtr cells = make_row("aa", 10);
+  if (!cache.insert(ag, "aa", generation, cells)) {
+    cout << "Error: insert failed." << endl;
+    exit(1);
+  }
+
+  CellCachePtr found = cache.lookup(ag, "aa", generation);
+  if (!found || found->size() != 10) {
+    cout << "Error: row not found." << endl;
+    exit(1);
+  }
+
+  // a new generation of the access group must not see the old row
+  int64_t next_generation = cache.new_generation();
+  HT_ASSERT(next_generation != generation);
+  if (cache.lookup(ag, "aa", next_generation)) {
+    cout << "Error: stale row returned." << endl;
+    exit(1);
+  }
+  HT_ASSERT(cache.memory_used() == 0);
+
+  // fill past the limit; the least recently used rows are evicted
+  char row[8];
+  for (int i=0; i<64; i++) {
+    sprintf(row, "r%02d", i);
+    cells = make_row(row, 10);
+    cache.insert(ag, row, next_generation, cells);
+  }
+  HT_ASSERT(cache.memory_used() <= 64 * 1024);
+  if (cache.lookup(ag, "r00", next_generation)) {
+    cout << "Error: least recently used row not evicted." << endl;
+    exit(1);
+  }
+  if (!cache.lookup(ag, "r63", next_generation)) {
+    cout << "Error: most recently inserted row not found." << endl;
+    exit(1);
+  }
+
+  // Cached rows are charged to the memory tracker once, by the row cache
+  HT_ASSERT(Global::memory_tracker->balance() == (int64_t)cache.memory_used());
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <poll.h>
+#include <unistd.h>
+}
+
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+#include "Common/System.h"
+
+#include "Hypertable/RangeServer/SsdBlockCache.h"
+
+using namespace Hypertable;
+using namespace std;
+
+#define BLOCK_SIZE 1000
+#define CAPACITY (10 * BLOCK_SIZE)
+
+namespace {
+
+  void fill_block(uint8_t *block, int id) {
+    for (size_t i=0; i<BLOCK_SIZE; i++)
+      block[i] = (uint8_t)(id + i);
+  }
+
+  /** Waits for the background writer to put the block on disk, which is
+   * when the cache file holds <code>cached</code> bytes.  Reads of blocks
+   * still in the write buffer succeed, so the read alone is not enough.
+   */
+  bool wait_for_block(SsdBlockCache &cache, int file_id, uint64_t offset,
+                      uint8_t *buf, uint64_t cached) {
+    uint64_t capacity, used, accesses, hits;
+    for (int i=0; i<500; i++) {
+      cache.get_stats(&capacity, &used, &accesses, &hits);
+      if (used >= cached && cache.read(file_id, offset, buf, BLOCK_SIZE))
+        return true;
+      poll(0, 0, 10);
+    }
+    return false;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  uint8_t block[BLOCK_SIZE];
+  uint8_t buf[BLOCK_SIZE];
+  String dir = format("./ssd_block_cache_test.%d", (int)getpid());
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  {
+    SsdBlockCache cache(dir, CAPACITY, 4 * BLOCK_SIZE);
+
+    HT_ASSERT(!cache.read(1, 0, buf, BLOCK_SIZE));
+
+    fill_block(block, 1);
+    cache.insert(1, 0, block, BLOCK_SIZE);
+    HT_ASSERT(wait_for_block(cache, 1, 0, buf, BLOCK_SIZE));
+    HT_ASSERT(memcmp(block, buf, BLOCK_SIZE) == 0);
+
+    // Wrong length is a miss
+    HT_ASSERT(!cache.read(1, 0, buf, BLOCK_SIZE / 2));
+
+    // Offsets beyond 4GB do not alias blocks of other files
+    HT_ASSERT(!cache.read(0, (uint64_t)1 << 32, buf, BLOCK_SIZE));
+    HT_ASSERT(!cache.read(1, (uint64_t)1 << 32, buf, BLOCK_SIZE));
+
+    // Filling the file once more wraps the log over the first block
+    for (int i=2; i<=CAPACITY/BLOCK_SIZE + 1; i++) {
+      fill_block(block, i);
+      cache.insert(i, 0, block, BLOCK_SIZE);
+      HT_ASSERT(wait_for_block(cache, i, 0, buf,
+                               std::min(i, CAPACITY/BLOCK_SIZE) * BLOCK_SIZE));
+      HT_ASSERT(memcmp(block, buf, BLOCK_SIZE) == 0);
+    }
+    int tries = 0;
+    while (cache.read(1, 0, buf, BLOCK_SIZE) && tries++ < 500)
+      poll(0, 0, 10);
+    HT_ASSERT(!cache.read(1, 0, buf, BLOCK_SIZE));
+    HT_ASSERT(cache.read(CAPACITY/BLOCK_SIZE + 1, 0, buf, BLOCK_SIZE));
+  }
+
+  rmdir(dir.c_str());
+
+  return 0;
+}
@@ -0,0 +1,278 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/ByteString.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/InetAddr.h"
+#include "Common/Serialization.h"
+#include "Common/System.h"
+
+#include <iostream>
+
+#include "AsyncComm/ConnectionManager.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "../Global.h"
+#include "../ValueLog.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  String make_value(size_t len, char c) {
+    DynamicBuffer buf(len + 8);
+    Serialization::encode_vi32(&buf.ptr, len);
+    memset(buf.ptr, c, len);
+    buf.ptr += len;
+    return String((const char *)buf.base, buf.fill());
+  }
+
+  ByteString as_value(const String &str) {
+    return ByteString((const uint8_t *)str.c_str());
+  }
+
+  String copy_value(const ByteString value) {
+    return String((const char *)value.ptr, value.length());
+  }
+
+  void check_read(ValueLogReader &reader, const String &ref,
+                  const String &expected) {
+    DynamicBuffer buf;
+    ByteString value;
+    reader.read(as_value(ref), buf, value);
+    if (copy_value(value) != expected) {
+      cout << "Error: value read from value log does not match" << endl;
+      exit(1);
+    }
+  }
+
+  String log_of(const String &ref) {
+    ValueLogReference value_ref;
+    value_ref.decode(as_value(ref));
+    return Global::toplevel_dir + "/tables/" +
+      String(value_ref.fname, value_ref.fname_len);
+  }
+
+
+  void check_value(size_t len) {
+    DynamicBuffer buf(len + 8);
+    Serialization::encode_vi32(&buf.ptr, len);
+    memset(buf.ptr, 'x', len);
+    buf.ptr += len;
+    if (ValueLogReference::is_reference(ByteString(buf.base))) {
+      cout << "Error: value of length " << len << " taken for a value log "
+           << "reference" << endl;
+      exit(1);
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+  const size_t lengths[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152,
+                             268435455 };
+
+  // Ordinary values never look like references
+  for (size_t i=0; i<sizeof(lengths)/sizeof(size_t); i++)
+    check_value(lengths[i]);
+  HT_ASSERT(!ValueLogReference::is_reference(ByteString()));
+
+  DynamicBuffer buf;
+  String fname = "2/default/AB2A0D28DE6B77FFDD6C72AF/vlog12";
+  ValueLogReference::encode(buf, fname, 5000000000ULL, 1048576, 0xDEADBEEF);
+
+  ByteString value(buf.base);
+  HT_ASSERT(ValueLogReference::is_reference(value));
+  HT_ASSERT(value.length() == buf.fill());
+
+  ValueLogReference ref;
+  ref.decode(value);
+  HT_ASSERT(ref.offset == 5000000000ULL);
+  HT_ASSERT(ref.length == 1048576);
+  HT_ASSERT(ref.checksum == 0xDEADBEEF);
+  HT_ASSERT(fname == String(ref.fname, ref.fname_len));
+
+  // References survive being copied the way CellStores copy values
+  DynamicBuffer copy(value.length());
+  copy.ptr += value.write(copy.base);
+  HT_ASSERT(ValueLogReference::is_reference(ByteString(copy.base)));
+
+  // Only names written by ValueLogWriter are accepted
+  HT_ASSERT(ValueLogReference::valid_name(fname.c_str(), fname.length()));
+  const char *bad_names[] = { "", "vlog", "/hypertable/tables/2/vlog1",
+                              "2/default/../../../etc/vlog1", "2/./vlog1",
+                              "2//vlog1", "2/default/AB/cs3", "2/default/" };
+  for (size_t i=0; i<sizeof(bad_names)/sizeof(const char *); i++) {
+    HT_ASSERT(!ValueLogReference::valid_name(bad_names[i],
+                                             strlen(bad_names[i])));
+    ValueLogReference::encode(buf, bad_names[i], 0, 10, 0);
+    try {
+      ref.decode(ByteString(buf.base));
+      cout << "Error: reference to '" << bad_names[i] << "' accepted" << endl;
+      exit(1);
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::RANGESERVER_CORRUPT_CELLSTORE);
+    }
+  }
+
+  // Logs inherited through a split are charged by share until measured
+  {
+    ValueLogSet logs;
+    std::vector<String> removed;
+    std::map<String, uint64_t> live;
+    std::set<String> rewrite;
+
+    logs.load("/hypertable/tables/vlog1", 1000000);
+    logs.load("/hypertable/tables/vlog2", 400000);
+    HT_ASSERT(logs.disk_usage(1.0) == 1400000);
+    HT_ASSERT(logs.disk_usage(0.5) == 700000);
+    logs.get_rewrite_candidates(rewrite);
+    HT_ASSERT(rewrite.empty());
+
+    logs.add("/hypertable/tables/vlog3", 2000);
+    HT_ASSERT(logs.disk_usage(0.5) == 702000);
+
+    live["/hypertable/tables/vlog1"] = 100000;
+    live["/hypertable/tables/vlog3"] = 2000;
+    logs.set_live_bytes(live, removed);
+    HT_ASSERT(removed.size() == 1 && removed[0] == "/hypertable/tables/vlog2");
+    HT_ASSERT(logs.disk_usage(0.5) == 102000);
+    logs.get_rewrite_candidates(rewrite);
+    HT_ASSERT(rewrite.size() == 1 &&
+              *rewrite.begin() == "/hypertable/tables/vlog1");
+  }
+
+  try {
+    struct sockaddr_in addr;
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::ClientPtr client;
+
+    Config::init(argc, argv);
+    System::initialize(System::locate_install_dir(argv[0]));
+    ReactorFactory::initialize(2);
+
+    uint16_t port = Config::properties->get_i16("DfsBroker.Port");
+    InetAddr::initialize(&addr, "localhost", port);
+
+    conn_mgr = new ConnectionManager();
+    Global::dfs = new DfsBroker::Client(conn_mgr, addr, 15000);
+
+    // force broker client to be destroyed before connection manager
+    client = (DfsBroker::Client *)Global::dfs.get();
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::toplevel_dir = "/ValueLog_test";
+    String dir = Global::toplevel_dir +
+      "/tables/2/default/AB2A0D28DE6B77FFDD6C72AF";
+    client->mkdirs(dir);
+
+    ValueLogReader reader(Global::dfs.get(), 2);
+    ValueLogSet logs;
+    Key key;
+    std::set<String> rewrite;
+    std::vector<String> removed;
+    ByteString value;
+
+    // A log inherited from the parent range that nothing references
+    logs.load(dir + "/vlog0", 1000);
+
+    // Minor compaction moves large inserts to the new log
+    String large[3] = { make_value(200, 'a'), make_value(300, 'b'),
+                        make_value(400, 'c') };
+    String small = make_value(10, 'd');
+    String refs[3];
+    {
+      ValueLogWriterPtr writer =
+        new ValueLogWriter(Global::dfs.get(), dir + "/vlog1");
+      ValueLogCompactor compactor(&reader, writer.get(), 100, rewrite);
+      for (size_t i=0; i<3; i++) {
+        value = as_value(large[i]);
+        compactor.process(key, false, value);
+        HT_ASSERT(ValueLogReference::is_reference(value));
+        refs[i] = copy_value(value);
+      }
+      value = as_value(small);
+      compactor.process(key, false, value);
+      HT_ASSERT(copy_value(value) == small);
+      value = as_value(large[0]);
+      compactor.process(key, true, value);
+      HT_ASSERT(copy_value(value) == large[0]);
+      writer->close();
+      HT_ASSERT(writer->size() == 900);
+      logs.add(writer->get_filename(), writer->size());
+    }
+    for (size_t i=0; i<3; i++) {
+      HT_ASSERT(log_of(refs[i]) == dir + "/vlog1");
+      check_read(reader, refs[i], large[i]);
+    }
+
+    // Major compaction after two of the values were deleted drops the
+    // unreferenced log and marks the mostly dead one for rewriting
+    {
+      ValueLogCompactor compactor(&reader, 0, 100, rewrite);
+      value = as_value(refs[0]);
+      compactor.process(key, false, value);
+      HT_ASSERT(copy_value(value) == refs[0]);
+      logs.set_live_bytes(compactor.live_bytes(), removed);
+      HT_ASSERT(removed.size() == 1 && removed[0] == dir + "/vlog0");
+      HT_ASSERT(logs.disk_usage(1.0) == 200);
+    }
+    logs.get_rewrite_candidates(rewrite);
+    HT_ASSERT(rewrite.size() == 1 && *rewrite.begin() == dir + "/vlog1");
+
+    // The next one copies the live value to a new log and drops the old
+    {
+      ValueLogWriterPtr writer =
+        new ValueLogWriter(Global::dfs.get(), dir + "/vlog2");
+      ValueLogCompactor compactor(&reader, writer.get(), 100, rewrite);
+      value = as_value(refs[0]);
+      compactor.process(key, false, value);
+      HT_ASSERT(ValueLogReference::is_reference(value));
+      refs[0] = copy_value(value);
+      writer->close();
+      removed.clear();
+      logs.set_live_bytes(compactor.live_bytes(), removed);
+      HT_ASSERT(removed.size() == 1 && removed[0] == dir + "/vlog1");
+      logs.add(writer->get_filename(), writer->size());
+    }
+    HT_ASSERT(log_of(refs[0]) == dir + "/vlog2");
+    check_read(reader, refs[0], large[0]);
+    HT_ASSERT(logs.disk_usage(1.0) == 200);
+
+    client->rmdir(Global::toplevel_dir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
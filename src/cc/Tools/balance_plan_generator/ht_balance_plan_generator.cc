@@ -39,6 +39,7 @@ extern "C" {
 #include "Hypertable/Lib/Config.h"
 #include "Hypertable/Lib/Client.h"
 #include "Hypertable/Lib/BalancePlan.h"
+#include "Hypertable/Master/BalanceAlgorithmHeat.h"
 #include "Hypertable/Master/BalanceAlgorithmLoad.h"
 
 using namespace Hypertable;
@@ -70,7 +71,9 @@ namespace {
         ("rs-metrics-loaded",  boo()->zero_tokens()->default_value(false),
          "If true then assume RS_METRICS is already loaded in namespace/table")
         ("load-balancer", str()->default_value("basic-distribute-load"),
-         "Type of load balancer to be used.")
+         "Type of load balancer to be used (basic-distribute-load or heat).")
+        ("server", strs(), "Location of a RangeServer to balance across in "
+         "addition to those in the metrics (heat balancer only)")
         ("verbose,v", boo()->zero_tokens()->default_value(false),
          "Show more verbose output")
         ("balance-plan-file,b",  str()->default_value(""),
@@ -159,17 +162,30 @@ int main(int argc, char **argv) {
 void generate_balance_plan(PropertiesPtr &props, const String &load_balancer,
     ContextPtr &context, BalancePlanPtr &plan) {
 
-  if (load_balancer != "basic-distribute-load")
+  if (load_balancer != "basic-distribute-load" && load_balancer != "heat")
     HT_THROW(Error::NOT_IMPLEMENTED,
-             (String)"Only 'basic-distribute-load' balancer is supported. '" + load_balancer
-             + "' balancer not supported.");
+             (String)"Only 'basic-distribute-load' and 'heat' balancers are "
+             "supported. '" + load_balancer + "' balancer not supported.");
 
   std::vector<RangeServerStatistics> range_server_stats;
   // TODO fill this vector; otherwise disk usage is not taken into account
 
-  BalanceAlgorithmLoad balancer(context, range_server_stats);
   std::vector<RangeServerConnectionPtr> balanced;
-  balancer.compute_plan(plan, balanced);
+  if (load_balancer == "heat") {
+    // servers without metrics are only known from their statistics
+    if (props->has("server")) {
+      foreach_ht (const String &location, props->get_strs("server")) {
+        range_server_stats.push_back(RangeServerStatistics());
+        range_server_stats.back().location = location;
+      }
+    }
+    BalanceAlgorithmHeat balancer(context, range_server_stats);
+    balancer.compute_plan(plan, balanced);
+  }
+  else {
+    BalanceAlgorithmLoad balancer(context, range_server_stats);
+    balancer.compute_plan(plan, balanced);
+  }
 }
 
 
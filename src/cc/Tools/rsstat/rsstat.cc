@@ -25,6 +25,10 @@
 #include "Common/InetAddr.h"
 #include "Common/Logger.h"
 
+extern "C" {
+#include <unistd.h>
+}
+
 #include "AsyncComm/Comm.h"
 #include "AsyncComm/ConnectionManager.h"
 
@@ -36,7 +40,21 @@
 using namespace Hypertable;
 using namespace Config;
 
-typedef Meta::list<RangeServerClientPolicy, DefaultCommPolicy> Policies;
+namespace {
+
+  struct AppPolicy : Config::Policy {
+    static void init_options() {
+      cmdline_desc().add_options()
+        ("interval", i32()->default_value(0), "Report latencies over this "
+         "many seconds instead of since the range server started")
+        ;
+    }
+  };
+
+  typedef Meta::list<AppPolicy, RangeServerClientPolicy, DefaultCommPolicy>
+          Policies;
+
+}
 
 int main(int argc, char **argv) {
   try {
@@ -55,14 +73,43 @@ int main(int argc, char **argv) {
 
     RangeServerClient *client = new RangeServerClient(comm, timeout);
     StatsRangeServer stats;
-    String stats_str;
+    int interval = get_i32("interval");
 
     client->get_statistics(addr, stats);
-    /** FIXME!!
-    stats->dump_str(stats_str);
 
-    std::cout << stats_str << std::endl;
-    */
+    // The server reports cumulative latencies; take a second sample and
+    // difference the two to cover just the interval
+    if (interval > 0) {
+      std::vector<LatencyHistogram> earlier;
+      earlier.swap(stats.latency);
+      sleep(interval);
+      client->get_statistics(addr, stats);
+      for (size_t i=0; i<stats.latency.size() && i<earlier.size(); i++)
+        stats.latency[i].subtract(earlier[i]);
+    }
+
+    std::cout << "Location:  " << stats.location << "\n";
+    std::cout << "Version:   " << stats.version << "\n";
+    std::cout << "Scans:     " << stats.scan_count << " ("
+              << stats.scanned_cells << " cells, "
+              << stats.scanned_bytes << " bytes)\n";
+    std::cout << "Updates:   " << stats.update_count << " ("
+              << stats.updated_cells << " cells, "
+              << stats.updated_bytes << " bytes)\n";
+    std::cout << "Syncs:     " << stats.sync_count << "\n\n";
+
+    std::cout << format("%-16s %10s %10s %10s %10s %10s %10s %10s",
+                        "latency (us)", "count", "mean", "p50", "p90",
+                        "p99", "p99.9", "max") << "\n";
+    for (size_t i=0; i<stats.latency.size(); i++) {
+      const LatencyHistogram &h = stats.latency[i];
+      std::cout << format("%-16s %10llu %10.0f %10llu %10llu %10llu %10llu %10llu",
+                          StatsRangeServer::latency_metric_name(i),
+                          (Llu)h.count(), h.mean(), (Llu)h.percentile(50.0),
+                          (Llu)h.percentile(90.0), (Llu)h.percentile(99.0),
+                          (Llu)h.percentile(99.9), (Llu)h.max()) << "\n";
+    }
+    std::cout << std::flush;
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+
+HT_HOME=${INSTALL_DIR:-"$HOME/hypertable/current"}
+HYPERTABLE_HOME=$HT_HOME
+SCRIPT_DIR=`dirname $0`
+DATA_SIZE=${DATA_SIZE:-"5000000"}
+AG_MAXMEM=250000
+
+. $HT_HOME/bin/ht-env.sh
+
+restart_servers() {
+  $HT_HOME/bin/start-test-servers.sh $@ --no-thriftbroker \
+      --Hypertable.RangeServer.AccessGroup.MaxMemory=$AG_MAXMEM \
+      --Hypertable.RangeServer.Range.SplitSize=1M \
+      --Hypertable.RangeServer.CellStore.LazyIndex=true \
+      --Hypertable.RangeServer.LoadThreads=4 \
+      --Hypertable.Mutator.FlushDelay=10
+}
+
+restart_servers --clear
+
+$HT_HOME/bin/hypertable --no-prompt < $SCRIPT_DIR/create-table.hql
+
+echo "================="
+echo "random WRITE test"
+echo "================="
+$HT_HOME/bin/random_write_test --blocksize=100 $DATA_SIZE || exit 1
+
+# Ranges come back with their CellStore indexes deferred; the first read
+# runs while they are being loaded in the background
+restart_servers
+
+echo "================="
+echo "random READ test"
+echo "================="
+$HT_HOME/bin/random_read_test --blocksize=100 $DATA_SIZE || exit 1
+
+echo "================="
+echo "random READ test"
+echo "================="
+$HT_HOME/bin/random_read_test --blocksize=100 $DATA_SIZE || exit 1
+
+exit 0
@@ -8,6 +8,8 @@ TEST_BIN=./load_balancer_test
 TEST_OUTPUT_FILE="load_balancer_test.out"
 BALANCE_OUTPUT_FILE="balance_plans.out"
 BALANCE_GOLDEN_FILE="${SCRIPT_DIR}/balance_plans.golden"
+HEAT_OUTPUT_FILE="heat_balance_plans.out"
+HEAT_GOLDEN_FILE="${SCRIPT_DIR}/heat_balance_plans.golden"
 TEST_RS_METRICS_FILE="${SCRIPT_DIR}/rs_metrics.txt"
 
 $HT_HOME/bin/start-test-servers.sh --clean
@@ -16,6 +18,10 @@ if [ -e $BALANCE_OUTPUT_FILE ]; then
   rm $BALANCE_OUTPUT_FILE 
 fi
 
+if [ -e $HEAT_OUTPUT_FILE ]; then
+  rm $HEAT_OUTPUT_FILE
+fi
+
 set -e
 
 cmd="$HT_HOME/bin/ht ht_balance_plan_generator --Hypertable.LoadBalancer.LoadavgThreshold=.001 --balance-plan-file=${BALANCE_OUTPUT_FILE} --rs-metrics-dump ${TEST_RS_METRICS_FILE}"
@@ -38,4 +44,25 @@ cmd="diff ${BALANCE_OUTPUT_FILE} ${BALANCE_GOLDEN_FILE}"
 echo "$cmd"
 ${cmd}
 
+cmd="$HT_HOME/bin/ht ht_balance_plan_generator --load-balancer=heat --Hypertable.LoadBalancer.Heat.Threshold=.2 --balance-plan-file=${HEAT_OUTPUT_FILE} --rs-metrics-loaded"
+echo "$cmd"
+${cmd}
+
+cmd="$HT_HOME/bin/ht ht_balance_plan_generator --load-balancer=heat --Hypertable.LoadBalancer.Heat.Threshold=.5 --balance-plan-file=${HEAT_OUTPUT_FILE} --rs-metrics-loaded"
+echo "$cmd"
+${cmd}
+
+# rs5 has no RS_METRICS rows and is the coldest destination
+cmd="$HT_HOME/bin/ht ht_balance_plan_generator --load-balancer=heat --Hypertable.LoadBalancer.Heat.Threshold=.2 --server=rs5 --balance-plan-file=${HEAT_OUTPUT_FILE} --rs-metrics-loaded"
+echo "$cmd"
+${cmd}
+
+cmd="$HT_HOME/bin/ht ht_balance_plan_generator --load-balancer=heat --Hypertable.LoadBalancer.Heat.Threshold=2 --balance-plan-file=${HEAT_OUTPUT_FILE} --rs-metrics-loaded"
+echo "$cmd"
+${cmd}
+
+cmd="diff ${HEAT_OUTPUT_FILE} ${HEAT_GOLDEN_FILE}"
+echo "$cmd"
+${cmd}
+
 exit 0
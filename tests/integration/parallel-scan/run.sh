@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+
+HT_HOME=${INSTALL_DIR:-"$HOME/hypertable/current"}
+NUM_ROWS=${NUM_ROWS:-"100000"}
+
+set -v
+
+# A small split size leaves the table with more ranges than the scanner
+# parallelism, so partitions are started as earlier ones finish
+$HT_HOME/bin/start-test-servers.sh --clear --no-thriftbroker \
+    --Hypertable.RangeServer.Range.SplitSize=1M
+
+cd ${TEST_BIN_DIR}
+./parallel_scan_test ${NUM_ROWS} || exit 1
+
+exit 0
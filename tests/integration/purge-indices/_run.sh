@@ -7,6 +7,7 @@ HT_SHELL=$HT_HOME/bin/hypertable
 SCRIPT_DIR=`dirname $0`
 HQL_CREATE=$1
 LOAD_GEN_FLAG=$2
+DATA_SPEC=${3:-data.spec}
 
 . $HT_HOME/bin/ht-env.sh
 
@@ -22,7 +23,7 @@ sleep 3
 $HT_SHELL --batch --no-prompt < $SCRIPT_DIR/$HQL_CREATE
 
 $HT_HOME/bin/ht ht_load_generator update \
-    --spec-file=${SCRIPT_DIR}/data.spec \
+    --spec-file=${SCRIPT_DIR}/$DATA_SPEC \
     --table=IndexTest --max-keys=30000 \
     --row-seed=1 --seed=1 $LOAD_GEN_FLAG \
     --delete-percentage=30
@@ -0,0 +1,29 @@
+#!/usr/bin/env bash
+
+HT_HOME=${INSTALL_DIR:-"/opt/hypertable/current"}
+HT_SHELL=$HT_HOME/bin/hypertable
+
+echo "========================================================================"
+echo "Purge indices tests 6 (values in a value log)"
+echo "========================================================================"
+
+SCRIPT_DIR=`dirname $0`
+
+$SCRIPT_DIR/_run.sh create-table-value-log.hql "" data-value-log.spec
+if [ $? -ne "0" ]
+then
+  exit -1
+fi
+
+# compactions see value log references instead of values; the index
+# entries of deleted cells must still have been purged
+$HT_SHELL --batch --test-mode --namespace / --exec "SELECT Field1 FROM IndexTest;" | wc -l > Field1.count
+$HT_SHELL --batch --test-mode --namespace / --exec "SELECT * FROM \"^IndexTest\";" | wc -l > Field1.index.count
+diff Field1.count Field1.index.count
+if [ $? -ne "0" ]
+then
+  echo "Stale entries left in the Field1 index"
+  exit -1
+fi
+
+exit 0
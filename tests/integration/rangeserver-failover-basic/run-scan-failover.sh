@@ -29,6 +29,9 @@ let j=1
 [ $TEST == $j ] && INDUCER_ARG="--induce-failure=create-scanner-user-1:exit:1"
 let j+=1
 [ $TEST == $j ] && INDUCER_ARG="--induce-failure=fetch-scanblock-user-1:exit:0"
+# aggregate scans over a row interval, a row set and a cell interval
+let j+=1
+[ $TEST -ge $j ] && INDUCER_ARG="--induce-failure=fetch-scanblock-user-1:exit:0"
 
 
 # stop and start servers
@@ -59,8 +62,30 @@ fi
 
 sleep 2
 
-# dump keys
-dump_keys dbdump-scan-failover
+if [ $TEST -le 2 ] ; then
+  # dump keys
+  dump_keys dbdump-scan-failover
+else
+  # count rows; partial counts received before the failure must not be
+  # added a second time when the scanner restarts on the recovered range
+  if [ $TEST == 3 ] ; then
+    expected=`wc -l < golden_dump.$MAX_KEYS.txt`
+    query="SELECT COUNT(*) FROM LoadTest;"
+  elif [ $TEST == 4 ] ; then
+    expected=`awk 'NR % 50 == 1' golden_dump.$MAX_KEYS.txt | wc -l`
+    query="SELECT COUNT(*) FROM LoadTest WHERE `awk 'NR % 50 == 1' golden_dump.$MAX_KEYS.txt | sed "s/.*/ROW = '&'/" | paste -s -d'|' | sed 's/|/ OR /g'` SCAN_AND_FILTER_ROWS;"
+  else
+    expected=`wc -l < golden_dump.$MAX_KEYS.txt`
+    query="SELECT COUNT(*) FROM LoadTest WHERE '0','column' <= CELL <= '99999999999999999999','column';"
+  fi
+  echo "use '/'; $query" | $HT_HOME/bin/ht shell -l error --batch \
+      | grep -v "Waiting for connection to Hyperspace" > count-scan-failover.txt
+  count=`tail -1 count-scan-failover.txt`
+  if [ "$count" != "$expected" ] ; then
+    echo "Test $TEST FAILED: counted $count rows, expected $expected"
+    exit 1
+  fi
+fi
 
 # wait for recovery to complete 
 wait_for_recovery rs1